@@ -12,7 +12,8 @@
 
 #include "LightingUtil.hlsl"
 
-Texture2D    gDiffuseMap : register(t0);
+// every 2D texture of the shader-visible heap, materials select theirs by index
+Texture2D    gTextureMaps[] : register(t0, space2);
 TextureCube  gCubeMap : register(t1);
 
 
@@ -57,6 +58,10 @@ cbuffer cbMaterial : register(b2)
     float3   gFresnelR0;
     float    gRoughness;
 	float4x4 gMatTransform;
+	uint     gDiffuseMapIndex;
+	uint     gMatPad0;
+	uint     gMatPad1;
+	uint     gMatPad2;
 };
 
 struct VertexIn
@@ -6,25 +6,21 @@ class Church
 public:
 	Church() = default;
 	
-	void BuildGeometry(ID3D12Device* devicePtr,
-		ID3D12GraphicsCommandList* commandListPtr,
-		std::unordered_map<std::string, std::unique_ptr<MeshGeometry>>& geometries);
+	void BuildGeometry(std::unordered_map<std::string, std::unique_ptr<MeshGeometry>>& geometries,
+		JobSystem& jobs);
 
 	void BuildRenderItems(std::unordered_map<std::string, std::unique_ptr<MeshGeometry>>& geometries,
 		std::unordered_map<std::string, std::unique_ptr<Material>>& materials,
-		std::vector<std::unique_ptr<RenderItem>>& allRitems,
-		std::vector<RenderItem*>& opaqueRenderItems);
+		RenderItemStore& ritems);
 
 protected:
 	void BuildRenderItems_Wall(std::unordered_map<std::string, std::unique_ptr<MeshGeometry>>& geometries,
 		std::unordered_map<std::string, std::unique_ptr<Material>>& materials,
-		std::vector<std::unique_ptr<RenderItem>>& allRitems,
-		std::vector<RenderItem*>& opaqueRenderItems);
+		RenderItemStore& ritems);
 
 	void BuildRenderItems_Roof(std::unordered_map<std::string, std::unique_ptr<MeshGeometry>>& geometries,
 		std::unordered_map<std::string, std::unique_ptr<Material>>& materials,
-		std::vector<std::unique_ptr<RenderItem>>& allRitems,
-		std::vector<RenderItem*>& opaqueRenderItems);
+		RenderItemStore& ritems);
 };
 
 #endif /* _CHURCH_H_ */
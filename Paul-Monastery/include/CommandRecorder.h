@@ -0,0 +1,130 @@
+#ifndef _COMMAND_RECORDER_H_
+#define _COMMAND_RECORDER_H_
+
+#include <RenderBackend.h>
+
+// In-memory RenderBackend. Command lists append every call to a byte stream,
+// an opcode followed by its arguments as variable-length integers, so a
+// frame of draws takes a few bytes each. Buffers are host memory at made-up
+// GPU addresses and fences complete when waited on, as if the GPU had
+// finished instantly.
+
+enum class RecordedOp : BYTE
+{
+	SetPipelineState,
+	SetPrimitiveTopology,
+	SetVertexBuffer,
+	SetIndexBuffer,
+	SetGraphicsRootConstantBufferView,
+	SetGraphicsRootShaderResourceView,
+	SetGraphicsRootDescriptorTable,
+	DrawIndexedInstanced,
+	Count
+};
+
+// A decoded call. Address holds the GPU address or descriptor; Args the
+// other arguments in declaration order, a base vertex location as INT bits.
+struct RecordedCommand
+{
+	RecordedOp Op;
+	RenderAddress Address = 0;
+	UINT Args[5] = {};
+};
+
+class RecordingCommandList : public RenderCommandList
+{
+public:
+	void SetPipelineState(UINT pso) override;
+	void SetPrimitiveTopology(UINT topology) override;
+	void SetVertexBuffer(const RenderVertexBufferView& view) override;
+	void SetIndexBuffer(const RenderIndexBufferView& view) override;
+
+	void SetGraphicsRootConstantBufferView(UINT parameter, RenderAddress address) override;
+	void SetGraphicsRootShaderResourceView(UINT parameter, RenderAddress address) override;
+	void SetGraphicsRootDescriptorTable(UINT parameter, RenderAddress descriptor) override;
+
+	void DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount,
+		UINT startIndexLocation, INT baseVertexLocation, UINT startInstanceLocation) override;
+
+	// Forgets the commands, keeps the memory.
+	void Reset();
+
+	const std::vector<BYTE>& Stream() const { return _Stream; }
+	UINT CommandCount() const { return _CommandCount; }
+	UINT CommandCount(RecordedOp op) const { return _OpCounts[(UINT)op]; }
+
+protected:
+	void Op(RecordedOp op);
+	void Write(UINT64 value);
+
+	std::vector<BYTE> _Stream;
+	UINT _CommandCount = 0;
+	UINT _OpCounts[(UINT)RecordedOp::Count] = {};
+};
+
+// Walks a recorded stream.
+class CommandReader
+{
+public:
+	CommandReader(const BYTE* data, size_t size) : _Data(data), _End(data + size) {}
+	explicit CommandReader(const std::vector<BYTE>& stream) : CommandReader(stream.data(), stream.size()) {}
+
+	// False at the end of the stream.
+	bool Next(RecordedCommand& command);
+
+	// Issues the remaining commands to cmdList.
+	void Replay(RenderCommandList& cmdList);
+
+protected:
+	UINT64 Read();
+
+	const BYTE* _Data;
+	const BYTE* _End;
+};
+
+class MemoryBuffer : public RenderBuffer
+{
+public:
+	MemoryBuffer(UINT64 size, RenderAddress gpuAddress) : _Memory((size_t)size), _GpuAddress(gpuAddress) {}
+
+	BYTE* Data() const override { return const_cast<BYTE*>(_Memory.data()); }
+	RenderAddress GpuAddress() const override { return _GpuAddress; }
+	UINT64 Size() const override { return _Memory.size(); }
+
+protected:
+	std::vector<BYTE> _Memory;
+	RenderAddress _GpuAddress;
+};
+
+class SimulatedFence : public RenderFence
+{
+public:
+	UINT64 CompletedValue() const override { return _Completed; }
+	void Signal(UINT64 value) override { _Signaled = max(_Signaled, value); }
+
+	// The GPU catches up with the wait; waiting past the last signal is a deadlock.
+	void Wait(UINT64 value) override;
+
+	// Lets the GPU finish everything up to value, e.g. to simulate latency.
+	void Complete(UINT64 value);
+
+	UINT WaitCount() const { return _WaitCount; }
+
+protected:
+	UINT64 _Completed = 0;
+	UINT64 _Signaled = 0;
+	UINT _WaitCount = 0;
+};
+
+class RecordingDevice : public RenderDevice
+{
+public:
+	std::unique_ptr<RenderBuffer> CreateUploadBuffer(UINT64 size) override;
+	std::unique_ptr<RenderFence> CreateFence() override;
+
+protected:
+	// made-up addresses, 64 KB aligned like placed resources
+	RenderAddress _NextAddress = 0x10000;
+};
+
+#endif /* _COMMAND_RECORDER_H_ */
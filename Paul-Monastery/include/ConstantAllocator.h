@@ -0,0 +1,82 @@
+#ifndef _CONSTANT_ALLOCATOR_H_
+#define _CONSTANT_ALLOCATOR_H_
+
+#include <UploadRing.h>
+#include <RenderBackend.h>
+
+class FrameCapture;
+
+// Hands out constant buffer memory for the frame being recorded from one
+// persistently mapped upload buffer. Allocations are bumped off an UploadRing
+// and reused once the frame's fence has completed, so constants are written
+// on demand instead of into slots fixed at build time. When the frames in
+// flight fill the ring, a ring twice the size replaces it; the old buffer is
+// released after the frames using it have completed.
+class ConstantAllocator
+{
+public:
+	struct Allocation
+	{
+		BYTE* Data;
+		RenderAddress GpuAddress;
+	};
+
+	// D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, the size of a view's unit
+	static const UINT64 Alignment = 256;
+
+	ConstantAllocator(RenderDevice& device, UINT64 capacity);
+	ConstantAllocator(const ConstantAllocator& rhs) = delete;
+	ConstantAllocator& operator=(const ConstantAllocator& rhs) = delete;
+
+	// Later allocations are read by the frame that completes at frameFence.
+	void BeginFrame(UINT64 frameFence, UINT64 completedFence);
+
+	// size bytes at the constant buffer placement alignment, rounded up to a
+	// whole view. Not thread safe, allocate a block for all items and fill it
+	// from the jobs instead.
+	Allocation Allocate(UINT64 size);
+
+	template <typename T>
+	RenderAddress Push(const T& constants)
+	{
+		Allocation a = Allocate(sizeof(T));
+		memcpy(a.Data, &constants, sizeof(T));
+		return a.GpuAddress;
+	}
+
+	// Distance of consecutive T in an allocated array; every one is a valid CBV address.
+	template <typename T>
+	static UINT Stride() { return (UINT)((sizeof(T) + Alignment - 1) & ~(Alignment - 1)); }
+
+	// Allocations are tracked by capture while it is set; their contents are
+	// read when the captured frame ends.
+	void SetCapture(FrameCapture* capture) { _Capture = capture; }
+
+	UINT64 Capacity() const { return _Ring.Capacity(); }
+	UINT64 UsedBytes() const { return _Ring.UsedBytes(); }
+
+protected:
+	struct Retired
+	{
+		UINT64 Fence;
+		std::unique_ptr<RenderBuffer> Buffer;
+	};
+
+	void CreateRing(UINT64 capacity);
+
+	RenderDevice& _Device;
+
+	std::unique_ptr<RenderBuffer> _Buffer;
+	BYTE* _Data = nullptr;
+	RenderAddress _GpuAddress = 0;
+	UploadRing _Ring;
+
+	UINT64 _FrameFence = 0;
+
+	// rings replaced by larger ones
+	std::deque<Retired> _Retired;
+
+	FrameCapture* _Capture = nullptr;
+};
+
+#endif /* _CONSTANT_ALLOCATOR_H_ */
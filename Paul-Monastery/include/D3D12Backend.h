@@ -0,0 +1,94 @@
+#ifndef _D3D12_BACKEND_H_
+#define _D3D12_BACKEND_H_
+
+#include <RenderBackend.h>
+
+class D3D12UploadBuffer : public RenderBuffer
+{
+public:
+	D3D12UploadBuffer(ID3D12Device* device, UINT64 size);
+	~D3D12UploadBuffer();
+
+	BYTE* Data() const override { return _Data; }
+	RenderAddress GpuAddress() const override { return _Buffer->GetGPUVirtualAddress(); }
+	UINT64 Size() const override { return _Size; }
+
+	ID3D12Resource* Resource() const { return _Buffer.Get(); }
+
+protected:
+	Microsoft::WRL::ComPtr<ID3D12Resource> _Buffer;
+	BYTE* _Data = nullptr;
+	UINT64 _Size;
+};
+
+// Waits on one event for the fence's whole lifetime instead of creating one per wait.
+class D3D12Fence : public RenderFence
+{
+public:
+	D3D12Fence(ID3D12Fence* fence, ID3D12CommandQueue* queue);
+	~D3D12Fence();
+
+	UINT64 CompletedValue() const override { return _Fence->GetCompletedValue(); }
+	void Signal(UINT64 value) override;
+	void Wait(UINT64 value) override;
+
+	ID3D12Fence* Fence() const { return _Fence.Get(); }
+
+protected:
+	Microsoft::WRL::ComPtr<ID3D12Fence> _Fence;
+	ID3D12CommandQueue* _Queue;
+	HANDLE _Event;
+};
+
+// Forwards to a graphics command list; pipeline state indices select from psos.
+class D3D12CommandList : public RenderCommandList
+{
+public:
+	D3D12CommandList(ID3D12GraphicsCommandList* cmdList, ID3D12PipelineState* const* psos)
+		: _CmdList(cmdList), _Psos(psos) {}
+
+	void SetPipelineState(UINT pso) override { _CmdList->SetPipelineState(_Psos[pso]); }
+	void SetPrimitiveTopology(UINT topology) override { _CmdList->IASetPrimitiveTopology((D3D12_PRIMITIVE_TOPOLOGY)topology); }
+	void SetVertexBuffer(const RenderVertexBufferView& view) override;
+	void SetIndexBuffer(const RenderIndexBufferView& view) override;
+
+	void SetGraphicsRootConstantBufferView(UINT parameter, RenderAddress address) override
+	{
+		_CmdList->SetGraphicsRootConstantBufferView(parameter, address);
+	}
+
+	void SetGraphicsRootShaderResourceView(UINT parameter, RenderAddress address) override
+	{
+		_CmdList->SetGraphicsRootShaderResourceView(parameter, address);
+	}
+
+	void SetGraphicsRootDescriptorTable(UINT parameter, RenderAddress descriptor) override
+	{
+		_CmdList->SetGraphicsRootDescriptorTable(parameter, D3D12_GPU_DESCRIPTOR_HANDLE{ descriptor });
+	}
+
+	void DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount,
+		UINT startIndexLocation, INT baseVertexLocation, UINT startInstanceLocation) override
+	{
+		_CmdList->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+	}
+
+protected:
+	ID3D12GraphicsCommandList* _CmdList;
+	ID3D12PipelineState* const* _Psos;
+};
+
+class D3D12RenderDevice : public RenderDevice
+{
+public:
+	D3D12RenderDevice(ID3D12Device* device, ID3D12CommandQueue* queue) : _Device(device), _Queue(queue) {}
+
+	std::unique_ptr<RenderBuffer> CreateUploadBuffer(UINT64 size) override;
+	std::unique_ptr<RenderFence> CreateFence() override;
+
+protected:
+	ID3D12Device* _Device;
+	ID3D12CommandQueue* _Queue;
+};
+
+#endif /* _D3D12_BACKEND_H_ */
@@ -0,0 +1,147 @@
+#ifndef _DDS_PARSER_H_
+#define _DDS_PARSER_H_
+
+#include <MappedFile.h>
+
+// The device-free half of the DDS loader: maps a file, validates its header
+// and finds every subresource in it. Needs only the DXGI format values and
+// the D3D12 limits, which platform.h declares where the SDK headers are not
+// available, so the parser also builds and is measured on other platforms.
+
+//--------------------------------------------------------------------------------------
+// DDS file structure definitions
+//
+// See DDS.h in the 'Texconv' sample and the 'DirectXTex' library
+//--------------------------------------------------------------------------------------
+#ifndef MAKEFOURCC
+#define MAKEFOURCC(ch0, ch1, ch2, ch3)                                      \
+	((uint32_t)(uint8_t)(ch0) | ((uint32_t)(uint8_t)(ch1) << 8) |           \
+	((uint32_t)(uint8_t)(ch2) << 16) | ((uint32_t)(uint8_t)(ch3) << 24 ))
+#endif
+
+#pragma pack(push,1)
+
+const uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+
+struct DDS_PIXELFORMAT
+{
+	uint32_t size;
+	uint32_t flags;
+	uint32_t fourCC;
+	uint32_t RGBBitCount;
+	uint32_t RBitMask;
+	uint32_t GBitMask;
+	uint32_t BBitMask;
+	uint32_t ABitMask;
+};
+
+#define DDS_FOURCC      0x00000004  // DDPF_FOURCC
+#define DDS_RGB         0x00000040  // DDPF_RGB
+#define DDS_LUMINANCE   0x00020000  // DDPF_LUMINANCE
+#define DDS_ALPHA       0x00000002  // DDPF_ALPHA
+
+#define DDS_HEADER_FLAGS_VOLUME         0x00800000  // DDSD_DEPTH
+
+#define DDS_HEIGHT 0x00000002 // DDSD_HEIGHT
+#define DDS_WIDTH  0x00000004 // DDSD_WIDTH
+
+#define DDS_CUBEMAP_POSITIVEX 0x00000600 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEX
+#define DDS_CUBEMAP_NEGATIVEX 0x00000a00 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEX
+#define DDS_CUBEMAP_POSITIVEY 0x00001200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEY
+#define DDS_CUBEMAP_NEGATIVEY 0x00002200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEY
+#define DDS_CUBEMAP_POSITIVEZ 0x00004200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEZ
+#define DDS_CUBEMAP_NEGATIVEZ 0x00008200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEZ
+
+#define DDS_CUBEMAP_ALLFACES ( DDS_CUBEMAP_POSITIVEX | DDS_CUBEMAP_NEGATIVEX |\
+                               DDS_CUBEMAP_POSITIVEY | DDS_CUBEMAP_NEGATIVEY |\
+                               DDS_CUBEMAP_POSITIVEZ | DDS_CUBEMAP_NEGATIVEZ )
+
+#define DDS_CUBEMAP 0x00000200 // DDSCAPS2_CUBEMAP
+
+// resourceDimension and miscFlag of the DX10 header, as in D3D11
+#define DDS_DIMENSION_TEXTURE1D 2
+#define DDS_DIMENSION_TEXTURE2D 3
+#define DDS_DIMENSION_TEXTURE3D 4
+#define DDS_RESOURCE_MISC_TEXTURECUBE 0x4
+
+#define DDS_MISC_FLAGS2_ALPHA_MODE_MASK 0x7
+
+struct DDS_HEADER
+{
+	uint32_t size;
+	uint32_t flags;
+	uint32_t height;
+	uint32_t width;
+	uint32_t pitchOrLinearSize;
+	uint32_t depth; // only if DDS_HEADER_FLAGS_VOLUME is set in flags
+	uint32_t mipMapCount;
+	uint32_t reserved1[11];
+	DDS_PIXELFORMAT ddspf;
+	uint32_t caps;
+	uint32_t caps2;
+	uint32_t caps3;
+	uint32_t caps4;
+	uint32_t reserved2;
+};
+
+struct DDS_HEADER_DXT10
+{
+	DXGI_FORMAT dxgiFormat;
+	uint32_t resourceDimension;
+	uint32_t miscFlag; // see D3D11_RESOURCE_MISC_FLAG
+	uint32_t arraySize;
+	uint32_t miscFlags2;
+};
+
+#pragma pack(pop)
+
+namespace DirectX
+{
+	enum DDS_ALPHA_MODE
+	{
+		DDS_ALPHA_MODE_UNKNOWN = 0,
+		DDS_ALPHA_MODE_STRAIGHT = 1,
+		DDS_ALPHA_MODE_PREMULTIPLIED = 2,
+		DDS_ALPHA_MODE_OPAQUE = 3,
+		DDS_ALPHA_MODE_CUSTOM = 4,
+	};
+
+	// A DDS file parsed and validated for D3D12; Subresources point into File.
+	struct DDSTextureData12
+	{
+		MappedFile File;
+
+		uint32_t ResourceDimension = 0;
+		size_t Width = 0;
+		size_t Height = 0;
+		size_t Depth = 0;
+		size_t MipCount = 0;
+		size_t ArraySize = 0;
+		DXGI_FORMAT Format = DXGI_FORMAT_UNKNOWN;
+		bool IsCubeMap = false;
+		DDS_ALPHA_MODE AlphaMode = DDS_ALPHA_MODE_UNKNOWN;
+
+		std::vector<D3D12_SUBRESOURCE_DATA> Subresources;
+	};
+
+	// Maps, parses and validates the file without touching the device, so it
+	// can run on any thread. Mips larger than maxsize (0 for any) are skipped.
+	HRESULT LoadDDSTextureData12(const wchar_t* szFileName, DDSTextureData12& data, size_t maxsize = 0);
+
+	// The same for a file already in memory; Subresources point into ddsData,
+	// which must outlive them, and File stays closed.
+	HRESULT ParseDDSTextureData12(const uint8_t* ddsData, size_t ddsDataSize, DDSTextureData12& data, size_t maxsize = 0);
+
+	// The pieces the D3D11 loader shares.
+	HRESULT FindDDSHeader(const uint8_t* ddsData, size_t ddsDataSize,
+		const DDS_HEADER** header, const uint8_t** bitData, size_t* bitSize);
+	HRESULT LoadDDSFile(const wchar_t* fileName, MappedFile& ddsFile,
+		const DDS_HEADER** header, const uint8_t** bitData, size_t* bitSize);
+	DDS_ALPHA_MODE GetDDSAlphaMode(const DDS_HEADER* header);
+	size_t BitsPerPixel(DXGI_FORMAT fmt);
+	void GetSurfaceInfo(size_t width, size_t height, DXGI_FORMAT fmt,
+		size_t* outNumBytes, size_t* outRowBytes, size_t* outNumRows);
+	DXGI_FORMAT GetDXGIFormat(const DDS_PIXELFORMAT& ddpf);
+}
+
+#endif /* _DDS_PARSER_H_ */
@@ -0,0 +1,41 @@
+#ifndef _DESCRIPTOR_ALLOCATOR_H_
+#define _DESCRIPTOR_ALLOCATOR_H_
+
+// Hands out the slots of a descriptor heap. Freed slots go on a free list
+// and are handed out again first; released slots join it once the frame
+// that may still read them has completed. When every slot is taken the
+// capacity doubles, the owner then moves the descriptors to a larger heap.
+class DescriptorAllocator
+{
+public:
+	explicit DescriptorAllocator(UINT capacity);
+
+	UINT Allocate();
+	void Free(UINT slot);
+
+	// Frees slot once the frame completing at fence is done.
+	void Release(UINT slot, UINT64 fence);
+	void Reclaim(UINT64 completedFence);
+
+	UINT Capacity() const { return _Capacity; }
+	UINT UsedCount() const { return _UsedCount; }
+
+	// Slots below it have been handed out at some point.
+	UINT HighWater() const { return _HighWater; }
+
+protected:
+	struct Retired
+	{
+		UINT64 Fence;
+		UINT Slot;
+	};
+
+	UINT _Capacity;
+	UINT _UsedCount = 0;
+	UINT _HighWater = 0;
+
+	std::vector<UINT> _FreeSlots;
+	std::deque<Retired> _Retired;
+};
+
+#endif /* _DESCRIPTOR_ALLOCATOR_H_ */
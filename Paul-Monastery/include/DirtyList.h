@@ -0,0 +1,33 @@
+#ifndef _DIRTY_LIST_H_
+#define _DIRTY_LIST_H_
+
+// Tracks which items need their per-frame data refreshed. Each frame
+// resource owns a bitset (to reject duplicates) and a compact list of the
+// dirty indices, so an update only visits the items that actually changed.
+class DirtyList
+{
+public:
+	DirtyList() = default;
+
+	void Reset(int frameResourceCount, UINT itemCount);
+	void Resize(UINT itemCount);
+
+	// Queues the item for the next update of every frame resource.
+	void MarkDirty(UINT index);
+	void MarkAllDirty();
+
+	const std::vector<UINT>& DirtyItems(int frameResourceIndex) const;
+	void Clear(int frameResourceIndex);
+
+protected:
+	struct FrameDirtySet
+	{
+		std::vector<std::uint64_t> Bits;
+		std::vector<UINT> Indices;
+	};
+
+	std::vector<FrameDirtySet> _Frames;
+	UINT _ItemCount = 0;
+};
+
+#endif /* _DIRTY_LIST_H_ */
@@ -0,0 +1,28 @@
+#ifndef _DRAW_CHUNKS_H_
+#define _DRAW_CHUNKS_H_
+
+#include <DrawKey.h>
+
+// A run of sorted draw keys recorded into one command list.
+struct DrawChunk
+{
+	UINT Begin = 0;
+	UINT End = 0;
+
+	UINT Size() const { return End - Begin; }
+};
+
+// Splits sorted draw keys into chunks that threads record into command
+// lists of their own. Executing the lists in chunk order draws the keys in
+// the order a single list recording all of them would.
+namespace DrawChunks
+{
+	// The keys of layer, sorting made them one run.
+	DrawChunk LayerRange(const std::vector<UINT64>& keys, UINT layer);
+
+	// At most maxChunks chunks of at least minDraws each (unless the range is
+	// smaller), in key order; their sizes differ by at most one draw.
+	void Split(DrawChunk range, UINT maxChunks, UINT minDraws, std::vector<DrawChunk>& chunks);
+}
+
+#endif /* _DRAW_CHUNKS_H_ */
@@ -0,0 +1,42 @@
+#ifndef _DRAW_KEY_H_
+#define _DRAW_KEY_H_
+
+// 64-bit sort key for one draw. From the most significant bits down:
+// layer (4), PSO (4), geometry (10), material (10), depth bucket (12) and the
+// render item index (24). Sorting the keys groups draws that share state, and
+// the item index in the low bits lets the submission loop go from key to item.
+namespace DrawKey
+{
+	const UINT LayerBits = 4;
+	const UINT PsoBits = 4;
+	const UINT GeometryBits = 10;
+	const UINT MaterialBits = 10;
+	const UINT DepthBits = 12;
+	const UINT IndexBits = 24;
+
+	const UINT IndexShift = 0;
+	const UINT DepthShift = IndexShift + IndexBits;
+	const UINT MaterialShift = DepthShift + DepthBits;
+	const UINT GeometryShift = MaterialShift + MaterialBits;
+	const UINT PsoShift = GeometryShift + GeometryBits;
+	const UINT LayerShift = PsoShift + PsoBits;
+
+	UINT64 Make(UINT layer, UINT pso, UINT geometry, UINT material, UINT depthBucket, UINT index);
+
+	// Quantizes a view-space depth in [0, farZ] to a depth bucket.
+	UINT DepthBucket(float viewZ, float farZ);
+
+	inline UINT Field(UINT64 key, UINT shift, UINT bits)
+	{
+		return (UINT)((key >> shift) & ((UINT64(1) << bits) - 1));
+	}
+
+	inline UINT Layer(UINT64 key) { return Field(key, LayerShift, LayerBits); }
+	inline UINT Pso(UINT64 key) { return Field(key, PsoShift, PsoBits); }
+	inline UINT Index(UINT64 key) { return Field(key, IndexShift, IndexBits); }
+
+	// LSD radix sort on bytes; passes where all keys share the byte are skipped.
+	void Sort(std::vector<UINT64>& keys, std::vector<UINT64>& scratch);
+}
+
+#endif /* _DRAW_KEY_H_ */
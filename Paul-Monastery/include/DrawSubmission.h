@@ -0,0 +1,38 @@
+#ifndef _DRAW_SUBMISSION_H_
+#define _DRAW_SUBMISSION_H_
+
+#include <RenderBackend.h>
+#include <RenderItemStore.h>
+
+// What the draws bind besides their meshes: object constants, one per draw
+// key in key order, material constants by material ID and the instance data
+// of the instanced items.
+struct DrawBindings
+{
+	RenderAddress ObjectCB = 0;
+	UINT ObjectCBStride = 0;
+	RenderAddress MaterialCB = 0;
+	UINT MaterialCBStride = 0;
+	RenderAddress Instances = 0;
+
+	// the vertex and index buffers of a mesh, asked for when the mesh changes
+	std::function<void(const MeshGeometry& geo, RenderVertexBufferView& vbv, RenderIndexBufferView& ibv)> BufferViews;
+};
+
+// Records sorted draw keys into a command list. Sorting puts draws that
+// share state next to each other, so only what differs from the previous
+// draw is set.
+namespace DrawSubmission
+{
+	// root parameters, as GraphicsWindow::BuildRootSignature lays them out
+	const UINT ObjectCBParameter = 1;
+	const UINT MaterialCBParameter = 3;
+	const UINT InstancesParameter = 5;
+
+	// The draws of keys [begin, end); a list starts without any state, so
+	// every call sets what its first draw needs.
+	void Record(RenderCommandList& cmdList, const RenderItemStore& ritems, const std::vector<UINT64>& keys,
+		UINT begin, UINT end, const DrawBindings& bindings);
+}
+
+#endif /* _DRAW_SUBMISSION_H_ */
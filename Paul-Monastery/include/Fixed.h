@@ -7,22 +7,19 @@ public:
 	Fixed() = delete;
 	~Fixed() = delete;
 
-	static void BuildGeometry(ID3D12Device* devicePtr,
-		ID3D12GraphicsCommandList* commandListPtr,
-		std::unordered_map<std::string, std::unique_ptr<MeshGeometry>>& geometries);
+	static void BuildGeometry(std::unordered_map<std::string, std::unique_ptr<MeshGeometry>>& geometries);
 
 	static void BuildRenderItems(std::unordered_map<std::string, std::unique_ptr<MeshGeometry>>& geometries,
 		std::unordered_map<std::string, std::unique_ptr<Material>>& materials,
-		std::vector<std::unique_ptr<RenderItem>>& allRitems,
-		std::vector<RenderItem*>& fixedRenderItems);
+		RenderItemStore& ritems);
 
-	static RenderItem* _newButton;
-	static RenderItem* _upButton;
-	static RenderItem* _downButton;
-	static RenderItem* _leftButton;
-	static RenderItem* _rightButton;
-	static RenderItem* _zoominButton;
-	static RenderItem* _zoomoutButton;
+	static RenderItemHandle _newButton;
+	static RenderItemHandle _upButton;
+	static RenderItemHandle _downButton;
+	static RenderItemHandle _leftButton;
+	static RenderItemHandle _rightButton;
+	static RenderItemHandle _zoominButton;
+	static RenderItemHandle _zoomoutButton;
 };
 
 
@@ -0,0 +1,69 @@
+#ifndef _FRAME_CAPTURE_H_
+#define _FRAME_CAPTURE_H_
+
+#include <RenderBackend.h>
+
+// Captured frames: the camera, the bytes the CPU wrote to upload memory and
+// the draw path's commands as recorded by RecordingCommandList. Written to a
+// file by the F10 capture mode and replayed by tools/FrameReplay.
+
+struct CapturedCamera
+{
+	float Theta = 0.0f;
+	float Phi = 0.0f;
+	float Radius = 0.0f;
+};
+
+// Size bytes at Offset in the frame's UploadData, written to Address.
+struct CapturedUpload
+{
+	RenderAddress Address;
+	UINT64 Offset;
+	UINT64 Size;
+};
+
+struct CapturedFrame
+{
+	CapturedCamera Camera;
+	std::vector<CapturedUpload> Uploads;
+	std::vector<BYTE> UploadData;
+	std::vector<BYTE> Commands;
+};
+
+class FrameCapture
+{
+public:
+	void BeginFrame(const CapturedCamera& camera);
+
+	// Copies the payload now. Writes continuing the previous one are merged.
+	void Upload(RenderAddress address, const void* data, UINT64 size);
+
+	// Copies the bytes at EndFrame, for memory filled after it was allocated.
+	void Track(RenderAddress address, const BYTE* data, UINT64 size);
+
+	void EndFrame(const std::vector<BYTE>& commands);
+
+	bool Capturing() const { return _Capturing; }
+
+	const std::vector<CapturedFrame>& Frames() const { return _Frames; }
+	void Clear();
+
+	bool Write(const std::string& filename) const;
+	bool Read(const std::string& filename);
+
+protected:
+	void Append(RenderAddress address, const void* data, UINT64 size);
+
+	struct Tracked
+	{
+		RenderAddress Address;
+		const BYTE* Data;
+		UINT64 Size;
+	};
+
+	std::vector<CapturedFrame> _Frames;
+	std::vector<Tracked> _Tracked;
+	bool _Capturing = false;
+};
+
+#endif /* _FRAME_CAPTURE_H_ */
@@ -0,0 +1,87 @@
+#ifndef _FRAME_PACER_H_
+#define _FRAME_PACER_H_
+
+#include <GameTimer.h>
+
+// Frame times of the last Window frames. Min, max, mean and jitter (the
+// standard deviation) are exact; percentiles come from a histogram of
+// BucketSize wide buckets that is updated as frames enter and leave.
+class FrameTimeStats
+{
+public:
+	static const UINT Window = 1024;
+	static const UINT BucketCount = 1000;
+	static constexpr double BucketSize = 50e-6;
+
+	FrameTimeStats() { Reset(); }
+
+	void Add(double seconds);
+	void Reset();
+
+	UINT Count() const { return _Count; }
+	double Min() const;
+	double Max() const;
+	double Mean() const;
+	double Jitter() const;
+
+	// p in [0, 1]; the upper edge of the bucket holding it, at most Max().
+	double Percentile(double p) const;
+
+protected:
+	static UINT Bucket(double seconds);
+
+	double _Samples[Window];
+	UINT _Next;
+	UINT _Count;
+
+	double _Sum;
+	double _SumSquares;
+
+	// the last bucket also counts everything longer
+	UINT _Buckets[BucketCount];
+};
+
+// Spaces frames at a target frame time. Wait() sleeps until shortly before
+// the frame is due and spins the rest, the margin following the 99th
+// percentile of the OS timer's oversleeps. A late frame restarts the
+// schedule instead of shortening the next one to catch up.
+class FramePacer
+{
+public:
+	FramePacer();
+	FramePacer(const FramePacer& rhs) = delete;
+	FramePacer& operator=(const FramePacer& rhs) = delete;
+	~FramePacer();
+
+	// 0 stops pacing; Wait() then only measures.
+	void SetTargetFrameRate(double framesPerSecond);
+	void SetTargetFrameTime(double seconds);
+	double TargetFrameTime() const { return (double)_Period / _TicksPerSecond; }
+
+	// Blocks until the next frame is due and records the time since the previous one.
+	void Wait();
+
+	const FrameTimeStats& Stats() const { return _Stats; }
+
+	// Time before a deadline spent spinning rather than sleeping.
+	double SpinTime() const { return (double)_SpinTicks / _TicksPerSecond; }
+
+protected:
+	void SleepUntil(INT64 ticks);
+
+	INT64 _TicksPerSecond;
+	INT64 _Period = 0;
+	INT64 _Deadline = 0;
+	INT64 _LastFrame = 0;
+
+	INT64 _SpinTicks;
+	INT64 _Oversleep = 0;
+
+#ifdef _WIN32
+	HANDLE _Timer = nullptr;
+#endif
+
+	FrameTimeStats _Stats;
+};
+
+#endif /* _FRAME_PACER_H_ */
@@ -0,0 +1,182 @@
+#ifndef _FRAME_PIPELINE_H_
+#define _FRAME_PIPELINE_H_
+
+#include <TripleBuffer.h>
+
+// Runs frames in two stages: the calling thread simulates frame N+1 into a
+// snapshot while a render thread draws frame N from the previous one. The
+// snapshots pass through a TripleBuffer. A new frame is begun only after
+// the render thread took the last one, so the simulation stays one frame
+// ahead and no snapshot is skipped. The mutex never guards a snapshot, it
+// only parks a thread that has nothing to do.
+//
+// Unthreaded, EndFrame() renders in place: the serial order the pipeline
+// replaces, kept to compare against.
+template<typename T>
+class FramePipeline
+{
+public:
+	typedef std::function<void(const T&)> RenderFunc;
+	typedef std::function<void()> ThreadFunc;
+
+	// threadStart, if given, runs first on every render thread started
+	explicit FramePipeline(RenderFunc render, bool threaded = true, ThreadFunc threadStart = nullptr)
+		: _Render(std::move(render)), _ThreadStart(std::move(threadStart))
+	{
+		SetThreaded(threaded);
+	}
+
+	FramePipeline(const FramePipeline& rhs) = delete;
+	FramePipeline& operator=(const FramePipeline& rhs) = delete;
+
+	// renders what was published before the thread stops
+	~FramePipeline()
+	{
+		Stop();
+	}
+
+	// The snapshot to fill for the next frame, holding whatever an earlier
+	// frame left in it. Rethrows what rendering the previous frames threw.
+	T& BeginFrame()
+	{
+		{
+			std::unique_lock<std::mutex> lock(_Mutex);
+			_Wake.wait(lock, [this] { return !_Buffer.Pending() || _Error; });
+		}
+
+		RethrowError();
+		return _Buffer.Back();
+	}
+
+	void EndFrame()
+	{
+		_Published++;
+
+		if (!Threaded())
+		{
+			// counted first, a throw still leaves nothing to flush
+			_Buffer.Publish();
+			_Buffer.Acquire();
+			_Rendered++;
+			_Render(_Buffer.Front());
+			return;
+		}
+
+		_Buffer.Publish();
+		Notify();
+	}
+
+	// Waits until every published frame is rendered; the render thread then
+	// touches nothing until the next EndFrame(). What rendering threw is
+	// left for BeginFrame(), so this is safe inside a window message.
+	void Flush()
+	{
+		std::unique_lock<std::mutex> lock(_Mutex);
+		_Wake.wait(lock, [this] { return _Rendered == _Published; });
+	}
+
+	void SetThreaded(bool threaded)
+	{
+		if (threaded == Threaded())
+			return;
+
+		if (threaded)
+		{
+			_Stopping = false;
+			_Thread = std::thread(&FramePipeline::RenderLoop, this);
+		}
+		else
+		{
+			Stop();
+		}
+	}
+
+	bool Threaded() const { return _Thread.joinable(); }
+
+protected:
+	void RenderLoop()
+	{
+		if (_ThreadStart)
+			_ThreadStart();
+
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(_Mutex);
+				_Wake.wait(lock, [this] { return _Buffer.Pending() || _Stopping; });
+
+				if (!_Buffer.Pending())
+					return;
+			}
+
+			// the simulation may begin the next frame while this one renders
+			_Buffer.Acquire();
+			Notify();
+
+			try
+			{
+				_Render(_Buffer.Front());
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(_Mutex);
+				if (!_Error)
+					_Error = std::current_exception();
+			}
+
+			_Rendered++;
+			Notify();
+		}
+	}
+
+	void Stop()
+	{
+		if (!Threaded())
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(_Mutex);
+			_Stopping = true;
+		}
+		_Wake.notify_all();
+
+		_Thread.join();
+	}
+
+	// a waiter tests its condition under the mutex, taking it once before
+	// notifying means the change cannot fall between its test and its wait
+	void Notify()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_Mutex);
+		}
+		_Wake.notify_all();
+	}
+
+	void RethrowError()
+	{
+		std::exception_ptr error;
+		{
+			std::lock_guard<std::mutex> lock(_Mutex);
+			std::swap(error, _Error);
+		}
+
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	RenderFunc _Render;
+	ThreadFunc _ThreadStart;
+	TripleBuffer<T> _Buffer;
+
+	UINT64 _Published = 0;
+	std::atomic<UINT64> _Rendered{ 0 };
+
+	std::thread _Thread;
+	std::mutex _Mutex;
+	std::condition_variable _Wake;
+	bool _Stopping = false;
+	std::exception_ptr _Error;
+};
+
+#endif /* _FRAME_PIPELINE_H_ */
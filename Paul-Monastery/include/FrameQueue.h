@@ -0,0 +1,108 @@
+#ifndef _FRAME_QUEUE_H_
+#define _FRAME_QUEUE_H_
+
+#include <RenderBackend.h>
+
+// Decides when the CPU may start recording the next frame. Up to SlotCount
+// frames have their own resources; Depth of them may be in flight at once,
+// so BeginFrame() waits for the frame submitted Depth frames earlier.
+//
+// Every frame records how long the CPU waited and, once the fence shows
+// it complete, how long it took from submission. When adaptive, the depth
+// is revised every Window frames:
+//  - frames the GPU had already finished when the next one was submitted,
+//    after the CPU had waited for them, mean the queue is too shallow to
+//    keep both busy: one frame deeper, and that depth is not left for a
+//    while;
+//  - otherwise, if the CPU mostly waited on a full queue, a frame less in
+//    flight takes a frame of latency off at no cost in throughput.
+class FrameQueue
+{
+public:
+	typedef INT64 (*Clock)();
+
+	struct Config
+	{
+		UINT SlotCount = 3;
+		UINT MinDepth = 1;
+		bool Adaptive = true;
+
+		// frames per adaptation step
+		UINT Window = 60;
+
+		// windows a depth that starved the GPU is not tried again
+		UINT Backoff = 8;
+
+		// waits shorter than this (seconds) count as not waiting
+		double WaitThreshold = 0.0002;
+	};
+
+	struct Stats
+	{
+		double CpuWait = 0.0;
+		double Latency = 0.0;
+	};
+
+	FrameQueue(RenderFence& fence, const Config& config, Clock clock, INT64 ticksPerSecond);
+	FrameQueue(const FrameQueue& rhs) = delete;
+	FrameQueue& operator=(const FrameQueue& rhs) = delete;
+
+	// Waits until the next frame may be recorded and returns its slot.
+	UINT BeginFrame();
+
+	// The frame started last was submitted and completes at fenceValue.
+	void EndFrame(UINT64 fenceValue);
+
+	UINT SlotCount() const { return _Config.SlotCount; }
+	UINT Depth() const { return _Depth; }
+
+	// Fixes the depth, or lets the queue adapt it again starting from depth.
+	void SetDepth(UINT depth, bool adaptive);
+	bool Adaptive() const { return _Config.Adaptive; }
+
+	// Averages over the last whole window, in seconds. Latency runs from
+	// submission to the first time the fence was seen to pass.
+	Stats WindowStats() const { return _WindowStats; }
+	Stats LastFrame() const { return _Last; }
+
+protected:
+	struct InFlight
+	{
+		UINT64 Fence;
+		INT64 SubmitTime;
+	};
+
+	void Retire(INT64 now);
+	void Adapt();
+
+	RenderFence& _Fence;
+	Config _Config;
+	Clock _Clock;
+	INT64 _TicksPerSecond;
+
+	UINT _Depth;
+	UINT64 _FrameIndex = 0;
+	std::vector<UINT64> _SlotFences;
+	std::deque<InFlight> _InFlight;
+
+	bool _Waited = false;
+	Stats _Last;
+	Stats _WindowStats;
+
+	// current window
+	UINT _Frames = 0;
+	UINT _Starved = 0;
+	UINT _Waits = 0;
+	UINT _Completed = 0;
+	double _TotalWait = 0.0;
+	double _TotalLatency = 0.0;
+
+	// depths below _Floor starved the GPU; it holds for _FloorWindows more
+	// windows, twice as long each time a probe below it fails
+	UINT _Floor = 0;
+	UINT _FloorWindows = 0;
+	UINT _BackoffWindows;
+	bool _Probing = false;
+};
+
+#endif /* _FRAME_QUEUE_H_ */
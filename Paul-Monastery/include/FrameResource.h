@@ -10,6 +10,12 @@ struct ObjectConstants
     DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
 };
 
+struct InstanceData
+{
+    DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
+    DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
+};
+
 struct PassConstants
 {
     DirectX::XMFLOAT4X4 View = MathHelper::Identity4x4();
@@ -40,22 +46,29 @@ struct Vertex
     DirectX::XMFLOAT2 TexC;
 };
 
+#ifdef _WIN32
 struct FrameResource
 {
 public:
 
-    FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount);
+    // Without a device there are no command allocators, as when recording
+    // frames on the CommandRecorder backend.
+    FrameResource(ID3D12Device* device, RenderDevice& renderDevice, UINT instanceCount, UINT threadCount);
     FrameResource(const FrameResource& rhs) = delete;
     FrameResource& operator=(const FrameResource& rhs) = delete;
     ~FrameResource();
 
     Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CmdListAlloc;
 
-    std::unique_ptr<UploadBuffer<PassConstants>> PassCB = nullptr;
-    std::unique_ptr<UploadBuffer<ObjectConstants>> ObjectCB = nullptr;
-    std::unique_ptr<UploadBuffer<MaterialConstants>> MaterialCB = nullptr;
+    // One per job thread for the chunks recorded in parallel; a thread
+    // records its chunks one after another, so they can share it.
+    std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> ThreadCmdListAllocs;
+
+    // Constants are allocated per frame from the ConstantAllocator.
+    std::unique_ptr<UploadBuffer<InstanceData>> InstanceBuffer = nullptr;
 
     UINT64 Fence = 0;
 };
+#endif
 
 #endif /* _FRAME_RESOURCE_H_ */
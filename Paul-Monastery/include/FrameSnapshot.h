@@ -0,0 +1,34 @@
+#ifndef _FRAME_SNAPSHOT_H_
+#define _FRAME_SNAPSHOT_H_
+
+#include <FrameResource.h>
+#include <FrameCapture.h>
+#include <RenderItemStore.h>
+
+// A render item the simulation moved.
+struct SnapshotTransform
+{
+	RenderItemHandle Item;
+	DirectX::XMFLOAT4X4 World;
+};
+
+// What the render thread draws a frame from, written by the simulation
+// thread and only read once published. The render item store itself
+// belongs to the render thread, so moves travel as transforms.
+struct FrameSnapshot
+{
+	CapturedCamera Camera;
+	DirectX::XMFLOAT3 EyePos = { 0.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT4X4 View = MathHelper::Identity4x4();
+	DirectX::XMFLOAT4X4 Proj = MathHelper::Identity4x4();
+
+	// size in pixels of one unit at distance one, see RenderItemStore::SelectLods
+	float PixelScale = 0.0f;
+
+	PassConstants Pass;
+
+	// items moved since the previous snapshot
+	std::vector<SnapshotTransform> Transforms;
+};
+
+#endif /* _FRAME_SNAPSHOT_H_ */
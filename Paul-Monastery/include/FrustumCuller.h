@@ -0,0 +1,48 @@
+#ifndef _FRUSTUM_CULLER_H_
+#define _FRUSTUM_CULLER_H_
+
+// Culls render items against the view frustum. World-space bounds are kept
+// as separate arrays (structure of arrays) so four boxes are tested against
+// a plane with one SIMD operation. The arrays are copies, Update() keeps
+// them in step with the store.
+class FrustumCuller
+{
+public:
+	FrustumCuller() = default;
+
+	void Build(const RenderItemStore& ritems, RenderLayer layer);
+
+	// Rebuilds after items were added or removed and copies the bounds again
+	// after items moved; does nothing while the store is unchanged.
+	void Update(const RenderItemStore& ritems, RenderLayer layer);
+
+	// Large layers are split into chunks that are tested in parallel when jobs is given.
+	void Cull(const DirectX::XMFLOAT4X4& viewProj, std::vector<UINT>& visibleRitems, JobSystem* jobs = nullptr) const;
+
+protected:
+	static const size_t ChunkSize = 1024;
+
+	struct FrustumPlanes
+	{
+		DirectX::XMVECTOR X[6], Y[6], Z[6], D[6];
+		DirectX::XMVECTOR AbsX[6], AbsY[6], AbsZ[6];
+	};
+
+	void CopyBounds(const RenderItemStore& ritems);
+	void CullRange(const FrustumPlanes& frustum, size_t begin, size_t end, std::vector<UINT>& visibleRitems) const;
+
+	std::vector<UINT> _Ritems;
+
+	std::vector<float> _CenterX;
+	std::vector<float> _CenterY;
+	std::vector<float> _CenterZ;
+	std::vector<float> _ExtentX;
+	std::vector<float> _ExtentY;
+	std::vector<float> _ExtentZ;
+
+	// store versions the arrays were copied at
+	UINT64 _LayoutVersion = UINT64_MAX;
+	UINT64 _BoundsVersion = UINT64_MAX;
+};
+
+#endif /* _FRUSTUM_CULLER_H_ */
@@ -15,15 +15,40 @@ public:
 	float DeltaTime();
 	float TotalTime();
 
+	// Raw timestamps of the high resolution clock, for profiling.
+	static INT64 Ticks()
+	{
+#ifdef _WIN32
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+		return counter.QuadPart;
+#else
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (INT64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+	}
+
+	static INT64 TicksPerSecond()
+	{
+#ifdef _WIN32
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		return frequency.QuadPart;
+#else
+		return 1000000000;
+#endif
+	}
+
 private:
 	double _secondsPerCount;
 	double _deltaTime;
 
-	__int64 _baseTime;
-	__int64 _prevTime;
-	__int64 _stopTime;
-	__int64 _pausedTime;
-	__int64 _currTime;
+	INT64 _baseTime;
+	INT64 _prevTime;
+	INT64 _stopTime;
+	INT64 _pausedTime;
+	INT64 _currTime;
 
 	bool _stopped;
 };
@@ -0,0 +1,71 @@
+#ifndef _GEOMETRY_BUFFER_H_
+#define _GEOMETRY_BUFFER_H_
+
+#include <HeapAllocator.h>
+#include <ResourceHeaps.h>
+#include <UploadManager.h>
+
+// One default heap buffer the vertices and indices of all small meshes are
+// sub-allocated from, so they share a resource instead of each taking a
+// 64 KB placement of its own. Released ranges are reused once the frames
+// that may still read them have completed.
+class GeometryBuffer
+{
+public:
+	// A mesh range: Resource is the shared buffer, or a buffer of its own if
+	// the data did not fit, in which case Handle is InvalidHandle and
+	// Placement is where the buffer was placed.
+	struct Range
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		UINT64 Offset = 0;
+		UINT Handle = HeapAllocator::InvalidHandle;
+		HeapPlacement Placement;
+	};
+
+	// Called for every range Defragment() moved, with its new offset. Returns
+	// the data to upload there, the CPU copy the range was filled from.
+	typedef std::function<const void*(UINT handle, UINT64 offset)> MoveCallback;
+
+	GeometryBuffer(ResourceHeaps& heaps, UploadManager& uploads, UINT64 capacity);
+	GeometryBuffer(const GeometryBuffer& rhs) = delete;
+	GeometryBuffer& operator=(const GeometryBuffer& rhs) = delete;
+
+	// Releases ranges retired by the frames up to completedFence; later
+	// releases wait for frameFence.
+	void BeginFrame(UINT64 frameFence, UINT64 completedFence);
+
+	Range Upload(const void* data, UINT64 byteSize, UINT64 alignment);
+	void Release(const Range& range);
+
+	// Uploads the CPU copies of a packed mesh, see MeshPacker::Pack.
+	void Upload(MeshGeometry& geo);
+
+	// Releases both ranges of an uploaded mesh and clears its GPU buffers.
+	void Release(MeshGeometry& geo);
+
+	// Moves up to maxMoves ranges towards the start of the buffer. The data is
+	// uploaded again from the callback, the old places are released with the frame.
+	UINT Defragment(UINT maxMoves, const MoveCallback& moved);
+
+	float Fragmentation() const { return _Allocator.Fragmentation(); }
+	UINT64 UsedBytes() const { return _Allocator.UsedBytes(); }
+	UINT64 Capacity() const { return _Allocator.Capacity(); }
+
+protected:
+	struct Retired
+	{
+		UINT64 Fence;
+		UINT Handle;
+	};
+
+	UploadManager& _Uploads;
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> _Buffer;
+	HeapAllocator _Allocator;
+
+	UINT64 _FrameFence = 0;
+	std::deque<Retired> _Retired;
+};
+
+#endif /* _GEOMETRY_BUFFER_H_ */
@@ -65,6 +65,45 @@ public:
 	MeshData CreateCylinder(float radius, float height, float alpha, float beta, uint32 sliceCount, uint32 stackCount);
 	MeshData CreateDome(float radius, float angle, uint32 sliceCount, uint32 stackCount);
 	MeshData CreateSector(float radius, float dr, float alpha, float beta, float thick, uint32 sliceCount, uint32 stackCount1, uint32 stackCount2);
+
+	// Level 0 is the requested tessellation, every further level halves the
+	// segment counts. Errors[i] bounds the distance between level i and the
+	// ideal surface, in object space.
+	struct LodChain
+	{
+		std::vector<MeshData> Levels;
+		std::vector<float> Errors;
+	};
+
+	LodChain CreateSphereLods(float radius, uint32 sliceCount, uint32 stackCount, uint32 levelCount);
+	LodChain CreateRingLods(float oradius, float thickness, float alpha, float beta, uint32 sliceCount, uint32 stackCount, uint32 levelCount);
+	LodChain CreateCylinderLods(float radius, float height, float alpha, float beta, uint32 sliceCount, uint32 stackCount, uint32 levelCount);
+	LodChain CreateDomeLods(float radius, float angle, uint32 sliceCount, uint32 stackCount, uint32 levelCount);
+	LodChain CreateSectorLods(float radius, float dr, float alpha, float beta, float thick, uint32 sliceCount, uint32 stackCount1, uint32 stackCount2, uint32 levelCount);
+
+	enum class CacheModel { Fifo, Lru };
+
+	struct CacheStats
+	{
+		float Acmr = 0.0f; // transformed vertices per triangle
+		float Atvr = 0.0f; // transformed vertices per referenced vertex
+	};
+
+	// Post-transform cache simulation of the index order.
+	CacheStats AnalyzeVertexCache(const MeshData& meshData, uint32 cacheSize = 16, CacheModel model = CacheModel::Fifo) const;
+
+	// Reorders the triangles for the post-transform cache (Tipsify), sorts the
+	// resulting clusters so outward facing ones are drawn first to reduce
+	// overdraw, then renumbers the vertices in first use order for fetch
+	// locality. Triangle winding is preserved.
+	void Optimize(MeshData& meshData, uint32 cacheSize = 16);
+
+private:
+	// Largest distance between an arc and the chords of its segments.
+	static float ArcError(float radius, float arc, uint32 segmentCount);
+
+	LodChain CreateLods(uint32 levelCount, uint32 sliceCount, uint32 minSliceCount, uint32 stackCount, uint32 minStackCount,
+		const std::function<MeshData(uint32, uint32)>& create, const std::function<float(uint32, uint32)>& error);
 };
 
 #endif /* _GEOMETRY_GENERATOR_H_ */
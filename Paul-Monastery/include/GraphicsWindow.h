@@ -5,9 +5,28 @@
 #include <MathHelper.h>
 #include <UploadBuffer.h>
 #include <FrameResource.h>
-#include <RenderItem.h>
+#include <RenderItemStore.h>
+#include <JobSystem.h>
+#include <ResourceHeaps.h>
+#include <ShaderResourceHeap.h>
+#include <UploadManager.h>
+#include <GeometryBuffer.h>
+#include <ConstantAllocator.h>
 #include <Monastery.h>
-
+#include <FrustumCuller.h>
+#include <DrawKey.h>
+#include <DrawSubmission.h>
+#include <SoftwareRasterizer.h>
+#include <StreamingTextures.h>
+#include <RenderBackend.h>
+#include <FrameCapture.h>
+#include <FramePacer.h>
+#include <FrameQueue.h>
+#include <FramePipeline.h>
+#include <FrameSnapshot.h>
+#include <DrawChunks.h>
+
+class TextureLoader;
 
 class GraphicsWindow : public AbstractWindow
 {
@@ -20,14 +39,19 @@ public:
 public:
 	void InitDirect3D();
 
-	void Draw();
+	// Simulates the next frame and hands it to the render thread, which
+	// applies it in Render() and draws it with Draw().
 	void Update();
 
+	// Moves a render item from the simulation, with the next frame.
+	void SetWorld(RenderItemHandle item, const DirectX::XMFLOAT4X4& world);
+
 	virtual LRESULT OnCreate(); 
 	virtual LRESULT OnResize();
 	virtual LRESULT OnMouseDown(WPARAM btnState, int x, int y);
 	virtual LRESULT OnMouseUp(WPARAM btnState, int x, int y);
 	virtual LRESULT OnMouseMove(WPARAM btnState, int x, int y);
+	virtual LRESULT OnKeyDown(WPARAM wParam, LPARAM lParam);
 
 	virtual LRESULT OnTimer_Up();
 	virtual LRESULT OnTimer_Down();
@@ -37,10 +61,34 @@ public:
 	virtual LRESULT OnTimer_Zoomout();
 
 protected:
-	UINT _CbvSrvDescriptorSize = 0;
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> _SrvDescriptorHeap = nullptr;
+	// Upload buffers and the frame fence, created through the RenderBackend
+	// interface so the per-frame path also runs on the CommandRecorder.
+	std::unique_ptr<RenderDevice> _RenderDevice;
+	std::unique_ptr<RenderFence> _FrameFence;
+
+	// Picks the frame resource of each frame and how many frames are in
+	// flight, F7 switches between the adaptive and a fixed depth.
+	std::unique_ptr<FrameQueue> _FrameQueue;
+	UINT _FrameQueueDepth = 0;
+
+	// Default heap memory of the buffers and textures, it outlives them all.
+	std::unique_ptr<ResourceHeaps> _ResourceHeaps;
+
+	// Staging memory of all buffer and texture uploads.
+	std::unique_ptr<UploadManager> _Uploads;
+
+	// Vertices and indices of the meshes in _Geometries.
+	std::unique_ptr<GeometryBuffer> _GeometryBuffer;
+
+	// SRVs of all textures; materials select theirs by Texture::SrvIndex.
+	std::unique_ptr<ShaderResourceHeap> _SrvHeap;
 
 	std::unordered_map<std::string, std::unique_ptr<Texture>> _Textures;
+
+	// Which mips of the streamed textures are resident, and the resources holding them.
+	std::unique_ptr<TextureStreamer> _TextureStreamer;
+	std::unique_ptr<StreamingTextures> _StreamingTextures;
+
 	std::unordered_map<std::string, std::unique_ptr<Material>> _Materials;
 
 	Microsoft::WRL::ComPtr<ID3D12RootSignature> _RootSignature = nullptr;
@@ -55,12 +103,53 @@ protected:
 	FrameResource* _CurrFrameResource = nullptr;
 	int _CurrFrameResourceIndex = 0;
 
-	// List of all the render items.
-	std::vector<std::unique_ptr<RenderItem>> _AllRitems;
-	std::vector<RenderItem*> _RitemLayer[(int)RenderLayer::Count];
+	// Lists the job threads record the opaque chunks into, one per thread,
+	// and the list ending the frame after them. Their allocators belong to
+	// the frame resources.
+	std::vector<Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>> _ChunkCommandLists;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> _PostCommandList;
+	std::vector<DrawChunk> _DrawChunks;
+	std::vector<ID3D12CommandList*> _SubmitLists;
+
+	// Constants of the frame being recorded. Object constants are stored in
+	// _DrawKeys order, material constants by MatCBIndex.
+	std::unique_ptr<ConstantAllocator> _Constants;
+	RenderAddress _PassCBAddress = 0;
+	RenderAddress _ObjectCBAddress = 0;
+	RenderAddress _MaterialCBAddress = 0;
+
+	// Materials indexed by MatCBIndex.
+	std::vector<Material*> _MaterialTable;
+
+	// All render items, stored as parallel arrays.
+	RenderItemStore _Ritems;
+
+	// Store indices of each layer that passed frustum culling this frame.
+	FrustumCuller _LayerCullers[(int)RenderLayer::Count];
+	std::vector<UINT> _VisibleRitems[(int)RenderLayer::Count];
+
+	// Visible items of all layers as sorted draw keys; the PSO field indexes _LayerPSOs.
+	std::vector<UINT64> _DrawKeys;
+	std::vector<UINT64> _DrawKeyScratch;
+	ID3D12PipelineState* _LayerPSOs[(int)RenderLayer::Count] = {};
 
 	PassConstants _MainPassCB;
 
+	// Frames left to capture, written to a file by FinishCapture().
+	std::unique_ptr<FrameCapture> _Capture;
+	UINT _CaptureFramesLeft = 0;
+
+	// Frames left to trace, written by FinishTrace().
+	UINT _TraceFramesLeft = 0;
+
+	// Spaces the presents at the selected gFrameRateTargets entry.
+	FramePacer _FramePacer;
+	UINT _FrameRateTarget = 0;
+
+	// CPU reference renderer and the decoded textures of the materials.
+	std::unique_ptr<SoftwareRasterizer> _SoftwareRasterizer;
+	std::unordered_map<const Texture*, SoftwareTexture> _SoftwareTextures;
+
 	DirectX::XMFLOAT3 _EyePos = { 0.0f, 0.0f, 0.0f };
 	DirectX::XMFLOAT4X4 _View = MathHelper::Identity4x4();
 	DirectX::XMFLOAT4X4 _Proj = MathHelper::Identity4x4();
@@ -70,30 +159,66 @@ protected:
 	float _Phi = DirectX::XM_PIDIV2 - 0.5f;
 	float _Radius = 30.0f;
 
+	// Items moved since the last snapshot, simulation thread only.
+	std::vector<SnapshotTransform> _MovedItems;
+
+	// The fixed button held down and where it is drawn when released.
+	RenderItemHandle _PressedButton;
+	DirectX::XMFLOAT4X4 _PressedButtonWorld = MathHelper::Identity4x4();
+
 protected:
 	void UpdateCamera(const GameTimer& gt);
 	void UpdateFixedCamera(const GameTimer& gt);
-	void UpdateObjectCBs(const GameTimer& gt);
-	void UpdateMaterialCBs(const GameTimer& gt);
-	void UpdateMainPassCB(const GameTimer& gt);
+	void UpdateMainPassCB(const GameTimer& gt, PassConstants& pass);
+
+	void Render(const FrameSnapshot& frame);
+	void Draw();
+	void UpdateObjectCBs();
+	void UpdateMaterialCBs();
+	void CullRenderItems(const FrameSnapshot& frame);
+	void RequestTextureMips(const FrameSnapshot& frame);
+	void BuildDrawKeys(const FrameSnapshot& frame);
 	
-	void LoadTextures();
+	void LoadTextures(TextureLoader& loader);
 	void BuildRootSignature();
 	void BuildShadersAndInputLayout();
 	void BuildGeometry();
+	const void* MoveGeometry(UINT handle, UINT64 offset);
 	void BuildMaterials();
 	void BuildDescriptorHeaps();
 	void BuildPSOs();
 	void BuildFrameResources();
+	void BuildCommandLists();
 	void BuildRenderItems();
 	void BuildMonastery();
 
 	void PickFixed(int sx, int sy);
+	void RenderSoftwareFrame(const std::string& filename);
+	void RecordFrames(UINT frameCount);
+	void ScaleMonastery(UINT drawCount);
+	void StartCapture(UINT frameCount);
+	void FinishCapture();
+	void StartTrace(UINT frameCount);
+	void FinishTrace();
+	void NextFrameRateTarget();
+	void NextFrameQueueDepth();
 	
-	void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
+	void SetFrameState(ID3D12GraphicsCommandList* cmdList);
+	void RecordChunks();
+	void RecordFrameCommands(RenderCommandList& cmdList, UINT begin, UINT end);
+	void DrawRenderItems(RenderCommandList& cmdList, const std::vector<UINT64>& drawKeys, UINT begin, UINT end);
 	std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> GetStaticSamplers();
 
 	std::unique_ptr<Monastery> _Monastery;
+
+	// Worker threads for frame update and scene build.
+	std::unique_ptr<JobSystem> _Jobs;
+
+	// Runs Render() on its own thread while Update() simulates the next
+	// frame. The message handlers flush it before touching render state.
+	// Declared last, so the render thread stops before anything it uses
+	// is destroyed; F6 switches to rendering on the calling thread.
+	std::unique_ptr<FramePipeline<FrameSnapshot>> _Pipeline;
 };
 
 #endif /* _GRAPHICS_WINDOW_H_ */
@@ -0,0 +1,104 @@
+#ifndef _HEAP_ALLOCATOR_H_
+#define _HEAP_ALLOCATOR_H_
+
+// Two-level segregated fit (TLSF) allocator over the offsets [0, capacity).
+// Free blocks are kept in lists by size class: the first level is the power
+// of two, the second splits it into 16 ranges, and a bitmap per level finds
+// the smallest non-empty list that fits in constant time. Freed blocks merge
+// with their free neighbours. Only offsets are handed out, the memory itself
+// is a GPU heap or buffer owned by the caller.
+class HeapAllocator
+{
+public:
+	static const UINT InvalidHandle = UINT_MAX;
+
+	// An allocation Defragment() moved. Handle now refers to the new place;
+	// Retired holds the old one until the caller has copied the data and the
+	// GPU is done with it, then it is freed like any other allocation.
+	struct Move
+	{
+		UINT Handle;
+		UINT Retired;
+		UINT64 From;
+		UINT64 To;
+		UINT64 Size;
+	};
+
+	explicit HeapAllocator(UINT64 capacity);
+
+	// Returns InvalidHandle if no free block holds size bytes at the
+	// alignment, a power of two.
+	UINT Allocate(UINT64 size, UINT64 alignment = 1);
+	void Free(UINT handle);
+
+	UINT64 Offset(UINT handle) const { return _Blocks[_Handles[handle]].Offset; }
+	UINT64 Size(UINT handle) const { return _Blocks[_Handles[handle]].Size; }
+
+	// Moves up to maxMoves allocations, highest first, into the lowest free
+	// block below them that holds them.
+	std::vector<Move> Defragment(UINT maxMoves);
+
+	UINT64 Capacity() const { return _Capacity; }
+	UINT64 UsedBytes() const { return _UsedBytes; }
+	UINT AllocationCount() const { return _AllocationCount; }
+	UINT64 LargestFreeBlock() const;
+
+	// Share of the free bytes outside the largest free block, 0 when unfragmented.
+	float Fragmentation() const;
+
+protected:
+	static const UINT SecondLevelBits = 4;
+	static const UINT SecondLevelCount = 1 << SecondLevelBits;
+	static const UINT FirstLevelCount = 64 - SecondLevelBits + 1;
+	static const UINT None = UINT_MAX;
+
+	struct Block
+	{
+		UINT64 Offset = 0;
+		UINT64 Size = 0;
+		UINT64 Alignment = 1;
+
+		// neighbours in address order
+		UINT PrevPhysical = None;
+		UINT NextPhysical = None;
+
+		// neighbours in the free list of the size class
+		UINT PrevFree = None;
+		UINT NextFree = None;
+
+		// None while free
+		UINT Handle = None;
+	};
+
+	static void Mapping(UINT64 size, UINT& fl, UINT& sl);
+
+	UINT FindFree(UINT64 size) const;
+	void InsertFree(UINT block);
+	void RemoveFree(UINT block);
+
+	// Turns [offset, offset + size) of a free block into an allocation.
+	UINT Place(UINT block, UINT64 offset, UINT64 size, UINT64 alignment);
+	UINT SplitFront(UINT block, UINT64 size);
+	void Merge(UINT block, UINT next);
+
+	UINT NewBlock();
+	UINT NewHandle(UINT block);
+	bool Fits(UINT block, UINT64 size, UINT64 alignment) const;
+
+	UINT64 _Capacity;
+	UINT64 _UsedBytes = 0;
+	UINT _AllocationCount = 0;
+
+	std::vector<Block> _Blocks;
+	std::vector<UINT> _UnusedBlocks;
+	UINT _FirstBlock = None;
+
+	std::vector<UINT> _Handles;
+	std::vector<UINT> _UnusedHandles;
+
+	UINT64 _FirstLevelMask = 0;
+	UINT _SecondLevelMasks[FirstLevelCount] = {};
+	UINT _FreeLists[FirstLevelCount][SecondLevelCount];
+};
+
+#endif /* _HEAP_ALLOCATOR_H_ */
@@ -0,0 +1,21 @@
+#ifndef _INSTANCE_GROUPING_H_
+#define _INSTANCE_GROUPING_H_
+
+#include <RenderItemStore.h>
+
+// Collapses render items that draw the same submesh with the same material
+// into instanced items, one per spatial cluster, so a scene built from many
+// copies of a mesh costs a draw per cluster instead of a draw per copy.
+namespace InstanceGrouping
+{
+	// Replaces the non-instanced items of layer that share geometry, submesh
+	// or LOD chain, topology, material, texture density and local bounds, and
+	// whose world bounds are centered in the same clusterSize cube, by one
+	// RenderLayer::Instanced item each; groups of fewer than minInstances items
+	// are left alone. materialTable maps the store's material IDs back to the
+	// materials. Returns the number of instanced items added.
+	UINT Group(RenderItemStore& ritems, RenderLayer layer, const std::vector<Material*>& materialTable,
+		float clusterSize, UINT minInstances);
+}
+
+#endif /* _INSTANCE_GROUPING_H_ */
@@ -0,0 +1,104 @@
+#ifndef _JOB_SYSTEM_H_
+#define _JOB_SYSTEM_H_
+
+// Counts the unfinished jobs of a group. Jobs queued with a counter as their
+// dependency start only after the counter drops to zero. The first exception
+// a job of the group throws is kept and rethrown by JobSystem::Wait() once
+// every job of the group has finished.
+class JobCounter
+{
+public:
+	JobCounter() = default;
+	JobCounter(const JobCounter& rhs) = delete;
+	JobCounter& operator=(const JobCounter& rhs) = delete;
+
+	bool IsDone() const { return _Pending.load() == 0; }
+
+protected:
+	friend class JobSystem;
+
+	struct Continuation
+	{
+		std::function<void()> Func;
+		JobCounter* Counter;
+	};
+
+	std::atomic<int> _Pending{ 0 };
+
+	std::mutex _Mutex;
+	std::vector<Continuation> _Continuations;
+	std::exception_ptr _Error;
+};
+
+// Work-stealing scheduler. Every worker thread (and the thread that created
+// the system) owns a deque: it pushes and pops its own jobs at the back, and
+// idle workers steal from the front of the other deques. Waiting threads
+// execute jobs instead of blocking, so jobs may wait on jobs they spawn.
+// Other long-lived threads that queue jobs, like a render thread, attach to
+// deques kept for them.
+class JobSystem
+{
+public:
+	// 0 uses one worker per hardware thread besides the calling thread;
+	// attachedCount deques are kept for AttachThread().
+	explicit JobSystem(UINT workerCount = 0, UINT attachedCount = 0);
+	JobSystem(const JobSystem& rhs) = delete;
+	JobSystem& operator=(const JobSystem& rhs) = delete;
+	~JobSystem();
+
+	// Threads that execute jobs, including the owning and attached threads.
+	UINT ThreadCount() const { return (UINT)_Queues.size(); }
+
+	// The calling thread's index below ThreadCount(); threads neither in the
+	// system nor attached share 0 with the owning thread.
+	UINT ThreadIndex() const { return QueueIndex(); }
+
+	// Gives the calling thread the deque kept for slot below attachedCount,
+	// and so an index of its own. One thread at a time may hold a slot.
+	void AttachThread(UINT slot);
+
+	// A job without a counter has nobody to report to and must not throw.
+	void Run(std::function<void()> func, JobCounter* counter = nullptr);
+
+	// Queues func once dependency is done, also when one of its jobs threw.
+	void RunAfter(JobCounter& dependency, std::function<void()> func, JobCounter* counter = nullptr);
+
+	// Rethrows the first exception of the counter's jobs, once all are done.
+	void Wait(JobCounter& counter);
+
+	// Calls func(begin, end) over [0, count) in chunks of at most grainSize and
+	// waits. Every chunk has finished before the first exception is rethrown.
+	void ParallelFor(UINT count, UINT grainSize, const std::function<void(UINT, UINT)>& func);
+
+protected:
+	struct Job
+	{
+		std::function<void()> Func;
+		JobCounter* Counter = nullptr;
+	};
+
+	struct WorkerQueue
+	{
+		std::mutex Mutex;
+		std::deque<Job> Jobs;
+	};
+
+	UINT QueueIndex() const;
+	void Push(Job job);
+	bool Pop(UINT queueIndex, Job& job);
+	bool Steal(UINT queueIndex, Job& job);
+	bool RunOne(UINT queueIndex);
+	void Execute(Job& job);
+	void WorkerLoop(UINT queueIndex);
+
+	std::vector<std::unique_ptr<WorkerQueue>> _Queues;
+	std::vector<std::thread> _Workers;
+	UINT _AttachedCount = 0;
+
+	std::atomic<int> _QueuedJobs{ 0 };
+	std::atomic<bool> _Quit{ false };
+	std::mutex _WakeMutex;
+	std::condition_variable _WakeCondition;
+};
+
+#endif /* _JOB_SYSTEM_H_ */
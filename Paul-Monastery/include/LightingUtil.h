@@ -0,0 +1,37 @@
+#ifndef _LIGHTING_UTIL_H_
+#define _LIGHTING_UTIL_H_
+
+// CPU port of Shaders/LightingUtil.hlsl for the software rasterizer.
+// Vectors are DirectXMath registers, w is ignored.
+namespace LightingUtil
+{
+	struct SurfaceMaterial
+	{
+		DirectX::XMVECTOR DiffuseAlbedo;
+		DirectX::XMVECTOR FresnelR0;
+		float Shininess;
+	};
+
+	float CalcAttenuation(float d, float falloffStart, float falloffEnd);
+
+	DirectX::XMVECTOR SchlickFresnel(DirectX::FXMVECTOR R0, DirectX::FXMVECTOR normal, DirectX::FXMVECTOR lightVec);
+
+	DirectX::XMVECTOR BlinnPhong(DirectX::FXMVECTOR lightStrength, DirectX::FXMVECTOR lightVec,
+		DirectX::FXMVECTOR normal, DirectX::GXMVECTOR toEye, const SurfaceMaterial& mat);
+
+	DirectX::XMVECTOR ComputeDirectionalLight(const Light& L, const SurfaceMaterial& mat,
+		DirectX::FXMVECTOR normal, DirectX::FXMVECTOR toEye);
+
+	DirectX::XMVECTOR ComputePointLight(const Light& L, const SurfaceMaterial& mat,
+		DirectX::FXMVECTOR pos, DirectX::FXMVECTOR normal, DirectX::FXMVECTOR toEye);
+
+	DirectX::XMVECTOR ComputeSpotLight(const Light& L, const SurfaceMaterial& mat,
+		DirectX::FXMVECTOR pos, DirectX::FXMVECTOR normal, DirectX::FXMVECTOR toEye);
+
+	// Same light layout as Common.hlsl: directional, then point, then spot lights.
+	DirectX::XMVECTOR ComputeLighting(const Light lights[MaxLights], const SurfaceMaterial& mat,
+		DirectX::FXMVECTOR pos, DirectX::FXMVECTOR normal, DirectX::FXMVECTOR toEye,
+		UINT numDirLights = 3, UINT numPointLights = 0, UINT numSpotLights = 0);
+}
+
+#endif /* _LIGHTING_UTIL_H_ */
@@ -0,0 +1,37 @@
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+// Read-only mapping of a whole file. Nothing is copied: pages are read from
+// the file cache on first access and shared with it, so parsers can point
+// straight into Data(). Uses a file mapping on Windows and mmap elsewhere.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile& rhs) = delete;
+	MappedFile& operator=(const MappedFile& rhs) = delete;
+	MappedFile(MappedFile&& rhs) noexcept;
+	MappedFile& operator=(MappedFile&& rhs) noexcept;
+	~MappedFile();
+
+	// On failure GetLastError (errno elsewhere) tells why.
+	bool Open(const wchar_t* fileName);
+	void Close();
+
+	bool IsOpen() const { return _Data != nullptr; }
+	const std::uint8_t* Data() const { return _Data; }
+	std::uint64_t Size() const { return _Size; }
+
+protected:
+	const std::uint8_t* _Data = nullptr;
+	std::uint64_t _Size = 0;
+
+#ifdef _WIN32
+	HANDLE _File = INVALID_HANDLE_VALUE;
+	HANDLE _Mapping = nullptr;
+#else
+	int _File = -1;
+#endif
+};
+
+#endif /* _MAPPED_FILE_H_ */
@@ -0,0 +1,48 @@
+#ifndef _MESH_PACKER_H_
+#define _MESH_PACKER_H_
+
+// Packs generated meshes into one MeshGeometry. Submeshes are only referenced
+// until Pack(), which sizes the CPU blobs exactly once and converts the
+// generator vertices and indices straight into them, filling in the submesh
+// offsets and bounds on the way. GeometryBuffer::Upload puts them on the GPU.
+class MeshPacker
+{
+public:
+	// mesh must stay alive until Pack() returns.
+	void Add(const std::string& name, const GeometryGenerator::MeshData& mesh, float geometricError = 0.0f);
+
+	// Adds the levels as name, name_lod1, name_lod2, ...
+	void AddLods(const std::string& name, const GeometryGenerator::LodChain& lods);
+
+	// The levels AddLods stored under name, finest first.
+	static std::vector<SubmeshGeometry> LodLevels(const MeshGeometry& geo, const std::string& name);
+
+	UINT VertexCount() const { return _VertexCount; }
+	UINT IndexCount() const { return _IndexCount; }
+
+	// 16-bit indices unless a submesh has more vertices than they can address.
+	std::unique_ptr<MeshGeometry> Pack(const std::string& geoName) const;
+
+protected:
+	static std::string LodName(const std::string& name, UINT level);
+
+	struct Entry
+	{
+		std::string Name;
+		const GeometryGenerator::MeshData* Mesh;
+		float GeometricError;
+	};
+
+	template <typename T>
+	static void WriteIndices(const GeometryGenerator::MeshData& mesh, T* dst);
+
+	static DirectX::BoundingBox WriteVertices(const GeometryGenerator::MeshData& mesh, Vertex* dst);
+	static float UvDensity(const GeometryGenerator::MeshData& mesh);
+
+	std::vector<Entry> _Submeshes;
+	UINT _VertexCount = 0;
+	UINT _IndexCount = 0;
+	UINT _MaxSubmeshVertexCount = 0;
+};
+
+#endif /* _MESH_PACKER_H_ */
@@ -8,14 +8,12 @@ class Monastery
 public:
 	Monastery();
 
-	void BuildGeometry(ID3D12Device* devicePtr,
-		ID3D12GraphicsCommandList* commandListPtr,
-		std::unordered_map<std::string, std::unique_ptr<MeshGeometry>>& geometries);
+	void BuildGeometry(std::unordered_map<std::string, std::unique_ptr<MeshGeometry>>& geometries,
+		JobSystem& jobs);
 
 	void BuildRenderItems(std::unordered_map<std::string, std::unique_ptr<MeshGeometry>>& geometries,
 		std::unordered_map<std::string, std::unique_ptr<Material>>& materials,
-		std::vector<std::unique_ptr<RenderItem>>& allRitems,
-		std::vector<RenderItem*>& opaqueRenderItems);
+		RenderItemStore& ritems);
 
 protected:
 	std::unique_ptr<Church> _Church;
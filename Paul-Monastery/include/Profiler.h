@@ -0,0 +1,171 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <GameTimer.h>
+
+// Scoped CPU profiler. A ProfileZone stamps GameTimer::Ticks() when it is
+// created and destroyed and pushes the pair to a ring owned by its thread;
+// nothing is shared between threads on that path. Collect(), called once a
+// frame, drains the rings into a rolling window of durations per zone and,
+// while tracing, into events written as Chrome trace JSON
+// (chrome://tracing, ui.perfetto.dev).
+//
+// A zone costs two clock reads and about 15 ns of bookkeeping. The target
+// was 20 ns per zone; it is missed wherever a clock read costs more than a
+// few ns: 76-90 ns per zone on a Linux VM reading the clock in ~35 ns
+// (tests/ProfilerBenchmark.cpp). Keep zones off per-item loops.
+
+struct ProfileEvent
+{
+	const char* Name;
+	INT64 Start;
+	INT64 End;
+	UINT Depth;
+	UINT Thread;
+};
+
+// One producer, one consumer. A full ring drops events instead of waiting.
+class ProfileRing
+{
+public:
+	static const UINT Capacity = 1 << 14;
+
+	bool Push(const ProfileEvent& e)
+	{
+		UINT64 head = _Head.load(std::memory_order_relaxed);
+		if (head - _Tail.load(std::memory_order_acquire) >= Capacity)
+		{
+			_Dropped.store(_Dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		_Events[head & (Capacity - 1)] = e;
+		_Head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	template <typename F>
+	void Drain(F&& f)
+	{
+		UINT64 tail = _Tail.load(std::memory_order_relaxed);
+		UINT64 head = _Head.load(std::memory_order_acquire);
+
+		for (; tail != head; ++tail)
+			f(_Events[tail & (Capacity - 1)]);
+
+		_Tail.store(tail, std::memory_order_release);
+	}
+
+	UINT64 Dropped() const { return _Dropped.load(std::memory_order_relaxed); }
+
+protected:
+	alignas(64) std::atomic<UINT64> _Head{ 0 };
+	alignas(64) std::atomic<UINT64> _Tail{ 0 };
+	std::atomic<UINT64> _Dropped{ 0 };
+	ProfileEvent _Events[Capacity];
+};
+
+// Mean and percentiles of the last Window durations of a zone in
+// microseconds; Count is every sample since the start.
+struct ProfileZoneStats
+{
+	const char* Name;
+	UINT64 Count;
+	double Mean;
+	double P50;
+	double P95;
+	double P99;
+};
+
+class Profiler
+{
+public:
+	struct Thread
+	{
+		ProfileRing Ring;
+		UINT Id = 0;
+		UINT Depth = 0;
+	};
+
+	// durations kept per zone for the percentiles
+	static const UINT Window = 512;
+
+	static Profiler& Get();
+
+	// The calling thread's ring, registered on first use.
+	static Thread& CurrentThread()
+	{
+		static thread_local Thread* thread = nullptr;
+		if (thread == nullptr)
+			thread = Get().RegisterThread();
+		return *thread;
+	}
+
+	// Moves the events of all threads into the zone statistics and the trace.
+	void Collect();
+
+	// Events collected between the two calls go to the trace.
+	void StartTrace();
+	void StopTrace();
+	bool WriteTrace(const std::string& filename) const;
+
+	std::vector<ProfileZoneStats> Summary() const;
+
+	// Events lost to full rings since the start.
+	UINT64 Dropped() const;
+
+protected:
+	Profiler() : _TicksPerSecond(GameTimer::TicksPerSecond()) {}
+
+	Thread* RegisterThread();
+
+	struct Zone
+	{
+		std::vector<INT64> Durations;
+		UINT Next = 0;
+		UINT64 Count = 0;
+	};
+
+	mutable std::mutex _Mutex;
+	std::vector<std::unique_ptr<Thread>> _Threads;
+
+	std::unordered_map<const char*, Zone> _Zones;
+
+	INT64 _TicksPerSecond;
+	bool _Tracing = false;
+	std::vector<ProfileEvent> _Trace;
+};
+
+class ProfileZone
+{
+public:
+	explicit ProfileZone(const char* name) : _Name(name), _Thread(Profiler::CurrentThread())
+	{
+		_Depth = _Thread.Depth++;
+		_Start = GameTimer::Ticks();
+	}
+
+	ProfileZone(const ProfileZone& rhs) = delete;
+	ProfileZone& operator=(const ProfileZone& rhs) = delete;
+
+	~ProfileZone()
+	{
+		INT64 end = GameTimer::Ticks();
+		_Thread.Depth--;
+		_Thread.Ring.Push({ _Name, _Start, end, _Depth, _Thread.Id });
+	}
+
+protected:
+	const char* _Name;
+	Profiler::Thread& _Thread;
+	UINT _Depth;
+	INT64 _Start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+// Times the rest of the enclosing scope; name must be a string literal.
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(_ProfileZone, __LINE__)(name)
+
+#endif /* _PROFILER_H_ */
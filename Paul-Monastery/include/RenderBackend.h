@@ -0,0 +1,84 @@
+#ifndef _RENDER_BACKEND_H_
+#define _RENDER_BACKEND_H_
+
+// The part of the graphics API the per-frame path records through: mapped
+// upload buffers, a fence and the draw-time command list calls. D3D12Backend
+// implements it on the device; CommandRecorder implements it in memory, so
+// the frame path runs and can be measured without a GPU. Only plain types
+// are used, GPU addresses and descriptor handles are the backend's UINT64s.
+
+typedef UINT64 RenderAddress;
+
+enum class RenderIndexFormat : UINT
+{
+	Uint16,
+	Uint32
+};
+
+struct RenderVertexBufferView
+{
+	RenderAddress Address;
+	UINT SizeInBytes;
+	UINT StrideInBytes;
+};
+
+struct RenderIndexBufferView
+{
+	RenderAddress Address;
+	UINT SizeInBytes;
+	RenderIndexFormat Format;
+};
+
+// A persistently mapped buffer the CPU writes and the GPU reads.
+class RenderBuffer
+{
+public:
+	virtual ~RenderBuffer() = default;
+
+	virtual BYTE* Data() const = 0;
+	virtual RenderAddress GpuAddress() const = 0;
+	virtual UINT64 Size() const = 0;
+};
+
+// Signalled by the queue after the commands before it have executed.
+class RenderFence
+{
+public:
+	virtual ~RenderFence() = default;
+
+	virtual UINT64 CompletedValue() const = 0;
+	virtual void Signal(UINT64 value) = 0;
+
+	// Blocks until CompletedValue() >= value.
+	virtual void Wait(UINT64 value) = 0;
+};
+
+class RenderCommandList
+{
+public:
+	virtual ~RenderCommandList() = default;
+
+	// pso indexes the pipeline states the backend was given.
+	virtual void SetPipelineState(UINT pso) = 0;
+	virtual void SetPrimitiveTopology(UINT topology) = 0;
+	virtual void SetVertexBuffer(const RenderVertexBufferView& view) = 0;
+	virtual void SetIndexBuffer(const RenderIndexBufferView& view) = 0;
+
+	virtual void SetGraphicsRootConstantBufferView(UINT parameter, RenderAddress address) = 0;
+	virtual void SetGraphicsRootShaderResourceView(UINT parameter, RenderAddress address) = 0;
+	virtual void SetGraphicsRootDescriptorTable(UINT parameter, RenderAddress descriptor) = 0;
+
+	virtual void DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount,
+		UINT startIndexLocation, INT baseVertexLocation, UINT startInstanceLocation) = 0;
+};
+
+class RenderDevice
+{
+public:
+	virtual ~RenderDevice() = default;
+
+	virtual std::unique_ptr<RenderBuffer> CreateUploadBuffer(UINT64 size) = 0;
+	virtual std::unique_ptr<RenderFence> CreateFence() = 0;
+};
+
+#endif /* _RENDER_BACKEND_H_ */
@@ -1,6 +1,8 @@
 #ifndef _RENDER_ITEM_H_
 #define _RENDER_ITEM_H_
 
+// Describes a render item to be added to a RenderItemStore. The store
+// copies the fields into its own arrays, so a RenderItem can live on the stack.
 struct RenderItem
 {
 	RenderItem() = default;
@@ -8,10 +10,6 @@ struct RenderItem
 	DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
 	DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
 
-	int NumFramesDirty = gNumFrameResources;
-
-	UINT ObjCBIndex = -1;
-
 	MeshGeometry* Geo = nullptr;
 	Material* Mat = nullptr;
 
@@ -23,7 +21,17 @@ struct RenderItem
 	UINT StartIndexLocation = 0;
 	int BaseVertexLocation = 0;
 
-	UINT SkinnedCBIndex = -1;
+	// Optional levels of detail of the submesh, finest first. The store
+	// switches the index arguments between them, see RenderItemStore::SelectLods.
+	std::vector<SubmeshGeometry> Lods;
+
+	// Texture coordinate units per object space unit, see SubmeshGeometry.
+	// Items left at 0 never ask for streamed texture mips.
+	float UvDensity = 0.0f;
+
+	// Instanced items draw every entry of Instances with a single call,
+	// reading the world matrices from the frame's instance buffer.
+	std::vector<InstanceData> Instances;
 };
 
 enum class RenderLayer : int
@@ -31,6 +39,7 @@ enum class RenderLayer : int
 	Sky = 0,
 	Fixed,
 	Opaque,
+	Instanced,
 	Count
 };
 
@@ -0,0 +1,165 @@
+#ifndef _RENDER_ITEM_STORE_H_
+#define _RENDER_ITEM_STORE_H_
+
+#include <RenderItem.h>
+#include <DirtyList.h>
+
+// Stable reference to an item in a RenderItemStore. The generation is bumped
+// when the slot is freed, so handles to removed items are detected.
+struct RenderItemHandle
+{
+	UINT Slot = UINT_MAX;
+	UINT Generation = 0;
+
+	bool operator==(const RenderItemHandle& rhs) const
+	{
+		return Slot == rhs.Slot && Generation == rhs.Generation;
+	}
+
+	bool operator!=(const RenderItemHandle& rhs) const
+	{
+		return !(*this == rhs);
+	}
+};
+
+struct RenderItemDrawArgs
+{
+	MeshGeometry* Geo = nullptr;
+	D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+
+	UINT IndexCount = 0;
+	UINT StartIndexLocation = 0;
+	int BaseVertexLocation = 0;
+
+	// range in Instances(), InstanceCount is 0 for non-instanced items
+	UINT InstanceCount = 0;
+	UINT InstanceOffset = 0;
+};
+
+struct RenderItemLod
+{
+	// range in the store's shared level table, LevelCount is 0 without LODs
+	UINT FirstLevel = 0;
+	UINT LevelCount = 0;
+	UINT Level = 0;
+
+	// largest scale of the world and instance transforms
+	float Scale = 1.0f;
+
+	// texture coordinate units per object space unit, scaled by the TexTransform
+	float UvDensity = 0.0f;
+};
+
+// Data-oriented storage for all render items. Transforms, bounds, draw
+// arguments and material IDs live in separate packed arrays that are indexed
+// by the same dense index. Removing an item moves the last one into the hole,
+// so the arrays never have gaps.
+class RenderItemStore
+{
+public:
+	RenderItemStore() = default;
+
+	void SetFrameResourceCount(int frameResourceCount);
+
+	RenderItemHandle Add(RenderLayer layer, const RenderItem& ritem);
+	void Remove(RenderItemHandle handle);
+
+	// Removes several items and renumbers the layers once.
+	void Remove(const std::vector<RenderItemHandle>& handles);
+
+	bool IsValid(RenderItemHandle handle) const;
+	UINT IndexOf(RenderItemHandle handle) const;
+	RenderItemHandle HandleOf(UINT index) const;
+
+	UINT Size() const { return (UINT)_World.size(); }
+	UINT InstanceCount() const { return (UINT)_Instances.size(); }
+
+	const std::vector<UINT>& Layer(RenderLayer layer) const { return _LayerItems[(int)layer]; }
+
+	void SetWorld(RenderItemHandle handle, const DirectX::XMFLOAT4X4& world);
+
+	// Bumped when items are added or removed, which renumbers the layers, and
+	// when items move. Copies of the layers or bounds compare them to stay current.
+	UINT64 LayoutVersion() const { return _LayoutVersion; }
+	UINT64 BoundsVersion() const { return _BoundsVersion; }
+
+	// Switches every item with LODs to the coarsest level whose geometric error,
+	// seen from eyePosW, covers at most maxPixelError pixels. pixelScale is the
+	// size in pixels of one unit at distance one: 0.5 * screen height * proj(1,1).
+	void SelectLods(const DirectX::XMFLOAT3& eyePosW, float pixelScale, float maxPixelError);
+
+	// Texture coordinate units one pixel covers at the item's nearest point,
+	// with pixelScale as in SelectLods. 0 for items without a UV density.
+	float UvPerPixel(UINT index, const DirectX::XMFLOAT3& eyePosW, float pixelScale) const;
+
+	const std::vector<DirectX::XMFLOAT4X4>& World() const { return _World; }
+	const std::vector<DirectX::XMFLOAT4X4>& TexTransform() const { return _TexTransform; }
+	const std::vector<DirectX::BoundingBox>& Bounds() const { return _Bounds; }
+	const std::vector<DirectX::BoundingBox>& WorldBounds() const { return _WorldBounds; }
+	const std::vector<RenderItemDrawArgs>& DrawArgs() const { return _DrawArgs; }
+	const std::vector<UINT>& MaterialIds() const { return _MaterialIds; }
+	const std::vector<UINT>& GeometryIds() const { return _GeometryIds; }
+	const std::vector<InstanceData>& Instances() const { return _Instances; }
+	const std::vector<RenderItemLod>& Lods() const { return _Lods; }
+
+	// The levels RenderItemLod::FirstLevel and LevelCount point into.
+	const std::vector<SubmeshGeometry>& LodLevels() const { return _LodLevels; }
+
+	// Items whose object constants must be rewritten, per frame resource.
+	void MarkDirty(UINT index) { _DirtyList.MarkDirty(index); }
+	const std::vector<UINT>& DirtyItems(int frameResourceIndex) const { return _DirtyList.DirtyItems(frameResourceIndex); }
+	void ClearDirty(int frameResourceIndex) { _DirtyList.Clear(frameResourceIndex); }
+
+protected:
+	void UpdateWorldBounds(UINT index);
+	void UpdateLodScale(UINT index);
+	float NearestDistance(UINT index, DirectX::FXMVECTOR eyePosW) const;
+	void RemoveItem(RenderItemHandle handle);
+	UINT AddLodLevels(const MeshGeometry* geo, const std::vector<SubmeshGeometry>& levels);
+	void RebuildLayers();
+
+	struct Slot
+	{
+		UINT Index = UINT_MAX;
+		UINT Generation = 0;
+	};
+
+	std::vector<Slot> _Slots;
+	std::vector<UINT> _FreeSlots;
+
+	std::vector<DirectX::XMFLOAT4X4> _World;
+	std::vector<DirectX::XMFLOAT4X4> _TexTransform;
+	std::vector<DirectX::BoundingBox> _Bounds;
+	std::vector<DirectX::BoundingBox> _WorldBounds;
+	std::vector<RenderItemDrawArgs> _DrawArgs;
+	std::vector<UINT> _MaterialIds;
+	std::vector<UINT> _GeometryIds;
+	std::vector<RenderLayer> _Layers;
+	std::vector<UINT> _SlotOf;
+	std::vector<RenderItemLod> _Lods;
+
+	std::vector<InstanceData> _Instances;
+
+	// items with the same submesh share their levels
+	struct LodChain
+	{
+		const MeshGeometry* Geo;
+		UINT FirstLevel;
+		UINT LevelCount;
+	};
+
+	std::vector<SubmeshGeometry> _LodLevels;
+	std::vector<LodChain> _LodChains;
+
+	// small dense IDs for draw sorting, assigned on first use
+	std::unordered_map<const MeshGeometry*, UINT> _GeometryIdOf;
+
+	std::vector<UINT> _LayerItems[(int)RenderLayer::Count];
+
+	DirtyList _DirtyList;
+
+	UINT64 _LayoutVersion = 0;
+	UINT64 _BoundsVersion = 0;
+};
+
+#endif /* _RENDER_ITEM_STORE_H_ */
@@ -0,0 +1,50 @@
+#ifndef _RESOURCE_HEAPS_H_
+#define _RESOURCE_HEAPS_H_
+
+#include <HeapAllocator.h>
+
+// Where a placed resource lives; Heap is None for committed resources.
+struct HeapPlacement
+{
+	static const UINT None = UINT_MAX;
+
+	UINT Heap = None;
+	UINT Handle = HeapAllocator::InvalidHandle;
+};
+
+// Places default heap resources in large ID3D12Heaps instead of giving each
+// its own committed allocation. Buffers and textures come from separate heaps,
+// as resource heap tier 1 requires, and textures small enough use the 4 KB
+// placement alignment. New heaps are created when the existing ones are full;
+// resources larger than a heap are committed.
+class ResourceHeaps
+{
+public:
+	ResourceHeaps(ID3D12Device* device, UINT64 heapSize);
+	ResourceHeaps(const ResourceHeaps& rhs) = delete;
+	ResourceHeaps& operator=(const ResourceHeaps& rhs) = delete;
+
+	HRESULT CreateResource(const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState,
+		Microsoft::WRL::ComPtr<ID3D12Resource>& resource, HeapPlacement& placement);
+
+	// The resource must be released and the GPU done with it.
+	void Free(const HeapPlacement& placement);
+
+	UINT HeapCount() const { return (UINT)_Heaps.size(); }
+	UINT64 UsedBytes() const;
+	UINT64 ReservedBytes() const { return _HeapSize * _Heaps.size(); }
+
+protected:
+	struct Heap
+	{
+		Microsoft::WRL::ComPtr<ID3D12Heap> Memory;
+		D3D12_HEAP_FLAGS Flags;
+		std::unique_ptr<HeapAllocator> Allocator;
+	};
+
+	ID3D12Device* _Device;
+	UINT64 _HeapSize;
+	std::vector<Heap> _Heaps;
+};
+
+#endif /* _RESOURCE_HEAPS_H_ */
@@ -0,0 +1,31 @@
+#ifndef _SCENE_MATERIALS_H_
+#define _SCENE_MATERIALS_H_
+
+// The textures and materials of the monastery scene, shared by GraphicsWindow
+// and the headless renderer in tools/SceneRender.
+class SceneMaterials
+{
+public:
+	SceneMaterials() = delete;
+	~SceneMaterials() = delete;
+
+	struct TextureFile
+	{
+		std::string Name;
+		std::wstring Filename;
+
+		// the scene textures stream their mips, the sky and the buttons stay whole
+		bool Streamed;
+	};
+
+	// directory ends with a path separator.
+	static std::vector<TextureFile> TextureFiles(const std::wstring& directory);
+
+	// textures holds every texture of TextureFiles by name. Render items refer
+	// to materials by MatCBIndex, materialTable maps it back.
+	static void BuildMaterials(std::unordered_map<std::string, std::unique_ptr<Texture>>& textures,
+		std::unordered_map<std::string, std::unique_ptr<Material>>& materials,
+		std::vector<Material*>& materialTable);
+};
+
+#endif /* _SCENE_MATERIALS_H_ */
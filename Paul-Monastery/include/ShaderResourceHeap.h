@@ -0,0 +1,61 @@
+#ifndef _SHADER_RESOURCE_HEAP_H_
+#define _SHADER_RESOURCE_HEAP_H_
+
+#include <DescriptorAllocator.h>
+
+// The shader-visible CBV/SRV/UAV heap, addressed by slot. Views are written
+// to a CPU staging heap of the same layout and copied to the shader-visible
+// heap in one batch by Commit(), so a slot written while frames in flight
+// read others never races them. When the slots run out both heaps are
+// replaced by larger ones; the old shader-visible heap is kept until the
+// frames bound to it have completed.
+class ShaderResourceHeap
+{
+public:
+	ShaderResourceHeap(ID3D12Device* device, UINT capacity);
+	ShaderResourceHeap(const ShaderResourceHeap& rhs) = delete;
+	ShaderResourceHeap& operator=(const ShaderResourceHeap& rhs) = delete;
+
+	// Slots released later wait for frameFence, those of frames up to
+	// completedFence are reused.
+	void BeginFrame(UINT64 frameFence, UINT64 completedFence);
+
+	UINT CreateSrv(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC& desc);
+	void Release(UINT slot);
+
+	// Copies the views created since the last call; binds may change the heap.
+	void Commit();
+
+	ID3D12DescriptorHeap* Heap() const { return _Heap.Get(); }
+	D3D12_GPU_DESCRIPTOR_HANDLE GpuHandle(UINT slot) const;
+
+	UINT Capacity() const { return _Allocator.Capacity(); }
+	UINT UsedCount() const { return _Allocator.UsedCount(); }
+
+protected:
+	struct Retired
+	{
+		UINT64 Fence;
+		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> Heap;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CreateHeap(UINT capacity, bool shaderVisible);
+	void GrowStaging();
+
+	ID3D12Device* _Device;
+	UINT _DescriptorSize;
+	DescriptorAllocator _Allocator;
+
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> _Staging;
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> _Heap;
+	UINT _StagingCapacity = 0;
+	UINT _HeapCapacity = 0;
+
+	// slots written to the staging heap since the last Commit()
+	std::vector<UINT> _Dirty;
+
+	UINT64 _FrameFence = 0;
+	std::deque<Retired> _Retired;
+};
+
+#endif /* _SHADER_RESOURCE_HEAP_H_ */
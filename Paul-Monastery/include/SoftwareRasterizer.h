@@ -0,0 +1,109 @@
+#ifndef _SOFTWARE_RASTERIZER_H_
+#define _SOFTWARE_RASTERIZER_H_
+
+#include <FrameResource.h>
+#include <RenderItemStore.h>
+#include <JobSystem.h>
+
+// Mip 0 of a texture, decoded to linear RGBA floats.
+struct SoftwareTexture
+{
+	UINT Width = 0;
+	UINT Height = 0;
+	std::vector<DirectX::XMFLOAT4> Texels;
+
+	// Loads uncompressed 32-bit DDS files (legacy RGBA masks or DX10 R8G8B8A8/B8G8R8A8).
+	bool LoadDDS(const std::wstring& filename);
+
+	// Bilinear sample with wrap addressing.
+	DirectX::XMVECTOR Sample(float u, float v) const;
+};
+
+// Renders the scene on the CPU from the same data the D3D12 path uses: the
+// MeshGeometry CPU blobs, the render item store, the sorted draw keys, the
+// materials and the pass constants. The screen is split into tiles; triangles
+// are binned per tile and the tiles are rasterized as jobs, each tile owning
+// its part of the color and depth buffers.
+class SoftwareRasterizer
+{
+public:
+	explicit SoftwareRasterizer(JobSystem& jobs) : _Jobs(jobs) {}
+
+	void Resize(UINT width, UINT height);
+
+	// passCB is the buffer as uploaded to the GPU (transposed matrices).
+	// textures holds the decoded Material::DiffuseMap of every material.
+	void Render(const RenderItemStore& ritems, const std::vector<UINT64>& drawKeys,
+		const std::vector<Material*>& materials, const std::unordered_map<const Texture*, SoftwareTexture>& textures,
+		const PassConstants& passCB);
+
+	// Binary PPM (P6) of the last rendered frame.
+	bool WritePPM(const std::string& filename) const;
+
+	UINT Width() const { return _Width; }
+	UINT Height() const { return _Height; }
+	const std::vector<std::uint32_t>& ColorBuffer() const { return _Color; }
+
+protected:
+	static const UINT TileSize = 64;
+
+	struct ClipVertex
+	{
+		DirectX::XMFLOAT4 PosH;
+		DirectX::XMFLOAT3 PosW;
+		DirectX::XMFLOAT3 NormalW;
+		DirectX::XMFLOAT2 TexC;
+	};
+
+	struct RasterVertex
+	{
+		float X, Y, Z, InvW;
+		DirectX::XMFLOAT3 PosW;
+		DirectX::XMFLOAT3 NormalW;
+		DirectX::XMFLOAT2 TexC;
+	};
+
+	struct RasterTriangle
+	{
+		RasterVertex V[3];
+		UINT Layer;
+		UINT MaterialId;
+		int MinX, MinY, MaxX, MaxY;
+	};
+
+	struct DrawContext
+	{
+		const RenderItemStore* Ritems;
+		const std::vector<Material*>* Materials;
+		const std::unordered_map<const Texture*, SoftwareTexture>* Textures;
+
+		DirectX::XMFLOAT4X4 ViewProj;
+		DirectX::XMFLOAT4X4 FixedViewProj;
+		DirectX::XMFLOAT3 EyePosW;
+		DirectX::XMFLOAT4 AmbientLight;
+		const Light* Lights;
+	};
+
+	void RunParallel(UINT count, const std::function<void(UINT)>& func) const;
+
+	void ProcessDraw(const DrawContext& ctx, UINT64 key, std::vector<RasterTriangle>& triangles) const;
+	void SetupTriangle(const ClipVertex* v, UINT layer, UINT materialId, std::vector<RasterTriangle>& triangles) const;
+	void RasterizeTile(const DrawContext& ctx, UINT tile);
+	DirectX::XMVECTOR ShadePixel(const DrawContext& ctx, const RasterTriangle& tri, const RasterVertex& v, bool& discard) const;
+
+	UINT _Width = 0;
+	UINT _Height = 0;
+	UINT _TilesX = 0;
+	UINT _TilesY = 0;
+
+	JobSystem& _Jobs;
+
+	std::vector<std::uint32_t> _Color;
+	std::vector<float> _Depth;
+
+	std::vector<std::vector<RasterTriangle>> _DrawTriangles;
+	std::vector<const RasterTriangle*> _Triangles;
+	std::vector<std::vector<UINT>> _TileBins;
+};
+
+#endif /* _SOFTWARE_RASTERIZER_H_ */
@@ -0,0 +1,65 @@
+#ifndef _STREAMING_TEXTURES_H_
+#define _STREAMING_TEXTURES_H_
+
+#include <DDSTextureLoader.h>
+#include <TextureStreamer.h>
+#include <ResourceHeaps.h>
+#include <ShaderResourceHeap.h>
+#include <UploadManager.h>
+
+// D3D12 side of texture streaming. Every streamed texture keeps its DDS file
+// mapped; a residency change places a resource holding just the resident
+// mips in the ResourceHeaps, uploads them from the file and points a fresh
+// descriptor at it, which Texture::SrvIndex follows. The replaced resource
+// and its descriptor are released once the frames that may still use them
+// have completed.
+class StreamingTextures : public TextureStreamingDevice
+{
+public:
+	StreamingTextures(ID3D12Device* device, ResourceHeaps& heaps, ShaderResourceHeap& srvHeap, UploadManager& uploads)
+		: _Device(device), _Heaps(heaps), _SrvHeap(srvHeap), _Uploads(uploads) {}
+	StreamingTextures(const StreamingTextures& rhs) = delete;
+	StreamingTextures& operator=(const StreamingTextures& rhs) = delete;
+
+	// Takes over the parsed file. texture->Resource follows the resident mips.
+	// IDs count up from 0, in the order TextureStreamer::Add() expects.
+	UINT Add(Texture* texture, DirectX::DDSTextureData12&& data);
+
+	UINT TextureCount() const { return (UINT)_Entries.size(); }
+	TextureStreamingDesc Desc(UINT texture) const;
+
+	// ID of a streamed texture, or -1.
+	int Find(const Texture* texture) const;
+
+	// Later changes upload through the UploadManager, in the frame that
+	// completes at frameFence. Everything retired by a frame up to
+	// completedFence is released.
+	void BeginFrame(UINT64 frameFence, UINT64 completedFence);
+
+	bool SetFirstResidentMip(UINT texture, UINT firstMip) override;
+
+protected:
+	struct Entry
+	{
+		Texture* Tex;
+		DirectX::DDSTextureData12 Data;
+	};
+
+	struct Retired
+	{
+		UINT64 Fence;
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		HeapPlacement Placement;
+	};
+
+	ID3D12Device* _Device;
+	ResourceHeaps& _Heaps;
+	ShaderResourceHeap& _SrvHeap;
+	UploadManager& _Uploads;
+	std::vector<std::unique_ptr<Entry>> _Entries;
+
+	UINT64 _FrameFence = 0;
+	std::deque<Retired> _Retired;
+};
+
+#endif /* _STREAMING_TEXTURES_H_ */
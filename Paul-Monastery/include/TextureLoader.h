@@ -0,0 +1,44 @@
+#ifndef _TEXTURE_LOADER_H_
+#define _TEXTURE_LOADER_H_
+
+#include <DDSTextureLoader.h>
+#include <JobSystem.h>
+#include <StreamingTextures.h>
+
+// Loads DDS textures in the background. Queue() maps, parses and validates
+// the file as a job; Finish() waits for the jobs and then creates the
+// resources through the UploadManager on the calling thread, in the order
+// the textures were queued. Streamed textures keep their file mapped and are
+// handed to StreamingTextures instead, which creates their resources.
+class TextureLoader
+{
+public:
+	explicit TextureLoader(JobSystem& jobs) : _Jobs(jobs) {}
+	TextureLoader(const TextureLoader& rhs) = delete;
+	TextureLoader& operator=(const TextureLoader& rhs) = delete;
+	~TextureLoader();
+
+	void Queue(const std::string& name, const std::wstring& filename, bool streamed = false);
+
+	void Finish(UploadManager& uploads,
+		std::unordered_map<std::string, std::unique_ptr<Texture>>& textures,
+		StreamingTextures* streaming = nullptr);
+
+protected:
+	struct Request
+	{
+		std::string Name;
+		std::wstring Filename;
+		bool Streamed = false;
+		DirectX::DDSTextureData12 Data;
+		HRESULT Result = E_PENDING;
+	};
+
+	JobSystem& _Jobs;
+	JobCounter _Pending;
+
+	// the jobs write into the requests, so their addresses must not change
+	std::vector<std::unique_ptr<Request>> _Requests;
+};
+
+#endif /* _TEXTURE_LOADER_H_ */
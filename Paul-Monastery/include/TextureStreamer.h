@@ -0,0 +1,99 @@
+#ifndef _TEXTURE_STREAMER_H_
+#define _TEXTURE_STREAMER_H_
+
+struct TextureStreamingDesc
+{
+	UINT Width = 0;
+	UINT Height = 0;
+
+	// bytes of every mip, all array slices included, finest first
+	std::vector<UINT64> MipBytes;
+
+	// coarsest mip a resource can start at, e.g. the last block-compressed
+	// mip whose size is a multiple of 4; it caps the resident tail
+	UINT MaxFirstMip = UINT_MAX;
+};
+
+// What the streamer needs from the renderer. Kept free of D3D12 so the
+// policy can run against a fake device.
+class TextureStreamingDevice
+{
+public:
+	virtual ~TextureStreamingDevice() = default;
+
+	// Makes mips [firstMip, mip count) of the texture resident and releases
+	// the finer ones. Returns false if the change could not be made; the
+	// streamer then keeps the previous residency.
+	virtual bool SetFirstResidentMip(UINT texture, UINT firstMip) = 0;
+};
+
+// Decides which mips of each texture are resident. Every frame the visible
+// items request the mip their screen-space texel density needs; Update()
+// then loads missing mips a level at a time and, when the budget is full,
+// evicts mips nobody requested, least recently used texture first. The mip
+// tail up to TailSize texels is always resident.
+class TextureStreamer
+{
+public:
+	struct Config
+	{
+		UINT64 BudgetBytes = 64ull * 1024 * 1024;
+
+		// largest mip of the always resident tail
+		UINT TailSize = 32;
+
+		// mip levels loaded per Update(), limits the upload work of a frame
+		UINT MaxLoadsPerUpdate = 4;
+	};
+
+	explicit TextureStreamer(const Config& config) : _Config(config) {}
+	TextureStreamer(const TextureStreamer& rhs) = delete;
+	TextureStreamer& operator=(const TextureStreamer& rhs) = delete;
+
+	// Registers the next texture, IDs count up from 0, and makes its tail resident.
+	UINT Add(const TextureStreamingDesc& desc, TextureStreamingDevice& device);
+
+	// uvPerPixel is how many texture coordinate units one pixel of the item covers.
+	void Request(UINT texture, float uvPerPixel);
+
+	// Applies this frame's requests and starts a new frame.
+	void Update(TextureStreamingDevice& device);
+
+	void SetBudget(UINT64 budgetBytes) { _Config.BudgetBytes = budgetBytes; }
+
+	// Finest mip whose texels are no smaller than a pixel.
+	static UINT MipForDensity(float texelsPerPixel, UINT mipCount);
+
+	UINT TextureCount() const { return (UINT)_Textures.size(); }
+	UINT FirstResidentMip(UINT texture) const { return _Textures[texture].FirstResident; }
+	UINT WantedMip(UINT texture) const { return _Textures[texture].Wanted; }
+	UINT64 ResidentBytes() const { return _ResidentBytes; }
+	UINT64 Budget() const { return _Config.BudgetBytes; }
+
+protected:
+	struct StreamedTexture
+	{
+		TextureStreamingDesc Desc;
+
+		UINT TailMip = 0;
+		UINT FirstResident = 0;
+
+		// finest mip requested this frame, or the tail without requests
+		UINT Wanted = 0;
+		UINT Requested = UINT_MAX;
+		UINT64 LastUsedFrame = 0;
+
+		// FirstResident as the device last saw it
+		UINT Applied = 0;
+	};
+
+	bool Evict(UINT64 bytes, UINT keep, bool excessOnly);
+	void Apply(TextureStreamingDevice& device);
+
+	Config _Config;
+	std::vector<StreamedTexture> _Textures;
+	UINT64 _ResidentBytes = 0;
+	UINT64 _Frame = 1;
+};
+
+#endif /* _TEXTURE_STREAMER_H_ */
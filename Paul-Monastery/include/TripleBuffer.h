@@ -0,0 +1,53 @@
+#ifndef _TRIPLE_BUFFER_H_
+#define _TRIPLE_BUFFER_H_
+
+// Hands values from one producer thread to one consumer thread without
+// locks. The producer fills Back() while the consumer reads Front(); the
+// third slot holds the latest published value. Publish() and Acquire()
+// each swap their slot with that one in a single atomic exchange, so
+// neither side ever waits for the other or sees a half written value.
+template<typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() = default;
+	TripleBuffer(const TripleBuffer& rhs) = delete;
+	TripleBuffer& operator=(const TripleBuffer& rhs) = delete;
+
+	// producer
+	T& Back() { return _Slots[_Back]; }
+
+	void Publish()
+	{
+		UINT latest = _Latest.exchange(_Back | Fresh, std::memory_order_acq_rel);
+		_Back = latest & IndexMask;
+	}
+
+	// consumer; false keeps the previous Front() when nothing new was published
+	bool Acquire()
+	{
+		// only the consumer clears the flag, so it cannot be lost before the exchange
+		if ((_Latest.load(std::memory_order_acquire) & Fresh) == 0)
+			return false;
+
+		UINT latest = _Latest.exchange(_Front, std::memory_order_acq_rel);
+		_Front = latest & IndexMask;
+		return true;
+	}
+
+	const T& Front() const { return _Slots[_Front]; }
+
+	// Whether a published value is still waiting for Acquire(), from either side.
+	bool Pending() const { return (_Latest.load(std::memory_order_acquire) & Fresh) != 0; }
+
+protected:
+	static const UINT IndexMask = 3;
+	static const UINT Fresh = 4;
+
+	T _Slots[3];
+	UINT _Back = 0;
+	UINT _Front = 1;
+	std::atomic<UINT> _Latest{ 2 };
+};
+
+#endif /* _TRIPLE_BUFFER_H_ */
@@ -2,12 +2,14 @@
 #define _UPLOAD_BUFFER_H_
 
 #include <d3dUtil.h>
+#include <RenderBackend.h>
+#include <FrameCapture.h>
 
 template<typename T>
 class UploadBuffer
 {
 public:
-    UploadBuffer(ID3D12Device* device, UINT elementCount, bool isConstantBuffer) :
+    UploadBuffer(RenderDevice& device, UINT elementCount, bool isConstantBuffer) :
         _IsConstantBuffer(isConstantBuffer)
     {
         _ElementByteSize = sizeof(T);
@@ -15,42 +17,43 @@ public:
         if (isConstantBuffer)
             _ElementByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(T));
 
-        ThrowIfFailed(device->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(_ElementByteSize * elementCount),
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&_UploadBuffer)));
-
-        ThrowIfFailed(_UploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&_MappedData)));
+        _UploadBuffer = device.CreateUploadBuffer((UINT64)_ElementByteSize * elementCount);
+        _MappedData = _UploadBuffer->Data();
     }
 
     UploadBuffer(const UploadBuffer& rhs) = delete;
     UploadBuffer& operator=(const UploadBuffer& rhs) = delete;
     ~UploadBuffer()
     {
-        if (_UploadBuffer != nullptr)
-            _UploadBuffer->Unmap(0, nullptr);
-
         _MappedData = nullptr;
     }
 
-    ID3D12Resource* Resource()const
+    RenderAddress GpuAddress()const
     {
-        return _UploadBuffer.Get();
+        return _UploadBuffer->GpuAddress();
     }
 
     void CopyData(int elementIndex, const T& data)
     {
         memcpy(&_MappedData[elementIndex * _ElementByteSize], &data, sizeof(T));
+
+        if (_Capture != nullptr)
+            _Capture->Upload(GpuAddress() + (UINT64)elementIndex * _ElementByteSize, &data, sizeof(T));
+    }
+
+    // Copies also go to capture while it is set.
+    void SetCapture(FrameCapture* capture)
+    {
+        _Capture = capture;
     }
 
 private:
-    Microsoft::WRL::ComPtr<ID3D12Resource> _UploadBuffer;
+    std::unique_ptr<RenderBuffer> _UploadBuffer;
     BYTE* _MappedData = nullptr;
 
     UINT _ElementByteSize = 0;
     bool _IsConstantBuffer = false;
+
+    FrameCapture* _Capture = nullptr;
 };
 #endif /* _UPLOAD_BUFFER_H_ */
@@ -0,0 +1,83 @@
+#ifndef _UPLOAD_MANAGER_H_
+#define _UPLOAD_MANAGER_H_
+
+#include <UploadRing.h>
+
+// Records buffer and texture uploads through one persistently mapped staging
+// buffer. The data is copied into an UploadRing allocation right away, so the
+// source can go away once a call returns; the ring space is reused after the
+// frame that read it has completed. Uploads too large for the ring get a
+// buffer of their own with the same lifetime. The transitions out of
+// COPY_DEST are batched and recorded by Flush(). Resources it creates are
+// placed in the ResourceHeaps; Release() gives their ranges back.
+class UploadManager
+{
+public:
+	UploadManager(ID3D12Device* device, ResourceHeaps& heaps, UINT64 capacity);
+	UploadManager(const UploadManager& rhs) = delete;
+	UploadManager& operator=(const UploadManager& rhs) = delete;
+
+	// Later uploads record into cmdList, whose commands complete at frameFence.
+	// Staging memory of the frames up to completedFence is reused.
+	void BeginFrame(ID3D12GraphicsCommandList* cmdList, UINT64 frameFence, UINT64 completedFence);
+
+	// A default heap buffer holding data, in finalState after Flush(), placed
+	// at placement.
+	Microsoft::WRL::ComPtr<ID3D12Resource> CreateBuffer(const void* data, UINT64 byteSize, HeapPlacement& placement,
+		D3D12_RESOURCE_STATES finalState = D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	// Writes data to [dstOffset, dstOffset + byteSize) of a buffer that is in
+	// COMMON or decays to it at the start of the command list.
+	void UploadBuffer(ID3D12Resource* buffer, UINT64 dstOffset, const void* data, UINT64 byteSize,
+		D3D12_RESOURCE_STATES finalState = D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	// A default heap texture holding all subresources, in finalState after
+	// Flush(), placed at placement.
+	Microsoft::WRL::ComPtr<ID3D12Resource> CreateTexture(const D3D12_RESOURCE_DESC& desc,
+		const D3D12_SUBRESOURCE_DATA* subresources, HeapPlacement& placement,
+		D3D12_RESOURCE_STATES finalState = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+	// Fills all subresources of a texture in COPY_DEST.
+	void UploadTexture(ID3D12Resource* texture, const D3D12_SUBRESOURCE_DATA* subresources,
+		D3D12_RESOURCE_STATES finalState = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+	// Drops a resource created here once the frames up to this one have
+	// completed, then frees its range of the heaps.
+	void Release(Microsoft::WRL::ComPtr<ID3D12Resource> resource, const HeapPlacement& placement);
+
+	// Records the transitions of everything uploaded since the last call.
+	void Flush();
+
+	UINT64 RingCapacity() const { return _Ring.Capacity(); }
+	UINT64 RingUsedBytes() const { return _Ring.UsedBytes(); }
+
+protected:
+	struct Retired
+	{
+		UINT64 Fence;
+		Microsoft::WRL::ComPtr<ID3D12Resource> Buffer;
+		HeapPlacement Placement;
+	};
+
+	// Staging memory for size bytes; buffer and offset locate it for the copy.
+	BYTE* Stage(UINT64 size, UINT64 alignment, ID3D12Resource*& buffer, UINT64& offset);
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> CreateUploadBuffer(UINT64 size, BYTE*& mapped);
+
+	ID3D12Device* _Device;
+	ResourceHeaps& _Heaps;
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> _RingBuffer;
+	BYTE* _RingData = nullptr;
+	UploadRing _Ring;
+
+	ID3D12GraphicsCommandList* _CmdList = nullptr;
+	UINT64 _FrameFence = 0;
+
+	// dedicated buffers of oversized uploads and released resources
+	std::deque<Retired> _Retired;
+
+	std::vector<D3D12_RESOURCE_BARRIER> _Barriers;
+};
+
+#endif /* _UPLOAD_MANAGER_H_ */
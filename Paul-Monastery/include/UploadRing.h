@@ -0,0 +1,39 @@
+#ifndef _UPLOAD_RING_H_
+#define _UPLOAD_RING_H_
+
+// Allocates staging memory from a fixed range in first-in first-out order.
+// Every allocation is tagged with the fence value of the frame whose commands
+// read it; Reclaim() frees the allocations of all completed frames at once.
+// Only offsets are handed out, so the ring runs without a device.
+class UploadRing
+{
+public:
+	explicit UploadRing(UINT64 capacity) : _Capacity(capacity) {}
+
+	// Fails if the free space does not hold size bytes at the alignment, a
+	// power of two; the space in front of a wrap counts as used until the
+	// allocation is reclaimed. Fence values must not decrease.
+	bool Allocate(UINT64 size, UINT64 alignment, UINT64 fence, UINT64& offset);
+
+	// Frees the allocations of all fences up to completedFence.
+	void Reclaim(UINT64 completedFence);
+
+	UINT64 Capacity() const { return _Capacity; }
+	UINT64 UsedBytes() const { return _UsedBytes; }
+
+protected:
+	struct Span
+	{
+		UINT64 Fence;
+		UINT64 Bytes;
+	};
+
+	UINT64 _Capacity;
+	UINT64 _Head = 0;
+	UINT64 _UsedBytes = 0;
+
+	// bytes of each fence still in use, oldest first
+	std::deque<Span> _Spans;
+};
+
+#endif /* _UPLOAD_RING_H_ */
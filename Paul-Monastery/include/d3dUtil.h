@@ -2,9 +2,13 @@
 #define _D3DUTIL_H_
 
 #include <MathHelper.h>
+#ifdef _WIN32
+#include <ResourceHeaps.h>
+#endif
 
-extern const int gNumFrameResources;
-
+// The meshes, materials and lights also build without D3D12, for the
+// software rasterizer elsewhere; the device parts are Windows only.
+#ifdef _WIN32
 inline std::wstring AnsiToWString(const std::string& str)
 {
 	WCHAR buffer[512];
@@ -35,6 +39,7 @@ private:
     if(FAILED(hr__)) { throw DxException(hr__, L#x, wfn, __LINE__); } \
 }
 #endif
+#endif /* _WIN32 */
 
 struct SubmeshGeometry
 {
@@ -43,20 +48,36 @@ struct SubmeshGeometry
 	INT BaseVertexLocation = 0;
 
 	DirectX::BoundingBox Bounds;
+
+	// Largest distance from the surface the submesh approximates, used to pick LODs.
+	float GeometricError = 0.0f;
+
+	// Texture coordinate units per object space unit, used to stream texture mips.
+	float UvDensity = 0.0f;
 };
 
 struct MeshGeometry
 {
 	std::string Name;
 
-	Microsoft::WRL::ComPtr<ID3DBlob> VertexBufferCPU = nullptr;
-	Microsoft::WRL::ComPtr<ID3DBlob> IndexBufferCPU = nullptr;
+	std::vector<BYTE> VertexBufferCPU;
+	std::vector<BYTE> IndexBufferCPU;
 
+#ifdef _WIN32
 	Microsoft::WRL::ComPtr<ID3D12Resource> VertexBufferGPU = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12Resource> IndexBufferGPU = nullptr;
 
-	Microsoft::WRL::ComPtr<ID3D12Resource> VertexBufferUploader = nullptr;
-	Microsoft::WRL::ComPtr<ID3D12Resource> IndexBufferUploader = nullptr;
+	// where buffers of their own were placed, see GeometryBuffer::Release
+	HeapPlacement VertexBufferPlacement;
+	HeapPlacement IndexBufferPlacement;
+#endif
+
+	// where the data starts in the buffers, shared with other meshes when
+	// the handles are valid
+	UINT64 VertexBufferOffset = 0;
+	UINT64 IndexBufferOffset = 0;
+	UINT VertexBufferHandle = UINT_MAX;
+	UINT IndexBufferHandle = UINT_MAX;
 
 	UINT VertexByteStride = 0;
 	UINT VertexBufferByteSize = 0;
@@ -65,10 +86,11 @@ struct MeshGeometry
 
 	std::unordered_map<std::string, SubmeshGeometry> DrawArgs;
 
+#ifdef _WIN32
 	D3D12_VERTEX_BUFFER_VIEW VertexBufferView()const
 	{
 		D3D12_VERTEX_BUFFER_VIEW vbv;
-		vbv.BufferLocation = VertexBufferGPU->GetGPUVirtualAddress();
+		vbv.BufferLocation = VertexBufferGPU->GetGPUVirtualAddress() + VertexBufferOffset;
 		vbv.StrideInBytes = VertexByteStride;
 		vbv.SizeInBytes = VertexBufferByteSize;
 
@@ -78,18 +100,13 @@ struct MeshGeometry
 	D3D12_INDEX_BUFFER_VIEW IndexBufferView()const
 	{
 		D3D12_INDEX_BUFFER_VIEW ibv;
-		ibv.BufferLocation = IndexBufferGPU->GetGPUVirtualAddress();
+		ibv.BufferLocation = IndexBufferGPU->GetGPUVirtualAddress() + IndexBufferOffset;
 		ibv.Format = IndexFormat;
 		ibv.SizeInBytes = IndexBufferByteSize;
 
 		return ibv;
 	}
-
-	void DisposeUploaders()
-	{
-		VertexBufferUploader = nullptr;
-		IndexBufferUploader = nullptr;
-	}
+#endif
 };
 
 struct Light
@@ -111,6 +128,29 @@ struct MaterialConstants
 	float Roughness = 0.25f;
 
 	DirectX::XMFLOAT4X4 MatTransform = MathHelper::Identity4x4();
+
+	// slot of the diffuse map in the shader-visible heap
+	UINT DiffuseMapIndex = 0;
+	UINT MaterialPad0 = 0;
+	UINT MaterialPad1 = 0;
+	UINT MaterialPad2 = 0;
+};
+
+struct Texture
+{
+	std::string Name;
+
+	std::wstring Filename;
+
+#ifdef _WIN32
+	Microsoft::WRL::ComPtr<ID3D12Resource> Resource = nullptr;
+
+	// freed with UploadManager::Release
+	HeapPlacement Placement;
+#endif
+
+	// slot of the SRV in the shader-visible heap, moves with the streamed mips
+	UINT SrvIndex = UINT_MAX;
 };
 
 struct Material
@@ -118,10 +158,7 @@ struct Material
 	std::string Name;
 	
 	int MatCBIndex = -1;
-	int DiffuseSrvHeapIndex = -1;
-	int NormalSrvHeapIndex = -1;
-
-	int NumFramesDirty = gNumFrameResources;
+	Texture* DiffuseMap = nullptr;
 
 	DirectX::XMFLOAT4 DiffuseAlbedo = { 1.0f, 1.0f, 1.0f, 1.0f };
 	DirectX::XMFLOAT3 FresnelR0 = { 0.01f, 0.01f, 0.01f };
@@ -129,16 +166,6 @@ struct Material
 	DirectX::XMFLOAT4X4 MatTransform = MathHelper::Identity4x4();
 };
 
-struct Texture
-{
-	std::string Name;
-
-	std::wstring Filename;
-
-	Microsoft::WRL::ComPtr<ID3D12Resource> Resource = nullptr;
-	Microsoft::WRL::ComPtr<ID3D12Resource> UploadHeap = nullptr;
-};
-
 class d3dUtil
 {
 public:
@@ -147,20 +174,15 @@ public:
 		return (byteSize + 255) & ~255;
 	}
 
+#ifdef _WIN32
 	static Microsoft::WRL::ComPtr<ID3DBlob> LoadBinary(const std::wstring& filename);
 
-	static Microsoft::WRL::ComPtr<ID3D12Resource> CreateDefaultBuffer(
-		ID3D12Device* device,
-		ID3D12GraphicsCommandList* cmdList,
-		const void* initData,
-		UINT64 byteSize,
-		Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer);
-
 	static Microsoft::WRL::ComPtr<ID3DBlob> CompileShader(
 		const std::wstring& filename,
 		const D3D_SHADER_MACRO* defines,
 		const std::string& entrypoint,
 		const std::string& target);
+#endif
 };
 
 #endif /* _D3DUTIL_H_ */
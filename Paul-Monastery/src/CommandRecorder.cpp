@@ -0,0 +1,215 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <CommandRecorder.h>
+
+void RecordingCommandList::SetPipelineState(UINT pso)
+{
+	Op(RecordedOp::SetPipelineState);
+	Write(pso);
+}
+
+void RecordingCommandList::SetPrimitiveTopology(UINT topology)
+{
+	Op(RecordedOp::SetPrimitiveTopology);
+	Write(topology);
+}
+
+void RecordingCommandList::SetVertexBuffer(const RenderVertexBufferView& view)
+{
+	Op(RecordedOp::SetVertexBuffer);
+	Write(view.Address);
+	Write(view.SizeInBytes);
+	Write(view.StrideInBytes);
+}
+
+void RecordingCommandList::SetIndexBuffer(const RenderIndexBufferView& view)
+{
+	Op(RecordedOp::SetIndexBuffer);
+	Write(view.Address);
+	Write(view.SizeInBytes);
+	Write((UINT)view.Format);
+}
+
+void RecordingCommandList::SetGraphicsRootConstantBufferView(UINT parameter, RenderAddress address)
+{
+	Op(RecordedOp::SetGraphicsRootConstantBufferView);
+	Write(address);
+	Write(parameter);
+}
+
+void RecordingCommandList::SetGraphicsRootShaderResourceView(UINT parameter, RenderAddress address)
+{
+	Op(RecordedOp::SetGraphicsRootShaderResourceView);
+	Write(address);
+	Write(parameter);
+}
+
+void RecordingCommandList::SetGraphicsRootDescriptorTable(UINT parameter, RenderAddress descriptor)
+{
+	Op(RecordedOp::SetGraphicsRootDescriptorTable);
+	Write(descriptor);
+	Write(parameter);
+}
+
+void RecordingCommandList::DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount,
+	UINT startIndexLocation, INT baseVertexLocation, UINT startInstanceLocation)
+{
+	Op(RecordedOp::DrawIndexedInstanced);
+	Write(indexCountPerInstance);
+	Write(instanceCount);
+	Write(startIndexLocation);
+
+	// zigzag, small negative offsets stay short
+	Write(((UINT)baseVertexLocation << 1) ^ (UINT)(baseVertexLocation >> 31));
+	Write(startInstanceLocation);
+}
+
+void RecordingCommandList::Reset()
+{
+	_Stream.clear();
+	_CommandCount = 0;
+	for (UINT& count : _OpCounts)
+		count = 0;
+}
+
+void RecordingCommandList::Op(RecordedOp op)
+{
+	_Stream.push_back((BYTE)op);
+	_CommandCount++;
+	_OpCounts[(UINT)op]++;
+}
+
+void RecordingCommandList::Write(UINT64 value)
+{
+	// 7 bits per byte, the high bit marks more to follow
+	while (value >= 0x80)
+	{
+		_Stream.push_back((BYTE)(value | 0x80));
+		value >>= 7;
+	}
+	_Stream.push_back((BYTE)value);
+}
+
+bool CommandReader::Next(RecordedCommand& command)
+{
+	if (_Data >= _End)
+		return false;
+
+	command = RecordedCommand();
+	command.Op = (RecordedOp)*_Data++;
+
+	switch (command.Op)
+	{
+	case RecordedOp::SetPipelineState:
+	case RecordedOp::SetPrimitiveTopology:
+		command.Args[0] = (UINT)Read();
+		break;
+
+	case RecordedOp::SetVertexBuffer:
+	case RecordedOp::SetIndexBuffer:
+		command.Address = Read();
+		command.Args[0] = (UINT)Read();
+		command.Args[1] = (UINT)Read();
+		break;
+
+	case RecordedOp::SetGraphicsRootConstantBufferView:
+	case RecordedOp::SetGraphicsRootShaderResourceView:
+	case RecordedOp::SetGraphicsRootDescriptorTable:
+		command.Address = Read();
+		command.Args[0] = (UINT)Read();
+		break;
+
+	case RecordedOp::DrawIndexedInstanced:
+	{
+		for (UINT i = 0; i < 5; ++i)
+			command.Args[i] = (UINT)Read();
+
+		UINT zigzag = command.Args[3];
+		command.Args[3] = (zigzag >> 1) ^ (0u - (zigzag & 1));
+		break;
+	}
+
+	default:
+		assert(false);
+		_Data = _End;
+		return false;
+	}
+
+	return true;
+}
+
+void CommandReader::Replay(RenderCommandList& cmdList)
+{
+	RecordedCommand c;
+	while (Next(c))
+	{
+		switch (c.Op)
+		{
+		case RecordedOp::SetPipelineState:
+			cmdList.SetPipelineState(c.Args[0]);
+			break;
+		case RecordedOp::SetPrimitiveTopology:
+			cmdList.SetPrimitiveTopology(c.Args[0]);
+			break;
+		case RecordedOp::SetVertexBuffer:
+			cmdList.SetVertexBuffer({ c.Address, c.Args[0], c.Args[1] });
+			break;
+		case RecordedOp::SetIndexBuffer:
+			cmdList.SetIndexBuffer({ c.Address, c.Args[0], (RenderIndexFormat)c.Args[1] });
+			break;
+		case RecordedOp::SetGraphicsRootConstantBufferView:
+			cmdList.SetGraphicsRootConstantBufferView(c.Args[0], c.Address);
+			break;
+		case RecordedOp::SetGraphicsRootShaderResourceView:
+			cmdList.SetGraphicsRootShaderResourceView(c.Args[0], c.Address);
+			break;
+		case RecordedOp::SetGraphicsRootDescriptorTable:
+			cmdList.SetGraphicsRootDescriptorTable(c.Args[0], c.Address);
+			break;
+		case RecordedOp::DrawIndexedInstanced:
+			cmdList.DrawIndexedInstanced(c.Args[0], c.Args[1], c.Args[2], (INT)c.Args[3], c.Args[4]);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+UINT64 CommandReader::Read()
+{
+	UINT64 value = 0;
+	for (UINT shift = 0; _Data < _End; shift += 7)
+	{
+		BYTE b = *_Data++;
+		value |= (UINT64)(b & 0x7f) << shift;
+		if ((b & 0x80) == 0)
+			break;
+	}
+	return value;
+}
+
+void SimulatedFence::Wait(UINT64 value)
+{
+	assert(value <= _Signaled);
+
+	_WaitCount++;
+	Complete(value);
+}
+
+void SimulatedFence::Complete(UINT64 value)
+{
+	_Completed = max(_Completed, min(value, _Signaled));
+}
+
+std::unique_ptr<RenderBuffer> RecordingDevice::CreateUploadBuffer(UINT64 size)
+{
+	auto buffer = std::make_unique<MemoryBuffer>(size, _NextAddress);
+	_NextAddress += (size + 0xffff) & ~(UINT64)0xffff;
+	return buffer;
+}
+
+std::unique_ptr<RenderFence> RecordingDevice::CreateFence()
+{
+	return std::make_unique<SimulatedFence>();
+}
@@ -0,0 +1,63 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <ConstantAllocator.h>
+#include <FrameCapture.h>
+
+#ifdef _WIN32
+static_assert(ConstantAllocator::Alignment == D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT,
+	"constant views are placed at the D3D12 alignment");
+#endif
+
+ConstantAllocator::ConstantAllocator(RenderDevice& device, UINT64 capacity)
+	: _Device(device), _Ring(capacity)
+{
+	CreateRing(capacity);
+}
+
+void ConstantAllocator::BeginFrame(UINT64 frameFence, UINT64 completedFence)
+{
+	_FrameFence = frameFence;
+
+	_Ring.Reclaim(completedFence);
+
+	while (!_Retired.empty() && _Retired.front().Fence <= completedFence)
+		_Retired.pop_front();
+}
+
+ConstantAllocator::Allocation ConstantAllocator::Allocate(UINT64 size)
+{
+	const UINT64 alignment = Alignment;
+	size = max(alignment, (size + alignment - 1) & ~(alignment - 1));
+
+	UINT64 offset;
+	if (!_Ring.Allocate(size, alignment, _FrameFence, offset))
+	{
+		// everything in the old ring is read by this frame at the latest
+		_Retired.push_back({ _FrameFence, std::move(_Buffer) });
+
+		UINT64 capacity = _Ring.Capacity() * 2;
+		while (capacity < size)
+			capacity *= 2;
+
+		CreateRing(capacity);
+
+		bool allocated = _Ring.Allocate(size, alignment, _FrameFence, offset);
+		assert(allocated);
+		(void)allocated;
+	}
+
+	if (_Capture != nullptr)
+		_Capture->Track(_GpuAddress + offset, _Data + offset, size);
+
+	return { _Data + offset, _GpuAddress + offset };
+}
+
+void ConstantAllocator::CreateRing(UINT64 capacity)
+{
+	_Buffer = _Device.CreateUploadBuffer(capacity);
+	_Data = _Buffer->Data();
+	_GpuAddress = _Buffer->GpuAddress();
+
+	_Ring = UploadRing(capacity);
+}
@@ -0,0 +1,80 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <d3dUtil.h>
+#include <D3D12Backend.h>
+
+D3D12UploadBuffer::D3D12UploadBuffer(ID3D12Device* device, UINT64 size) : _Size(size)
+{
+	ThrowIfFailed(device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(size),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&_Buffer)));
+
+	// upload heaps may stay mapped for their whole lifetime
+	ThrowIfFailed(_Buffer->Map(0, nullptr, reinterpret_cast<void**>(&_Data)));
+}
+
+D3D12UploadBuffer::~D3D12UploadBuffer()
+{
+	_Buffer->Unmap(0, nullptr);
+}
+
+D3D12Fence::D3D12Fence(ID3D12Fence* fence, ID3D12CommandQueue* queue) : _Fence(fence), _Queue(queue)
+{
+	_Event = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+	if (_Event == nullptr)
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+}
+
+D3D12Fence::~D3D12Fence()
+{
+	CloseHandle(_Event);
+}
+
+void D3D12Fence::Signal(UINT64 value)
+{
+	ThrowIfFailed(_Queue->Signal(_Fence.Get(), value));
+}
+
+void D3D12Fence::Wait(UINT64 value)
+{
+	if (_Fence->GetCompletedValue() >= value)
+		return;
+
+	ThrowIfFailed(_Fence->SetEventOnCompletion(value, _Event));
+	WaitForSingleObject(_Event, INFINITE);
+}
+
+void D3D12CommandList::SetVertexBuffer(const RenderVertexBufferView& view)
+{
+	D3D12_VERTEX_BUFFER_VIEW vbv;
+	vbv.BufferLocation = view.Address;
+	vbv.SizeInBytes = view.SizeInBytes;
+	vbv.StrideInBytes = view.StrideInBytes;
+	_CmdList->IASetVertexBuffers(0, 1, &vbv);
+}
+
+void D3D12CommandList::SetIndexBuffer(const RenderIndexBufferView& view)
+{
+	D3D12_INDEX_BUFFER_VIEW ibv;
+	ibv.BufferLocation = view.Address;
+	ibv.SizeInBytes = view.SizeInBytes;
+	ibv.Format = view.Format == RenderIndexFormat::Uint16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	_CmdList->IASetIndexBuffer(&ibv);
+}
+
+std::unique_ptr<RenderBuffer> D3D12RenderDevice::CreateUploadBuffer(UINT64 size)
+{
+	return std::make_unique<D3D12UploadBuffer>(_Device, size);
+}
+
+std::unique_ptr<RenderFence> D3D12RenderDevice::CreateFence()
+{
+	Microsoft::WRL::ComPtr<ID3D12Fence> fence;
+	ThrowIfFailed(_Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
+	return std::make_unique<D3D12Fence>(fence.Get(), _Queue);
+}
@@ -0,0 +1,50 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <DescriptorAllocator.h>
+
+DescriptorAllocator::DescriptorAllocator(UINT capacity) : _Capacity(max(capacity, 1u))
+{
+}
+
+UINT DescriptorAllocator::Allocate()
+{
+	UINT slot;
+	if (!_FreeSlots.empty())
+	{
+		slot = _FreeSlots.back();
+		_FreeSlots.pop_back();
+	}
+	else
+	{
+		if (_HighWater == _Capacity)
+			_Capacity *= 2;
+		slot = _HighWater++;
+	}
+
+	_UsedCount++;
+	return slot;
+}
+
+void DescriptorAllocator::Free(UINT slot)
+{
+	assert(slot < _HighWater && _UsedCount > 0);
+
+	_FreeSlots.push_back(slot);
+	_UsedCount--;
+}
+
+void DescriptorAllocator::Release(UINT slot, UINT64 fence)
+{
+	assert(_Retired.empty() || _Retired.back().Fence <= fence);
+	_Retired.push_back({ fence, slot });
+}
+
+void DescriptorAllocator::Reclaim(UINT64 completedFence)
+{
+	while (!_Retired.empty() && _Retired.front().Fence <= completedFence)
+	{
+		Free(_Retired.front().Slot);
+		_Retired.pop_front();
+	}
+}
@@ -0,0 +1,75 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <DirtyList.h>
+
+void DirtyList::Reset(int frameResourceCount, UINT itemCount)
+{
+	_ItemCount = itemCount;
+
+	_Frames.resize(frameResourceCount);
+	for (auto& frame : _Frames)
+	{
+		frame.Bits.assign((itemCount + 63) / 64, 0);
+		frame.Indices.clear();
+		frame.Indices.reserve(itemCount);
+	}
+}
+
+void DirtyList::Resize(UINT itemCount)
+{
+	_ItemCount = itemCount;
+
+	for (auto& frame : _Frames)
+	{
+		// forget items that no longer exist
+		size_t k = 0;
+		for (UINT index : frame.Indices)
+		{
+			if (index < itemCount)
+				frame.Indices[k++] = index;
+			else
+				frame.Bits[index >> 6] &= ~(1ull << (index & 63));
+		}
+		frame.Indices.resize(k);
+
+		frame.Bits.resize((itemCount + 63) / 64, 0);
+	}
+}
+
+void DirtyList::MarkDirty(UINT index)
+{
+	assert(index < _ItemCount);
+
+	const std::uint64_t bit = 1ull << (index & 63);
+	for (auto& frame : _Frames)
+	{
+		std::uint64_t& word = frame.Bits[index >> 6];
+		if ((word & bit) == 0)
+		{
+			word |= bit;
+			frame.Indices.push_back(index);
+		}
+	}
+}
+
+void DirtyList::MarkAllDirty()
+{
+	for (UINT i = 0; i < _ItemCount; ++i)
+		MarkDirty(i);
+}
+
+const std::vector<UINT>& DirtyList::DirtyItems(int frameResourceIndex) const
+{
+	return _Frames[frameResourceIndex].Indices;
+}
+
+void DirtyList::Clear(int frameResourceIndex)
+{
+	auto& frame = _Frames[frameResourceIndex];
+
+	for (UINT index : frame.Indices)
+		frame.Bits[index >> 6] = 0;
+
+	frame.Indices.clear();
+}
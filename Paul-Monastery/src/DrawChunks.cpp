@@ -0,0 +1,40 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <DrawChunks.h>
+
+DrawChunk DrawChunks::LayerRange(const std::vector<UINT64>& keys, UINT layer)
+{
+	// the layer is the top field, so the run starts at the first key of the
+	// layer and ends at the first key of the next
+	UINT64 first = (UINT64)layer << DrawKey::LayerShift;
+	UINT64 next = (UINT64)(layer + 1) << DrawKey::LayerShift;
+
+	DrawChunk range;
+	range.Begin = (UINT)(std::lower_bound(keys.begin(), keys.end(), first) - keys.begin());
+	range.End = layer + 1 < (1u << DrawKey::LayerBits) ?
+		(UINT)(std::lower_bound(keys.begin() + range.Begin, keys.end(), next) - keys.begin()) : (UINT)keys.size();
+	return range;
+}
+
+void DrawChunks::Split(DrawChunk range, UINT maxChunks, UINT minDraws, std::vector<DrawChunk>& chunks)
+{
+	chunks.clear();
+	if (range.Size() == 0)
+		return;
+
+	UINT count = min(max(1u, maxChunks), max(1u, range.Size() / max(1u, minDraws)));
+
+	// the first Size() % count chunks take one draw more
+	UINT size = range.Size() / count;
+	UINT larger = range.Size() % count;
+
+	DrawChunk chunk;
+	chunk.End = range.Begin;
+	for (UINT i = 0; i < count; ++i)
+	{
+		chunk.Begin = chunk.End;
+		chunk.End = chunk.Begin + size + (i < larger ? 1 : 0);
+		chunks.push_back(chunk);
+	}
+}
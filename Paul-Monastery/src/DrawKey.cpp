@@ -0,0 +1,72 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <DrawKey.h>
+
+UINT64 DrawKey::Make(UINT layer, UINT pso, UINT geometry, UINT material, UINT depthBucket, UINT index)
+{
+	assert(layer < (1u << LayerBits));
+	assert(pso < (1u << PsoBits));
+	assert(geometry < (1u << GeometryBits));
+	assert(material < (1u << MaterialBits));
+	assert(depthBucket < (1u << DepthBits));
+	assert(index < (1u << IndexBits));
+
+	return ((UINT64)layer << LayerShift) |
+		((UINT64)pso << PsoShift) |
+		((UINT64)geometry << GeometryShift) |
+		((UINT64)material << MaterialShift) |
+		((UINT64)depthBucket << DepthShift) |
+		((UINT64)index << IndexShift);
+}
+
+UINT DrawKey::DepthBucket(float viewZ, float farZ)
+{
+	const UINT maxBucket = (1u << DepthBits) - 1;
+
+	if (!(viewZ > 0.0f))
+		return 0;
+	if (viewZ >= farZ)
+		return maxBucket;
+
+	return (UINT)(viewZ / farZ * maxBucket);
+}
+
+void DrawKey::Sort(std::vector<UINT64>& keys, std::vector<UINT64>& scratch)
+{
+	const size_t n = keys.size();
+	if (n < 2)
+		return;
+
+	scratch.resize(n);
+
+	UINT64* src = keys.data();
+	UINT64* dst = scratch.data();
+
+	for (UINT shift = 0; shift < 64; shift += 8)
+	{
+		size_t count[256] = {};
+		for (size_t i = 0; i < n; ++i)
+			count[(src[i] >> shift) & 0xFF]++;
+
+		// every key has the same byte, the order is already right
+		if (count[(src[0] >> shift) & 0xFF] == n)
+			continue;
+
+		size_t offset = 0;
+		for (size_t& c : count)
+		{
+			size_t c0 = c;
+			c = offset;
+			offset += c0;
+		}
+
+		for (size_t i = 0; i < n; ++i)
+			dst[count[(src[i] >> shift) & 0xFF]++] = src[i];
+
+		std::swap(src, dst);
+	}
+
+	if (src != keys.data())
+		std::copy(src, src + n, keys.data());
+}
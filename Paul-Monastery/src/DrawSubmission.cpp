@@ -0,0 +1,73 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <d3dUtil.h>
+#include <FrameResource.h>
+#include <DrawKey.h>
+#include <DrawSubmission.h>
+
+void DrawSubmission::Record(RenderCommandList& cmdList, const RenderItemStore& ritems, const std::vector<UINT64>& keys,
+	UINT begin, UINT end, const DrawBindings& bindings)
+{
+	const auto& drawArgs = ritems.DrawArgs();
+	const auto& materialIds = ritems.MaterialIds();
+
+	// state of the previous draw
+	UINT currPso = UINT_MAX;
+	const MeshGeometry* currGeo = nullptr;
+	D3D12_PRIMITIVE_TOPOLOGY currTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+	UINT currMat = UINT_MAX;
+
+	for (UINT k = begin; k < end; ++k)
+	{
+		UINT64 key = keys[k];
+		UINT index = DrawKey::Index(key);
+		UINT pso = DrawKey::Pso(key);
+
+		const RenderItemDrawArgs& args = drawArgs[index];
+		UINT mat = materialIds[index];
+
+		if (pso != currPso)
+		{
+			cmdList.SetPipelineState(pso);
+			currPso = pso;
+		}
+
+		if (args.Geo != currGeo)
+		{
+			RenderVertexBufferView vbv;
+			RenderIndexBufferView ibv;
+			bindings.BufferViews(*args.Geo, vbv, ibv);
+			cmdList.SetVertexBuffer(vbv);
+			cmdList.SetIndexBuffer(ibv);
+			currGeo = args.Geo;
+		}
+
+		if (args.PrimitiveType != currTopology)
+		{
+			cmdList.SetPrimitiveTopology(args.PrimitiveType);
+			currTopology = args.PrimitiveType;
+		}
+
+		if (mat != currMat)
+		{
+			cmdList.SetGraphicsRootConstantBufferView(MaterialCBParameter,
+				bindings.MaterialCB + (UINT64)mat * bindings.MaterialCBStride);
+			currMat = mat;
+		}
+
+		cmdList.SetGraphicsRootConstantBufferView(ObjectCBParameter,
+			bindings.ObjectCB + (UINT64)k * bindings.ObjectCBStride);
+
+		if (args.InstanceCount > 0)
+		{
+			cmdList.SetGraphicsRootShaderResourceView(InstancesParameter,
+				bindings.Instances + (UINT64)args.InstanceOffset * sizeof(InstanceData));
+			cmdList.DrawIndexedInstanced(args.IndexCount, args.InstanceCount, args.StartIndexLocation, args.BaseVertexLocation, 0);
+		}
+		else
+		{
+			cmdList.DrawIndexedInstanced(args.IndexCount, 1, args.StartIndexLocation, args.BaseVertexLocation, 0);
+		}
+	}
+}
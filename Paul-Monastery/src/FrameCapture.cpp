@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <FrameCapture.h>
+
+namespace
+{
+	const UINT CaptureMagic = 0x43464d50; // "PMFC"
+	const UINT CaptureVersion = 1;
+
+	template <typename T>
+	void WriteValue(std::ofstream& fout, const T& value)
+	{
+		fout.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template <typename T>
+	bool ReadValue(std::ifstream& fin, T& value)
+	{
+		return (bool)fin.read(reinterpret_cast<char*>(&value), sizeof(T));
+	}
+
+	void WriteBytes(std::ofstream& fout, const std::vector<BYTE>& bytes)
+	{
+		WriteValue(fout, (UINT64)bytes.size());
+		fout.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	}
+
+	bool ReadBytes(std::ifstream& fin, std::vector<BYTE>& bytes)
+	{
+		UINT64 size;
+		if (!ReadValue(fin, size) || size > (1ull << 32))
+			return false;
+
+		bytes.resize((size_t)size);
+		return (bool)fin.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+	}
+}
+
+void FrameCapture::BeginFrame(const CapturedCamera& camera)
+{
+	_Frames.emplace_back();
+	_Frames.back().Camera = camera;
+	_Tracked.clear();
+	_Capturing = true;
+}
+
+void FrameCapture::Upload(RenderAddress address, const void* data, UINT64 size)
+{
+	if (_Capturing)
+		Append(address, data, size);
+}
+
+void FrameCapture::Track(RenderAddress address, const BYTE* data, UINT64 size)
+{
+	if (_Capturing)
+		_Tracked.push_back({ address, data, size });
+}
+
+void FrameCapture::EndFrame(const std::vector<BYTE>& commands)
+{
+	if (!_Capturing)
+		return;
+
+	for (const Tracked& t : _Tracked)
+		Append(t.Address, t.Data, t.Size);
+	_Tracked.clear();
+
+	_Frames.back().Commands = commands;
+	_Capturing = false;
+}
+
+void FrameCapture::Append(RenderAddress address, const void* data, UINT64 size)
+{
+	CapturedFrame& frame = _Frames.back();
+
+	// consecutive elements of one buffer become one upload
+	CapturedUpload* last = frame.Uploads.empty() ? nullptr : &frame.Uploads.back();
+	if (last != nullptr && last->Address + last->Size == address && last->Offset + last->Size == frame.UploadData.size())
+		last->Size += size;
+	else
+		frame.Uploads.push_back({ address, frame.UploadData.size(), size });
+
+	const BYTE* bytes = static_cast<const BYTE*>(data);
+	frame.UploadData.insert(frame.UploadData.end(), bytes, bytes + size);
+}
+
+void FrameCapture::Clear()
+{
+	_Frames.clear();
+	_Tracked.clear();
+	_Capturing = false;
+}
+
+bool FrameCapture::Write(const std::string& filename) const
+{
+	std::ofstream fout(filename, std::ios::binary);
+	if (!fout)
+		return false;
+
+	WriteValue(fout, CaptureMagic);
+	WriteValue(fout, CaptureVersion);
+	WriteValue(fout, (UINT)_Frames.size());
+
+	for (const CapturedFrame& frame : _Frames)
+	{
+		WriteValue(fout, frame.Camera);
+
+		WriteValue(fout, (UINT)frame.Uploads.size());
+		for (const CapturedUpload& upload : frame.Uploads)
+			WriteValue(fout, upload);
+
+		WriteBytes(fout, frame.UploadData);
+		WriteBytes(fout, frame.Commands);
+	}
+
+	return (bool)fout;
+}
+
+bool FrameCapture::Read(const std::string& filename)
+{
+	Clear();
+
+	std::ifstream fin(filename, std::ios::binary);
+	if (!fin)
+		return false;
+
+	UINT magic, version, frameCount;
+	if (!ReadValue(fin, magic) || !ReadValue(fin, version) || !ReadValue(fin, frameCount))
+		return false;
+	if (magic != CaptureMagic || version != CaptureVersion)
+		return false;
+
+	_Frames.resize(frameCount);
+	for (CapturedFrame& frame : _Frames)
+	{
+		UINT uploadCount;
+		if (!ReadValue(fin, frame.Camera) || !ReadValue(fin, uploadCount))
+			return false;
+
+		frame.Uploads.resize(uploadCount);
+		for (CapturedUpload& upload : frame.Uploads)
+		{
+			if (!ReadValue(fin, upload))
+				return false;
+		}
+
+		if (!ReadBytes(fin, frame.UploadData) || !ReadBytes(fin, frame.Commands))
+			return false;
+
+		for (const CapturedUpload& upload : frame.Uploads)
+		{
+			if (upload.Offset > frame.UploadData.size() || upload.Size > frame.UploadData.size() - upload.Offset)
+				return false;
+		}
+	}
+
+	return true;
+}
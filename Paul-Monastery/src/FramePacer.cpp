@@ -0,0 +1,205 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <cerrno>
+#include <cmath>
+
+#include <FramePacer.h>
+
+namespace
+{
+	// spinning without giving up the core, a yield may not come back in time
+	inline void CpuPause()
+	{
+#ifdef _WIN32
+		YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#endif
+	}
+}
+
+void FrameTimeStats::Add(double seconds)
+{
+	if (_Count == Window)
+	{
+		double old = _Samples[_Next];
+		_Sum -= old;
+		_SumSquares -= old * old;
+		_Buckets[Bucket(old)]--;
+	}
+	else
+	{
+		_Count++;
+	}
+
+	_Samples[_Next] = seconds;
+	_Next = (_Next + 1) % Window;
+
+	_Sum += seconds;
+	_SumSquares += seconds * seconds;
+	_Buckets[Bucket(seconds)]++;
+}
+
+void FrameTimeStats::Reset()
+{
+	_Next = 0;
+	_Count = 0;
+	_Sum = 0.0;
+	_SumSquares = 0.0;
+
+	for (UINT& bucket : _Buckets)
+		bucket = 0;
+}
+
+double FrameTimeStats::Min() const
+{
+	double m = _Count > 0 ? _Samples[0] : 0.0;
+	for (UINT i = 1; i < _Count; ++i)
+		m = min(m, _Samples[i]);
+	return m;
+}
+
+double FrameTimeStats::Max() const
+{
+	double m = _Count > 0 ? _Samples[0] : 0.0;
+	for (UINT i = 1; i < _Count; ++i)
+		m = max(m, _Samples[i]);
+	return m;
+}
+
+double FrameTimeStats::Mean() const
+{
+	return _Count > 0 ? _Sum / _Count : 0.0;
+}
+
+double FrameTimeStats::Jitter() const
+{
+	if (_Count < 2)
+		return 0.0;
+
+	// the running sums drift a little, never below zero
+	double mean = _Sum / _Count;
+	return sqrt(max(0.0, _SumSquares / _Count - mean * mean));
+}
+
+double FrameTimeStats::Percentile(double p) const
+{
+	if (_Count == 0)
+		return 0.0;
+
+	UINT rank = (UINT)ceil(p * _Count);
+	rank = max(1u, min(rank, _Count));
+
+	UINT seen = 0;
+	for (UINT i = 0; i < BucketCount; ++i)
+	{
+		seen += _Buckets[i];
+		if (seen >= rank)
+			return i + 1 < BucketCount ? min((i + 1) * BucketSize, Max()) : Max();
+	}
+	return Max();
+}
+
+UINT FrameTimeStats::Bucket(double seconds)
+{
+	double bucket = seconds / BucketSize;
+	return bucket < BucketCount - 1 ? (UINT)max(0.0, bucket) : BucketCount - 1;
+}
+
+FramePacer::FramePacer() : _TicksPerSecond(GameTimer::TicksPerSecond())
+{
+	// enough for a 1 ms timer until the first oversleeps are measured
+	_SpinTicks = _TicksPerSecond / 500;
+
+#ifdef _WIN32
+	_Timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (_Timer == nullptr)
+		_Timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+#endif
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	if (_Timer != nullptr)
+		CloseHandle(_Timer);
+#endif
+}
+
+void FramePacer::SetTargetFrameRate(double framesPerSecond)
+{
+	SetTargetFrameTime(framesPerSecond > 0.0 ? 1.0 / framesPerSecond : 0.0);
+}
+
+void FramePacer::SetTargetFrameTime(double seconds)
+{
+	_Period = (INT64)(seconds * _TicksPerSecond);
+	_Deadline = 0;
+	_Stats.Reset();
+}
+
+void FramePacer::Wait()
+{
+	INT64 now = GameTimer::Ticks();
+
+	if (_Period > 0)
+	{
+		_Deadline = _Deadline == 0 ? now : _Deadline + _Period;
+
+		if (_Deadline > now)
+		{
+			INT64 wake = _Deadline - _SpinTicks;
+			if (wake > now)
+			{
+				SleepUntil(wake);
+
+				// track the 99th percentile of the oversleeps: a step up when
+				// above it is 99 steps down, single stalls barely move it
+				INT64 oversleep = GameTimer::Ticks() - wake;
+				INT64 step = _TicksPerSecond / 500000;
+				_Oversleep = oversleep > _Oversleep ? _Oversleep + 99 * step : max((INT64)0, _Oversleep - step);
+				_SpinTicks = min(_Oversleep + _TicksPerSecond / 10000, _Period / 2);
+			}
+
+			while (GameTimer::Ticks() < _Deadline)
+				CpuPause();
+		}
+
+		now = GameTimer::Ticks();
+
+		// a late frame moves the schedule, the next one still gets a whole period
+		if (now - _Deadline > _TicksPerSecond / 20000)
+			_Deadline = now;
+	}
+
+	if (_LastFrame != 0)
+		_Stats.Add((double)(now - _LastFrame) / _TicksPerSecond);
+	_LastFrame = now;
+}
+
+void FramePacer::SleepUntil(INT64 ticks)
+{
+#ifdef _WIN32
+	INT64 remaining = ticks - GameTimer::Ticks();
+	if (remaining <= 0)
+		return;
+
+	// relative due time in 100 ns units
+	LARGE_INTEGER due;
+	due.QuadPart = -(LONGLONG)(remaining * 10000000 / _TicksPerSecond);
+
+	if (_Timer != nullptr && SetWaitableTimer(_Timer, &due, 0, nullptr, nullptr, FALSE))
+		WaitForSingleObject(_Timer, INFINITE);
+	else
+		Sleep((DWORD)(remaining * 1000 / _TicksPerSecond));
+#else
+	timespec ts;
+	ts.tv_sec = (time_t)(ticks / 1000000000);
+	ts.tv_nsec = (long)(ticks % 1000000000);
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+	{
+	}
+#endif
+}
@@ -0,0 +1,131 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <FrameQueue.h>
+
+FrameQueue::FrameQueue(RenderFence& fence, const Config& config, Clock clock, INT64 ticksPerSecond)
+	: _Fence(fence), _Config(config), _Clock(clock), _TicksPerSecond(ticksPerSecond)
+{
+	_Config.SlotCount = max(1u, _Config.SlotCount);
+	_Config.MinDepth = max(1u, min(_Config.MinDepth, _Config.SlotCount));
+	_Config.Window = max(1u, _Config.Window);
+	_Config.Backoff = max(1u, _Config.Backoff);
+
+	// start where the fixed three frames were and work down
+	_Depth = _Config.SlotCount;
+	_SlotFences.assign(_Config.SlotCount, 0);
+	_BackoffWindows = _Config.Backoff;
+}
+
+UINT FrameQueue::BeginFrame()
+{
+	UINT slot = (UINT)(_FrameIndex % _Config.SlotCount);
+
+	// the frame Depth submissions back, and the last one to use this slot
+	UINT64 waitFence = _SlotFences[slot];
+	if (_InFlight.size() >= _Depth)
+		waitFence = max(waitFence, _InFlight[_InFlight.size() - _Depth].Fence);
+
+	INT64 start = _Clock();
+	_Fence.Wait(waitFence);
+	INT64 now = _Clock();
+
+	_Last.CpuWait = (double)(now - start) / _TicksPerSecond;
+	_Waited = _Last.CpuWait > _Config.WaitThreshold;
+
+	Retire(now);
+	return slot;
+}
+
+void FrameQueue::EndFrame(UINT64 fenceValue)
+{
+	INT64 now = _Clock();
+	Retire(now);
+
+	// nothing left for the GPU while this frame was recorded after a wait:
+	// it idled because the CPU could not start earlier
+	if (_Waited)
+	{
+		_Waits++;
+		if (_InFlight.empty())
+			_Starved++;
+	}
+	_TotalWait += _Last.CpuWait;
+
+	_SlotFences[(UINT)(_FrameIndex % _Config.SlotCount)] = fenceValue;
+	_InFlight.push_back({ fenceValue, now });
+	_FrameIndex++;
+
+	if (++_Frames == _Config.Window)
+		Adapt();
+}
+
+void FrameQueue::SetDepth(UINT depth, bool adaptive)
+{
+	_Depth = max(_Config.MinDepth, min(depth, _Config.SlotCount));
+	_Config.Adaptive = adaptive;
+
+	_Floor = 0;
+	_FloorWindows = 0;
+	_BackoffWindows = _Config.Backoff;
+	_Probing = false;
+}
+
+void FrameQueue::Retire(INT64 now)
+{
+	UINT64 completed = _Fence.CompletedValue();
+
+	while (!_InFlight.empty() && _InFlight.front().Fence <= completed)
+	{
+		_Last.Latency = (double)(now - _InFlight.front().SubmitTime) / _TicksPerSecond;
+		_TotalLatency += _Last.Latency;
+		_Completed++;
+		_InFlight.pop_front();
+	}
+}
+
+void FrameQueue::Adapt()
+{
+	_WindowStats.CpuWait = _TotalWait / _Frames;
+	_WindowStats.Latency = _Completed > 0 ? _TotalLatency / _Completed : 0.0;
+
+	if (_Config.Adaptive)
+	{
+		if (_FloorWindows > 0 && --_FloorWindows == 0)
+			_Floor = 0;
+
+		if (_Starved * 10 > _Frames)
+		{
+			if (_Depth < _Config.SlotCount)
+				_Depth++;
+
+			// probing below failed again, wait twice as long next time
+			_Floor = _Depth;
+			_FloorWindows = _BackoffWindows;
+			_BackoffWindows = min(_BackoffWindows * 2, _Config.Backoff * 16);
+			_Probing = false;
+		}
+		else
+		{
+			// a shallower queue held up for a whole window
+			if (_Probing)
+			{
+				_BackoffWindows = _Config.Backoff;
+				_Probing = false;
+			}
+
+			if (_Waits * 2 > _Frames && _Depth > max(_Config.MinDepth, _Floor))
+			{
+				_Depth--;
+				_Probing = true;
+			}
+		}
+	}
+
+	_Frames = 0;
+	_Starved = 0;
+	_Waits = 0;
+	_Completed = 0;
+	_TotalWait = 0.0;
+	_TotalLatency = 0.0;
+}
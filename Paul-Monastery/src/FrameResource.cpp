@@ -3,15 +3,24 @@
 
 #include <FrameResource.h>
 
-FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount)
+FrameResource::FrameResource(ID3D12Device* device, RenderDevice& renderDevice, UINT instanceCount, UINT threadCount)
 {
-    ThrowIfFailed(device->CreateCommandAllocator(
-        D3D12_COMMAND_LIST_TYPE_DIRECT,
-        IID_PPV_ARGS(CmdListAlloc.GetAddressOf())));
+    if (device != nullptr)
+    {
+        ThrowIfFailed(device->CreateCommandAllocator(
+            D3D12_COMMAND_LIST_TYPE_DIRECT,
+            IID_PPV_ARGS(CmdListAlloc.GetAddressOf())));
 
-    PassCB = std::make_unique<UploadBuffer<PassConstants>>(device, passCount, true);
-    ObjectCB = std::make_unique<UploadBuffer<ObjectConstants>>(device, objectCount, true);
-    MaterialCB = std::make_unique<UploadBuffer<MaterialConstants>>(device, materialCount, true);
+        ThreadCmdListAllocs.resize(threadCount);
+        for (auto& alloc : ThreadCmdListAllocs)
+        {
+            ThrowIfFailed(device->CreateCommandAllocator(
+                D3D12_COMMAND_LIST_TYPE_DIRECT,
+                IID_PPV_ARGS(alloc.GetAddressOf())));
+        }
+    }
+
+    InstanceBuffer = std::make_unique<UploadBuffer<InstanceData>>(renderDevice, max(instanceCount, 1u), false);
 }
 
 FrameResource::~FrameResource()
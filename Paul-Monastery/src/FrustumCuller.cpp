@@ -0,0 +1,144 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <d3dUtil.h>
+#include <FrameResource.h>
+#include <RenderItemStore.h>
+#include <JobSystem.h>
+#include <FrustumCuller.h>
+
+using namespace DirectX;
+
+void FrustumCuller::Build(const RenderItemStore& ritems, RenderLayer layer)
+{
+	_Ritems = ritems.Layer(layer);
+
+	// pad to a multiple of 4 so the SIMD loop never reads past the end
+	size_t paddedSize = (_Ritems.size() + 3) & ~(size_t)3;
+
+	_CenterX.assign(paddedSize, 0.0f);
+	_CenterY.assign(paddedSize, 0.0f);
+	_CenterZ.assign(paddedSize, 0.0f);
+	_ExtentX.assign(paddedSize, 0.0f);
+	_ExtentY.assign(paddedSize, 0.0f);
+	_ExtentZ.assign(paddedSize, 0.0f);
+
+	_LayoutVersion = ritems.LayoutVersion();
+	CopyBounds(ritems);
+}
+
+void FrustumCuller::Update(const RenderItemStore& ritems, RenderLayer layer)
+{
+	if (ritems.LayoutVersion() != _LayoutVersion)
+		Build(ritems, layer);
+	else if (ritems.BoundsVersion() != _BoundsVersion)
+		CopyBounds(ritems);
+}
+
+void FrustumCuller::CopyBounds(const RenderItemStore& ritems)
+{
+	const auto& worldBounds = ritems.WorldBounds();
+	for (size_t i = 0; i < _Ritems.size(); ++i)
+	{
+		const BoundingBox& bounds = worldBounds[_Ritems[i]];
+
+		_CenterX[i] = bounds.Center.x;
+		_CenterY[i] = bounds.Center.y;
+		_CenterZ[i] = bounds.Center.z;
+		_ExtentX[i] = bounds.Extents.x;
+		_ExtentY[i] = bounds.Extents.y;
+		_ExtentZ[i] = bounds.Extents.z;
+	}
+
+	_BoundsVersion = ritems.BoundsVersion();
+}
+
+void FrustumCuller::Cull(const XMFLOAT4X4& viewProj, std::vector<UINT>& visibleRitems, JobSystem* jobs) const
+{
+	visibleRitems.clear();
+
+	// Frustum planes (a, b, c, d) from the columns of the view-projection
+	// matrix; a point p is inside when dot(p, n) + d >= 0 for all planes.
+	const XMFLOAT4X4& m = viewProj;
+	XMFLOAT4 planes[6] =
+	{
+		{ m(0, 3) + m(0, 0), m(1, 3) + m(1, 0), m(2, 3) + m(2, 0), m(3, 3) + m(3, 0) }, // left
+		{ m(0, 3) - m(0, 0), m(1, 3) - m(1, 0), m(2, 3) - m(2, 0), m(3, 3) - m(3, 0) }, // right
+		{ m(0, 3) + m(0, 1), m(1, 3) + m(1, 1), m(2, 3) + m(2, 1), m(3, 3) + m(3, 1) }, // bottom
+		{ m(0, 3) - m(0, 1), m(1, 3) - m(1, 1), m(2, 3) - m(2, 1), m(3, 3) - m(3, 1) }, // top
+		{ m(0, 2), m(1, 2), m(2, 2), m(3, 2) },                                         // near
+		{ m(0, 3) - m(0, 2), m(1, 3) - m(1, 2), m(2, 3) - m(2, 2), m(3, 3) - m(3, 2) }  // far
+	};
+
+	FrustumPlanes frustum;
+	for (int p = 0; p < 6; ++p)
+	{
+		frustum.X[p] = XMVectorReplicate(planes[p].x);
+		frustum.Y[p] = XMVectorReplicate(planes[p].y);
+		frustum.Z[p] = XMVectorReplicate(planes[p].z);
+		frustum.D[p] = XMVectorReplicate(planes[p].w);
+
+		frustum.AbsX[p] = XMVectorAbs(frustum.X[p]);
+		frustum.AbsY[p] = XMVectorAbs(frustum.Y[p]);
+		frustum.AbsZ[p] = XMVectorAbs(frustum.Z[p]);
+	}
+
+	if (!jobs || _Ritems.size() <= ChunkSize)
+	{
+		CullRange(frustum, 0, _Ritems.size(), visibleRitems);
+		return;
+	}
+
+	// every chunk collects its own list, concatenating them keeps the layer order
+	size_t chunkCount = (_Ritems.size() + ChunkSize - 1) / ChunkSize;
+	std::vector<std::vector<UINT>> chunkVisible(chunkCount);
+
+	jobs->ParallelFor((UINT)chunkCount, 1, [&](UINT begin, UINT end)
+	{
+		for (UINT c = begin; c < end; ++c)
+			CullRange(frustum, c * ChunkSize, min((c + 1) * ChunkSize, _Ritems.size()), chunkVisible[c]);
+	});
+
+	for (const auto& chunk : chunkVisible)
+		visibleRitems.insert(visibleRitems.end(), chunk.begin(), chunk.end());
+}
+
+void FrustumCuller::CullRange(const FrustumPlanes& frustum, size_t begin, size_t end, std::vector<UINT>& visibleRitems) const
+{
+	const XMVECTOR zero = XMVectorZero();
+
+	for (size_t i = begin; i < end; i += 4)
+	{
+		XMVECTOR cx = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&_CenterX[i]));
+		XMVECTOR cy = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&_CenterY[i]));
+		XMVECTOR cz = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&_CenterZ[i]));
+		XMVECTOR ex = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&_ExtentX[i]));
+		XMVECTOR ey = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&_ExtentY[i]));
+		XMVECTOR ez = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&_ExtentZ[i]));
+
+		XMVECTOR outside = XMVectorFalseInt();
+		for (int p = 0; p < 6; ++p)
+		{
+			// signed distance of the box centers and projected box radii
+			XMVECTOR dist = XMVectorMultiplyAdd(cx, frustum.X[p],
+				XMVectorMultiplyAdd(cy, frustum.Y[p],
+					XMVectorMultiplyAdd(cz, frustum.Z[p], frustum.D[p])));
+			XMVECTOR radius = XMVectorMultiplyAdd(ex, frustum.AbsX[p],
+				XMVectorMultiplyAdd(ey, frustum.AbsY[p],
+					XMVectorMultiply(ez, frustum.AbsZ[p])));
+
+			outside = XMVectorOrInt(outside, XMVectorLess(XMVectorAdd(dist, radius), zero));
+		}
+
+		XMUINT4 mask;
+		XMStoreUInt4(&mask, outside);
+
+		const uint32_t results[4] = { mask.x, mask.y, mask.z, mask.w };
+		size_t count = min((size_t)4, end - i);
+		for (size_t k = 0; k < count; ++k)
+		{
+			if (results[k] == 0)
+				visibleRitems.push_back(_Ritems[i + k]);
+		}
+	}
+}
@@ -9,9 +9,7 @@ GameTimer::GameTimer()
 	_baseTime(0), _prevTime(0), _stopTime(0), _pausedTime(0), _currTime(0),
 	_stopped(false)
 {
-	__int64 countPerSecond;
-	QueryPerformanceFrequency((LARGE_INTEGER*) & countPerSecond);
-	_secondsPerCount = 1.0 / countPerSecond;
+	_secondsPerCount = 1.0 / TicksPerSecond();
 }
 
 GameTimer::~GameTimer()
@@ -21,8 +19,7 @@ GameTimer::~GameTimer()
 
 void GameTimer::Reset()
 {
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+	INT64 currTime = Ticks();
 
 	_baseTime = currTime;
 	_prevTime = currTime;
@@ -32,8 +29,7 @@ void GameTimer::Reset()
 
 void GameTimer::Start()
 {
-	__int64 startTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
+	INT64 startTime = Ticks();
 
 	if (_stopped)
 	{
@@ -49,8 +45,7 @@ void GameTimer::Stop()
 {
 	if (!_stopped)
 	{
-		__int64 currTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+		INT64 currTime = Ticks();
 
 		_stopTime = currTime;
 		_stopped = true;
@@ -65,8 +60,7 @@ void GameTimer::Tick()
 		return;
 	}
 
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+	INT64 currTime = Ticks();
 	_currTime = currTime;
 
 	_deltaTime = (_currTime - _prevTime) * _secondsPerCount;
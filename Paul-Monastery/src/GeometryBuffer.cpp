@@ -0,0 +1,92 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <d3dUtil.h>
+#include <GeometryBuffer.h>
+
+GeometryBuffer::GeometryBuffer(ResourceHeaps& heaps, UploadManager& uploads, UINT64 capacity)
+	: _Uploads(uploads), _Allocator(capacity)
+{
+	HeapPlacement placement;
+	ThrowIfFailed(heaps.CreateResource(CD3DX12_RESOURCE_DESC::Buffer(capacity),
+		D3D12_RESOURCE_STATE_COMMON, _Buffer, placement));
+}
+
+void GeometryBuffer::BeginFrame(UINT64 frameFence, UINT64 completedFence)
+{
+	_FrameFence = frameFence;
+
+	while (!_Retired.empty() && _Retired.front().Fence <= completedFence)
+	{
+		_Allocator.Free(_Retired.front().Handle);
+		_Retired.pop_front();
+	}
+}
+
+GeometryBuffer::Range GeometryBuffer::Upload(const void* data, UINT64 byteSize, UINT64 alignment)
+{
+	Range range;
+	range.Handle = _Allocator.Allocate(byteSize, alignment);
+
+	if (range.Handle == HeapAllocator::InvalidHandle)
+	{
+		range.Resource = _Uploads.CreateBuffer(data, byteSize, range.Placement);
+		return range;
+	}
+
+	range.Resource = _Buffer;
+	range.Offset = _Allocator.Offset(range.Handle);
+	_Uploads.UploadBuffer(_Buffer.Get(), range.Offset, data, byteSize);
+	return range;
+}
+
+void GeometryBuffer::Upload(MeshGeometry& geo)
+{
+	Range vb = Upload(geo.VertexBufferCPU.data(), geo.VertexBufferByteSize, sizeof(float));
+	geo.VertexBufferGPU = vb.Resource;
+	geo.VertexBufferOffset = vb.Offset;
+	geo.VertexBufferHandle = vb.Handle;
+	geo.VertexBufferPlacement = vb.Placement;
+
+	UINT indexSize = geo.IndexFormat == DXGI_FORMAT_R16_UINT ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+	Range ib = Upload(geo.IndexBufferCPU.data(), geo.IndexBufferByteSize, indexSize);
+	geo.IndexBufferGPU = ib.Resource;
+	geo.IndexBufferOffset = ib.Offset;
+	geo.IndexBufferHandle = ib.Handle;
+	geo.IndexBufferPlacement = ib.Placement;
+}
+
+void GeometryBuffer::Release(const Range& range)
+{
+	if (range.Handle != HeapAllocator::InvalidHandle)
+		_Retired.push_back({ _FrameFence, range.Handle });
+	else if (range.Resource)
+		_Uploads.Release(range.Resource, range.Placement);
+}
+
+void GeometryBuffer::Release(MeshGeometry& geo)
+{
+	Release(Range{ geo.VertexBufferGPU, geo.VertexBufferOffset, geo.VertexBufferHandle, geo.VertexBufferPlacement });
+	Release(Range{ geo.IndexBufferGPU, geo.IndexBufferOffset, geo.IndexBufferHandle, geo.IndexBufferPlacement });
+
+	geo.VertexBufferGPU = nullptr;
+	geo.IndexBufferGPU = nullptr;
+	geo.VertexBufferHandle = HeapAllocator::InvalidHandle;
+	geo.IndexBufferHandle = HeapAllocator::InvalidHandle;
+	geo.VertexBufferPlacement = HeapPlacement();
+	geo.IndexBufferPlacement = HeapPlacement();
+}
+
+UINT GeometryBuffer::Defragment(UINT maxMoves, const MoveCallback& moved)
+{
+	// the copy goes through the staging ring, a buffer cannot be copy source
+	// and destination at once; draws of this frame already see the new place
+	std::vector<HeapAllocator::Move> moves = _Allocator.Defragment(maxMoves);
+	for (const HeapAllocator::Move& move : moves)
+	{
+		_Uploads.UploadBuffer(_Buffer.Get(), move.To, moved(move.Handle, move.To), move.Size);
+		_Retired.push_back({ _FrameFence, move.Retired });
+	}
+
+	return (UINT)moves.size();
+}
@@ -559,3 +559,380 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSector(float radius, float
 
 	return meshData;
 }
+
+GeometryGenerator::LodChain GeometryGenerator::CreateSphereLods(float radius, uint32 sliceCount, uint32 stackCount, uint32 levelCount)
+{
+	// a triangle strays from the surface by at most the sum of both arc errors
+	return CreateLods(levelCount, sliceCount, 3, stackCount, 2,
+		[&](uint32 slices, uint32 stacks) { return CreateSphere(radius, slices, stacks); },
+		[&](uint32 slices, uint32 stacks) { return ArcError(radius, XM_2PI, slices) + ArcError(radius, XM_PI, stacks); });
+}
+
+GeometryGenerator::LodChain GeometryGenerator::CreateRingLods(float oradius, float thickness, float alpha, float beta,
+	uint32 sliceCount, uint32 stackCount, uint32 levelCount)
+{
+	// flat across the thickness, only the slices approximate the arc
+	return CreateLods(levelCount, sliceCount, beta - alpha > XM_PI ? 3 : 1, stackCount, 1,
+		[&](uint32 slices, uint32 stacks) { return CreateRing(oradius, thickness, alpha, beta, slices, stacks); },
+		[&](uint32 slices, uint32) { return ArcError(oradius, beta - alpha, slices); });
+}
+
+GeometryGenerator::LodChain GeometryGenerator::CreateCylinderLods(float radius, float height, float alpha, float beta,
+	uint32 sliceCount, uint32 stackCount, uint32 levelCount)
+{
+	return CreateLods(levelCount, sliceCount, beta - alpha > XM_PI ? 3 : 1, stackCount, 1,
+		[&](uint32 slices, uint32 stacks) { return CreateCylinder(radius, height, alpha, beta, slices, stacks); },
+		[&](uint32 slices, uint32) { return ArcError(radius, beta - alpha, slices); });
+}
+
+GeometryGenerator::LodChain GeometryGenerator::CreateDomeLods(float radius, float angle, uint32 sliceCount, uint32 stackCount, uint32 levelCount)
+{
+	return CreateLods(levelCount, sliceCount, 3, stackCount, 2,
+		[&](uint32 slices, uint32 stacks) { return CreateDome(radius, angle, slices, stacks); },
+		[&](uint32 slices, uint32 stacks) { return ArcError(radius, XM_2PI, slices) + ArcError(radius, angle, stacks); });
+}
+
+GeometryGenerator::LodChain GeometryGenerator::CreateSectorLods(float radius, float dr, float alpha, float beta, float thick,
+	uint32 sliceCount, uint32 stackCount1, uint32 stackCount2, uint32 levelCount)
+{
+	// flat across both stack directions, only the slices approximate the arc
+	return CreateLods(levelCount, sliceCount, beta - alpha > XM_PI ? 3 : 1, 1, 1,
+		[&](uint32 slices, uint32) { return CreateSector(radius, dr, alpha, beta, thick, slices, stackCount1, stackCount2); },
+		[&](uint32 slices, uint32) { return ArcError(radius, beta - alpha, slices); });
+}
+
+float GeometryGenerator::ArcError(float radius, float arc, uint32 segmentCount)
+{
+	return radius * (1.0f - cosf(0.5f * arc / segmentCount));
+}
+
+GeometryGenerator::LodChain GeometryGenerator::CreateLods(uint32 levelCount, uint32 sliceCount, uint32 minSliceCount,
+	uint32 stackCount, uint32 minStackCount,
+	const std::function<MeshData(uint32, uint32)>& create, const std::function<float(uint32, uint32)>& error)
+{
+	LodChain chain;
+
+	for (uint32 level = 0; level < levelCount; ++level)
+	{
+		chain.Levels.push_back(create(sliceCount, stackCount));
+		chain.Errors.push_back(error(sliceCount, stackCount));
+
+		uint32 slices = max(minSliceCount, sliceCount / 2);
+		uint32 stacks = max(minStackCount, stackCount / 2);
+		if (slices == sliceCount && stacks == stackCount)
+			break;
+
+		sliceCount = slices;
+		stackCount = stacks;
+	}
+
+	return chain;
+}
+
+namespace
+{
+	using uint32 = GeometryGenerator::uint32;
+
+	// Tipsify (Sander et al. 2007). Returns the triangles in emit order and, for
+	// each of them, whether a new fan started there after a dead end was hit.
+	void TipsifyTriangles(const std::vector<uint32>& indices, uint32 vertexCount, uint32 cacheSize,
+		std::vector<uint32>& order, std::vector<bool>& hardBoundary)
+	{
+		uint32 triCount = (uint32)indices.size() / 3;
+
+		// vertex -> triangle adjacency in CSR form
+		std::vector<uint32> adjOffset(vertexCount + 1, 0);
+		for (uint32 index : indices)
+			adjOffset[index + 1]++;
+		for (uint32 v = 0; v < vertexCount; ++v)
+			adjOffset[v + 1] += adjOffset[v];
+
+		std::vector<uint32> adjacency(indices.size());
+		std::vector<uint32> fill(adjOffset.begin(), adjOffset.end() - 1);
+		for (uint32 i = 0; i < (uint32)indices.size(); ++i)
+			adjacency[fill[indices[i]]++] = i / 3;
+
+		std::vector<uint32> live(vertexCount);
+		for (uint32 v = 0; v < vertexCount; ++v)
+			live[v] = adjOffset[v + 1] - adjOffset[v];
+
+		std::vector<uint32> cacheTime(vertexCount, 0);
+		std::vector<bool> emitted(triCount, false);
+		std::vector<uint32> deadEnd;
+		std::vector<uint32> candidates;
+
+		order.clear();
+		order.reserve(triCount);
+		hardBoundary.assign(triCount, false);
+
+		uint32 time = cacheSize + 1;
+		uint32 cursor = 0;
+		bool jumped = true;
+
+		auto skipDeadEnd = [&]() -> int {
+			while (!deadEnd.empty())
+			{
+				uint32 d = deadEnd.back();
+				deadEnd.pop_back();
+				if (live[d] > 0)
+					return (int)d;
+			}
+
+			jumped = true;
+			for (; cursor < vertexCount; ++cursor)
+			{
+				if (live[cursor] > 0)
+					return (int)cursor;
+			}
+			return -1;
+		};
+
+		int fan = skipDeadEnd();
+		while (fan >= 0)
+		{
+			candidates.clear();
+			for (uint32 a = adjOffset[fan]; a < adjOffset[fan + 1]; ++a)
+			{
+				uint32 t = adjacency[a];
+				if (emitted[t])
+					continue;
+
+				if (jumped)
+				{
+					hardBoundary[order.size()] = true;
+					jumped = false;
+				}
+
+				for (uint32 k = 0; k < 3; ++k)
+				{
+					uint32 v = indices[t * 3 + k];
+					deadEnd.push_back(v);
+					candidates.push_back(v);
+					live[v]--;
+
+					if (time - cacheTime[v] > cacheSize)
+						cacheTime[v] = time++;
+				}
+
+				emitted[t] = true;
+				order.push_back(t);
+			}
+
+			// prefer the candidate that stays in the cache while its remaining fan is emitted
+			fan = -1;
+			int best = -1;
+			for (uint32 v : candidates)
+			{
+				if (live[v] == 0)
+					continue;
+
+				int priority = 0;
+				if (time - cacheTime[v] + 2 * live[v] <= cacheSize)
+					priority = (int)(time - cacheTime[v]);
+
+				if (priority > best)
+				{
+					best = priority;
+					fan = (int)v;
+				}
+			}
+
+			if (fan < 0)
+				fan = skipDeadEnd();
+		}
+	}
+
+	// Misses of a FIFO cache over the triangles [begin, end) of order.
+	uint32 FifoMisses(const std::vector<uint32>& indices, const std::vector<uint32>& order,
+		size_t begin, size_t end, uint32 cacheSize, std::vector<uint32>& cacheTime, uint32& time)
+	{
+		uint32 misses = 0;
+		for (size_t i = begin; i < end; ++i)
+		{
+			for (uint32 k = 0; k < 3; ++k)
+			{
+				uint32 v = indices[order[i] * 3 + k];
+				if (time - cacheTime[v] > cacheSize)
+				{
+					cacheTime[v] = time++;
+					misses++;
+				}
+			}
+		}
+		return misses;
+	}
+}
+
+GeometryGenerator::CacheStats GeometryGenerator::AnalyzeVertexCache(const MeshData& meshData, uint32 cacheSize, CacheModel model) const
+{
+	CacheStats stats;
+	if (meshData.Indices32.empty() || cacheSize == 0)
+		return stats;
+
+	uint32 misses = 0;
+	std::vector<uint32> cache;
+	cache.reserve(cacheSize + 1);
+
+	std::vector<bool> referenced(meshData.Vertices.size(), false);
+	uint32 referencedCount = 0;
+
+	for (uint32 v : meshData.Indices32)
+	{
+		if (!referenced[v])
+		{
+			referenced[v] = true;
+			referencedCount++;
+		}
+
+		auto it = std::find(cache.begin(), cache.end(), v);
+		if (it != cache.end())
+		{
+			// a FIFO keeps its order on a hit, an LRU moves the vertex to the front
+			if (model == CacheModel::Lru)
+			{
+				cache.erase(it);
+				cache.insert(cache.begin(), v);
+			}
+			continue;
+		}
+
+		misses++;
+		cache.insert(cache.begin(), v);
+		if (cache.size() > cacheSize)
+			cache.pop_back();
+	}
+
+	stats.Acmr = (float)misses / (float)(meshData.Indices32.size() / 3);
+	stats.Atvr = (float)misses / (float)referencedCount;
+	return stats;
+}
+
+void GeometryGenerator::Optimize(MeshData& meshData, uint32 cacheSize)
+{
+	uint32 vertexCount = (uint32)meshData.Vertices.size();
+	uint32 triCount = (uint32)meshData.Indices32.size() / 3;
+	if (triCount == 0 || cacheSize == 0)
+		return;
+
+	const std::vector<uint32>& indices = meshData.Indices32;
+
+	std::vector<uint32> order;
+	std::vector<bool> hardBoundary;
+	TipsifyTriangles(indices, vertexCount, cacheSize, order, hardBoundary);
+
+	// Split the order into clusters: always where Tipsify restarted, and at a
+	// soft boundary once the cluster alone, starting from a cold cache, is as
+	// cache efficient as the whole order. Reordering the clusters then costs
+	// little cache efficiency.
+	std::vector<uint32> cacheTime(vertexCount, 0);
+	uint32 time = cacheSize + 1;
+	float targetAcmr = (float)FifoMisses(indices, order, 0, order.size(), cacheSize, cacheTime, time) / (float)triCount;
+
+	std::vector<size_t> clusterStart;
+	std::fill(cacheTime.begin(), cacheTime.end(), 0);
+	time = cacheSize + 1;
+	uint32 clusterMisses = 0;
+	size_t start = 0;
+
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		bool soft = i > start && (float)clusterMisses / (float)(i - start) <= targetAcmr;
+		if (i == 0 || hardBoundary[i] || soft)
+		{
+			clusterStart.push_back(i);
+			start = i;
+			clusterMisses = 0;
+			time += cacheSize + 1; // flush
+		}
+
+		clusterMisses += FifoMisses(indices, order, i, i + 1, cacheSize, cacheTime, time);
+	}
+	clusterStart.push_back(order.size());
+
+	// Draw clusters facing away from the mesh center first, they tend to
+	// occlude the rest (Sander et al., fast approximate overdraw ordering).
+	XMVECTOR meshCenter = XMVectorZero();
+	for (const auto& vertex : meshData.Vertices)
+		meshCenter += XMLoadFloat3(&vertex.Position);
+	meshCenter /= (float)max(1u, vertexCount);
+
+	struct Cluster
+	{
+		size_t Begin;
+		size_t End;
+		float Sort;
+	};
+
+	std::vector<Cluster> clusters;
+	clusters.reserve(clusterStart.size() - 1);
+	for (size_t c = 0; c + 1 < clusterStart.size(); ++c)
+	{
+		XMVECTOR center = XMVectorZero();
+		XMVECTOR normal = XMVectorZero();
+		float area = 0.0f;
+
+		for (size_t i = clusterStart[c]; i < clusterStart[c + 1]; ++i)
+		{
+			uint32 t = order[i];
+			XMVECTOR p0 = XMLoadFloat3(&meshData.Vertices[indices[t * 3 + 0]].Position);
+			XMVECTOR p1 = XMLoadFloat3(&meshData.Vertices[indices[t * 3 + 1]].Position);
+			XMVECTOR p2 = XMLoadFloat3(&meshData.Vertices[indices[t * 3 + 2]].Position);
+
+			// area weighted, the cross product length is twice the area
+			XMVECTOR n = XMVector3Cross(p1 - p0, p2 - p0);
+			float a = XMVectorGetX(XMVector3Length(n));
+			center += (p0 + p1 + p2) * (a / 3.0f);
+			normal += n;
+			area += a;
+		}
+
+		// clockwise front faces in a left-handed space, the cross product points outwards
+		float sort = 0.0f;
+		if (area > 0.0f)
+			sort = XMVectorGetX(XMVector3Dot(center / area - meshCenter, XMVector3Normalize(normal)));
+
+		clusters.push_back({ clusterStart[c], clusterStart[c + 1], sort });
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(),
+		[](const Cluster& a, const Cluster& b) { return a.Sort > b.Sort; });
+
+	// vertex fetch remap: number the vertices in the order the indices first use them
+	const uint32 unassigned = 0xffffffff;
+	std::vector<uint32> remap(vertexCount, unassigned);
+	uint32 next = 0;
+
+	MeshData result;
+	result.Indices32.reserve(indices.size());
+	for (const Cluster& cluster : clusters)
+	{
+		for (size_t i = cluster.Begin; i < cluster.End; ++i)
+		{
+			for (uint32 k = 0; k < 3; ++k)
+			{
+				uint32 v = indices[order[i] * 3 + k];
+				if (remap[v] == unassigned)
+					remap[v] = next++;
+				result.Indices32.push_back(remap[v]);
+			}
+		}
+	}
+
+	// unreferenced vertices keep their place after the used ones
+	for (uint32 v = 0; v < vertexCount; ++v)
+	{
+		if (remap[v] == unassigned)
+			remap[v] = next++;
+	}
+
+	result.Vertices.resize(vertexCount);
+	for (uint32 v = 0; v < vertexCount; ++v)
+		result.Vertices[remap[v]] = meshData.Vertices[v];
+
+	// small meshes can already be close to optimal, keep whichever order is better
+	if (AnalyzeVertexCache(result, cacheSize).Acmr > AnalyzeVertexCache(meshData, cacheSize).Acmr)
+		return;
+
+	// a fresh MeshData also drops any stale 16-bit index copy
+	meshData = std::move(result);
+}
@@ -7,13 +7,19 @@
 #include <d3dUtil.h>
 #include <FrameResource.h>
 #include <DDSTextureLoader.h>
+#include <TextureLoader.h>
 #include <GeometryGenerator.h>
 #include <Sky.h>
 #include <Fixed.h>
+#include <SceneMaterials.h>
+#include <D3D12Backend.h>
+#include <CommandRecorder.h>
+#include <Profiler.h>
+#include <DrawChunks.h>
+#include <InstanceGrouping.h>
 
 using namespace DirectX;
 
-int g_ObjCBIndex = 0;
 
 #define TEXTURE_PATH L"Textures\\"
 #define SHADER_PATH L"Shaders\\"
@@ -23,7 +29,67 @@ int g_ObjCBIndex = 0;
 //#define SHADER_PATH L"\\ProgramData\\rezek\\"
 //#define MODELS_PATH L"\\ProgramData\\rezek\\"
 
-const int gNumFrameResources = 3;
+// frames with resources of their own, FrameQueue keeps up to as many in flight
+const UINT gMaxFramesInFlight = 3;
+
+// opaque draws per command list recorded by a job thread, fewer stay on the frame's list
+const UINT gMinChunkDraws = 1024;
+
+// opaque render items F5 scales the monastery to, for timing the recording with F11
+const UINT gBenchmarkDrawCount = 100000;
+
+// largest screen-space error a coarser level of detail may add
+const float gLodMaxPixelError = 0.5f;
+
+// copies of a mesh centered in the same cube of this size become one instanced draw
+const float gInstanceClusterSize = 10.0f;
+const UINT gMinInstances = 2;
+
+// clip planes of the projection, the depth buckets of the draw keys span them
+const float gNearZ = 1.0f;
+const float gFarZ = 1000.0f;
+
+// size of a fixed button while it is held down
+const float gPressedButtonScale = 0.85f;
+
+// memory the streamed textures may keep resident, mip tails included
+const UINT64 gTextureStreamingBudget = 256 * 1024;
+
+// staging memory shared by all uploads, larger ones get a buffer of their own
+const UINT64 gUploadRingSize = 4 * 1024 * 1024;
+
+// default heaps the buffers and textures are placed in
+const UINT64 gResourceHeapSize = 32 * 1024 * 1024;
+
+// shared vertex and index memory, meshes beyond it get buffers of their own
+const UINT64 gGeometryBufferSize = 4 * 1024 * 1024;
+
+// fragmentation of the geometry buffer that starts moving meshes, a few per frame
+const float gGeometryDefragThreshold = 0.5f;
+const UINT gGeometryDefragMoves = 4;
+
+// initial shader-visible descriptors, the heap grows when they run out
+const UINT gSrvHeapCapacity = 16;
+
+// initial constant memory of the frames in flight, it grows when needed
+const UINT64 gConstantRingSize = 1024 * 1024;
+
+// frames F11 records on the CommandRecorder to time the draw path without a GPU
+const UINT gRecordFrameCount = 100;
+
+// frames F10 captures for tools/FrameReplay, and where they go
+const UINT gCaptureFrameCount = 60;
+const char* const gCaptureFilename = "FrameCapture.pmcap";
+
+// frame rates F8 cycles through, 0 presents as fast as possible
+const double gFrameRateTargets[] = { 60.0, 144.0, 240.0, 0.0 };
+
+// frames in flight F7 cycles through, 0 lets FrameQueue adapt the depth
+const UINT gFrameQueueDepths[] = { 0, 1, 2, 3 };
+
+// frames F9 traces for chrome://tracing
+const UINT gTraceFrameCount = 120;
+const char* const gTraceFilename = "ProfileTrace.json";
 
 LRESULT GraphicsWindow::OnCreate()
 {
@@ -34,38 +100,99 @@ void GraphicsWindow::InitDirect3D()
 {
 	AbstractWindow::InitDirect3D();
 
+	// one deque is kept for the render thread, see RecordChunks()
+	_Jobs = std::make_unique<JobSystem>(0, 1);
+
+	_FramePacer.SetTargetFrameRate(gFrameRateTargets[_FrameRateTarget]);
+
 	ThrowIfFailed(_CommandList->Reset(_DirectCmdListAlloc.Get(), nullptr));
 
-	_CbvSrvDescriptorSize = _d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	TextureStreamer::Config streamingConfig;
+	streamingConfig.BudgetBytes = gTextureStreamingBudget;
+	_TextureStreamer = std::make_unique<TextureStreamer>(streamingConfig);
+	_RenderDevice = std::make_unique<D3D12RenderDevice>(_d3dDevice.Get(), _CommandQueue.Get());
+	_FrameFence = std::make_unique<D3D12Fence>(_Fence.Get(), _CommandQueue.Get());
+	FrameQueue::Config queueConfig;
+	queueConfig.SlotCount = gMaxFramesInFlight;
+	_FrameQueue = std::make_unique<FrameQueue>(*_FrameFence, queueConfig, GameTimer::Ticks, GameTimer::TicksPerSecond());
+	_ResourceHeaps = std::make_unique<ResourceHeaps>(_d3dDevice.Get(), gResourceHeapSize);
+	_Uploads = std::make_unique<UploadManager>(_d3dDevice.Get(), *_ResourceHeaps, gUploadRingSize);
+	_GeometryBuffer = std::make_unique<GeometryBuffer>(*_ResourceHeaps, *_Uploads, gGeometryBufferSize);
+	_Constants = std::make_unique<ConstantAllocator>(*_RenderDevice, gConstantRingSize);
+	_SrvHeap = std::make_unique<ShaderResourceHeap>(_d3dDevice.Get(), gSrvHeapCapacity);
+	_StreamingTextures = std::make_unique<StreamingTextures>(_d3dDevice.Get(), *_ResourceHeaps, *_SrvHeap, *_Uploads);
+
+	// FlushCommandQueue() below completes the startup uploads at the next fence
+	_Uploads->BeginFrame(_CommandList.Get(), _CurrentFence + 1, _Fence->GetCompletedValue());
+	_GeometryBuffer->BeginFrame(_CurrentFence + 1, _Fence->GetCompletedValue());
+	_SrvHeap->BeginFrame(_CurrentFence + 1, _Fence->GetCompletedValue());
+	_StreamingTextures->BeginFrame(_CurrentFence + 1, _Fence->GetCompletedValue());
+
+	// the texture files are read and parsed by jobs while the rest is built
+	TextureLoader textureLoader(*_Jobs);
+	LoadTextures(textureLoader);
 
-	LoadTextures();
 	BuildMonastery();
 	BuildRootSignature();
 	BuildShadersAndInputLayout();
 	BuildGeometry();
+
+	textureLoader.Finish(*_Uploads, _Textures, _StreamingTextures.get());
+
+	// streamed textures start with their mip tails
+	for (UINT i = 0; i < _StreamingTextures->TextureCount(); ++i)
+		_TextureStreamer->Add(_StreamingTextures->Desc(i), *_StreamingTextures);
+
 	BuildMaterials();
 	BuildRenderItems();
 	BuildFrameResources();
+	BuildCommandLists();
 	BuildDescriptorHeaps();
 	BuildPSOs();
 
+	_Uploads->Flush();
+	_SrvHeap->Commit();
+
 	ThrowIfFailed(_CommandList->Close());
 	ID3D12CommandList* cmdsLists[] = { _CommandList.Get() };
 	_CommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
 
 	FlushCommandQueue();
+
+	_Pipeline = std::make_unique<FramePipeline<FrameSnapshot>>([this](const FrameSnapshot& frame) {
+		Render(frame);
+	}, true, [this]() {
+		_Jobs->AttachThread(0);
+	});
 }
 
 void GraphicsWindow::Draw()
 {
+	PROFILE_ZONE("Draw");
+
 	auto cmdListAlloc = _CurrFrameResource->CmdListAlloc;
 
 	ThrowIfFailed(cmdListAlloc->Reset());
+	for (auto& alloc : _CurrFrameResource->ThreadCmdListAllocs)
+		ThrowIfFailed(alloc->Reset());
 
 	ThrowIfFailed(_CommandList->Reset(cmdListAlloc.Get(), _PSOs["sky"].Get()));
 
-	_CommandList->RSSetViewports(1, &_ScreenViewport);
-	_CommandList->RSSetScissorRects(1, &_ScissorRect);
+	// residency changes upload ahead of this frame's draws
+	UINT64 completedFence = _FrameFence->CompletedValue();
+	_Uploads->BeginFrame(_CommandList.Get(), _CurrentFence + 1, completedFence);
+	_GeometryBuffer->BeginFrame(_CurrentFence + 1, completedFence);
+	_SrvHeap->BeginFrame(_CurrentFence + 1, completedFence);
+	_StreamingTextures->BeginFrame(_CurrentFence + 1, completedFence);
+	_TextureStreamer->Update(*_StreamingTextures);
+	if (_GeometryBuffer->Fragmentation() > gGeometryDefragThreshold)
+	{
+		_GeometryBuffer->Defragment(gGeometryDefragMoves, [this](UINT handle, UINT64 offset) {
+			return MoveGeometry(handle, offset);
+		});
+	}
+	_Uploads->Flush();
+	_SrvHeap->Commit();
 
 	_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
 		D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
@@ -73,73 +200,164 @@ void GraphicsWindow::Draw()
 	_CommandList->ClearRenderTargetView(CurrentBackBufferView(), DirectX::Colors::LightSteelBlue, 0, nullptr);
 	_CommandList->ClearDepthStencilView(DepthStencilView(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
 
-	_CommandList->OMSetRenderTargets(1, &CurrentBackBufferView(), true, &DepthStencilView());
+	SetFrameState(_CommandList.Get());
 
-	ID3D12DescriptorHeap* descriptorHeaps[] = { _SrvDescriptorHeap.Get() };
-	_CommandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+	// with enough opaque draws for several chunks, the job threads record
+	// them into lists executed between this one and _PostCommandList
+	DrawChunk opaque = DrawChunks::LayerRange(_DrawKeys, (UINT)RenderLayer::Opaque);
+	DrawChunks::Split(opaque, (UINT)_ChunkCommandLists.size(), gMinChunkDraws, _DrawChunks);
 
-	_CommandList->SetGraphicsRootSignature(_RootSignature.Get());
+	D3D12CommandList cmdList(_CommandList.Get(), _LayerPSOs);
+	ID3D12GraphicsCommandList* lastList = _CommandList.Get();
+	_SubmitLists.assign(1, _CommandList.Get());
 
-	auto passCB = _CurrFrameResource->PassCB->Resource();
-	_CommandList->SetGraphicsRootConstantBufferView(2, passCB->GetGPUVirtualAddress());
+	if (_DrawChunks.size() < 2)
+	{
+		RecordFrameCommands(cmdList, 0, (UINT)_DrawKeys.size());
+	}
+	else
+	{
+		RecordFrameCommands(cmdList, 0, opaque.Begin);
+		ThrowIfFailed(_CommandList->Close());
 
-	CD3DX12_GPU_DESCRIPTOR_HANDLE skyTexDescriptor(_SrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
-	skyTexDescriptor.Offset(0, _CbvSrvUavDescriptorSize);
-	_CommandList->SetGraphicsRootDescriptorTable(4, skyTexDescriptor);
+		RecordChunks();
 
-	_CommandList->SetPipelineState(_PSOs["sky"].Get());
-	DrawRenderItems(_CommandList.Get(), _RitemLayer[(int)RenderLayer::Sky]);
+		// the allocator is free again now that _CommandList is closed
+		ThrowIfFailed(_PostCommandList->Reset(cmdListAlloc.Get(), nullptr));
+		SetFrameState(_PostCommandList.Get());
 
-	_CommandList->SetPipelineState(_PSOs["fixed"].Get());
-	DrawRenderItems(_CommandList.Get(), _RitemLayer[(int)RenderLayer::Fixed]);
+		D3D12CommandList postList(_PostCommandList.Get(), _LayerPSOs);
+		RecordFrameCommands(postList, opaque.End, (UINT)_DrawKeys.size());
 
-	_CommandList->SetPipelineState(_PSOs["opaque"].Get());
-	DrawRenderItems(_CommandList.Get(), _RitemLayer[(int)RenderLayer::Opaque]);
+		lastList = _PostCommandList.Get();
+		_SubmitLists.push_back(lastList);
+	}
 
-	_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
+	lastList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
 		D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
 
-	ThrowIfFailed(_CommandList->Close());
+	ThrowIfFailed(lastList->Close());
 
-	ID3D12CommandList* cmdsLists[] = { _CommandList.Get() };
-	_CommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+	{
+		PROFILE_ZONE("ExecuteCommandLists");
+		_CommandQueue->ExecuteCommandLists((UINT)_SubmitLists.size(), _SubmitLists.data());
+	}
 
-	RenderUI();
+	{
+		PROFILE_ZONE("RenderUI");
+		RenderUI();
+	}
+
+	{
+		PROFILE_ZONE("FramePacer");
+		_FramePacer.Wait();
+	}
 
-	ThrowIfFailed(_SwapChain->Present(0, 0));
+	{
+		PROFILE_ZONE("Present");
+		ThrowIfFailed(_SwapChain->Present(0, 0));
+	}
 	_CurrBackBuffer = (_CurrBackBuffer + 1) % SwapChainBufferCount;
 
 	_CurrFrameResource->Fence = ++_CurrentFence;
 
-	_CommandQueue->Signal(_Fence.Get(), _CurrentFence);
+	_FrameFence->Signal(_CurrentFence);
+	_FrameQueue->EndFrame(_CurrentFence);
+
+	// frames begin capturing in Render()
+	if (_CaptureFramesLeft > 0 && _Capture->Capturing())
+	{
+		RecordingCommandList recorder;
+		RecordFrameCommands(recorder, 0, (UINT)_DrawKeys.size());
+		_Capture->EndFrame(recorder.Stream());
+
+		if (--_CaptureFramesLeft == 0)
+			FinishCapture();
+	}
+
+	Profiler::Get().Collect();
+	if (_TraceFramesLeft > 0 && --_TraceFramesLeft == 0)
+		FinishTrace();
 }
 
 void GraphicsWindow::Update()
 {
+	PROFILE_ZONE("Update");
+
+	// the render thread took the previous frame and draws it meanwhile
+	FrameSnapshot* frame;
+	{
+		PROFILE_ZONE("PipelineWait");
+		frame = &_Pipeline->BeginFrame();
+	}
+
 	UpdateCamera(_game_timer);
 	UpdateFixedCamera(_game_timer);
 
-	_CurrFrameResourceIndex = (_CurrFrameResourceIndex + 1) % gNumFrameResources;
-	_CurrFrameResource = _FrameResources[_CurrFrameResourceIndex].get();
+	frame->Camera = { _Theta, _Phi, _Radius };
+	frame->EyePos = _EyePos;
+	frame->View = _View;
+	frame->Proj = _Proj;
+	frame->PixelScale = 0.5f * _ClientHeight * _Proj._22;
+	UpdateMainPassCB(_game_timer, frame->Pass);
+
+	// the slot still holds the moves of an older frame
+	frame->Transforms.swap(_MovedItems);
+	_MovedItems.clear();
+
+	_Pipeline->EndFrame();
+}
+
+void GraphicsWindow::SetWorld(RenderItemHandle item, const DirectX::XMFLOAT4X4& world)
+{
+	_MovedItems.push_back({ item, world });
+}
+
+void GraphicsWindow::Render(const FrameSnapshot& frame)
+{
+	PROFILE_ZONE("Render");
+
+	for (const SnapshotTransform& moved : frame.Transforms)
+	{
+		if (_Ritems.IsValid(moved.Item))
+			_Ritems.SetWorld(moved.Item, moved.World);
+	}
+
+	_Ritems.SelectLods(frame.EyePos, frame.PixelScale, gLodMaxPixelError);
+	CullRenderItems(frame);
+	RequestTextureMips(frame);
+	BuildDrawKeys(frame);
 
-	if (_CurrFrameResource->Fence != 0 && _Fence->GetCompletedValue() < _CurrFrameResource->Fence)
 	{
-		HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
-		ThrowIfFailed(_Fence->SetEventOnCompletion(_CurrFrameResource->Fence, eventHandle));
-		WaitForSingleObject(eventHandle, INFINITE);
-		CloseHandle(eventHandle);
+		PROFILE_ZONE("FrameFenceWait");
+		_CurrFrameResourceIndex = (int)_FrameQueue->BeginFrame();
 	}
+	_CurrFrameResource = _FrameResources[_CurrFrameResourceIndex].get();
+
+	if (_CaptureFramesLeft > 0)
+		_Capture->BeginFrame(frame.Camera);
+
+	// Draw() signals the next fence value once this frame is recorded
+	_Constants->BeginFrame(_CurrentFence + 1, _FrameFence->CompletedValue());
 
-	UpdateObjectCBs(_game_timer);
-	UpdateMaterialCBs(_game_timer);
-	UpdateMainPassCB(_game_timer);
+	UpdateObjectCBs();
+	UpdateMaterialCBs();
+
+	_MainPassCB = frame.Pass;
+	_PassCBAddress = _Constants->Push(_MainPassCB);
+
+	Draw();
 }
 
 LRESULT GraphicsWindow::OnResize()
 {
+	// startup resizes come before the pipeline exists
+	if (_Pipeline)
+		_Pipeline->Flush();
+
 	AbstractWindow::OnResize();
 
-	DirectX::XMMATRIX P = DirectX::XMMatrixPerspectiveFovLH(0.25f * DirectX::XM_PI, AspectRatio(), 1.0f, 1000.0f);
+	DirectX::XMMATRIX P = DirectX::XMMatrixPerspectiveFovLH(0.25f * DirectX::XM_PI, AspectRatio(), gNearZ, gFarZ);
 	XMStoreFloat4x4(&_Proj, P);
 
 	return 0;
@@ -156,6 +374,10 @@ LRESULT GraphicsWindow::OnMouseDown(WPARAM btnState, int x, int y)
 	}
 	else
 	{
+		// picking reads the render thread's items
+		if (_Pipeline)
+			_Pipeline->Flush();
+
 		PickFixed(x, y);
 	}
 
@@ -176,6 +398,12 @@ LRESULT GraphicsWindow::OnMouseUp(WPARAM btnState, int x, int y)
 	KillTimer(Window(), IDT_TIMER_IN);
 	KillTimer(Window(), IDT_TIMER_OUT);
 
+	if (_PressedButton != RenderItemHandle())
+	{
+		SetWorld(_PressedButton, _PressedButtonWorld);
+		_PressedButton = RenderItemHandle();
+	}
+
 	return 0;
 }
 
@@ -213,51 +441,68 @@ LRESULT GraphicsWindow::OnMouseMove(WPARAM btnState, int x, int y)
 	return 0;
 }
 
-void GraphicsWindow::LoadTextures()
+LRESULT GraphicsWindow::OnKeyDown(WPARAM wParam, LPARAM lParam)
 {
-	std::vector<std::string> texNames =
+	// the function keys work on the render thread's state
+	if (_Pipeline && wParam >= VK_F5 && wParam <= VK_F12)
+		_Pipeline->Flush();
+
+	if (wParam == VK_F12)
 	{
-		"SkyTex",
+		RenderSoftwareFrame("SoftwareFrame.ppm");
+		return 0;
+	}
 
-		"upTex",
-		"downTex",
-		"leftTex",
-		"rightTex",
-		"zoominTex",
-		"zoomoutTex",
+	if (wParam == VK_F11)
+	{
+		RecordFrames(gRecordFrameCount);
+		return 0;
+	}
 
-		"groundTex",
-		"churchBlockTex",
-		"churchDomeTex"
-	};
+	if (wParam == VK_F10)
+	{
+		StartCapture(gCaptureFrameCount);
+		return 0;
+	}
 
-	std::vector<std::wstring> texFilenames =
+	if (wParam == VK_F9)
 	{
-		TEXTURE_PATH L"Sky.dds",
+		StartTrace(gTraceFrameCount);
+		return 0;
+	}
 
-		TEXTURE_PATH L"up.dds",
-		TEXTURE_PATH L"down.dds",
-		TEXTURE_PATH L"left.dds",
-		TEXTURE_PATH L"right.dds",
-		TEXTURE_PATH L"zoomin.dds",
-		TEXTURE_PATH L"zoomout.dds",
+	if (wParam == VK_F8)
+	{
+		NextFrameRateTarget();
+		return 0;
+	}
 
-		TEXTURE_PATH L"ground.dds",
-		TEXTURE_PATH L"church-block.dds",
-		TEXTURE_PATH L"church-dome.dds"
-	};
+	if (wParam == VK_F7)
+	{
+		NextFrameQueueDepth();
+		return 0;
+	}
 
-	for (int i = 0; i < (int)texNames.size(); ++i)
+	if (wParam == VK_F5)
 	{
-		auto tex = std::make_unique<Texture>();
-		tex->Name = texNames[i];
-		tex->Filename = texFilenames[i];
-		ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(_d3dDevice.Get(),
-			_CommandList.Get(), tex->Filename.c_str(),
-			tex->Resource, tex->UploadHeap));
+		ScaleMonastery(gBenchmarkDrawCount);
+		return 0;
+	}
 
-		_Textures[tex->Name] = std::move(tex);
+	if (wParam == VK_F6)
+	{
+		_Pipeline->SetThreaded(!_Pipeline->Threaded());
+		OutputDebugStringA(_Pipeline->Threaded() ? "FramePipeline: render thread\n" : "FramePipeline: serial\n");
+		return 0;
 	}
+
+	return AbstractWindow::OnKeyDown(wParam, lParam);
+}
+
+void GraphicsWindow::LoadTextures(TextureLoader& loader)
+{
+	for (const SceneMaterials::TextureFile& file : SceneMaterials::TextureFiles(TEXTURE_PATH))
+		loader.Queue(file.Name, file.Filename, file.Streamed);
 }
 
 void GraphicsWindow::BuildMonastery()
@@ -267,11 +512,14 @@ void GraphicsWindow::BuildMonastery()
 
 void GraphicsWindow::BuildRootSignature()
 {
+	// unbounded, the heap grows with the textures; a space of its own, as an
+	// unbounded range overlaps every register after t0 in its space
 	CD3DX12_DESCRIPTOR_RANGE texTable0;
 	texTable0.Init(
 		D3D12_DESCRIPTOR_RANGE_TYPE_SRV,
-		1,
-		0);
+		UINT_MAX,
+		0,
+		2);
 
 	CD3DX12_DESCRIPTOR_RANGE texTable1;
 	texTable1.Init(
@@ -279,17 +527,19 @@ void GraphicsWindow::BuildRootSignature()
 		1,
 		1);
 
-	CD3DX12_ROOT_PARAMETER slotRootParameter[5];
+	CD3DX12_ROOT_PARAMETER slotRootParameter[6];
 
 	slotRootParameter[0].InitAsDescriptorTable(1, &texTable0, D3D12_SHADER_VISIBILITY_PIXEL);
 	slotRootParameter[1].InitAsConstantBufferView(0);
 	slotRootParameter[2].InitAsConstantBufferView(1);
 	slotRootParameter[3].InitAsConstantBufferView(2);
 	slotRootParameter[4].InitAsDescriptorTable(1, &texTable1, D3D12_SHADER_VISIBILITY_PIXEL);
+	// the instance data, t0 in space1
+	slotRootParameter[5].InitAsShaderResourceView(0, 1);
 
 	auto staticSamplers = GetStaticSamplers();
 
-	CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(5, slotRootParameter,
+	CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(6, slotRootParameter,
 		(UINT)staticSamplers.size(), staticSamplers.data(),
 		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
@@ -318,15 +568,20 @@ void GraphicsWindow::BuildShadersAndInputLayout()
 	_Shaders["skyPS"] = d3dUtil::LoadBinary(SHADER_PATH L"sky_ps.cso");
 	//d3dUtil::CompileShader(SHADER_PATH L"Sky.hlsl", nullptr, "PS", "ps_5_1");
 	
-	_Shaders["fixedVS"] = d3dUtil::LoadBinary(SHADER_PATH L"fixed_vs.cso");
-	//d3dUtil::CompileShader(SHADER_PATH L"Fixed.hlsl", nullptr, "VS", "vs_5_1");
-	_Shaders["fixedPS"] = d3dUtil::LoadBinary(SHADER_PATH L"fixed_ps.cso");
-	//d3dUtil::CompileShader(SHADER_PATH L"Fixed.hlsl", nullptr, "PS", "ps_5_1");
+	_Shaders["fixedVS"] = d3dUtil::CompileShader(SHADER_PATH L"Fixed.hlsl", nullptr, "VS", "vs_5_1");
+	//d3dUtil::LoadBinary(SHADER_PATH L"fixed_vs.cso");
+	_Shaders["fixedPS"] = d3dUtil::CompileShader(SHADER_PATH L"Fixed.hlsl", nullptr, "PS", "ps_5_1");
+	//d3dUtil::LoadBinary(SHADER_PATH L"fixed_ps.cso");
 
-	_Shaders["opaqueVS"] = d3dUtil::LoadBinary(SHADER_PATH L"default_vs.cso");
-		//d3dUtil::CompileShader(SHADER_PATH L"Default.hlsl", nullptr, "VS", "vs_5_1");
-	_Shaders["opaquePS"] = d3dUtil::LoadBinary(SHADER_PATH L"default_ps.cso");
-		//d3dUtil::CompileShader(SHADER_PATH L"Default.hlsl", nullptr, "PS", "ps_5_1");
+	_Shaders["opaqueVS"] = d3dUtil::CompileShader(SHADER_PATH L"Default.hlsl", nullptr, "VS", "vs_5_1");
+		//d3dUtil::LoadBinary(SHADER_PATH L"default_vs.cso");
+	_Shaders["opaquePS"] = d3dUtil::CompileShader(SHADER_PATH L"Default.hlsl", nullptr, "PS", "ps_5_1");
+		//d3dUtil::LoadBinary(SHADER_PATH L"default_ps.cso");
+
+	_Shaders["instancedVS"] = d3dUtil::CompileShader(SHADER_PATH L"Instanced.hlsl", nullptr, "VS", "vs_5_1");
+		//d3dUtil::LoadBinary(SHADER_PATH L"instanced_vs.cso");
+	_Shaders["instancedPS"] = d3dUtil::CompileShader(SHADER_PATH L"Instanced.hlsl", nullptr, "PS", "ps_5_1");
+		//d3dUtil::LoadBinary(SHADER_PATH L"instanced_ps.cso");
 
 	_InputLayout =
 	{
@@ -339,10 +594,36 @@ void GraphicsWindow::BuildShadersAndInputLayout()
 
 void GraphicsWindow::BuildGeometry()
 {
-	Sky::BuildGeometry(_d3dDevice.Get(), _CommandList.Get(), _Geometries);
-	Fixed::BuildGeometry(_d3dDevice.Get(), _CommandList.Get(), _Geometries);
+	Sky::BuildGeometry(_Geometries);
+	Fixed::BuildGeometry(_Geometries);
+
+	_Monastery->BuildGeometry(_Geometries, *_Jobs);
 
-	_Monastery->BuildGeometry(_d3dDevice.Get(), _CommandList.Get(), _Geometries);
+	// the uploads record into the command list, so they stay on this thread
+	for (auto& g : _Geometries)
+		_GeometryBuffer->Upload(*g.second);
+}
+
+const void* GraphicsWindow::MoveGeometry(UINT handle, UINT64 offset)
+{
+	// the views are rebuilt from the offsets at every draw
+	for (auto& g : _Geometries)
+	{
+		MeshGeometry* geo = g.second.get();
+		if (geo->VertexBufferHandle == handle)
+		{
+			geo->VertexBufferOffset = offset;
+			return geo->VertexBufferCPU.data();
+		}
+		if (geo->IndexBufferHandle == handle)
+		{
+			geo->IndexBufferOffset = offset;
+			return geo->IndexBufferCPU.data();
+		}
+	}
+
+	assert(false);
+	return nullptr;
 }
 
 void GraphicsWindow::BuildPSOs()
@@ -421,52 +702,223 @@ void GraphicsWindow::BuildPSOs()
 	};
 
 	ThrowIfFailed(_d3dDevice->CreateGraphicsPipelineState(&opaquePsoDesc, IID_PPV_ARGS(&_PSOs["opaque"])));
+
+	//
+	// PSO for Instanced objects.
+	//
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC instancedPsoDesc = opaquePsoDesc;
+	instancedPsoDesc.VS =
+	{
+		reinterpret_cast<BYTE*>(_Shaders["instancedVS"]->GetBufferPointer()),
+		_Shaders["instancedVS"]->GetBufferSize()
+	};
+
+	instancedPsoDesc.PS =
+	{
+		reinterpret_cast<BYTE*>(_Shaders["instancedPS"]->GetBufferPointer()),
+		_Shaders["instancedPS"]->GetBufferSize()
+	};
+
+	ThrowIfFailed(_d3dDevice->CreateGraphicsPipelineState(&instancedPsoDesc, IID_PPV_ARGS(&_PSOs["instanced"])));
+
+	_LayerPSOs[(int)RenderLayer::Sky] = _PSOs["sky"].Get();
+	_LayerPSOs[(int)RenderLayer::Fixed] = _PSOs["fixed"].Get();
+	_LayerPSOs[(int)RenderLayer::Opaque] = _PSOs["opaque"].Get();
+	_LayerPSOs[(int)RenderLayer::Instanced] = _PSOs["instanced"].Get();
 }
 
 void GraphicsWindow::BuildFrameResources()
 {
-	for (int i = 0; i < gNumFrameResources; ++i)
+	for (UINT i = 0; i < _FrameQueue->SlotCount(); ++i)
 	{
-		_FrameResources.push_back(std::make_unique<FrameResource>(_d3dDevice.Get(),
-			1, (UINT)_AllRitems.size(), (UINT)_Materials.size()));
+		_FrameResources.push_back(std::make_unique<FrameResource>(_d3dDevice.Get(), *_RenderDevice,
+			_Ritems.InstanceCount(), _Jobs->ThreadCount()));
 	}
 }
 
+void GraphicsWindow::BuildCommandLists()
+{
+	// at most one chunk per job thread; lists are reset with the allocators
+	// of the frame they record, so any frame resource's will do to create them
+	_ChunkCommandLists.resize(_Jobs->ThreadCount());
+	for (UINT i = 0; i < _Jobs->ThreadCount(); ++i)
+	{
+		ThrowIfFailed(_d3dDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT,
+			_FrameResources[0]->ThreadCmdListAllocs[i].Get(), nullptr, IID_PPV_ARGS(_ChunkCommandLists[i].GetAddressOf())));
+		ThrowIfFailed(_ChunkCommandLists[i]->Close());
+	}
+
+	ThrowIfFailed(_d3dDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT,
+		_FrameResources[0]->CmdListAlloc.Get(), nullptr, IID_PPV_ARGS(_PostCommandList.GetAddressOf())));
+	ThrowIfFailed(_PostCommandList->Close());
+}
+
 void GraphicsWindow::BuildRenderItems()
 {
-	Sky::BuildRenderItems(_Geometries, _Materials, _AllRitems, _RitemLayer[(int)RenderLayer::Sky]);
-	Fixed::BuildRenderItems(_Geometries, _Materials, _AllRitems, _RitemLayer[(int)RenderLayer::Fixed]);
+	_Ritems.SetFrameResourceCount(_FrameQueue->SlotCount());
+
+	Sky::BuildRenderItems(_Geometries, _Materials, _Ritems);
+	Fixed::BuildRenderItems(_Geometries, _Materials, _Ritems);
+
+	_Monastery->BuildRenderItems(_Geometries, _Materials, _Ritems);
 
-	_Monastery->BuildRenderItems(_Geometries, _Materials, _AllRitems, _RitemLayer[(int)RenderLayer::Opaque]);
+	InstanceGrouping::Group(_Ritems, RenderLayer::Opaque, _MaterialTable, gInstanceClusterSize, gMinInstances);
+
+	_LayerCullers[(int)RenderLayer::Opaque].Build(_Ritems, RenderLayer::Opaque);
+	_LayerCullers[(int)RenderLayer::Instanced].Build(_Ritems, RenderLayer::Instanced);
 }
 
-void GraphicsWindow::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems)
+void GraphicsWindow::CullRenderItems(const FrameSnapshot& frame)
 {
-	UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
-	UINT matCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(MaterialConstants));
-	
-	auto objectCB = _CurrFrameResource->ObjectCB->Resource();
-	auto matCB = _CurrFrameResource->MaterialCB->Resource();
-	
-	for (size_t i = 0; i < ritems.size(); ++i)
+	PROFILE_ZONE("CullRenderItems");
+
+	DirectX::XMMATRIX view = XMLoadFloat4x4(&frame.View);
+	DirectX::XMMATRIX proj = XMLoadFloat4x4(&frame.Proj);
+
+	DirectX::XMFLOAT4X4 viewProj;
+	XMStoreFloat4x4(&viewProj, XMMatrixMultiply(view, proj));
+
+	// the sky is centered on the eye and the fixed buttons live in screen space,
+	// so only the world layers are tested against the frustum
+	_VisibleRitems[(int)RenderLayer::Sky] = _Ritems.Layer(RenderLayer::Sky);
+	_VisibleRitems[(int)RenderLayer::Fixed] = _Ritems.Layer(RenderLayer::Fixed);
+
+	// items moved by the snapshot or added since the last frame
+	_LayerCullers[(int)RenderLayer::Opaque].Update(_Ritems, RenderLayer::Opaque);
+	_LayerCullers[(int)RenderLayer::Instanced].Update(_Ritems, RenderLayer::Instanced);
+
+	_LayerCullers[(int)RenderLayer::Opaque].Cull(viewProj, _VisibleRitems[(int)RenderLayer::Opaque], _Jobs.get());
+	_LayerCullers[(int)RenderLayer::Instanced].Cull(viewProj, _VisibleRitems[(int)RenderLayer::Instanced], _Jobs.get());
+}
+
+void GraphicsWindow::RequestTextureMips(const FrameSnapshot& frame)
+{
+	PROFILE_ZONE("RequestTextureMips");
+
+	const auto& materialIds = _Ritems.MaterialIds();
+
+	for (int layer : { (int)RenderLayer::Opaque, (int)RenderLayer::Instanced })
 	{
-		auto ri = ritems[i];
+		for (UINT index : _VisibleRitems[layer])
+		{
+			int texture = _StreamingTextures->Find(_MaterialTable[materialIds[index]]->DiffuseMap);
+			if (texture < 0)
+				continue;
+
+			// items without texture coordinates keep the tail
+			float uvPerPixel = _Ritems.UvPerPixel(index, frame.EyePos, frame.PixelScale);
+			if (uvPerPixel > 0.0f)
+				_TextureStreamer->Request((UINT)texture, uvPerPixel);
+		}
+	}
+}
+
+void GraphicsWindow::BuildDrawKeys(const FrameSnapshot& frame)
+{
+	PROFILE_ZONE("BuildDrawKeys");
 
-		cmdList->IASetVertexBuffers(0, 1, &ri->Geo->VertexBufferView());
-		cmdList->IASetIndexBuffer(&ri->Geo->IndexBufferView());
-		cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
+	DirectX::XMMATRIX view = XMLoadFloat4x4(&frame.View);
 
-		CD3DX12_GPU_DESCRIPTOR_HANDLE tex(_SrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
-		tex.Offset(ri->Mat->DiffuseSrvHeapIndex, _CbvSrvDescriptorSize);
+	const auto& worldBounds = _Ritems.WorldBounds();
+	const auto& geometryIds = _Ritems.GeometryIds();
+	const auto& materialIds = _Ritems.MaterialIds();
 
-		D3D12_GPU_VIRTUAL_ADDRESS objCBAddress = objectCB->GetGPUVirtualAddress() + ri->ObjCBIndex * objCBByteSize;
-		D3D12_GPU_VIRTUAL_ADDRESS matCBAddress = matCB->GetGPUVirtualAddress() + ri->Mat->MatCBIndex * matCBByteSize;
+	_DrawKeys.clear();
+	for (int layer = 0; layer < (int)RenderLayer::Count; ++layer)
+	{
+		// the sky and the fixed buttons do not depend on the eye position
+		bool depthSorted = layer == (int)RenderLayer::Opaque || layer == (int)RenderLayer::Instanced;
 
-		cmdList->SetGraphicsRootDescriptorTable(0, tex);
-		cmdList->SetGraphicsRootConstantBufferView(1, objCBAddress);
-		cmdList->SetGraphicsRootConstantBufferView(3, matCBAddress);
-		cmdList->DrawIndexedInstanced(ri->IndexCount, 1, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
+		for (UINT index : _VisibleRitems[layer])
+		{
+			UINT depthBucket = 0;
+			if (depthSorted)
+			{
+				DirectX::XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&worldBounds[index].Center), view);
+				depthBucket = DrawKey::DepthBucket(DirectX::XMVectorGetZ(center), gFarZ);
+			}
+
+			// one PSO per layer
+			_DrawKeys.push_back(DrawKey::Make(layer, layer, geometryIds[index], materialIds[index], depthBucket, index));
+		}
 	}
+
+	DrawKey::Sort(_DrawKeys, _DrawKeyScratch);
+}
+
+void GraphicsWindow::SetFrameState(ID3D12GraphicsCommandList* cmdList)
+{
+	cmdList->RSSetViewports(1, &_ScreenViewport);
+	cmdList->RSSetScissorRects(1, &_ScissorRect);
+
+	cmdList->OMSetRenderTargets(1, &CurrentBackBufferView(), true, &DepthStencilView());
+
+	ID3D12DescriptorHeap* descriptorHeaps[] = { _SrvHeap->Heap() };
+	cmdList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+
+	cmdList->SetGraphicsRootSignature(_RootSignature.Get());
+}
+
+void GraphicsWindow::RecordChunks()
+{
+	PROFILE_ZONE("RecordChunks");
+
+	// A job thread records its chunks one after another into its own
+	// allocator. The render thread is attached to the job system, so it
+	// never shares index 0 with the window thread, which may run these
+	// chunks too while it waits on jobs of the next frame.
+	_Jobs->ParallelFor((UINT)_DrawChunks.size(), 1, [this](UINT begin, UINT end)
+	{
+		ID3D12CommandAllocator* alloc = _CurrFrameResource->ThreadCmdListAllocs[_Jobs->ThreadIndex()].Get();
+
+		for (UINT c = begin; c < end; ++c)
+		{
+			ID3D12GraphicsCommandList* list = _ChunkCommandLists[c].Get();
+
+			ThrowIfFailed(list->Reset(alloc, nullptr));
+			SetFrameState(list);
+
+			D3D12CommandList chunkList(list, _LayerPSOs);
+			RecordFrameCommands(chunkList, _DrawChunks[c].Begin, _DrawChunks[c].End);
+
+			ThrowIfFailed(list->Close());
+		}
+	});
+
+	for (UINT c = 0; c < (UINT)_DrawChunks.size(); ++c)
+		_SubmitLists.push_back(_ChunkCommandLists[c].Get());
+}
+
+void GraphicsWindow::RecordFrameCommands(RenderCommandList& cmdList, UINT begin, UINT end)
+{
+	cmdList.SetGraphicsRootConstantBufferView(2, _PassCBAddress);
+
+	// the whole heap is one texture array, the material constants index it
+	cmdList.SetGraphicsRootDescriptorTable(0, _SrvHeap->GpuHandle(0).ptr);
+	cmdList.SetGraphicsRootDescriptorTable(4, _SrvHeap->GpuHandle(_Textures.at("SkyTex")->SrvIndex).ptr);
+
+	DrawRenderItems(cmdList, _DrawKeys, begin, end);
+}
+
+void GraphicsWindow::DrawRenderItems(RenderCommandList& cmdList, const std::vector<UINT64>& drawKeys, UINT begin, UINT end)
+{
+	PROFILE_ZONE("DrawRenderItems");
+
+	DrawBindings bindings;
+	bindings.ObjectCB = _ObjectCBAddress;
+	bindings.ObjectCBStride = ConstantAllocator::Stride<ObjectConstants>();
+	bindings.MaterialCB = _MaterialCBAddress;
+	bindings.MaterialCBStride = ConstantAllocator::Stride<MaterialConstants>();
+	bindings.Instances = _CurrFrameResource->InstanceBuffer->GpuAddress();
+	bindings.BufferViews = [](const MeshGeometry& geo, RenderVertexBufferView& vbv, RenderIndexBufferView& ibv) {
+		D3D12_VERTEX_BUFFER_VIEW d3dVbv = geo.VertexBufferView();
+		D3D12_INDEX_BUFFER_VIEW d3dIbv = geo.IndexBufferView();
+		vbv = { d3dVbv.BufferLocation, d3dVbv.SizeInBytes, d3dVbv.StrideInBytes };
+		ibv = { d3dIbv.BufferLocation, d3dIbv.SizeInBytes,
+			d3dIbv.Format == DXGI_FORMAT_R16_UINT ? RenderIndexFormat::Uint16 : RenderIndexFormat::Uint32 };
+	};
+
+	DrawSubmission::Record(cmdList, _Ritems, drawKeys, begin, end, bindings);
 }
 
 void GraphicsWindow::UpdateCamera(const GameTimer& gt)
@@ -493,52 +945,95 @@ void GraphicsWindow::UpdateFixedCamera(const GameTimer& gt)
 	XMStoreFloat4x4(&_FixedView, view);
 }
 
-void GraphicsWindow::UpdateObjectCBs(const GameTimer& gt)
+void GraphicsWindow::UpdateObjectCBs()
 {
-	auto currObjectCB = _CurrFrameResource->ObjectCB.get();
-	for (auto& e : _AllRitems)
+	PROFILE_ZONE("UpdateObjectCBs");
+
+	auto currInstanceBuffer = _CurrFrameResource->InstanceBuffer.get();
+	const auto& worlds = _Ritems.World();
+	const auto& texTransforms = _Ritems.TexTransform();
+	const auto& drawArgs = _Ritems.DrawArgs();
+	const auto& instances = _Ritems.Instances();
+
+	// one constant buffer per draw, only the visible items get one
+	const UINT objCBByteSize = ConstantAllocator::Stride<ObjectConstants>();
+	ConstantAllocator::Allocation objectCBs = _Constants->Allocate((UINT64)_DrawKeys.size() * objCBByteSize);
+	_ObjectCBAddress = objectCBs.GpuAddress;
+
+	_Jobs->ParallelFor((UINT)_DrawKeys.size(), 256, [&](UINT begin, UINT end)
 	{
-		if (e->NumFramesDirty > 0)
+		for (UINT k = begin; k < end; ++k)
 		{
-			DirectX::XMMATRIX world = XMLoadFloat4x4(&e->World);
-			DirectX::XMMATRIX texTransform = XMLoadFloat4x4(&e->TexTransform);
+			UINT index = DrawKey::Index(_DrawKeys[k]);
+
+			DirectX::XMMATRIX world = XMLoadFloat4x4(&worlds[index]);
+			DirectX::XMMATRIX texTransform = XMLoadFloat4x4(&texTransforms[index]);
 
 			ObjectConstants objConstants;
 			XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
 			XMStoreFloat4x4(&objConstants.TexTransform, XMMatrixTranspose(texTransform));
 
-			currObjectCB->CopyData(e->ObjCBIndex, objConstants);
+			memcpy(objectCBs.Data + (UINT64)k * objCBByteSize, &objConstants, sizeof(ObjectConstants));
+		}
+	});
 
-			e->NumFramesDirty--;
+	const auto& dirtyItems = _Ritems.DirtyItems(_CurrFrameResourceIndex);
+
+	// instances keep their slots in the frame resource's buffer, so only the
+	// changed items copy theirs; every instance owns its slot, so the copies
+	// can run on any thread
+	_Jobs->ParallelFor((UINT)dirtyItems.size(), 64, [&](UINT begin, UINT end)
+	{
+		for (UINT d = begin; d < end; ++d)
+		{
+			UINT index = dirtyItems[d];
+
+			const RenderItemDrawArgs& args = drawArgs[index];
+			_Jobs->ParallelFor(args.InstanceCount, 256, [&](UINT instBegin, UINT instEnd)
+			{
+				for (UINT i = args.InstanceOffset + instBegin; i < args.InstanceOffset + instEnd; ++i)
+				{
+					InstanceData instData;
+					XMStoreFloat4x4(&instData.World, XMMatrixTranspose(XMLoadFloat4x4(&instances[i].World)));
+					XMStoreFloat4x4(&instData.TexTransform, XMMatrixTranspose(XMLoadFloat4x4(&instances[i].TexTransform)));
+
+					currInstanceBuffer->CopyData(i, instData);
+				}
+			});
 		}
-	}
+	});
+
+	_Ritems.ClearDirty(_CurrFrameResourceIndex);
 }
 
-void GraphicsWindow::UpdateMaterialCBs(const GameTimer& gt)
+void GraphicsWindow::UpdateMaterialCBs()
 {
-	auto currMaterialCB = _CurrFrameResource->MaterialCB.get();
-	for (auto& e : _Materials)
-	{
-		Material* mat = e.second.get();
-		if (mat->NumFramesDirty > 0)
-		{
-			DirectX::XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
+	PROFILE_ZONE("UpdateMaterialCBs");
 
-			MaterialConstants matConstants;
-			matConstants.DiffuseAlbedo = mat->DiffuseAlbedo;
-			matConstants.FresnelR0 = mat->FresnelR0;
-			matConstants.Roughness = mat->Roughness;
-			XMStoreFloat4x4(&matConstants.MatTransform, XMMatrixTranspose(matTransform));
+	// the frame's buffer is new, so every material is written
+	const UINT matCBByteSize = ConstantAllocator::Stride<MaterialConstants>();
+	ConstantAllocator::Allocation materialCBs = _Constants->Allocate((UINT64)_MaterialTable.size() * matCBByteSize);
+	_MaterialCBAddress = materialCBs.GpuAddress;
 
-			currMaterialCB->CopyData(mat->MatCBIndex, matConstants);
+	for (const Material* mat : _MaterialTable)
+	{
+		DirectX::XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
 
-			mat->NumFramesDirty--;
-		}
+		MaterialConstants matConstants;
+		matConstants.DiffuseAlbedo = mat->DiffuseAlbedo;
+		matConstants.FresnelR0 = mat->FresnelR0;
+		matConstants.Roughness = mat->Roughness;
+		XMStoreFloat4x4(&matConstants.MatTransform, XMMatrixTranspose(matTransform));
+		matConstants.DiffuseMapIndex = mat->DiffuseMap->SrvIndex;
+
+		memcpy(materialCBs.Data + (UINT64)mat->MatCBIndex * matCBByteSize, &matConstants, sizeof(MaterialConstants));
 	}
 }
 
-void GraphicsWindow::UpdateMainPassCB(const GameTimer& gt)
+void GraphicsWindow::UpdateMainPassCB(const GameTimer& gt, PassConstants& pass)
 {
+	PROFILE_ZONE("UpdateMainPassCB");
+
 	DirectX::XMMATRIX view = XMLoadFloat4x4(&_View);
 	DirectX::XMMATRIX proj = XMLoadFloat4x4(&_Proj);
 	DirectX::XMMATRIX fixedView = XMLoadFloat4x4(&_FixedView);
@@ -548,177 +1043,55 @@ void GraphicsWindow::UpdateMainPassCB(const GameTimer& gt)
 	DirectX::XMMATRIX invProj = XMMatrixInverse(&XMMatrixDeterminant(proj), proj);
 	DirectX::XMMATRIX invViewProj = XMMatrixInverse(&XMMatrixDeterminant(viewProj), viewProj);
 
-	XMStoreFloat4x4(&_MainPassCB.View, XMMatrixTranspose(view));
-	XMStoreFloat4x4(&_MainPassCB.InvView, XMMatrixTranspose(invView));
-	XMStoreFloat4x4(&_MainPassCB.Proj, XMMatrixTranspose(proj));
-	XMStoreFloat4x4(&_MainPassCB.InvProj, XMMatrixTranspose(invProj));
-	XMStoreFloat4x4(&_MainPassCB.ViewProj, XMMatrixTranspose(viewProj));
-	XMStoreFloat4x4(&_MainPassCB.InvViewProj, XMMatrixTranspose(invViewProj));
-	XMStoreFloat4x4(&_MainPassCB.FixedView, XMMatrixTranspose(fixedView));
-	_MainPassCB.EyePosW = _EyePos;
-	_MainPassCB.RenderTargetSize = DirectX::XMFLOAT2((float)_ClientWidth, (float)_ClientHeight);
-	_MainPassCB.InvRenderTargetSize = DirectX::XMFLOAT2(1.0f / _ClientWidth, 1.0f / _ClientHeight);
-	_MainPassCB.NearZ = 1.0f;
-	_MainPassCB.FarZ = 1000.0f;
-	_MainPassCB.TotalTime = _game_timer.TotalTime();
-	_MainPassCB.DeltaTime = _game_timer.DeltaTime();
-	_MainPassCB.AmbientLight = { 0.25f, 0.25f, 0.35f, 1.0f };
-	_MainPassCB.Lights[0].Direction = { 0.57735f, -0.57735f, 0.57735f };
-	_MainPassCB.Lights[0].Strength = { 0.8f, 0.8f, 0.8f };
-	_MainPassCB.Lights[1].Direction = { -0.57735f, -0.57735f, 0.57735f };
-	_MainPassCB.Lights[1].Strength = { 0.4f, 0.4f, 0.4f };
-	_MainPassCB.Lights[2].Direction = { 0.0f, -0.707f, -0.707f };
-	_MainPassCB.Lights[2].Strength = { 0.2f, 0.2f, 0.2f };
-
-	auto currPassCB = _CurrFrameResource->PassCB.get();
-	currPassCB->CopyData(0, _MainPassCB);
+	XMStoreFloat4x4(&pass.View, XMMatrixTranspose(view));
+	XMStoreFloat4x4(&pass.InvView, XMMatrixTranspose(invView));
+	XMStoreFloat4x4(&pass.Proj, XMMatrixTranspose(proj));
+	XMStoreFloat4x4(&pass.InvProj, XMMatrixTranspose(invProj));
+	XMStoreFloat4x4(&pass.ViewProj, XMMatrixTranspose(viewProj));
+	XMStoreFloat4x4(&pass.InvViewProj, XMMatrixTranspose(invViewProj));
+	XMStoreFloat4x4(&pass.FixedView, XMMatrixTranspose(fixedView));
+	pass.EyePosW = _EyePos;
+	pass.RenderTargetSize = DirectX::XMFLOAT2((float)_ClientWidth, (float)_ClientHeight);
+	pass.InvRenderTargetSize = DirectX::XMFLOAT2(1.0f / _ClientWidth, 1.0f / _ClientHeight);
+	pass.NearZ = gNearZ;
+	pass.FarZ = gFarZ;
+	pass.TotalTime = gt.TotalTime();
+	pass.DeltaTime = gt.DeltaTime();
+	pass.AmbientLight = { 0.25f, 0.25f, 0.35f, 1.0f };
+	pass.Lights[0].Direction = { 0.57735f, -0.57735f, 0.57735f };
+	pass.Lights[0].Strength = { 0.8f, 0.8f, 0.8f };
+	pass.Lights[1].Direction = { -0.57735f, -0.57735f, 0.57735f };
+	pass.Lights[1].Strength = { 0.4f, 0.4f, 0.4f };
+	pass.Lights[2].Direction = { 0.0f, -0.707f, -0.707f };
+	pass.Lights[2].Strength = { 0.2f, 0.2f, 0.2f };
 }
 
 
 void GraphicsWindow::BuildDescriptorHeaps()
 {
-	D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-	srvHeapDesc.NumDescriptors = 10;
-	srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	ThrowIfFailed(_d3dDevice->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&_SrvDescriptorHeap)));
-
-	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(_SrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
-
-	auto skyTex = _Textures["SkyTex"]->Resource; 
-	
-	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> tex2DList =
-	{
-		_Textures["upTex"]->Resource,
-		_Textures["downTex"]->Resource,
-		_Textures["leftTex"]->Resource,
-		_Textures["rightTex"]->Resource,
-		_Textures["zoominTex"]->Resource,
-		_Textures["zoomoutTex"]->Resource,
-
-		_Textures["groundTex"]->Resource,
-		_Textures["churchBlockTex"]->Resource,
-		_Textures["churchDomeTex"]->Resource
-	};
-	
+	// streamed textures got their SRVs with the first resident mips
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE; 
 	srvDesc.Texture2D.MostDetailedMip = 0;
 	srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
 
-	srvDesc.Format = skyTex->GetDesc().Format;
-	srvDesc.Texture2D.MipLevels = skyTex->GetDesc().MipLevels;
-	_d3dDevice->CreateShaderResourceView(skyTex.Get(), &srvDesc, hDescriptor);
-
-	// next descriptor
-	hDescriptor.Offset(1, _CbvSrvUavDescriptorSize);
-
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-	for (UINT i = 0; i < (UINT)tex2DList.size(); ++i)
+	for (auto& e : _Textures)
 	{
-		srvDesc.Format = tex2DList[i]->GetDesc().Format;
-		srvDesc.Texture2D.MipLevels = tex2DList[i]->GetDesc().MipLevels;
-		_d3dDevice->CreateShaderResourceView(tex2DList[i].Get(), &srvDesc, hDescriptor);
-
-		// next descriptor
-		hDescriptor.Offset(1, _CbvSrvUavDescriptorSize);
+		Texture* tex = e.second.get();
+		if (tex->SrvIndex != UINT_MAX)
+			continue;
+
+		D3D12_RESOURCE_DESC desc = tex->Resource->GetDesc();
+		srvDesc.ViewDimension = tex->Name == "SkyTex" ? D3D12_SRV_DIMENSION_TEXTURECUBE : D3D12_SRV_DIMENSION_TEXTURE2D;
+		srvDesc.Format = desc.Format;
+		srvDesc.Texture2D.MipLevels = desc.MipLevels;
+		tex->SrvIndex = _SrvHeap->CreateSrv(tex->Resource.Get(), srvDesc);
 	}
 }
 
 void GraphicsWindow::BuildMaterials()
 {
-	auto sky0 = std::make_unique<Material>();
-	sky0->Name = "sky0";
-	sky0->MatCBIndex = 0;
-	sky0->DiffuseSrvHeapIndex = 0;
-	sky0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-	sky0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
-	sky0->Roughness = 0.3f;
-
-	auto up0 = std::make_unique<Material>();
-	up0->Name = "up0";
-	up0->MatCBIndex = 1;
-	up0->DiffuseSrvHeapIndex = 1;
-	up0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-	up0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
-	up0->Roughness = 0.3f;
-
-	auto down0 = std::make_unique<Material>();
-	down0->Name = "down0";
-	down0->MatCBIndex = 2;
-	down0->DiffuseSrvHeapIndex = 2;
-	down0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-	down0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
-	down0->Roughness = 0.3f;
-
-	auto left0 = std::make_unique<Material>();
-	left0->Name = "left0";
-	left0->MatCBIndex = 3;
-	left0->DiffuseSrvHeapIndex = 3;
-	left0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-	left0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
-	left0->Roughness = 0.3f;
-
-	auto right0 = std::make_unique<Material>();
-	right0->Name = "right0";
-	right0->MatCBIndex = 4;
-	right0->DiffuseSrvHeapIndex = 4;
-	right0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-	right0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
-	right0->Roughness = 0.3f;
-
-	auto zoomin0 = std::make_unique<Material>();
-	zoomin0->Name = "zoomin0";
-	zoomin0->MatCBIndex = 5;
-	zoomin0->DiffuseSrvHeapIndex = 5;
-	zoomin0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-	zoomin0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
-	zoomin0->Roughness = 0.3f;
-
-	auto zoomout0 = std::make_unique<Material>();
-	zoomout0->Name = "zoomout0";
-	zoomout0->MatCBIndex = 6;
-	zoomout0->DiffuseSrvHeapIndex = 6;
-	zoomout0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-	zoomout0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
-	zoomout0->Roughness = 0.3f;
-
-	auto ground0 = std::make_unique<Material>();
-	ground0->Name = "ground0";
-	ground0->MatCBIndex = 7;
-	ground0->DiffuseSrvHeapIndex = 7;
-	ground0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-	ground0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
-	ground0->Roughness = 0.3f;
-
-	auto churchBlock0 = std::make_unique<Material>();
-	churchBlock0->Name = "churchBlock0";
-	churchBlock0->MatCBIndex = 8;
-	churchBlock0->DiffuseSrvHeapIndex = 8;
-	churchBlock0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-	churchBlock0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
-	churchBlock0->Roughness = 0.3f;
-
-	auto churchDome0 = std::make_unique<Material>();
-	churchDome0->Name = "churchDome0";
-	churchDome0->MatCBIndex = 9;
-	churchDome0->DiffuseSrvHeapIndex = 9;
-	churchDome0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-	churchDome0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
-	
-	_Materials["sky0"] = std::move(sky0);
-
-	_Materials["up0"] = std::move(up0);
-	_Materials["down0"] = std::move(down0);
-	_Materials["left0"] = std::move(left0);
-	_Materials["right0"] = std::move(right0);
-	_Materials["zoomin0"] = std::move(zoomin0);
-	_Materials["zoomout0"] = std::move(zoomout0);
-
-	_Materials["ground0"] = std::move(ground0);
-	_Materials["churchBlock0"] = std::move(churchBlock0);
-	_Materials["churchDome0"] = std::move(churchDome0);
+	SceneMaterials::BuildMaterials(_Textures, _Materials, _MaterialTable);
 }
 
 std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> GraphicsWindow::GetStaticSamplers()
@@ -820,9 +1193,9 @@ LRESULT GraphicsWindow::OnTimer_Zoomout()
 
 void GraphicsWindow::PickFixed(int sx, int sy)
 {
-	for (auto ri : _RitemLayer[(int)RenderLayer::Fixed])
+	for (UINT index : _Ritems.Layer(RenderLayer::Fixed))
 	{
-		auto geo = ri->Geo;
+		RenderItemHandle ri = _Ritems.HandleOf(index);
 
 		XMFLOAT4X4 P = _Proj;
 
@@ -835,7 +1208,7 @@ void GraphicsWindow::PickFixed(int sx, int sy)
 		XMMATRIX V = XMLoadFloat4x4(&_FixedView);
 		XMMATRIX invView = XMMatrixInverse(&XMMatrixDeterminant(V), V);
 
-		XMMATRIX W = XMLoadFloat4x4(&ri->World);
+		XMMATRIX W = XMLoadFloat4x4(&_Ritems.World()[index]);
 		XMMATRIX invWorld = XMMatrixInverse(&XMMatrixDeterminant(W), W);
 
 		XMMATRIX toLocal = XMMatrixMultiply(invView, invWorld);
@@ -846,7 +1219,7 @@ void GraphicsWindow::PickFixed(int sx, int sy)
 		rayDir = XMVector3Normalize(rayDir);
 
 		float tmin = 0.0f;
-		if (ri->Bounds.Intersects(rayOrigin, rayDir, tmin))
+		if (_Ritems.Bounds()[index].Intersects(rayOrigin, rayDir, tmin))
 		{
 			if (ri == Fixed::_upButton)
 			{
@@ -878,6 +1251,216 @@ void GraphicsWindow::PickFixed(int sx, int sy)
 				OnTimer_Zoomout();
 				SetTimer(Window(), IDT_TIMER_OUT, TIMER_PERIOD, NULL);
 			}
+
+			// drawn smaller until the mouse is released
+			if (_PressedButton == RenderItemHandle())
+			{
+				_PressedButton = ri;
+				_PressedButtonWorld = _Ritems.World()[index];
+
+				XMFLOAT4X4 pressed;
+				XMStoreFloat4x4(&pressed, XMMatrixScaling(gPressedButtonScale, gPressedButtonScale, 1.0f) * W);
+				SetWorld(ri, pressed);
+			}
+		}
+	}
+}
+
+void GraphicsWindow::RenderSoftwareFrame(const std::string& filename)
+{
+	if (!_SoftwareRasterizer)
+	{
+		_SoftwareRasterizer = std::make_unique<SoftwareRasterizer>(*_Jobs);
+
+		for (const Material* mat : _MaterialTable)
+		{
+			const Texture* tex = mat->DiffuseMap;
+			if (_SoftwareTextures.count(tex))
+				continue;
+
+			if (!_SoftwareTextures[tex].LoadDDS(tex->Filename))
+				OutputDebugStringW((L"SoftwareTexture::LoadDDS failed: " + tex->Filename + L"\n").c_str());
 		}
 	}
+
+	if (_SoftwareRasterizer->Width() != (UINT)_ClientWidth || _SoftwareRasterizer->Height() != (UINT)_ClientHeight)
+		_SoftwareRasterizer->Resize((UINT)_ClientWidth, (UINT)_ClientHeight);
+
+	_SoftwareRasterizer->Render(_Ritems, _DrawKeys, _MaterialTable, _SoftwareTextures, _MainPassCB);
+
+	if (!_SoftwareRasterizer->WritePPM(filename))
+		OutputDebugStringA(("SoftwareRasterizer::WritePPM failed: " + filename + "\n").c_str());
+}
+
+void GraphicsWindow::RecordFrames(UINT frameCount)
+{
+	RecordingCommandList cmdList;
+
+	INT64 countsPerSecond = GameTimer::TicksPerSecond();
+	INT64 startTime = GameTimer::Ticks();
+
+	for (UINT i = 0; i < frameCount; ++i)
+	{
+		cmdList.Reset();
+		RecordFrameCommands(cmdList, 0, (UINT)_DrawKeys.size());
+	}
+
+	INT64 endTime = GameTimer::Ticks();
+
+	double microseconds = 1e6 * (endTime - startTime) / ((double)countsPerSecond * max(frameCount, 1u));
+
+	// the same frames with the opaque chunks recorded as Draw() does
+	DrawChunk opaque = DrawChunks::LayerRange(_DrawKeys, (UINT)RenderLayer::Opaque);
+	std::vector<DrawChunk> chunks;
+	DrawChunks::Split(opaque, _Jobs->ThreadCount(), gMinChunkDraws, chunks);
+
+	std::vector<RecordingCommandList> chunkLists(chunks.size() + 1);
+	startTime = GameTimer::Ticks();
+
+	for (UINT i = 0; i < frameCount && chunks.size() > 1; ++i)
+	{
+		cmdList.Reset();
+		RecordFrameCommands(cmdList, 0, opaque.Begin);
+
+		_Jobs->ParallelFor((UINT)chunks.size(), 1, [&](UINT begin, UINT end)
+		{
+			for (UINT c = begin; c < end; ++c)
+			{
+				chunkLists[c].Reset();
+				RecordFrameCommands(chunkLists[c], chunks[c].Begin, chunks[c].End);
+			}
+		});
+
+		chunkLists.back().Reset();
+		RecordFrameCommands(chunkLists.back(), opaque.End, (UINT)_DrawKeys.size());
+	}
+
+	endTime = GameTimer::Ticks();
+
+	double chunkedMicroseconds = 1e6 * (endTime - startTime) / ((double)countsPerSecond * max(frameCount, 1u));
+
+	OutputDebugStringW((L"RecordFrames: " + std::to_wstring(_DrawKeys.size()) + L" draws, " +
+		std::to_wstring(cmdList.CommandCount()) + L" commands, " +
+		std::to_wstring(cmdList.Stream().size()) + L" bytes, " +
+		std::to_wstring(microseconds) + L" us per frame\n").c_str());
+
+	if (chunks.size() > 1)
+	{
+		OutputDebugStringW((L"RecordFrames: " + std::to_wstring(chunks.size()) + L" opaque chunks on " +
+			std::to_wstring(_Jobs->ThreadCount()) + L" threads, " +
+			std::to_wstring(chunkedMicroseconds) + L" us per frame\n").c_str());
+	}
+}
+
+void GraphicsWindow::ScaleMonastery(UINT drawCount)
+{
+	// copies of the opaque items drawn in place of the originals, with the
+	// level of detail they have now and without streamed textures
+	std::vector<UINT> opaque = _Ritems.Layer(RenderLayer::Opaque);
+	if (opaque.empty())
+		return;
+
+	for (UINT n = (UINT)opaque.size(), i = 0; n < drawCount; ++n, i = (i + 1) % opaque.size())
+	{
+		UINT index = opaque[i];
+		const RenderItemDrawArgs& args = _Ritems.DrawArgs()[index];
+
+		RenderItem ritem;
+		ritem.World = _Ritems.World()[index];
+		ritem.TexTransform = _Ritems.TexTransform()[index];
+		ritem.Geo = args.Geo;
+		ritem.Mat = _MaterialTable[_Ritems.MaterialIds()[index]];
+		ritem.Bounds = _Ritems.Bounds()[index];
+		ritem.PrimitiveType = args.PrimitiveType;
+		ritem.IndexCount = args.IndexCount;
+		ritem.StartIndexLocation = args.StartIndexLocation;
+		ritem.BaseVertexLocation = args.BaseVertexLocation;
+
+		_Ritems.Add(RenderLayer::Opaque, ritem);
+	}
+
+	OutputDebugStringW((L"ScaleMonastery: " + std::to_wstring(_Ritems.Layer(RenderLayer::Opaque).size()) +
+		L" opaque items\n").c_str());
+}
+
+void GraphicsWindow::StartCapture(UINT frameCount)
+{
+	if (_CaptureFramesLeft > 0 || frameCount == 0)
+		return;
+
+	if (!_Capture)
+		_Capture = std::make_unique<FrameCapture>();
+	_Capture->Clear();
+
+	_Constants->SetCapture(_Capture.get());
+	for (auto& frameResource : _FrameResources)
+		frameResource->InstanceBuffer->SetCapture(_Capture.get());
+
+	_CaptureFramesLeft = frameCount;
+}
+
+void GraphicsWindow::FinishCapture()
+{
+	_Constants->SetCapture(nullptr);
+	for (auto& frameResource : _FrameResources)
+		frameResource->InstanceBuffer->SetCapture(nullptr);
+
+	if (!_Capture->Write(gCaptureFilename))
+		OutputDebugStringA((std::string("FrameCapture::Write failed: ") + gCaptureFilename + "\n").c_str());
+	else
+		OutputDebugStringW((L"FrameCapture: " + std::to_wstring(_Capture->Frames().size()) + L" frames\n").c_str());
+}
+
+void GraphicsWindow::StartTrace(UINT frameCount)
+{
+	if (_TraceFramesLeft > 0 || frameCount == 0)
+		return;
+
+	Profiler::Get().StartTrace();
+	_TraceFramesLeft = frameCount;
+}
+
+void GraphicsWindow::FinishTrace()
+{
+	Profiler& profiler = Profiler::Get();
+	profiler.StopTrace();
+
+	if (!profiler.WriteTrace(gTraceFilename))
+		OutputDebugStringA((std::string("Profiler::WriteTrace failed: ") + gTraceFilename + "\n").c_str());
+
+	char line[256];
+	for (const ProfileZoneStats& zone : profiler.Summary())
+	{
+		sprintf_s(line, "%-20s mean %8.1f  p50 %8.1f  p95 %8.1f  p99 %8.1f us\n",
+			zone.Name, zone.Mean, zone.P50, zone.P95, zone.P99);
+		OutputDebugStringA(line);
+	}
+}
+
+void GraphicsWindow::NextFrameRateTarget()
+{
+	const FrameTimeStats& stats = _FramePacer.Stats();
+
+	char line[256];
+	sprintf_s(line, "FramePacer %.0f Hz: min %.2f  mean %.2f  p50 %.2f  p99 %.2f  max %.2f  jitter %.3f ms\n",
+		gFrameRateTargets[_FrameRateTarget], 1e3 * stats.Min(), 1e3 * stats.Mean(), 1e3 * stats.Percentile(0.5),
+		1e3 * stats.Percentile(0.99), 1e3 * stats.Max(), 1e3 * stats.Jitter());
+	OutputDebugStringA(line);
+
+	_FrameRateTarget = (_FrameRateTarget + 1) % _countof(gFrameRateTargets);
+	_FramePacer.SetTargetFrameRate(gFrameRateTargets[_FrameRateTarget]);
+}
+
+void GraphicsWindow::NextFrameQueueDepth()
+{
+	FrameQueue::Stats stats = _FrameQueue->WindowStats();
+
+	char line[256];
+	sprintf_s(line, "FrameQueue %s depth %u: cpu wait %.2f  latency %.2f ms\n",
+		_FrameQueue->Adaptive() ? "adaptive" : "fixed", _FrameQueue->Depth(), 1e3 * stats.CpuWait, 1e3 * stats.Latency);
+	OutputDebugStringA(line);
+
+	_FrameQueueDepth = (_FrameQueueDepth + 1) % _countof(gFrameQueueDepths);
+	UINT depth = gFrameQueueDepths[_FrameQueueDepth];
+	_FrameQueue->SetDepth(depth > 0 ? depth : _FrameQueue->SlotCount(), depth == 0);
 }
@@ -0,0 +1,360 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <HeapAllocator.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+	// index of the highest set bit, v != 0
+	UINT HighestBit(UINT64 v)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse64(&index, v);
+		return (UINT)index;
+#else
+		return 63 - (UINT)__builtin_clzll(v);
+#endif
+	}
+
+	// index of the lowest set bit, v != 0
+	UINT LowestBit(UINT64 v)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, v);
+		return (UINT)index;
+#else
+		return (UINT)__builtin_ctzll(v);
+#endif
+	}
+
+	UINT64 AlignUp(UINT64 v, UINT64 alignment)
+	{
+		return (v + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+HeapAllocator::HeapAllocator(UINT64 capacity) : _Capacity(capacity)
+{
+	for (UINT fl = 0; fl < FirstLevelCount; ++fl)
+	{
+		for (UINT sl = 0; sl < SecondLevelCount; ++sl)
+			_FreeLists[fl][sl] = None;
+	}
+
+	if (capacity == 0)
+		return;
+
+	_FirstBlock = NewBlock();
+	_Blocks[_FirstBlock].Size = capacity;
+	InsertFree(_FirstBlock);
+}
+
+UINT HeapAllocator::Allocate(UINT64 size, UINT64 alignment)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+	if (size == 0 || size > _Capacity)
+		return InvalidHandle;
+
+	// a block of the size class usually is aligned already, e.g. in a heap
+	// of 64 KB placements; only otherwise the search makes room for padding
+	UINT block = FindFree(size);
+	if (block == None || !Fits(block, size, alignment))
+	{
+		if (alignment > 1 && size + alignment - 1 <= _Capacity)
+			block = FindFree(size + alignment - 1);
+		else
+			block = None;
+	}
+
+	if (block == None)
+		return InvalidHandle;
+
+	RemoveFree(block);
+	UINT used = Place(block, AlignUp(_Blocks[block].Offset, alignment), size, alignment);
+	return NewHandle(used);
+}
+
+void HeapAllocator::Free(UINT handle)
+{
+	UINT block = _Handles[handle];
+	Block& b = _Blocks[block];
+	assert(b.Handle == handle);
+
+	_UsedBytes -= b.Size;
+	_AllocationCount--;
+
+	b.Handle = None;
+	_UnusedHandles.push_back(handle);
+
+	UINT next = b.NextPhysical;
+	if (next != None && _Blocks[next].Handle == None)
+	{
+		RemoveFree(next);
+		Merge(block, next);
+	}
+
+	UINT prev = _Blocks[block].PrevPhysical;
+	if (prev != None && _Blocks[prev].Handle == None)
+	{
+		RemoveFree(prev);
+		Merge(prev, block);
+		block = prev;
+	}
+
+	InsertFree(block);
+}
+
+std::vector<HeapAllocator::Move> HeapAllocator::Defragment(UINT maxMoves)
+{
+	std::vector<Move> moves;
+
+	std::vector<UINT> used;
+	for (UINT b = _FirstBlock; b != None; b = _Blocks[b].NextPhysical)
+	{
+		if (_Blocks[b].Handle != None)
+			used.push_back(b);
+	}
+
+	for (auto it = used.rbegin(); it != used.rend() && moves.size() < maxMoves; ++it)
+	{
+		const UINT64 offset = _Blocks[*it].Offset;
+		const UINT64 size = _Blocks[*it].Size;
+		const UINT64 alignment = _Blocks[*it].Alignment;
+
+		// the lowest free block that takes the allocation
+		UINT target = None;
+		for (UINT b = _FirstBlock; b != None && _Blocks[b].Offset < offset; b = _Blocks[b].NextPhysical)
+		{
+			if (_Blocks[b].Handle == None && Fits(b, size, alignment))
+			{
+				target = b;
+				break;
+			}
+		}
+
+		if (target == None || AlignUp(_Blocks[target].Offset, alignment) >= offset)
+			continue;
+
+		RemoveFree(target);
+		UINT placed = Place(target, AlignUp(_Blocks[target].Offset, alignment), size, alignment);
+
+		// the handle follows the data, the old block stays allocated under a new one
+		UINT handle = _Blocks[*it].Handle;
+		_Blocks[placed].Handle = handle;
+		_Handles[handle] = placed;
+
+		UINT retired = NewHandle(*it);
+		moves.push_back({ handle, retired, offset, _Blocks[placed].Offset, size });
+	}
+
+	return moves;
+}
+
+UINT64 HeapAllocator::LargestFreeBlock() const
+{
+	if (_FirstLevelMask == 0)
+		return 0;
+
+	UINT fl = HighestBit(_FirstLevelMask);
+	UINT sl = HighestBit(_SecondLevelMasks[fl]);
+
+	UINT64 largest = 0;
+	for (UINT b = _FreeLists[fl][sl]; b != None; b = _Blocks[b].NextFree)
+		largest = max(largest, _Blocks[b].Size);
+	return largest;
+}
+
+float HeapAllocator::Fragmentation() const
+{
+	UINT64 freeBytes = _Capacity - _UsedBytes;
+	if (freeBytes == 0)
+		return 0.0f;
+
+	return 1.0f - (float)LargestFreeBlock() / (float)freeBytes;
+}
+
+void HeapAllocator::Mapping(UINT64 size, UINT& fl, UINT& sl)
+{
+	if (size < SecondLevelCount)
+	{
+		fl = 0;
+		sl = (UINT)size;
+		return;
+	}
+
+	UINT bit = HighestBit(size);
+	fl = bit - SecondLevelBits + 1;
+	sl = (UINT)(size >> (bit - SecondLevelBits)) - SecondLevelCount;
+}
+
+UINT HeapAllocator::FindFree(UINT64 size) const
+{
+	// round up to the next size class, so any block of the class found fits
+	if (size >= SecondLevelCount)
+	{
+		UINT64 rounded = size + (1ull << (HighestBit(size) - SecondLevelBits)) - 1;
+		if (rounded < size)
+			return None;
+		size = rounded;
+	}
+
+	UINT fl, sl;
+	Mapping(size, fl, sl);
+	if (fl >= FirstLevelCount)
+		return None;
+
+	UINT slMask = _SecondLevelMasks[fl] & (~0u << sl);
+	if (slMask == 0)
+	{
+		UINT64 flMask = fl + 1 < 64 ? _FirstLevelMask & (~0ull << (fl + 1)) : 0;
+		if (flMask == 0)
+			return None;
+
+		fl = LowestBit(flMask);
+		slMask = _SecondLevelMasks[fl];
+	}
+
+	return _FreeLists[fl][LowestBit(slMask)];
+}
+
+void HeapAllocator::InsertFree(UINT block)
+{
+	UINT fl, sl;
+	Mapping(_Blocks[block].Size, fl, sl);
+
+	UINT head = _FreeLists[fl][sl];
+	_Blocks[block].PrevFree = None;
+	_Blocks[block].NextFree = head;
+	if (head != None)
+		_Blocks[head].PrevFree = block;
+
+	_FreeLists[fl][sl] = block;
+	_FirstLevelMask |= 1ull << fl;
+	_SecondLevelMasks[fl] |= 1u << sl;
+}
+
+void HeapAllocator::RemoveFree(UINT block)
+{
+	Block& b = _Blocks[block];
+
+	if (b.PrevFree != None)
+		_Blocks[b.PrevFree].NextFree = b.NextFree;
+	if (b.NextFree != None)
+		_Blocks[b.NextFree].PrevFree = b.PrevFree;
+
+	UINT fl, sl;
+	Mapping(b.Size, fl, sl);
+	if (_FreeLists[fl][sl] == block)
+	{
+		_FreeLists[fl][sl] = b.NextFree;
+		if (b.NextFree == None)
+		{
+			_SecondLevelMasks[fl] &= ~(1u << sl);
+			if (_SecondLevelMasks[fl] == 0)
+				_FirstLevelMask &= ~(1ull << fl);
+		}
+	}
+
+	b.PrevFree = None;
+	b.NextFree = None;
+}
+
+UINT HeapAllocator::Place(UINT block, UINT64 offset, UINT64 size, UINT64 alignment)
+{
+	// the alignment padding in front and the rest behind stay free
+	UINT64 padding = offset - _Blocks[block].Offset;
+	if (padding > 0)
+	{
+		InsertFree(SplitFront(block, padding));
+		block = _Blocks[block].NextPhysical;
+	}
+
+	if (_Blocks[block].Size > size)
+	{
+		SplitFront(block, size);
+		InsertFree(_Blocks[block].NextPhysical);
+	}
+
+	_Blocks[block].Alignment = alignment;
+	_UsedBytes += size;
+	_AllocationCount++;
+	return block;
+}
+
+UINT HeapAllocator::SplitFront(UINT block, UINT64 size)
+{
+	// block keeps the front, a new block after it takes the rest
+	UINT rest = NewBlock();
+	Block& b = _Blocks[block];
+	Block& r = _Blocks[rest];
+
+	r.Offset = b.Offset + size;
+	r.Size = b.Size - size;
+	r.PrevPhysical = block;
+	r.NextPhysical = b.NextPhysical;
+	if (r.NextPhysical != None)
+		_Blocks[r.NextPhysical].PrevPhysical = rest;
+
+	b.Size = size;
+	b.NextPhysical = rest;
+	return block;
+}
+
+void HeapAllocator::Merge(UINT block, UINT next)
+{
+	Block& b = _Blocks[block];
+	Block& n = _Blocks[next];
+
+	b.Size += n.Size;
+	b.NextPhysical = n.NextPhysical;
+	if (b.NextPhysical != None)
+		_Blocks[b.NextPhysical].PrevPhysical = block;
+
+	n = Block();
+	_UnusedBlocks.push_back(next);
+}
+
+UINT HeapAllocator::NewBlock()
+{
+	if (!_UnusedBlocks.empty())
+	{
+		UINT block = _UnusedBlocks.back();
+		_UnusedBlocks.pop_back();
+		return block;
+	}
+
+	_Blocks.emplace_back();
+	return (UINT)_Blocks.size() - 1;
+}
+
+UINT HeapAllocator::NewHandle(UINT block)
+{
+	UINT handle;
+	if (!_UnusedHandles.empty())
+	{
+		handle = _UnusedHandles.back();
+		_UnusedHandles.pop_back();
+		_Handles[handle] = block;
+	}
+	else
+	{
+		handle = (UINT)_Handles.size();
+		_Handles.push_back(block);
+	}
+
+	_Blocks[block].Handle = handle;
+	return handle;
+}
+
+bool HeapAllocator::Fits(UINT block, UINT64 size, UINT64 alignment) const
+{
+	const Block& b = _Blocks[block];
+	return AlignUp(b.Offset, alignment) + size <= b.Offset + b.Size;
+}
@@ -0,0 +1,158 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <d3dUtil.h>
+#include <FrameResource.h>
+#include <RenderItemStore.h>
+#include <InstanceGrouping.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// what items must share to be drawn as instances of one another
+	struct GroupKey
+	{
+		UINT Geometry;
+		int PrimitiveType;
+		UINT FirstLevel;
+		UINT LevelCount;
+		UINT IndexCount;
+		UINT StartIndexLocation;
+		int BaseVertexLocation;
+		UINT Material;
+		float UvDensity;
+		float Bounds[6];
+		int Cell[3];
+
+		bool operator<(const GroupKey& rhs) const
+		{
+			return std::memcmp(this, &rhs, sizeof(GroupKey)) < 0;
+		}
+
+		bool operator==(const GroupKey& rhs) const
+		{
+			return std::memcmp(this, &rhs, sizeof(GroupKey)) == 0;
+		}
+	};
+
+	GroupKey MakeKey(const RenderItemStore& ritems, UINT index, float clusterSize)
+	{
+		const RenderItemDrawArgs& args = ritems.DrawArgs()[index];
+		const RenderItemLod& lod = ritems.Lods()[index];
+		const BoundingBox& bounds = ritems.Bounds()[index];
+		const BoundingBox& worldBounds = ritems.WorldBounds()[index];
+
+		GroupKey key;
+		std::memset(&key, 0, sizeof(key));
+		key.Geometry = ritems.GeometryIds()[index];
+		key.PrimitiveType = (int)args.PrimitiveType;
+		key.Material = ritems.MaterialIds()[index];
+		key.UvDensity = lod.UvDensity;
+
+		// items with LODs are told apart by their chain, the level drawn now may differ
+		if (lod.LevelCount > 0)
+		{
+			key.FirstLevel = lod.FirstLevel;
+			key.LevelCount = lod.LevelCount;
+		}
+		else
+		{
+			key.IndexCount = args.IndexCount;
+			key.StartIndexLocation = args.StartIndexLocation;
+			key.BaseVertexLocation = args.BaseVertexLocation;
+		}
+
+		key.Bounds[0] = bounds.Center.x;
+		key.Bounds[1] = bounds.Center.y;
+		key.Bounds[2] = bounds.Center.z;
+		key.Bounds[3] = bounds.Extents.x;
+		key.Bounds[4] = bounds.Extents.y;
+		key.Bounds[5] = bounds.Extents.z;
+
+		key.Cell[0] = (int)floorf(worldBounds.Center.x / clusterSize);
+		key.Cell[1] = (int)floorf(worldBounds.Center.y / clusterSize);
+		key.Cell[2] = (int)floorf(worldBounds.Center.z / clusterSize);
+		return key;
+	}
+}
+
+UINT InstanceGrouping::Group(RenderItemStore& ritems, RenderLayer layer, const std::vector<Material*>& materialTable,
+	float clusterSize, UINT minInstances)
+{
+	const auto& drawArgs = ritems.DrawArgs();
+
+	// equal keys end up next to each other, in layer order within a run
+	std::vector<std::pair<GroupKey, UINT>> keyed;
+	for (UINT index : ritems.Layer(layer))
+	{
+		if (drawArgs[index].InstanceCount == 0)
+			keyed.push_back({ MakeKey(ritems, index, clusterSize), index });
+	}
+	std::stable_sort(keyed.begin(), keyed.end(), [](const auto& a, const auto& b) {
+		return a.first < b.first;
+	});
+
+	// runs large enough to be worth an instanced draw, in order of their first item
+	std::vector<std::pair<UINT, UINT>> groups;
+	for (UINT begin = 0, end = 0; begin < (UINT)keyed.size(); begin = end)
+	{
+		for (end = begin + 1; end < (UINT)keyed.size() && keyed[end].first == keyed[begin].first; ++end)
+			;
+
+		if (end - begin >= max(2u, minInstances))
+			groups.push_back({ begin, end });
+	}
+	std::sort(groups.begin(), groups.end(), [&](const auto& a, const auto& b) {
+		return keyed[a.first].second < keyed[b.first].second;
+	});
+
+	std::vector<RenderItem> grouped;
+	std::vector<RenderItemHandle> removed;
+	for (const auto& group : groups)
+	{
+		UINT first = keyed[group.first].second;
+		const RenderItemDrawArgs& args = drawArgs[first];
+		const RenderItemLod& lod = ritems.Lods()[first];
+
+		// the instances carry the transforms, the store's density already includes the TexTransform
+		RenderItem ritem;
+		ritem.Geo = args.Geo;
+		ritem.Mat = materialTable[ritems.MaterialIds()[first]];
+		ritem.Bounds = ritems.Bounds()[first];
+		ritem.PrimitiveType = args.PrimitiveType;
+		ritem.UvDensity = lod.UvDensity;
+
+		if (lod.LevelCount > 0)
+		{
+			const auto& levels = ritems.LodLevels();
+			ritem.Lods.assign(levels.begin() + lod.FirstLevel, levels.begin() + lod.FirstLevel + lod.LevelCount);
+		}
+		else
+		{
+			ritem.IndexCount = args.IndexCount;
+			ritem.StartIndexLocation = args.StartIndexLocation;
+			ritem.BaseVertexLocation = args.BaseVertexLocation;
+		}
+
+		for (UINT k = group.first; k < group.second; ++k)
+		{
+			UINT index = keyed[k].second;
+
+			InstanceData instance;
+			instance.World = ritems.World()[index];
+			instance.TexTransform = ritems.TexTransform()[index];
+			ritem.Instances.push_back(instance);
+
+			removed.push_back(ritems.HandleOf(index));
+		}
+
+		grouped.push_back(std::move(ritem));
+	}
+
+	ritems.Remove(removed);
+	for (const RenderItem& ritem : grouped)
+		ritems.Add(RenderLayer::Instanced, ritem);
+
+	return (UINT)grouped.size();
+}
@@ -0,0 +1,259 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <JobSystem.h>
+#include <Profiler.h>
+
+namespace
+{
+	// queue of the current thread, threads outside the system use queue 0
+	thread_local const JobSystem* t_JobSystem = nullptr;
+	thread_local UINT t_QueueIndex = 0;
+}
+
+JobSystem::JobSystem(UINT workerCount, UINT attachedCount) : _AttachedCount(attachedCount)
+{
+	if (workerCount == 0)
+		workerCount = max(1u, std::thread::hardware_concurrency()) - 1;
+
+	// the owner's, the workers', then the attached threads' deques
+	for (UINT i = 0; i < workerCount + 1 + attachedCount; ++i)
+		_Queues.push_back(std::make_unique<WorkerQueue>());
+
+	t_JobSystem = this;
+	t_QueueIndex = 0;
+
+	for (UINT i = 1; i < workerCount + 1; ++i)
+		_Workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(_WakeMutex);
+		_Quit = true;
+	}
+	_WakeCondition.notify_all();
+
+	for (auto& worker : _Workers)
+		worker.join();
+
+	if (t_JobSystem == this)
+		t_JobSystem = nullptr;
+}
+
+void JobSystem::AttachThread(UINT slot)
+{
+	assert(slot < _AttachedCount);
+
+	t_JobSystem = this;
+	t_QueueIndex = (UINT)_Queues.size() - _AttachedCount + slot;
+}
+
+void JobSystem::Run(std::function<void()> func, JobCounter* counter)
+{
+	if (counter)
+		counter->_Pending++;
+
+	Push({ std::move(func), counter });
+}
+
+void JobSystem::RunAfter(JobCounter& dependency, std::function<void()> func, JobCounter* counter)
+{
+	if (counter)
+		counter->_Pending++;
+
+	{
+		// the last job of the dependency flushes the list under the same lock
+		std::lock_guard<std::mutex> lock(dependency._Mutex);
+		if (dependency._Pending.load() > 0)
+		{
+			dependency._Continuations.push_back({ std::move(func), counter });
+			return;
+		}
+	}
+
+	Push({ std::move(func), counter });
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	UINT queueIndex = QueueIndex();
+	while (!counter.IsDone())
+	{
+		if (!RunOne(queueIndex))
+			std::this_thread::yield();
+	}
+
+	// the last job may still hold the lock, the counter can be destroyed once it is released
+	std::exception_ptr error;
+	{
+		std::lock_guard<std::mutex> lock(counter._Mutex);
+		std::swap(error, counter._Error);
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+void JobSystem::ParallelFor(UINT count, UINT grainSize, const std::function<void(UINT, UINT)>& func)
+{
+	if (count == 0)
+		return;
+
+	grainSize = max(1u, grainSize);
+	if (count <= grainSize)
+	{
+		func(0, count);
+		return;
+	}
+
+	JobCounter counter;
+	for (UINT begin = grainSize; begin < count; begin += grainSize)
+	{
+		UINT end = min(begin + grainSize, count);
+		Run([&func, begin, end]() { func(begin, end); }, &counter);
+	}
+
+	// The calling thread takes the first chunk itself. Whatever it throws
+	// waits for the queued chunks, they still refer to func and counter.
+	std::exception_ptr error;
+	try
+	{
+		func(0, grainSize);
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+	}
+
+	try
+	{
+		Wait(counter);
+	}
+	catch (...)
+	{
+		if (!error)
+			error = std::current_exception();
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+UINT JobSystem::QueueIndex() const
+{
+	return t_JobSystem == this ? t_QueueIndex : 0;
+}
+
+void JobSystem::Push(Job job)
+{
+	WorkerQueue& queue = *_Queues[QueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Jobs.push_back(std::move(job));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_WakeMutex);
+		_QueuedJobs++;
+	}
+	_WakeCondition.notify_one();
+}
+
+bool JobSystem::Pop(UINT queueIndex, Job& job)
+{
+	WorkerQueue& queue = *_Queues[queueIndex];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+	if (queue.Jobs.empty())
+		return false;
+
+	// newest first, its data is most likely still in the cache
+	job = std::move(queue.Jobs.back());
+	queue.Jobs.pop_back();
+	return true;
+}
+
+bool JobSystem::Steal(UINT queueIndex, Job& job)
+{
+	UINT queueCount = (UINT)_Queues.size();
+	for (UINT i = 1; i < queueCount; ++i)
+	{
+		WorkerQueue& victim = *_Queues[(queueIndex + i) % queueCount];
+		std::lock_guard<std::mutex> lock(victim.Mutex);
+		if (victim.Jobs.empty())
+			continue;
+
+		// oldest first, it tends to be the largest piece of work
+		job = std::move(victim.Jobs.front());
+		victim.Jobs.pop_front();
+		return true;
+	}
+
+	return false;
+}
+
+bool JobSystem::RunOne(UINT queueIndex)
+{
+	Job job;
+	if (!Pop(queueIndex, job) && !Steal(queueIndex, job))
+		return false;
+
+	_QueuedJobs--;
+	Execute(job);
+	return true;
+}
+
+void JobSystem::Execute(Job& job)
+{
+	std::exception_ptr error;
+	try
+	{
+		PROFILE_ZONE("Job");
+		job.Func();
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+	}
+
+	JobCounter* counter = job.Counter;
+	if (!counter)
+	{
+		// nothing waits to see it, fail as loudly as an unhandled exception
+		if (error)
+			std::terminate();
+		return;
+	}
+
+	// the counter is not touched after the lock is released, see Wait()
+	std::vector<JobCounter::Continuation> continuations;
+	{
+		std::lock_guard<std::mutex> lock(counter->_Mutex);
+		if (error && !counter->_Error)
+			counter->_Error = error;
+
+		if (--counter->_Pending == 0)
+			continuations.swap(counter->_Continuations);
+	}
+
+	for (auto& c : continuations)
+		Push({ std::move(c.Func), c.Counter });
+}
+
+void JobSystem::WorkerLoop(UINT queueIndex)
+{
+	t_JobSystem = this;
+	t_QueueIndex = queueIndex;
+
+	while (true)
+	{
+		if (RunOne(queueIndex))
+			continue;
+
+		std::unique_lock<std::mutex> lock(_WakeMutex);
+		_WakeCondition.wait(lock, [this]() { return _Quit || _QueuedJobs.load() > 0; });
+		if (_Quit)
+			break;
+	}
+}
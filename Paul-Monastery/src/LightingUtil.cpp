@@ -0,0 +1,111 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <d3dUtil.h>
+#include <LightingUtil.h>
+
+using namespace DirectX;
+
+float LightingUtil::CalcAttenuation(float d, float falloffStart, float falloffEnd)
+{
+	// Linear falloff.
+	return MathHelper::Clamp((falloffEnd - d) / (falloffEnd - falloffStart), 0.0f, 1.0f);
+}
+
+XMVECTOR LightingUtil::SchlickFresnel(FXMVECTOR R0, FXMVECTOR normal, FXMVECTOR lightVec)
+{
+	float cosIncidentAngle = MathHelper::Clamp(XMVectorGetX(XMVector3Dot(normal, lightVec)), 0.0f, 1.0f);
+
+	float f0 = 1.0f - cosIncidentAngle;
+	float f5 = f0 * f0 * f0 * f0 * f0;
+
+	return XMVectorAdd(R0, XMVectorScale(XMVectorSubtract(XMVectorReplicate(1.0f), R0), f5));
+}
+
+XMVECTOR LightingUtil::BlinnPhong(FXMVECTOR lightStrength, FXMVECTOR lightVec,
+	FXMVECTOR normal, GXMVECTOR toEye, const SurfaceMaterial& mat)
+{
+	const float m = mat.Shininess * 256.0f;
+	XMVECTOR halfVec = XMVector3Normalize(XMVectorAdd(toEye, lightVec));
+
+	float nDotH = max(XMVectorGetX(XMVector3Dot(halfVec, normal)), 0.0f);
+	float roughnessFactor = (m + 8.0f) * powf(nDotH, m) / 8.0f;
+	XMVECTOR fresnelFactor = SchlickFresnel(mat.FresnelR0, halfVec, lightVec);
+
+	XMVECTOR specAlbedo = XMVectorScale(fresnelFactor, roughnessFactor);
+
+	// LDR rendering, scale the specular term down like the shader does
+	specAlbedo = XMVectorDivide(specAlbedo, XMVectorAdd(specAlbedo, XMVectorReplicate(1.0f)));
+
+	return XMVectorMultiply(XMVectorAdd(mat.DiffuseAlbedo, specAlbedo), lightStrength);
+}
+
+XMVECTOR LightingUtil::ComputeDirectionalLight(const Light& L, const SurfaceMaterial& mat,
+	FXMVECTOR normal, FXMVECTOR toEye)
+{
+	XMVECTOR lightVec = XMVectorNegate(XMLoadFloat3(&L.Direction));
+
+	float ndotl = max(XMVectorGetX(XMVector3Dot(lightVec, normal)), 0.0f);
+	XMVECTOR lightStrength = XMVectorScale(XMLoadFloat3(&L.Strength), ndotl);
+
+	return BlinnPhong(lightStrength, lightVec, normal, toEye, mat);
+}
+
+XMVECTOR LightingUtil::ComputePointLight(const Light& L, const SurfaceMaterial& mat,
+	FXMVECTOR pos, FXMVECTOR normal, FXMVECTOR toEye)
+{
+	XMVECTOR lightVec = XMVectorSubtract(XMLoadFloat3(&L.Position), pos);
+
+	float d = XMVectorGetX(XMVector3Length(lightVec));
+	if (d > L.FalloffEnd)
+		return XMVectorZero();
+
+	lightVec = XMVectorScale(lightVec, 1.0f / d);
+
+	float ndotl = max(XMVectorGetX(XMVector3Dot(lightVec, normal)), 0.0f);
+	float att = CalcAttenuation(d, L.FalloffStart, L.FalloffEnd);
+	XMVECTOR lightStrength = XMVectorScale(XMLoadFloat3(&L.Strength), ndotl * att);
+
+	return BlinnPhong(lightStrength, lightVec, normal, toEye, mat);
+}
+
+XMVECTOR LightingUtil::ComputeSpotLight(const Light& L, const SurfaceMaterial& mat,
+	FXMVECTOR pos, FXMVECTOR normal, FXMVECTOR toEye)
+{
+	XMVECTOR lightVec = XMVectorSubtract(XMLoadFloat3(&L.Position), pos);
+
+	float d = XMVectorGetX(XMVector3Length(lightVec));
+	if (d > L.FalloffEnd)
+		return XMVectorZero();
+
+	lightVec = XMVectorScale(lightVec, 1.0f / d);
+
+	float ndotl = max(XMVectorGetX(XMVector3Dot(lightVec, normal)), 0.0f);
+	float att = CalcAttenuation(d, L.FalloffStart, L.FalloffEnd);
+
+	float cosSpot = max(XMVectorGetX(XMVector3Dot(XMVectorNegate(lightVec), XMLoadFloat3(&L.Direction))), 0.0f);
+	float spotFactor = powf(cosSpot, L.SpotPower);
+
+	XMVECTOR lightStrength = XMVectorScale(XMLoadFloat3(&L.Strength), ndotl * att * spotFactor);
+
+	return BlinnPhong(lightStrength, lightVec, normal, toEye, mat);
+}
+
+XMVECTOR LightingUtil::ComputeLighting(const Light lights[MaxLights], const SurfaceMaterial& mat,
+	FXMVECTOR pos, FXMVECTOR normal, FXMVECTOR toEye,
+	UINT numDirLights, UINT numPointLights, UINT numSpotLights)
+{
+	XMVECTOR result = XMVectorZero();
+
+	UINT i = 0;
+	for (; i < numDirLights; ++i)
+		result = XMVectorAdd(result, ComputeDirectionalLight(lights[i], mat, normal, toEye));
+
+	for (; i < numDirLights + numPointLights; ++i)
+		result = XMVectorAdd(result, ComputePointLight(lights[i], mat, pos, normal, toEye));
+
+	for (; i < numDirLights + numPointLights + numSpotLights; ++i)
+		result = XMVectorAdd(result, ComputeSpotLight(lights[i], mat, pos, normal, toEye));
+
+	return XMVectorSetW(result, 0.0f);
+}
@@ -54,7 +54,6 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 	try
 	{
 		win.Update();
-		win.Draw();
 	}
 	catch (const DxException& ex)
 	{
@@ -81,8 +80,8 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 			{
 				try
 				{
+					// drawn by the render thread meanwhile
 					win.Update();
-					win.Draw();
 				}
 				catch (const DxException& ex)
 				{
@@ -92,7 +91,8 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 			}
 			else
 			{
-				Sleep(50);
+				// nothing to draw until a message unpauses
+				WaitMessage();
 			}
 		}
 	}
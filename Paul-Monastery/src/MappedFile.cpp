@@ -0,0 +1,175 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <MappedFile.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+MappedFile::MappedFile(MappedFile&& rhs) noexcept
+{
+	*this = std::move(rhs);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& rhs) noexcept
+{
+	if (this != &rhs)
+	{
+		Close();
+
+		std::swap(_Data, rhs._Data);
+		std::swap(_Size, rhs._Size);
+		std::swap(_File, rhs._File);
+#ifdef _WIN32
+		std::swap(_Mapping, rhs._Mapping);
+#endif
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const wchar_t* fileName)
+{
+	Close();
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+	_File = CreateFile2(fileName, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+#else
+	_File = CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+#endif
+	if (_File == INVALID_HANDLE_VALUE)
+		return false;
+
+	// releases what is open so far but keeps the error of the failed call
+	auto fail = [this](DWORD error) {
+		Close();
+		SetLastError(error);
+		return false;
+	};
+
+	LARGE_INTEGER fileSize = { 0 };
+	if (!GetFileSizeEx(_File, &fileSize))
+		return fail(GetLastError());
+
+	// a view must fit in the address space
+	if ((std::uint64_t)fileSize.QuadPart > (std::uint64_t)SIZE_MAX)
+		return fail(ERROR_FILE_TOO_LARGE);
+
+	// empty files cannot be mapped
+	if (fileSize.QuadPart == 0)
+		return fail(ERROR_HANDLE_EOF);
+
+	_Mapping = CreateFileMappingW(_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!_Mapping)
+		return fail(GetLastError());
+
+	_Data = (const std::uint8_t*)MapViewOfFile(_Mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!_Data)
+		return fail(GetLastError());
+
+	_Size = (std::uint64_t)fileSize.QuadPart;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (_Data)
+		UnmapViewOfFile(_Data);
+	if (_Mapping)
+		CloseHandle(_Mapping);
+	if (_File != INVALID_HANDLE_VALUE)
+		CloseHandle(_File);
+
+	_Data = nullptr;
+	_Size = 0;
+	_Mapping = nullptr;
+	_File = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::Open(const wchar_t* fileName)
+{
+	Close();
+
+	// wchar_t holds UTF-32 here, the file system expects UTF-8
+	std::string path;
+	for (const wchar_t* c = fileName; *c; ++c)
+	{
+		std::uint32_t cp = (std::uint32_t)*c;
+		if (cp < 0x80)
+			path += (char)cp;
+		else if (cp < 0x800)
+		{
+			path += (char)(0xc0 | (cp >> 6));
+			path += (char)(0x80 | (cp & 0x3f));
+		}
+		else if (cp < 0x10000)
+		{
+			path += (char)(0xe0 | (cp >> 12));
+			path += (char)(0x80 | ((cp >> 6) & 0x3f));
+			path += (char)(0x80 | (cp & 0x3f));
+		}
+		else
+		{
+			path += (char)(0xf0 | (cp >> 18));
+			path += (char)(0x80 | ((cp >> 12) & 0x3f));
+			path += (char)(0x80 | ((cp >> 6) & 0x3f));
+			path += (char)(0x80 | (cp & 0x3f));
+		}
+	}
+
+	_File = open(path.c_str(), O_RDONLY);
+	if (_File < 0)
+		return false;
+
+	auto fail = [this](int error) {
+		Close();
+		errno = error;
+		return false;
+	};
+
+	struct stat st;
+	if (fstat(_File, &st) != 0)
+		return fail(errno);
+
+	if ((std::uint64_t)st.st_size > (std::uint64_t)SIZE_MAX)
+		return fail(EFBIG);
+
+	if (st.st_size == 0)
+		return fail(EINVAL);
+
+	void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, _File, 0);
+	if (data == MAP_FAILED)
+		return fail(errno);
+
+	_Data = (const std::uint8_t*)data;
+	_Size = (std::uint64_t)st.st_size;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (_Data)
+		munmap((void*)_Data, (size_t)_Size);
+	if (_File >= 0)
+		close(_File);
+
+	_Data = nullptr;
+	_Size = 0;
+	_File = -1;
+}
+
+#endif
@@ -0,0 +1,152 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <d3dUtil.h>
+#include <GeometryGenerator.h>
+#include <FrameResource.h>
+#include <MeshPacker.h>
+
+using namespace DirectX;
+
+void MeshPacker::Add(const std::string& name, const GeometryGenerator::MeshData& mesh, float geometricError)
+{
+	_Submeshes.push_back({ name, &mesh, geometricError });
+
+	_VertexCount += (UINT)mesh.Vertices.size();
+	_IndexCount += (UINT)mesh.Indices32.size();
+	_MaxSubmeshVertexCount = max(_MaxSubmeshVertexCount, (UINT)mesh.Vertices.size());
+}
+
+void MeshPacker::AddLods(const std::string& name, const GeometryGenerator::LodChain& lods)
+{
+	for (UINT level = 0; level < (UINT)lods.Levels.size(); ++level)
+		Add(LodName(name, level), lods.Levels[level], lods.Errors[level]);
+}
+
+std::vector<SubmeshGeometry> MeshPacker::LodLevels(const MeshGeometry& geo, const std::string& name)
+{
+	std::vector<SubmeshGeometry> levels;
+	for (UINT level = 0; ; ++level)
+	{
+		auto it = geo.DrawArgs.find(LodName(name, level));
+		if (it == geo.DrawArgs.end())
+			break;
+
+		levels.push_back(it->second);
+	}
+	return levels;
+}
+
+std::string MeshPacker::LodName(const std::string& name, UINT level)
+{
+	return level == 0 ? name : name + "_lod" + std::to_string(level);
+}
+
+std::unique_ptr<MeshGeometry> MeshPacker::Pack(const std::string& geoName) const
+{
+	// indices are relative to BaseVertexLocation, only the submesh size matters
+	const bool use16 = _MaxSubmeshVertexCount <= 0x10000;
+	const UINT indexSize = use16 ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+
+	const UINT vbByteSize = _VertexCount * sizeof(Vertex);
+	const UINT ibByteSize = _IndexCount * indexSize;
+
+	auto geo = std::make_unique<MeshGeometry>();
+	geo->Name = geoName;
+
+	geo->VertexBufferCPU.resize(vbByteSize);
+	geo->IndexBufferCPU.resize(ibByteSize);
+
+	Vertex* vertices = (Vertex*)geo->VertexBufferCPU.data();
+	BYTE* indices = geo->IndexBufferCPU.data();
+
+	UINT vertexOffset = 0;
+	UINT indexOffset = 0;
+	for (const auto& entry : _Submeshes)
+	{
+		const GeometryGenerator::MeshData& mesh = *entry.Mesh;
+
+		SubmeshGeometry submesh;
+		submesh.IndexCount = (UINT)mesh.Indices32.size();
+		submesh.StartIndexLocation = indexOffset;
+		submesh.BaseVertexLocation = (INT)vertexOffset;
+		submesh.Bounds = WriteVertices(mesh, vertices + vertexOffset);
+		submesh.GeometricError = entry.GeometricError;
+		submesh.UvDensity = UvDensity(mesh);
+
+		if (use16)
+			WriteIndices(mesh, (std::uint16_t*)indices + indexOffset);
+		else
+			WriteIndices(mesh, (std::uint32_t*)indices + indexOffset);
+
+		geo->DrawArgs[entry.Name] = submesh;
+
+		vertexOffset += (UINT)mesh.Vertices.size();
+		indexOffset += submesh.IndexCount;
+	}
+
+	geo->VertexByteStride = sizeof(Vertex);
+	geo->VertexBufferByteSize = vbByteSize;
+	geo->IndexFormat = use16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	geo->IndexBufferByteSize = ibByteSize;
+
+	return geo;
+}
+
+template <typename T>
+void MeshPacker::WriteIndices(const GeometryGenerator::MeshData& mesh, T* dst)
+{
+	for (size_t i = 0; i < mesh.Indices32.size(); ++i)
+		dst[i] = (T)mesh.Indices32[i];
+}
+
+BoundingBox MeshPacker::WriteVertices(const GeometryGenerator::MeshData& mesh, Vertex* dst)
+{
+	XMVECTOR vMin = XMVectorReplicate(FLT_MAX);
+	XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+
+	for (size_t i = 0; i < mesh.Vertices.size(); ++i)
+	{
+		const GeometryGenerator::Vertex& src = mesh.Vertices[i];
+		dst[i].Pos = src.Position;
+		dst[i].Normal = src.Normal;
+		dst[i].TexC = src.TexC;
+
+		XMVECTOR p = XMLoadFloat3(&src.Position);
+		vMin = XMVectorMin(vMin, p);
+		vMax = XMVectorMax(vMax, p);
+	}
+
+	// same box BoundingBox::CreateFromPoints produces
+	BoundingBox bounds;
+	if (!mesh.Vertices.empty())
+	{
+		XMStoreFloat3(&bounds.Center, (vMin + vMax) * 0.5f);
+		XMStoreFloat3(&bounds.Extents, (vMax - vMin) * 0.5f);
+	}
+	return bounds;
+}
+
+float MeshPacker::UvDensity(const GeometryGenerator::MeshData& mesh)
+{
+	// area weighted over the triangles: sqrt(total uv area / total surface area)
+	float uvArea = 0.0f;
+	float area = 0.0f;
+	for (size_t i = 0; i + 2 < mesh.Indices32.size(); i += 3)
+	{
+		const GeometryGenerator::Vertex& v0 = mesh.Vertices[mesh.Indices32[i]];
+		const GeometryGenerator::Vertex& v1 = mesh.Vertices[mesh.Indices32[i + 1]];
+		const GeometryGenerator::Vertex& v2 = mesh.Vertices[mesh.Indices32[i + 2]];
+
+		XMVECTOR p0 = XMLoadFloat3(&v0.Position);
+		XMVECTOR e0 = XMLoadFloat3(&v1.Position) - p0;
+		XMVECTOR e1 = XMLoadFloat3(&v2.Position) - p0;
+		area += 0.5f * XMVectorGetX(XMVector3Length(XMVector3Cross(e0, e1)));
+
+		float du0 = v1.TexC.x - v0.TexC.x, dv0 = v1.TexC.y - v0.TexC.y;
+		float du1 = v2.TexC.x - v0.TexC.x, dv1 = v2.TexC.y - v0.TexC.y;
+		uvArea += 0.5f * fabsf(du0 * dv1 - du1 * dv0);
+	}
+
+	return area > 0.0f ? sqrtf(uvArea / area) : 0.0f;
+}
@@ -4,7 +4,8 @@
 #include <d3dUtil.h>
 #include <GeometryGenerator.h>
 #include <FrameResource.h>
-#include <RenderItem.h>
+#include <RenderItemStore.h>
+#include <JobSystem.h>
 #include <Monastery.h>
 
 Monastery::Monastery()
@@ -12,19 +13,17 @@ Monastery::Monastery()
 	_Church = std::make_unique<Church>();
 }
 
-void Monastery::BuildGeometry(ID3D12Device* devicePtr, 
-	ID3D12GraphicsCommandList* commandListPtr, 
-	std::unordered_map<std::string, 
-	std::unique_ptr<MeshGeometry>>& geometries)
+void Monastery::BuildGeometry(std::unordered_map<std::string, 
+	std::unique_ptr<MeshGeometry>>& geometries,
+	JobSystem& jobs)
 {
-	_Church->BuildGeometry(devicePtr, commandListPtr, geometries);
+	_Church->BuildGeometry(geometries, jobs);
 }
 
 void Monastery::BuildRenderItems(std::unordered_map<std::string, 
 	std::unique_ptr<MeshGeometry>>& geometries, 
 	std::unordered_map<std::string, std::unique_ptr<Material>>& materials, 
-	std::vector<std::unique_ptr<RenderItem>>& allRitems, 
-	std::vector<RenderItem*>& opaqueRenderItems)
+	RenderItemStore& ritems)
 {
-	_Church->BuildRenderItems(geometries, materials, allRitems, opaqueRenderItems);
+	_Church->BuildRenderItems(geometries, materials, ritems);
 }
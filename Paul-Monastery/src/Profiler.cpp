@@ -0,0 +1,161 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <Profiler.h>
+
+namespace
+{
+	// a trace stops growing here, about 32 MB of events
+	const size_t MaxTraceEvents = 1 << 20;
+
+	void WriteJsonString(std::ofstream& fout, const char* s)
+	{
+		fout << '"';
+		for (; *s; ++s)
+		{
+			if (*s == '"' || *s == '\\')
+				fout << '\\';
+			fout << *s;
+		}
+		fout << '"';
+	}
+}
+
+Profiler& Profiler::Get()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+Profiler::Thread* Profiler::RegisterThread()
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	_Threads.push_back(std::make_unique<Thread>());
+	_Threads.back()->Id = (UINT)_Threads.size() - 1;
+	return _Threads.back().get();
+}
+
+void Profiler::Collect()
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	for (auto& thread : _Threads)
+	{
+		thread->Ring.Drain([this](const ProfileEvent& e) {
+			Zone& zone = _Zones[e.Name];
+			if (zone.Durations.size() < Window)
+				zone.Durations.push_back(e.End - e.Start);
+			else
+				zone.Durations[zone.Next] = e.End - e.Start;
+			zone.Next = (zone.Next + 1) % Window;
+			zone.Count++;
+
+			if (_Tracing && _Trace.size() < MaxTraceEvents)
+				_Trace.push_back(e);
+		});
+	}
+}
+
+void Profiler::StartTrace()
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	_Trace.clear();
+	_Tracing = true;
+}
+
+void Profiler::StopTrace()
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	_Tracing = false;
+}
+
+bool Profiler::WriteTrace(const std::string& filename) const
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	std::ofstream fout(filename);
+	if (!fout)
+		return false;
+
+	INT64 base = INT64_MAX;
+	for (const ProfileEvent& e : _Trace)
+		base = min(base, e.Start);
+
+	double microsecondsPerTick = 1e6 / _TicksPerSecond;
+
+	// complete events, the viewer nests them by their times
+	fout << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+	fout.precision(3);
+	fout << std::fixed;
+
+	for (size_t i = 0; i < _Trace.size(); ++i)
+	{
+		const ProfileEvent& e = _Trace[i];
+
+		fout << "{\"name\":";
+		WriteJsonString(fout, e.Name);
+		fout << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.Thread <<
+			",\"ts\":" << (e.Start - base) * microsecondsPerTick <<
+			",\"dur\":" << (e.End - e.Start) * microsecondsPerTick <<
+			",\"args\":{\"depth\":" << e.Depth << "}}";
+		fout << (i + 1 < _Trace.size() ? ",\n" : "\n");
+	}
+
+	fout << "]}\n";
+	return (bool)fout;
+}
+
+std::vector<ProfileZoneStats> Profiler::Summary() const
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	double microsecondsPerTick = 1e6 / _TicksPerSecond;
+
+	std::vector<ProfileZoneStats> summary;
+	std::vector<INT64> sorted;
+	for (const auto& z : _Zones)
+	{
+		const Zone& zone = z.second;
+		if (zone.Durations.empty())
+			continue;
+
+		sorted = zone.Durations;
+		std::sort(sorted.begin(), sorted.end());
+
+		INT64 total = 0;
+		for (INT64 d : sorted)
+			total += d;
+
+		auto percentile = [&](double p) {
+			size_t i = min(sorted.size() - 1, (size_t)(p * sorted.size()));
+			return sorted[i] * microsecondsPerTick;
+		};
+
+		ProfileZoneStats stats;
+		stats.Name = z.first;
+		stats.Count = zone.Count;
+		stats.Mean = total * microsecondsPerTick / sorted.size();
+		stats.P50 = percentile(0.50);
+		stats.P95 = percentile(0.95);
+		stats.P99 = percentile(0.99);
+		summary.push_back(stats);
+	}
+
+	std::sort(summary.begin(), summary.end(), [](const ProfileZoneStats& a, const ProfileZoneStats& b) {
+		return strcmp(a.Name, b.Name) < 0;
+	});
+	return summary;
+}
+
+UINT64 Profiler::Dropped() const
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	UINT64 dropped = 0;
+	for (auto& thread : _Threads)
+		dropped += thread->Ring.Dropped();
+	return dropped;
+}
@@ -0,0 +1,320 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <d3dUtil.h>
+#include <FrameResource.h>
+#include <RenderItemStore.h>
+
+using namespace DirectX;
+
+void RenderItemStore::SetFrameResourceCount(int frameResourceCount)
+{
+	_DirtyList.Reset(frameResourceCount, Size());
+	_DirtyList.MarkAllDirty();
+}
+
+RenderItemHandle RenderItemStore::Add(RenderLayer layer, const RenderItem& ritem)
+{
+	UINT index = Size();
+
+	UINT slot;
+	if (!_FreeSlots.empty())
+	{
+		slot = _FreeSlots.back();
+		_FreeSlots.pop_back();
+	}
+	else
+	{
+		slot = (UINT)_Slots.size();
+		_Slots.push_back(Slot());
+	}
+	_Slots[slot].Index = index;
+
+	RenderItemDrawArgs args;
+	args.Geo = ritem.Geo;
+	args.PrimitiveType = ritem.PrimitiveType;
+	args.IndexCount = ritem.IndexCount;
+	args.StartIndexLocation = ritem.StartIndexLocation;
+	args.BaseVertexLocation = ritem.BaseVertexLocation;
+	args.InstanceCount = (UINT)ritem.Instances.size();
+	args.InstanceOffset = (UINT)_Instances.size();
+
+	RenderItemLod lod;
+	if (!ritem.Lods.empty())
+	{
+		lod.FirstLevel = AddLodLevels(ritem.Geo, ritem.Lods);
+		lod.LevelCount = (UINT)ritem.Lods.size();
+
+		args.IndexCount = ritem.Lods[0].IndexCount;
+		args.StartIndexLocation = ritem.Lods[0].StartIndexLocation;
+		args.BaseVertexLocation = ritem.Lods[0].BaseVertexLocation;
+	}
+
+	// the longer texture axis, so the density is never underestimated
+	const XMFLOAT4X4& tex = ritem.TexTransform;
+	float texScale = sqrtf(max(tex._11 * tex._11 + tex._12 * tex._12, tex._21 * tex._21 + tex._22 * tex._22));
+	lod.UvDensity = ritem.UvDensity * texScale;
+
+	_Instances.insert(_Instances.end(), ritem.Instances.begin(), ritem.Instances.end());
+
+	_World.push_back(ritem.World);
+	_TexTransform.push_back(ritem.TexTransform);
+	_Bounds.push_back(ritem.Bounds);
+	_WorldBounds.push_back(ritem.Bounds);
+	_DrawArgs.push_back(args);
+	_MaterialIds.push_back((UINT)ritem.Mat->MatCBIndex);
+	_GeometryIds.push_back(_GeometryIdOf.emplace(ritem.Geo, (UINT)_GeometryIdOf.size()).first->second);
+	_Layers.push_back(layer);
+	_SlotOf.push_back(slot);
+	_Lods.push_back(lod);
+
+	_LayerItems[(int)layer].push_back(index);
+
+	UpdateWorldBounds(index);
+	UpdateLodScale(index);
+
+	_DirtyList.Resize(Size());
+	_DirtyList.MarkDirty(index);
+
+	_LayoutVersion++;
+
+	return { slot, _Slots[slot].Generation };
+}
+
+void RenderItemStore::Remove(RenderItemHandle handle)
+{
+	RemoveItem(handle);
+
+	RebuildLayers();
+	_LayoutVersion++;
+}
+
+void RenderItemStore::Remove(const std::vector<RenderItemHandle>& handles)
+{
+	if (handles.empty())
+		return;
+
+	for (RenderItemHandle handle : handles)
+		RemoveItem(handle);
+
+	RebuildLayers();
+	_LayoutVersion++;
+}
+
+void RenderItemStore::RemoveItem(RenderItemHandle handle)
+{
+	assert(IsValid(handle));
+
+	UINT index = IndexOf(handle);
+	UINT last = Size() - 1;
+
+	// close the gap in the instance array
+	const RenderItemDrawArgs removed = _DrawArgs[index];
+	if (removed.InstanceCount > 0)
+	{
+		_Instances.erase(_Instances.begin() + removed.InstanceOffset,
+			_Instances.begin() + removed.InstanceOffset + removed.InstanceCount);
+
+		for (UINT i = 0; i < Size(); ++i)
+		{
+			if (_DrawArgs[i].InstanceCount > 0 && _DrawArgs[i].InstanceOffset > removed.InstanceOffset)
+			{
+				_DrawArgs[i].InstanceOffset -= removed.InstanceCount;
+				_DirtyList.MarkDirty(i);
+			}
+		}
+	}
+
+	// move the last item into the hole
+	if (index != last)
+	{
+		_World[index] = _World[last];
+		_TexTransform[index] = _TexTransform[last];
+		_Bounds[index] = _Bounds[last];
+		_WorldBounds[index] = _WorldBounds[last];
+		_DrawArgs[index] = _DrawArgs[last];
+		_MaterialIds[index] = _MaterialIds[last];
+		_GeometryIds[index] = _GeometryIds[last];
+		_Layers[index] = _Layers[last];
+		_SlotOf[index] = _SlotOf[last];
+		_Lods[index] = _Lods[last];
+
+		_Slots[_SlotOf[index]].Index = index;
+
+		// pending instance updates follow it to the new index
+		_DirtyList.MarkDirty(index);
+	}
+
+	_World.pop_back();
+	_TexTransform.pop_back();
+	_Bounds.pop_back();
+	_WorldBounds.pop_back();
+	_DrawArgs.pop_back();
+	_MaterialIds.pop_back();
+	_GeometryIds.pop_back();
+	_Layers.pop_back();
+	_SlotOf.pop_back();
+	_Lods.pop_back();
+
+	_Slots[handle.Slot].Index = UINT_MAX;
+	_Slots[handle.Slot].Generation++;
+	_FreeSlots.push_back(handle.Slot);
+
+	_DirtyList.Resize(Size());
+}
+
+bool RenderItemStore::IsValid(RenderItemHandle handle) const
+{
+	return handle.Slot < _Slots.size() &&
+		_Slots[handle.Slot].Generation == handle.Generation &&
+		_Slots[handle.Slot].Index != UINT_MAX;
+}
+
+UINT RenderItemStore::IndexOf(RenderItemHandle handle) const
+{
+	assert(IsValid(handle));
+	return _Slots[handle.Slot].Index;
+}
+
+RenderItemHandle RenderItemStore::HandleOf(UINT index) const
+{
+	UINT slot = _SlotOf[index];
+	return { slot, _Slots[slot].Generation };
+}
+
+void RenderItemStore::SetWorld(RenderItemHandle handle, const XMFLOAT4X4& world)
+{
+	UINT index = IndexOf(handle);
+
+	_World[index] = world;
+	UpdateWorldBounds(index);
+	UpdateLodScale(index);
+
+	_DirtyList.MarkDirty(index);
+	_BoundsVersion++;
+}
+
+void RenderItemStore::SelectLods(const XMFLOAT3& eyePosW, float pixelScale, float maxPixelError)
+{
+	XMVECTOR eye = XMLoadFloat3(&eyePosW);
+
+	for (UINT i = 0; i < Size(); ++i)
+	{
+		RenderItemLod& lod = _Lods[i];
+		if (lod.LevelCount < 2)
+			continue;
+
+		float distance = NearestDistance(i, eye);
+
+		UINT level = 0;
+		if (distance > 0.0f)
+		{
+			float pixelsPerUnit = lod.Scale * pixelScale / distance;
+			while (level + 1 < lod.LevelCount &&
+				_LodLevels[lod.FirstLevel + level + 1].GeometricError * pixelsPerUnit <= maxPixelError)
+				++level;
+		}
+
+		if (level == lod.Level)
+			continue;
+
+		const SubmeshGeometry& submesh = _LodLevels[lod.FirstLevel + level];
+		_DrawArgs[i].IndexCount = submesh.IndexCount;
+		_DrawArgs[i].StartIndexLocation = submesh.StartIndexLocation;
+		_DrawArgs[i].BaseVertexLocation = submesh.BaseVertexLocation;
+		lod.Level = level;
+	}
+}
+
+float RenderItemStore::UvPerPixel(UINT index, const XMFLOAT3& eyePosW, float pixelScale) const
+{
+	const RenderItemLod& lod = _Lods[index];
+	if (lod.UvDensity == 0.0f)
+		return 0.0f;
+
+	// one pixel covers distance / pixelScale world units
+	float distance = NearestDistance(index, XMLoadFloat3(&eyePosW));
+	return lod.UvDensity / lod.Scale * distance / pixelScale;
+}
+
+float RenderItemStore::NearestDistance(UINT index, FXMVECTOR eyePosW) const
+{
+	// distance to the nearest point of the bounds, conservative for every instance
+	XMVECTOR center = XMLoadFloat3(&_WorldBounds[index].Center);
+	XMVECTOR extents = XMLoadFloat3(&_WorldBounds[index].Extents);
+	XMVECTOR nearest = XMVectorClamp(eyePosW, center - extents, center + extents);
+	return XMVectorGetX(XMVector3Length(eyePosW - nearest));
+}
+
+void RenderItemStore::UpdateWorldBounds(UINT index)
+{
+	const RenderItemDrawArgs& args = _DrawArgs[index];
+	const BoundingBox& bounds = _Bounds[index];
+
+	if (args.InstanceCount == 0)
+	{
+		bounds.Transform(_WorldBounds[index], XMLoadFloat4x4(&_World[index]));
+		return;
+	}
+
+	// instanced items are bounded by the union of their instances
+	BoundingBox worldBounds;
+	bounds.Transform(worldBounds, XMLoadFloat4x4(&_Instances[args.InstanceOffset].World));
+	for (UINT i = 1; i < args.InstanceCount; ++i)
+	{
+		BoundingBox instanceBounds;
+		bounds.Transform(instanceBounds, XMLoadFloat4x4(&_Instances[args.InstanceOffset + i].World));
+		BoundingBox::CreateMerged(worldBounds, worldBounds, instanceBounds);
+	}
+
+	_WorldBounds[index] = worldBounds;
+}
+
+void RenderItemStore::UpdateLodScale(UINT index)
+{
+	auto maxScale = [](const XMFLOAT4X4& m) {
+		float x = m._11 * m._11 + m._12 * m._12 + m._13 * m._13;
+		float y = m._21 * m._21 + m._22 * m._22 + m._23 * m._23;
+		float z = m._31 * m._31 + m._32 * m._32 + m._33 * m._33;
+		return sqrtf(max(x, max(y, z)));
+	};
+
+	const RenderItemDrawArgs& args = _DrawArgs[index];
+
+	float scale = maxScale(_World[index]);
+	if (args.InstanceCount > 0)
+	{
+		float instanceScale = 0.0f;
+		for (UINT i = 0; i < args.InstanceCount; ++i)
+			instanceScale = max(instanceScale, maxScale(_Instances[args.InstanceOffset + i].World));
+		scale *= instanceScale;
+	}
+
+	_Lods[index].Scale = scale;
+}
+
+UINT RenderItemStore::AddLodLevels(const MeshGeometry* geo, const std::vector<SubmeshGeometry>& levels)
+{
+	for (const auto& chain : _LodChains)
+	{
+		if (chain.Geo == geo && chain.LevelCount == (UINT)levels.size() &&
+			_LodLevels[chain.FirstLevel].StartIndexLocation == levels[0].StartIndexLocation &&
+			_LodLevels[chain.FirstLevel].BaseVertexLocation == levels[0].BaseVertexLocation)
+			return chain.FirstLevel;
+	}
+
+	UINT firstLevel = (UINT)_LodLevels.size();
+	_LodLevels.insert(_LodLevels.end(), levels.begin(), levels.end());
+	_LodChains.push_back({ geo, firstLevel, (UINT)levels.size() });
+
+	return firstLevel;
+}
+
+void RenderItemStore::RebuildLayers()
+{
+	for (auto& layerItems : _LayerItems)
+		layerItems.clear();
+
+	for (UINT i = 0; i < Size(); ++i)
+		_LayerItems[(int)_Layers[i]].push_back(i);
+}
@@ -0,0 +1,106 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <d3dUtil.h>
+#include <ResourceHeaps.h>
+
+using Microsoft::WRL::ComPtr;
+
+ResourceHeaps::ResourceHeaps(ID3D12Device* device, UINT64 heapSize)
+	: _Device(device), _HeapSize(heapSize)
+{
+}
+
+HRESULT ResourceHeaps::CreateResource(const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState,
+	ComPtr<ID3D12Resource>& resource, HeapPlacement& placement)
+{
+	placement = HeapPlacement();
+
+	const bool isBuffer = desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER;
+	const bool isTarget = (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0;
+
+	// small textures may be placed at 4 KB, the device tells which qualify
+	D3D12_RESOURCE_DESC placedDesc = desc;
+	D3D12_RESOURCE_ALLOCATION_INFO info;
+	if (!isBuffer && !isTarget)
+	{
+		placedDesc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+		info = _Device->GetResourceAllocationInfo(0, 1, &placedDesc);
+		if (info.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+		{
+			placedDesc.Alignment = 0;
+			info = _Device->GetResourceAllocationInfo(0, 1, &placedDesc);
+		}
+	}
+	else
+		info = _Device->GetResourceAllocationInfo(0, 1, &placedDesc);
+
+	if (isTarget || info.SizeInBytes > _HeapSize)
+	{
+		return _Device->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+			D3D12_HEAP_FLAG_NONE,
+			&desc,
+			initialState,
+			nullptr,
+			IID_PPV_ARGS(&resource));
+	}
+
+	const D3D12_HEAP_FLAGS flags = isBuffer ? D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS : D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+
+	UINT handle = HeapAllocator::InvalidHandle;
+	UINT heap = 0;
+	for (; heap < (UINT)_Heaps.size(); ++heap)
+	{
+		if (_Heaps[heap].Flags != flags)
+			continue;
+
+		handle = _Heaps[heap].Allocator->Allocate(info.SizeInBytes, info.Alignment);
+		if (handle != HeapAllocator::InvalidHandle)
+			break;
+	}
+
+	if (handle == HeapAllocator::InvalidHandle)
+	{
+		CD3DX12_HEAP_DESC heapDesc(_HeapSize, D3D12_HEAP_TYPE_DEFAULT, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT, flags);
+
+		Heap h;
+		HRESULT hr = _Device->CreateHeap(&heapDesc, IID_PPV_ARGS(&h.Memory));
+		if (FAILED(hr))
+			return hr;
+
+		h.Flags = flags;
+		h.Allocator = std::make_unique<HeapAllocator>(_HeapSize);
+
+		heap = (UINT)_Heaps.size();
+		_Heaps.push_back(std::move(h));
+
+		handle = _Heaps[heap].Allocator->Allocate(info.SizeInBytes, info.Alignment);
+	}
+
+	HRESULT hr = _Device->CreatePlacedResource(_Heaps[heap].Memory.Get(), _Heaps[heap].Allocator->Offset(handle),
+		&placedDesc, initialState, nullptr, IID_PPV_ARGS(&resource));
+	if (FAILED(hr))
+	{
+		_Heaps[heap].Allocator->Free(handle);
+		return hr;
+	}
+
+	placement.Heap = heap;
+	placement.Handle = handle;
+	return S_OK;
+}
+
+void ResourceHeaps::Free(const HeapPlacement& placement)
+{
+	if (placement.Heap != HeapPlacement::None)
+		_Heaps[placement.Heap].Allocator->Free(placement.Handle);
+}
+
+UINT64 ResourceHeaps::UsedBytes() const
+{
+	UINT64 used = 0;
+	for (const Heap& heap : _Heaps)
+		used += heap.Allocator->UsedBytes();
+	return used;
+}
@@ -0,0 +1,125 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <d3dUtil.h>
+#include <SceneMaterials.h>
+
+std::vector<SceneMaterials::TextureFile> SceneMaterials::TextureFiles(const std::wstring& directory)
+{
+	return
+	{
+		{ "SkyTex", directory + L"sky.dds", false },
+
+		{ "upTex", directory + L"up.dds", false },
+		{ "downTex", directory + L"down.dds", false },
+		{ "leftTex", directory + L"left.dds", false },
+		{ "rightTex", directory + L"right.dds", false },
+		{ "zoominTex", directory + L"zoomin.dds", false },
+		{ "zoomoutTex", directory + L"zoomout.dds", false },
+
+		{ "groundTex", directory + L"ground.dds", true },
+		{ "churchBlockTex", directory + L"church-block.dds", true },
+		{ "churchDomeTex", directory + L"church-dome.dds", true }
+	};
+}
+
+void SceneMaterials::BuildMaterials(std::unordered_map<std::string, std::unique_ptr<Texture>>& textures,
+	std::unordered_map<std::string, std::unique_ptr<Material>>& materials,
+	std::vector<Material*>& materialTable)
+{
+	auto sky0 = std::make_unique<Material>();
+	sky0->Name = "sky0";
+	sky0->MatCBIndex = 0;
+	sky0->DiffuseMap = textures["SkyTex"].get();
+	sky0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	sky0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
+	sky0->Roughness = 0.3f;
+
+	auto up0 = std::make_unique<Material>();
+	up0->Name = "up0";
+	up0->MatCBIndex = 1;
+	up0->DiffuseMap = textures["upTex"].get();
+	up0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	up0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
+	up0->Roughness = 0.3f;
+
+	auto down0 = std::make_unique<Material>();
+	down0->Name = "down0";
+	down0->MatCBIndex = 2;
+	down0->DiffuseMap = textures["downTex"].get();
+	down0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	down0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
+	down0->Roughness = 0.3f;
+
+	auto left0 = std::make_unique<Material>();
+	left0->Name = "left0";
+	left0->MatCBIndex = 3;
+	left0->DiffuseMap = textures["leftTex"].get();
+	left0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	left0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
+	left0->Roughness = 0.3f;
+
+	auto right0 = std::make_unique<Material>();
+	right0->Name = "right0";
+	right0->MatCBIndex = 4;
+	right0->DiffuseMap = textures["rightTex"].get();
+	right0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	right0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
+	right0->Roughness = 0.3f;
+
+	auto zoomin0 = std::make_unique<Material>();
+	zoomin0->Name = "zoomin0";
+	zoomin0->MatCBIndex = 5;
+	zoomin0->DiffuseMap = textures["zoominTex"].get();
+	zoomin0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	zoomin0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
+	zoomin0->Roughness = 0.3f;
+
+	auto zoomout0 = std::make_unique<Material>();
+	zoomout0->Name = "zoomout0";
+	zoomout0->MatCBIndex = 6;
+	zoomout0->DiffuseMap = textures["zoomoutTex"].get();
+	zoomout0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	zoomout0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
+	zoomout0->Roughness = 0.3f;
+
+	auto ground0 = std::make_unique<Material>();
+	ground0->Name = "ground0";
+	ground0->MatCBIndex = 7;
+	ground0->DiffuseMap = textures["groundTex"].get();
+	ground0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	ground0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
+	ground0->Roughness = 0.3f;
+
+	auto churchBlock0 = std::make_unique<Material>();
+	churchBlock0->Name = "churchBlock0";
+	churchBlock0->MatCBIndex = 8;
+	churchBlock0->DiffuseMap = textures["churchBlockTex"].get();
+	churchBlock0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	churchBlock0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
+	churchBlock0->Roughness = 0.3f;
+
+	auto churchDome0 = std::make_unique<Material>();
+	churchDome0->Name = "churchDome0";
+	churchDome0->MatCBIndex = 9;
+	churchDome0->DiffuseMap = textures["churchDomeTex"].get();
+	churchDome0->DiffuseAlbedo = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	churchDome0->FresnelR0 = DirectX::XMFLOAT3(0.02f, 0.02f, 0.02f);
+	
+	materials["sky0"] = std::move(sky0);
+
+	materials["up0"] = std::move(up0);
+	materials["down0"] = std::move(down0);
+	materials["left0"] = std::move(left0);
+	materials["right0"] = std::move(right0);
+	materials["zoomin0"] = std::move(zoomin0);
+	materials["zoomout0"] = std::move(zoomout0);
+
+	materials["ground0"] = std::move(ground0);
+	materials["churchBlock0"] = std::move(churchBlock0);
+	materials["churchDome0"] = std::move(churchDome0);
+
+	materialTable.resize(materials.size());
+	for (auto& e : materials)
+		materialTable[e.second->MatCBIndex] = e.second.get();
+}
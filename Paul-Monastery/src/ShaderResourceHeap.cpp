@@ -0,0 +1,123 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <d3dUtil.h>
+#include <ShaderResourceHeap.h>
+
+using Microsoft::WRL::ComPtr;
+
+ShaderResourceHeap::ShaderResourceHeap(ID3D12Device* device, UINT capacity)
+	: _Device(device), _Allocator(capacity)
+{
+	_DescriptorSize = _Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	_StagingCapacity = _Allocator.Capacity();
+	_Staging = CreateHeap(_StagingCapacity, false);
+
+	_HeapCapacity = _Allocator.Capacity();
+	_Heap = CreateHeap(_HeapCapacity, true);
+}
+
+void ShaderResourceHeap::BeginFrame(UINT64 frameFence, UINT64 completedFence)
+{
+	_FrameFence = frameFence;
+
+	_Allocator.Reclaim(completedFence);
+
+	while (!_Retired.empty() && _Retired.front().Fence <= completedFence)
+		_Retired.pop_front();
+}
+
+UINT ShaderResourceHeap::CreateSrv(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC& desc)
+{
+	UINT slot = _Allocator.Allocate();
+	if (_Allocator.Capacity() > _StagingCapacity)
+		GrowStaging();
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE handle(_Staging->GetCPUDescriptorHandleForHeapStart(), slot, _DescriptorSize);
+	_Device->CreateShaderResourceView(resource, &desc, handle);
+
+	_Dirty.push_back(slot);
+	return slot;
+}
+
+void ShaderResourceHeap::Release(UINT slot)
+{
+	_Allocator.Release(slot, _FrameFence);
+}
+
+void ShaderResourceHeap::Commit()
+{
+	if (_HeapCapacity < _StagingCapacity)
+	{
+		// the frames in flight stay bound to the old heap
+		_Retired.push_back({ _FrameFence, _Heap });
+
+		_HeapCapacity = _StagingCapacity;
+		_Heap = CreateHeap(_HeapCapacity, true);
+
+		_Device->CopyDescriptorsSimple(_Allocator.HighWater(), _Heap->GetCPUDescriptorHandleForHeapStart(),
+			_Staging->GetCPUDescriptorHandleForHeapStart(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+		_Dirty.clear();
+		return;
+	}
+
+	if (_Dirty.empty())
+		return;
+
+	// adjacent slots are copied as one range
+	std::sort(_Dirty.begin(), _Dirty.end());
+	_Dirty.erase(std::unique(_Dirty.begin(), _Dirty.end()), _Dirty.end());
+
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> starts;
+	std::vector<UINT> sizes;
+	for (size_t i = 0; i < _Dirty.size(); ++i)
+	{
+		if (i > 0 && _Dirty[i] == _Dirty[i - 1] + 1)
+		{
+			sizes.back()++;
+			continue;
+		}
+
+		starts.push_back(CD3DX12_CPU_DESCRIPTOR_HANDLE(_Staging->GetCPUDescriptorHandleForHeapStart(), _Dirty[i], _DescriptorSize));
+		sizes.push_back(1);
+	}
+
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> dstStarts;
+	for (size_t i = 0, first = 0; i < starts.size(); first += sizes[i], ++i)
+		dstStarts.push_back(CD3DX12_CPU_DESCRIPTOR_HANDLE(_Heap->GetCPUDescriptorHandleForHeapStart(), _Dirty[first], _DescriptorSize));
+
+	_Device->CopyDescriptors((UINT)dstStarts.size(), dstStarts.data(), sizes.data(),
+		(UINT)starts.size(), starts.data(), sizes.data(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	_Dirty.clear();
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE ShaderResourceHeap::GpuHandle(UINT slot) const
+{
+	return CD3DX12_GPU_DESCRIPTOR_HANDLE(_Heap->GetGPUDescriptorHandleForHeapStart(), slot, _DescriptorSize);
+}
+
+ComPtr<ID3D12DescriptorHeap> ShaderResourceHeap::CreateHeap(UINT capacity, bool shaderVisible)
+{
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+	heapDesc.NumDescriptors = capacity;
+	heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	heapDesc.Flags = shaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+	ComPtr<ID3D12DescriptorHeap> heap;
+	ThrowIfFailed(_Device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&heap)));
+	return heap;
+}
+
+void ShaderResourceHeap::GrowStaging()
+{
+	// staging heaps are not shader-visible, so they can be copied from at any time
+	ComPtr<ID3D12DescriptorHeap> staging = CreateHeap(_Allocator.Capacity(), false);
+	_Device->CopyDescriptorsSimple(_StagingCapacity, staging->GetCPUDescriptorHandleForHeapStart(),
+		_Staging->GetCPUDescriptorHandleForHeapStart(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	_Staging = staging;
+	_StagingCapacity = _Allocator.Capacity();
+}
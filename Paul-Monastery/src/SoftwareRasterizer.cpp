@@ -0,0 +1,574 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <d3dUtil.h>
+#include <FrameResource.h>
+#include <RenderItemStore.h>
+#include <DrawKey.h>
+#include <LightingUtil.h>
+#include <MappedFile.h>
+#include <SoftwareRasterizer.h>
+
+using namespace DirectX;
+
+namespace
+{
+	const std::uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+	const std::uint32_t DDS_FOURCC = 0x00000004;
+	const std::uint32_t DDS_DX10 = 0x30315844; // "DX10"
+
+	const std::uint32_t DXGI_R8G8B8A8_UNORM = 28;
+	const std::uint32_t DXGI_R8G8B8A8_UNORM_SRGB = 29;
+	const std::uint32_t DXGI_B8G8R8A8_UNORM = 87;
+	const std::uint32_t DXGI_B8G8R8A8_UNORM_SRGB = 91;
+
+	float SrgbToLinear(float c)
+	{
+		return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float UnpackChannel(std::uint32_t pixel, std::uint32_t mask, float defaultValue)
+	{
+		if (mask == 0)
+			return defaultValue;
+
+		UINT shift = 0;
+		while (((mask >> shift) & 1) == 0)
+			++shift;
+
+		return (float)((pixel & mask) >> shift) / (float)(mask >> shift);
+	}
+
+	std::uint32_t PackColor(FXMVECTOR color)
+	{
+		XMFLOAT4 c;
+		XMStoreFloat4(&c, XMVectorSaturate(color));
+
+		return (std::uint32_t)(c.x * 255.0f + 0.5f) |
+			((std::uint32_t)(c.y * 255.0f + 0.5f) << 8) |
+			((std::uint32_t)(c.z * 255.0f + 0.5f) << 16) |
+			((std::uint32_t)(c.w * 255.0f + 0.5f) << 24);
+	}
+}
+
+bool SoftwareTexture::LoadDDS(const std::wstring& filename)
+{
+	MappedFile file;
+	if (!file.Open(filename.c_str()) || file.Size() < 128)
+		return false;
+
+	const std::uint8_t* data = file.Data();
+
+	// magic followed by the 124 byte DDS_HEADER
+	std::uint32_t header[32];
+	memcpy(header, data, sizeof(header));
+	if (header[0] != DDS_MAGIC)
+		return false;
+
+	UINT height = header[3];
+	UINT width = header[4];
+	std::uint32_t pfFlags = header[20];
+	std::uint32_t fourCC = header[21];
+	std::uint32_t bitCount = header[22];
+	std::uint32_t masks[4] = { header[23], header[24], header[25], header[26] };
+
+	size_t offset = 128;
+	bool srgb = false;
+
+	if ((pfFlags & DDS_FOURCC) && fourCC == DDS_DX10)
+	{
+		if (file.Size() < 148)
+			return false;
+
+		std::uint32_t format;
+		memcpy(&format, data + 128, sizeof(format));
+		offset = 148;
+
+		switch (format)
+		{
+		case DXGI_R8G8B8A8_UNORM_SRGB:
+			srgb = true;
+			// fall through
+		case DXGI_R8G8B8A8_UNORM:
+			masks[0] = 0x000000ff; masks[1] = 0x0000ff00; masks[2] = 0x00ff0000; masks[3] = 0xff000000;
+			break;
+		case DXGI_B8G8R8A8_UNORM_SRGB:
+			srgb = true;
+			// fall through
+		case DXGI_B8G8R8A8_UNORM:
+			masks[0] = 0x00ff0000; masks[1] = 0x0000ff00; masks[2] = 0x000000ff; masks[3] = 0xff000000;
+			break;
+		default:
+			return false;
+		}
+	}
+	else if ((pfFlags & DDS_FOURCC) || bitCount != 32)
+	{
+		// block compressed and packed formats are not decoded
+		return false;
+	}
+
+	if (file.Size() < offset + (std::uint64_t)width * height * 4)
+		return false;
+
+	Width = width;
+	Height = height;
+	Texels.resize((size_t)width * height);
+
+	const std::uint32_t* pixels = reinterpret_cast<const std::uint32_t*>(data + offset);
+	for (size_t i = 0; i < Texels.size(); ++i)
+	{
+		XMFLOAT4& t = Texels[i];
+		t.x = UnpackChannel(pixels[i], masks[0], 0.0f);
+		t.y = UnpackChannel(pixels[i], masks[1], 0.0f);
+		t.z = UnpackChannel(pixels[i], masks[2], 0.0f);
+		t.w = UnpackChannel(pixels[i], masks[3], 1.0f);
+
+		if (srgb)
+		{
+			t.x = SrgbToLinear(t.x);
+			t.y = SrgbToLinear(t.y);
+			t.z = SrgbToLinear(t.z);
+		}
+	}
+
+	return true;
+}
+
+XMVECTOR SoftwareTexture::Sample(float u, float v) const
+{
+	if (Texels.empty())
+		return XMVectorReplicate(1.0f);
+
+	float x = u * Width - 0.5f;
+	float y = v * Height - 0.5f;
+
+	float fx = floorf(x);
+	float fy = floorf(y);
+	float tx = x - fx;
+	float ty = y - fy;
+
+	auto wrap = [](int i, int n) { i %= n; return i < 0 ? i + n : i; };
+
+	int x0 = wrap((int)fx, Width);
+	int y0 = wrap((int)fy, Height);
+	int x1 = wrap(x0 + 1, Width);
+	int y1 = wrap(y0 + 1, Height);
+
+	XMVECTOR c00 = XMLoadFloat4(&Texels[y0 * Width + x0]);
+	XMVECTOR c10 = XMLoadFloat4(&Texels[y0 * Width + x1]);
+	XMVECTOR c01 = XMLoadFloat4(&Texels[y1 * Width + x0]);
+	XMVECTOR c11 = XMLoadFloat4(&Texels[y1 * Width + x1]);
+
+	return XMVectorLerp(XMVectorLerp(c00, c10, tx), XMVectorLerp(c01, c11, tx), ty);
+}
+
+void SoftwareRasterizer::Resize(UINT width, UINT height)
+{
+	_Width = width;
+	_Height = height;
+	_TilesX = (width + TileSize - 1) / TileSize;
+	_TilesY = (height + TileSize - 1) / TileSize;
+
+	_Color.assign((size_t)width * height, 0);
+	_Depth.assign((size_t)width * height, 1.0f);
+	_TileBins.assign(_TilesX * _TilesY, std::vector<UINT>());
+}
+
+void SoftwareRasterizer::RunParallel(UINT count, const std::function<void(UINT)>& func) const
+{
+	// one job per element, draws and tiles vary too much in cost for larger chunks
+	_Jobs.ParallelFor(count, 1, [&func](UINT begin, UINT end)
+	{
+		for (UINT i = begin; i < end; ++i)
+			func(i);
+	});
+}
+
+void SoftwareRasterizer::Render(const RenderItemStore& ritems, const std::vector<UINT64>& drawKeys,
+	const std::vector<Material*>& materials, const std::unordered_map<const Texture*, SoftwareTexture>& textures,
+	const PassConstants& passCB)
+{
+	DrawContext ctx;
+	ctx.Ritems = &ritems;
+	ctx.Materials = &materials;
+	ctx.Textures = &textures;
+
+	// the constant buffer holds transposed matrices for HLSL
+	XMMATRIX viewProj = XMMatrixTranspose(XMLoadFloat4x4(&passCB.ViewProj));
+	XMMATRIX fixedView = XMMatrixTranspose(XMLoadFloat4x4(&passCB.FixedView));
+	XMMATRIX proj = XMMatrixTranspose(XMLoadFloat4x4(&passCB.Proj));
+	XMStoreFloat4x4(&ctx.ViewProj, viewProj);
+	XMStoreFloat4x4(&ctx.FixedViewProj, XMMatrixMultiply(fixedView, proj));
+	ctx.EyePosW = passCB.EyePosW;
+	ctx.AmbientLight = passCB.AmbientLight;
+	ctx.Lights = passCB.Lights;
+
+	// same clear values as GraphicsWindow::Draw
+	std::fill(_Color.begin(), _Color.end(), PackColor(Colors::LightSteelBlue));
+	std::fill(_Depth.begin(), _Depth.end(), 1.0f);
+
+	// vertex processing, one job per draw
+	_DrawTriangles.resize(drawKeys.size());
+	RunParallel((UINT)drawKeys.size(), [&](UINT i)
+	{
+		_DrawTriangles[i].clear();
+		ProcessDraw(ctx, drawKeys[i], _DrawTriangles[i]);
+	});
+
+	// bin in submission order so every tile keeps the draw order
+	_Triangles.clear();
+	for (auto& bin : _TileBins)
+		bin.clear();
+
+	for (const auto& drawTriangles : _DrawTriangles)
+	{
+		for (const RasterTriangle& tri : drawTriangles)
+		{
+			UINT triIndex = (UINT)_Triangles.size();
+			_Triangles.push_back(&tri);
+
+			for (int ty = tri.MinY / (int)TileSize; ty <= tri.MaxY / (int)TileSize; ++ty)
+				for (int tx = tri.MinX / (int)TileSize; tx <= tri.MaxX / (int)TileSize; ++tx)
+					_TileBins[ty * _TilesX + tx].push_back(triIndex);
+		}
+	}
+
+	// pixel processing, one job per tile
+	RunParallel(_TilesX * _TilesY, [&](UINT tile)
+	{
+		RasterizeTile(ctx, tile);
+	});
+}
+
+void SoftwareRasterizer::ProcessDraw(const DrawContext& ctx, UINT64 key, std::vector<RasterTriangle>& triangles) const
+{
+	UINT index = DrawKey::Index(key);
+	UINT layer = DrawKey::Layer(key);
+
+	const RenderItemStore& ritems = *ctx.Ritems;
+	const RenderItemDrawArgs& args = ritems.DrawArgs()[index];
+	UINT materialId = ritems.MaterialIds()[index];
+	const Material* mat = (*ctx.Materials)[materialId];
+
+	const MeshGeometry* geo = args.Geo;
+	const BYTE* vertexData = geo->VertexBufferCPU.data();
+	const BYTE* indexData = geo->IndexBufferCPU.data();
+	bool index16 = geo->IndexFormat == DXGI_FORMAT_R16_UINT;
+
+	bool sky = layer == (UINT)RenderLayer::Sky;
+	XMMATRIX viewProj = XMLoadFloat4x4(layer == (UINT)RenderLayer::Fixed ? &ctx.FixedViewProj : &ctx.ViewProj);
+	XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
+	XMVECTOR eyePos = XMLoadFloat3(&ctx.EyePosW);
+
+	UINT instanceCount = args.InstanceCount > 0 ? args.InstanceCount : 1;
+	for (UINT instance = 0; instance < instanceCount; ++instance)
+	{
+		XMMATRIX world;
+		XMMATRIX texTransform;
+		if (args.InstanceCount > 0)
+		{
+			const InstanceData& instData = ritems.Instances()[args.InstanceOffset + instance];
+			world = XMLoadFloat4x4(&instData.World);
+			texTransform = XMLoadFloat4x4(&instData.TexTransform);
+		}
+		else
+		{
+			world = XMLoadFloat4x4(&ritems.World()[index]);
+			texTransform = XMLoadFloat4x4(&ritems.TexTransform()[index]);
+		}
+		XMMATRIX texMatrix = XMMatrixMultiply(texTransform, matTransform);
+
+		// small direct-mapped post-transform cache, like the one in the input assembler
+		const UINT CacheSize = 32;
+		UINT cacheTags[CacheSize];
+		ClipVertex cache[CacheSize];
+		std::fill(cacheTags, cacheTags + CacheSize, UINT_MAX);
+
+		for (UINT i = 0; i + 2 < args.IndexCount; i += 3)
+		{
+			ClipVertex v[3];
+			for (UINT k = 0; k < 3; ++k)
+			{
+				UINT location = args.StartIndexLocation + i + k;
+				UINT vi = index16 ?
+					reinterpret_cast<const std::uint16_t*>(indexData)[location] :
+					reinterpret_cast<const std::uint32_t*>(indexData)[location];
+
+				UINT slot = vi % CacheSize;
+				if (cacheTags[slot] != vi)
+				{
+					const Vertex& vin = *reinterpret_cast<const Vertex*>(vertexData +
+						(size_t)(args.BaseVertexLocation + (INT)vi) * geo->VertexByteStride);
+
+					ClipVertex& vout = cache[slot];
+					XMVECTOR posW = XMVector3Transform(XMLoadFloat3(&vin.Pos), world);
+
+					if (sky)
+					{
+						// local position is the cube map lookup vector, the sky is centered on the eye
+						vout.PosW = vin.Pos;
+						vout.NormalW = XMFLOAT3(0.0f, 0.0f, 0.0f);
+						vout.TexC = XMFLOAT2(0.0f, 0.0f);
+
+						XMVECTOR posH = XMVector4Transform(XMVectorAdd(posW, XMVectorSetW(eyePos, 0.0f)), viewProj);
+						XMStoreFloat4(&vout.PosH, XMVectorPermute<0, 1, 3, 3>(posH, posH));
+					}
+					else
+					{
+						XMStoreFloat3(&vout.PosW, posW);
+						XMStoreFloat3(&vout.NormalW, XMVector3TransformNormal(XMLoadFloat3(&vin.Normal), world));
+						XMStoreFloat4(&vout.PosH, XMVector4Transform(posW, viewProj));
+
+						XMVECTOR texC = XMVector4Transform(XMVectorSet(vin.TexC.x, vin.TexC.y, 0.0f, 1.0f), texMatrix);
+						XMStoreFloat2(&vout.TexC, texC);
+					}
+
+					cacheTags[slot] = vi;
+				}
+
+				v[k] = cache[slot];
+			}
+
+			SetupTriangle(v, layer, materialId, triangles);
+		}
+	}
+}
+
+void SoftwareRasterizer::SetupTriangle(const ClipVertex* v, UINT layer, UINT materialId, std::vector<RasterTriangle>& triangles) const
+{
+	auto lerp = [](const ClipVertex& a, const ClipVertex& b, float t)
+	{
+		ClipVertex r;
+		XMStoreFloat4(&r.PosH, XMVectorLerp(XMLoadFloat4(&a.PosH), XMLoadFloat4(&b.PosH), t));
+		XMStoreFloat3(&r.PosW, XMVectorLerp(XMLoadFloat3(&a.PosW), XMLoadFloat3(&b.PosW), t));
+		XMStoreFloat3(&r.NormalW, XMVectorLerp(XMLoadFloat3(&a.NormalW), XMLoadFloat3(&b.NormalW), t));
+		XMStoreFloat2(&r.TexC, XMVectorLerp(XMLoadFloat2(&a.TexC), XMLoadFloat2(&b.TexC), t));
+		return r;
+	};
+
+	// clip against the near plane (z >= 0); the other planes are handled by the screen bounds
+	ClipVertex poly[4];
+	UINT n = 0;
+	for (UINT i = 0; i < 3; ++i)
+	{
+		const ClipVertex& a = v[i];
+		const ClipVertex& b = v[(i + 1) % 3];
+
+		bool aInside = a.PosH.z >= 0.0f;
+		bool bInside = b.PosH.z >= 0.0f;
+
+		if (aInside)
+			poly[n++] = a;
+		if (aInside != bInside)
+			poly[n++] = lerp(a, b, a.PosH.z / (a.PosH.z - b.PosH.z));
+	}
+
+	if (n < 3)
+		return;
+
+	// perspective divide and viewport transform, attributes are stored divided by w
+	RasterVertex r[4];
+	for (UINT i = 0; i < n; ++i)
+	{
+		const ClipVertex& c = poly[i];
+		if (c.PosH.w <= 1e-6f)
+			return;
+
+		float invW = 1.0f / c.PosH.w;
+
+		r[i].X = (c.PosH.x * invW * 0.5f + 0.5f) * _Width;
+		r[i].Y = (0.5f - c.PosH.y * invW * 0.5f) * _Height;
+		r[i].Z = c.PosH.z * invW;
+		r[i].InvW = invW;
+		XMStoreFloat3(&r[i].PosW, XMVectorScale(XMLoadFloat3(&c.PosW), invW));
+		XMStoreFloat3(&r[i].NormalW, XMVectorScale(XMLoadFloat3(&c.NormalW), invW));
+		XMStoreFloat2(&r[i].TexC, XMVectorScale(XMLoadFloat2(&c.TexC), invW));
+	}
+
+	for (UINT i = 1; i + 1 < n; ++i)
+	{
+		RasterTriangle tri;
+		tri.V[0] = r[0];
+		tri.V[1] = r[i];
+		tri.V[2] = r[i + 1];
+		tri.Layer = layer;
+		tri.MaterialId = materialId;
+
+		const RasterVertex& a = tri.V[0];
+		const RasterVertex& b = tri.V[1];
+		const RasterVertex& c = tri.V[2];
+
+		// clockwise triangles on screen are front facing, the sky is not culled
+		float area = (b.X - a.X) * (c.Y - a.Y) - (b.Y - a.Y) * (c.X - a.X);
+		if (area == 0.0f)
+			continue;
+		if (area < 0.0f)
+		{
+			if (layer != (UINT)RenderLayer::Sky)
+				continue;
+			std::swap(tri.V[1], tri.V[2]);
+		}
+
+		// screen bounds, clamped before the conversion to int
+		float minX = MathHelper::Clamp(min(a.X, min(b.X, c.X)), 0.0f, (float)_Width);
+		float minY = MathHelper::Clamp(min(a.Y, min(b.Y, c.Y)), 0.0f, (float)_Height);
+		float maxX = MathHelper::Clamp(max(a.X, max(b.X, c.X)), 0.0f, (float)_Width);
+		float maxY = MathHelper::Clamp(max(a.Y, max(b.Y, c.Y)), 0.0f, (float)_Height);
+
+		tri.MinX = (int)floorf(minX);
+		tri.MinY = (int)floorf(minY);
+		tri.MaxX = min((int)_Width - 1, (int)ceilf(maxX));
+		tri.MaxY = min((int)_Height - 1, (int)ceilf(maxY));
+
+		if (tri.MinX > tri.MaxX || tri.MinY > tri.MaxY)
+			continue;
+
+		triangles.push_back(tri);
+	}
+}
+
+void SoftwareRasterizer::RasterizeTile(const DrawContext& ctx, UINT tile)
+{
+	int tileMinX = (int)((tile % _TilesX) * TileSize);
+	int tileMinY = (int)((tile / _TilesX) * TileSize);
+	int tileMaxX = min(tileMinX + (int)TileSize, (int)_Width) - 1;
+	int tileMaxY = min(tileMinY + (int)TileSize, (int)_Height) - 1;
+
+	for (UINT triIndex : _TileBins[tile])
+	{
+		const RasterTriangle& tri = *_Triangles[triIndex];
+		const RasterVertex& a = tri.V[0];
+		const RasterVertex& b = tri.V[1];
+		const RasterVertex& c = tri.V[2];
+
+		int minX = max(tri.MinX, tileMinX);
+		int minY = max(tri.MinY, tileMinY);
+		int maxX = min(tri.MaxX, tileMaxX);
+		int maxY = min(tri.MaxY, tileMaxY);
+
+		float invArea = 1.0f / ((b.X - a.X) * (c.Y - a.Y) - (b.Y - a.Y) * (c.X - a.X));
+
+		// the sky is drawn at the far plane with LESS_EQUAL, everything else uses LESS
+		bool lessEqual = tri.Layer == (UINT)RenderLayer::Sky;
+
+		for (int y = minY; y <= maxY; ++y)
+		{
+			float py = y + 0.5f;
+			float px = minX + 0.5f;
+
+			// edge functions at the first pixel center of the row, stepped along x
+			float w0 = (c.X - b.X) * (py - b.Y) - (c.Y - b.Y) * (px - b.X);
+			float w1 = (a.X - c.X) * (py - c.Y) - (a.Y - c.Y) * (px - c.X);
+			float w2 = (b.X - a.X) * (py - a.Y) - (b.Y - a.Y) * (px - a.X);
+
+			for (int x = minX; x <= maxX; ++x, w0 -= c.Y - b.Y, w1 -= a.Y - c.Y, w2 -= b.Y - a.Y)
+			{
+				if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+					continue;
+
+				float l0 = w0 * invArea;
+				float l1 = w1 * invArea;
+				float l2 = w2 * invArea;
+
+				size_t pixel = (size_t)y * _Width + x;
+				// clamped to the viewport depth range like the hardware does, which keeps
+				// the sky at exactly 1 whatever the rounding of the weights
+				float z = MathHelper::Clamp(l0 * a.Z + l1 * b.Z + l2 * c.Z, 0.0f, 1.0f);
+				if (lessEqual ? z > _Depth[pixel] : z >= _Depth[pixel])
+					continue;
+
+				// perspective correct attributes
+				float w = 1.0f / (l0 * a.InvW + l1 * b.InvW + l2 * c.InvW);
+
+				RasterVertex v;
+				XMStoreFloat3(&v.PosW, XMVectorScale(XMVectorAdd(XMVectorAdd(
+					XMVectorScale(XMLoadFloat3(&a.PosW), l0),
+					XMVectorScale(XMLoadFloat3(&b.PosW), l1)),
+					XMVectorScale(XMLoadFloat3(&c.PosW), l2)), w));
+				XMStoreFloat3(&v.NormalW, XMVectorScale(XMVectorAdd(XMVectorAdd(
+					XMVectorScale(XMLoadFloat3(&a.NormalW), l0),
+					XMVectorScale(XMLoadFloat3(&b.NormalW), l1)),
+					XMVectorScale(XMLoadFloat3(&c.NormalW), l2)), w));
+				v.TexC.x = (l0 * a.TexC.x + l1 * b.TexC.x + l2 * c.TexC.x) * w;
+				v.TexC.y = (l0 * a.TexC.y + l1 * b.TexC.y + l2 * c.TexC.y) * w;
+
+				bool discard = false;
+				XMVECTOR color = ShadePixel(ctx, tri, v, discard);
+				if (discard)
+					continue;
+
+				_Depth[pixel] = z;
+				_Color[pixel] = PackColor(color);
+			}
+		}
+	}
+}
+
+XMVECTOR SoftwareRasterizer::ShadePixel(const DrawContext& ctx, const RasterTriangle& tri, const RasterVertex& v, bool& discard) const
+{
+	const Material* mat = (*ctx.Materials)[tri.MaterialId];
+	const SoftwareTexture& tex = ctx.Textures->at(mat->DiffuseMap);
+
+	if (tri.Layer == (UINT)RenderLayer::Sky)
+	{
+		// the sky texture is a single image, wrap it around the lookup vector
+		XMFLOAT3 dir;
+		XMStoreFloat3(&dir, XMVector3Normalize(XMLoadFloat3(&v.PosW)));
+
+		float u = 0.5f + atan2f(dir.z, dir.x) / XM_2PI;
+		float t = acosf(MathHelper::Clamp(dir.y, -1.0f, 1.0f)) / XM_PI;
+
+		return tex.Sample(u, t);
+	}
+
+	XMVECTOR diffuseAlbedo = XMVectorMultiply(tex.Sample(v.TexC.x, v.TexC.y), XMLoadFloat4(&mat->DiffuseAlbedo));
+
+	if (tri.Layer == (UINT)RenderLayer::Fixed && XMVectorGetW(diffuseAlbedo) < 0.1f)
+	{
+		discard = true;
+		return XMVectorZero();
+	}
+
+	XMVECTOR posW = XMLoadFloat3(&v.PosW);
+	XMVECTOR normalW = XMVector3Normalize(XMLoadFloat3(&v.NormalW));
+	XMVECTOR toEyeW = XMVector3Normalize(XMVectorSubtract(XMLoadFloat3(&ctx.EyePosW), posW));
+
+	XMVECTOR ambient = XMVectorMultiply(XMLoadFloat4(&ctx.AmbientLight), diffuseAlbedo);
+
+	LightingUtil::SurfaceMaterial surface;
+	surface.DiffuseAlbedo = diffuseAlbedo;
+	surface.FresnelR0 = XMLoadFloat3(&mat->FresnelR0);
+	surface.Shininess = 1.0f - mat->Roughness;
+
+	XMVECTOR directLight = LightingUtil::ComputeLighting(ctx.Lights, surface, posW, normalW, toEyeW);
+
+	XMVECTOR litColor = XMVectorAdd(ambient, directLight);
+
+	// alpha comes from the diffuse albedo
+	return XMVectorSetW(litColor, XMVectorGetW(diffuseAlbedo));
+}
+
+bool SoftwareRasterizer::WritePPM(const std::string& filename) const
+{
+	std::ofstream fout(filename, std::ios::binary);
+	if (!fout)
+		return false;
+
+	fout << "P6\n" << _Width << " " << _Height << "\n255\n";
+
+	std::vector<char> row((size_t)_Width * 3);
+	for (UINT y = 0; y < _Height; ++y)
+	{
+		for (UINT x = 0; x < _Width; ++x)
+		{
+			std::uint32_t c = _Color[(size_t)y * _Width + x];
+			row[x * 3 + 0] = (char)(c & 0xFF);
+			row[x * 3 + 1] = (char)((c >> 8) & 0xFF);
+			row[x * 3 + 2] = (char)((c >> 16) & 0xFF);
+		}
+		fout.write(row.data(), row.size());
+	}
+
+	return (bool)fout;
+}
@@ -0,0 +1,137 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <d3dUtil.h>
+#include <StreamingTextures.h>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	bool IsBlockCompressed(DXGI_FORMAT format)
+	{
+		return (format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM) ||
+			(format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+	}
+}
+
+UINT StreamingTextures::Add(Texture* texture, DirectX::DDSTextureData12&& data)
+{
+	// cube maps, volumes and 1D textures are loaded whole
+	assert(data.ResourceDimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D && !data.IsCubeMap);
+
+	auto entry = std::make_unique<Entry>();
+	entry->Tex = texture;
+	entry->Data = std::move(data);
+
+	_Entries.push_back(std::move(entry));
+	return (UINT)_Entries.size() - 1;
+}
+
+TextureStreamingDesc StreamingTextures::Desc(UINT texture) const
+{
+	const DirectX::DDSTextureData12& data = _Entries[texture]->Data;
+
+	TextureStreamingDesc desc;
+	desc.Width = (UINT)data.Width;
+	desc.Height = (UINT)data.Height;
+	desc.MipBytes.assign(data.MipCount, 0);
+
+	for (size_t item = 0; item < data.ArraySize; ++item)
+	{
+		for (size_t mip = 0; mip < data.MipCount; ++mip)
+			desc.MipBytes[mip] += data.Subresources[item * data.MipCount + mip].SlicePitch;
+	}
+
+	if (IsBlockCompressed(data.Format))
+	{
+		desc.MaxFirstMip = 0;
+		while (desc.MaxFirstMip + 1 < data.MipCount &&
+			((data.Width >> (desc.MaxFirstMip + 1)) & 3) == 0 &&
+			((data.Height >> (desc.MaxFirstMip + 1)) & 3) == 0)
+			desc.MaxFirstMip++;
+	}
+
+	return desc;
+}
+
+int StreamingTextures::Find(const Texture* texture) const
+{
+	for (UINT i = 0; i < TextureCount(); ++i)
+	{
+		if (_Entries[i]->Tex == texture)
+			return (int)i;
+	}
+	return -1;
+}
+
+void StreamingTextures::BeginFrame(UINT64 frameFence, UINT64 completedFence)
+{
+	_FrameFence = frameFence;
+
+	while (!_Retired.empty() && _Retired.front().Fence <= completedFence)
+	{
+		Retired& r = _Retired.front();
+
+		// the heap range may only be reused once the resource is gone
+		r.Resource.Reset();
+		_Heaps.Free(r.Placement);
+		_Retired.pop_front();
+	}
+}
+
+bool StreamingTextures::SetFirstResidentMip(UINT texture, UINT firstMip)
+{
+	Entry& e = *_Entries[texture];
+	const DirectX::DDSTextureData12& data = e.Data;
+
+	const UINT mipCount = (UINT)data.MipCount - firstMip;
+
+	D3D12_RESOURCE_DESC texDesc = {};
+	texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	texDesc.Width = max((UINT64)1, (UINT64)data.Width >> firstMip);
+	texDesc.Height = max(1u, (UINT)data.Height >> firstMip);
+	texDesc.DepthOrArraySize = (UINT16)data.ArraySize;
+	texDesc.MipLevels = (UINT16)mipCount;
+	texDesc.Format = data.Format;
+	texDesc.SampleDesc.Count = 1;
+	texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+	ComPtr<ID3D12Resource> resource;
+	HeapPlacement placement;
+	if (FAILED(_Heaps.CreateResource(texDesc, D3D12_RESOURCE_STATE_COPY_DEST, resource, placement)))
+		return false;
+
+	// the resident mips of every array slice, straight from the mapped file
+	std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+	for (size_t item = 0; item < data.ArraySize; ++item)
+	{
+		for (UINT mip = firstMip; mip < data.MipCount; ++mip)
+			subresources.push_back(data.Subresources[item * data.MipCount + mip]);
+	}
+
+	_Uploads.UploadTexture(resource.Get(), subresources.data());
+
+	// frames already submitted may still sample the old resource through the old slot
+	if (e.Tex->Resource)
+	{
+		_Retired.push_back({ _FrameFence, e.Tex->Resource, e.Tex->Placement });
+		_SrvHeap.Release(e.Tex->SrvIndex);
+	}
+
+	e.Tex->Resource = resource;
+	e.Tex->Placement = placement;
+
+	// descriptors of frames in flight stay untouched, the new SRV gets a slot of its own
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Format = texDesc.Format;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MostDetailedMip = 0;
+	srvDesc.Texture2D.MipLevels = texDesc.MipLevels;
+	srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
+	e.Tex->SrvIndex = _SrvHeap.CreateSrv(resource.Get(), srvDesc);
+
+	return true;
+}
@@ -0,0 +1,75 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <d3dUtil.h>
+#include <TextureLoader.h>
+
+TextureLoader::~TextureLoader()
+{
+	// jobs still running write into _Requests; an error they threw went to
+	// Finish() already, or is dropped with the textures
+	try
+	{
+		_Jobs.Wait(_Pending);
+	}
+	catch (...)
+	{
+	}
+}
+
+void TextureLoader::Queue(const std::string& name, const std::wstring& filename, bool streamed)
+{
+	auto request = std::make_unique<Request>();
+	request->Name = name;
+	request->Filename = filename;
+	request->Streamed = streamed;
+
+	Request* r = request.get();
+	_Requests.push_back(std::move(request));
+
+	_Jobs.Run([r]() {
+		r->Result = DirectX::LoadDDSTextureData12(r->Filename.c_str(), r->Data);
+	}, &_Pending);
+}
+
+void TextureLoader::Finish(UploadManager& uploads,
+	std::unordered_map<std::string, std::unique_ptr<Texture>>& textures,
+	StreamingTextures* streaming)
+{
+	_Jobs.Wait(_Pending);
+
+	for (auto& r : _Requests)
+	{
+		auto tex = std::make_unique<Texture>();
+		tex->Name = r->Name;
+		tex->Filename = r->Filename;
+
+		ThrowIfFailed(r->Result);
+		if (r->Streamed && streaming)
+			streaming->Add(tex.get(), std::move(r->Data));
+		else
+		{
+			const DirectX::DDSTextureData12& data = r->Data;
+			assert(data.ResourceDimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D);
+
+			// cube maps are arrays of six faces, already counted in ArraySize
+			D3D12_RESOURCE_DESC texDesc = {};
+			texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+			texDesc.Width = data.Width;
+			texDesc.Height = (UINT)data.Height;
+			texDesc.DepthOrArraySize = (UINT16)data.ArraySize;
+			texDesc.MipLevels = (UINT16)data.MipCount;
+			texDesc.Format = data.Format;
+			texDesc.SampleDesc.Count = 1;
+			texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+			texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+			// the bits are staged right away, the file is closed with the request
+			tex->Resource = uploads.CreateTexture(texDesc, data.Subresources.data(), tex->Placement);
+		}
+
+		textures[tex->Name] = std::move(tex);
+	}
+
+	_Requests.clear();
+}
@@ -0,0 +1,195 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <TextureStreamer.h>
+
+UINT TextureStreamer::Add(const TextureStreamingDesc& desc, TextureStreamingDevice& device)
+{
+	assert(!desc.MipBytes.empty());
+
+	StreamedTexture texture;
+	texture.Desc = desc;
+
+	const UINT mipCount = (UINT)desc.MipBytes.size();
+	UINT tail = 0;
+	while (tail + 1 < mipCount && max(desc.Width >> tail, desc.Height >> tail) > _Config.TailSize)
+		++tail;
+	tail = min(tail, desc.MaxFirstMip);
+
+	texture.TailMip = tail;
+	texture.FirstResident = tail;
+	texture.Wanted = tail;
+	texture.Applied = tail;
+
+	// the tails are resident even if they alone exceed the budget
+	for (UINT mip = tail; mip < mipCount; ++mip)
+		_ResidentBytes += desc.MipBytes[mip];
+
+	UINT id = (UINT)_Textures.size();
+	_Textures.push_back(texture);
+
+	bool created = device.SetFirstResidentMip(id, tail);
+	assert(created);
+	(void)created;
+
+	return id;
+}
+
+void TextureStreamer::Request(UINT texture, float uvPerPixel)
+{
+	StreamedTexture& t = _Textures[texture];
+	float texelsPerPixel = uvPerPixel * (float)max(t.Desc.Width, t.Desc.Height);
+	t.Requested = min(t.Requested, MipForDensity(texelsPerPixel, (UINT)t.Desc.MipBytes.size()));
+}
+
+UINT TextureStreamer::MipForDensity(float texelsPerPixel, UINT mipCount)
+{
+	// the level the sampler reads, rounded to the finer one
+	if (!(texelsPerPixel > 1.0f))
+		return 0;
+
+	UINT mip = (UINT)floorf(log2f(texelsPerPixel));
+	return min(mip, mipCount - 1);
+}
+
+void TextureStreamer::Update(TextureStreamingDevice& device)
+{
+	std::vector<UINT> loads;
+	for (UINT i = 0; i < TextureCount(); ++i)
+	{
+		StreamedTexture& t = _Textures[i];
+		if (t.Requested != UINT_MAX)
+		{
+			t.Wanted = min(t.Requested, t.TailMip);
+			t.LastUsedFrame = _Frame;
+		}
+		else
+			t.Wanted = t.TailMip;
+
+		t.Requested = UINT_MAX;
+
+		if (t.Wanted < t.FirstResident)
+			loads.push_back(i);
+	}
+
+	// a lowered budget gives up unrequested mips first, then any above the tails
+	if (_ResidentBytes > _Config.BudgetBytes && !Evict(_ResidentBytes - _Config.BudgetBytes, UINT_MAX, true))
+		Evict(_ResidentBytes - _Config.BudgetBytes, UINT_MAX, false);
+
+	// furthest from the wanted level first
+	std::stable_sort(loads.begin(), loads.end(), [this](UINT a, UINT b) {
+		return _Textures[a].FirstResident - _Textures[a].Wanted > _Textures[b].FirstResident - _Textures[b].Wanted;
+	});
+
+	// one level per texture and pass, so every visible texture makes progress
+	UINT loadCount = 0;
+	while (!loads.empty() && loadCount < _Config.MaxLoadsPerUpdate)
+	{
+		for (size_t i = 0; i < loads.size() && loadCount < _Config.MaxLoadsPerUpdate; )
+		{
+			StreamedTexture& t = _Textures[loads[i]];
+			UINT64 bytes = t.Desc.MipBytes[t.FirstResident - 1];
+
+			UINT64 needed = _ResidentBytes + bytes;
+			if (needed > _Config.BudgetBytes && !Evict(needed - _Config.BudgetBytes, loads[i], true))
+			{
+				loads.erase(loads.begin() + i);
+				continue;
+			}
+
+			t.FirstResident--;
+			_ResidentBytes += bytes;
+			++loadCount;
+
+			if (t.FirstResident == t.Wanted)
+				loads.erase(loads.begin() + i);
+			else
+				++i;
+		}
+	}
+
+	Apply(device);
+	++_Frame;
+}
+
+bool TextureStreamer::Evict(UINT64 bytes, UINT keep, bool excessOnly)
+{
+	auto evictable = [&](UINT i) {
+		const StreamedTexture& t = _Textures[i];
+		if (i == keep || t.FirstResident >= t.TailMip)
+			return false;
+		return !excessOnly || t.FirstResident < t.Wanted;
+	};
+
+	// nothing is evicted unless enough can be
+	UINT64 available = 0;
+	for (UINT i = 0; i < TextureCount(); ++i)
+	{
+		const StreamedTexture& t = _Textures[i];
+		if (!evictable(i))
+			continue;
+
+		UINT last = excessOnly ? t.Wanted : t.TailMip;
+		for (UINT mip = t.FirstResident; mip < last; ++mip)
+			available += t.Desc.MipBytes[mip];
+	}
+	if (available < bytes)
+		return false;
+
+	UINT64 freed = 0;
+	while (freed < bytes)
+	{
+		// least recently used, the largest resident mip on ties
+		UINT victim = UINT_MAX;
+		for (UINT i = 0; i < TextureCount(); ++i)
+		{
+			if (!evictable(i))
+				continue;
+
+			const StreamedTexture& t = _Textures[i];
+			if (victim == UINT_MAX)
+			{
+				victim = i;
+				continue;
+			}
+
+			const StreamedTexture& v = _Textures[victim];
+			if (t.LastUsedFrame < v.LastUsedFrame ||
+				(t.LastUsedFrame == v.LastUsedFrame && t.Desc.MipBytes[t.FirstResident] > v.Desc.MipBytes[v.FirstResident]))
+				victim = i;
+		}
+
+		StreamedTexture& v = _Textures[victim];
+		freed += v.Desc.MipBytes[v.FirstResident];
+		_ResidentBytes -= v.Desc.MipBytes[v.FirstResident];
+		v.FirstResident++;
+	}
+
+	return true;
+}
+
+void TextureStreamer::Apply(TextureStreamingDevice& device)
+{
+	for (UINT i = 0; i < TextureCount(); ++i)
+	{
+		StreamedTexture& t = _Textures[i];
+		if (t.FirstResident == t.Applied)
+			continue;
+
+		if (device.SetFirstResidentMip(i, t.FirstResident))
+		{
+			t.Applied = t.FirstResident;
+			continue;
+		}
+
+		// back to what the device still holds
+		for (UINT mip = min(t.FirstResident, t.Applied); mip < max(t.FirstResident, t.Applied); ++mip)
+		{
+			if (t.FirstResident < t.Applied)
+				_ResidentBytes -= t.Desc.MipBytes[mip];
+			else
+				_ResidentBytes += t.Desc.MipBytes[mip];
+		}
+		t.FirstResident = t.Applied;
+	}
+}
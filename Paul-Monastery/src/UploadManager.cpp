@@ -0,0 +1,168 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <d3dUtil.h>
+#include <ResourceHeaps.h>
+#include <UploadManager.h>
+
+using Microsoft::WRL::ComPtr;
+
+UploadManager::UploadManager(ID3D12Device* device, ResourceHeaps& heaps, UINT64 capacity)
+	: _Device(device), _Heaps(heaps), _Ring(capacity)
+{
+	_RingBuffer = CreateUploadBuffer(capacity, _RingData);
+}
+
+void UploadManager::BeginFrame(ID3D12GraphicsCommandList* cmdList, UINT64 frameFence, UINT64 completedFence)
+{
+	assert(_Barriers.empty());
+
+	_CmdList = cmdList;
+	_FrameFence = frameFence;
+
+	_Ring.Reclaim(completedFence);
+
+	while (!_Retired.empty() && _Retired.front().Fence <= completedFence)
+	{
+		Retired& r = _Retired.front();
+
+		// the heap range may only be reused once the resource is gone
+		r.Buffer.Reset();
+		_Heaps.Free(r.Placement);
+		_Retired.pop_front();
+	}
+}
+
+ComPtr<ID3D12Resource> UploadManager::CreateBuffer(const void* data, UINT64 byteSize, HeapPlacement& placement,
+	D3D12_RESOURCE_STATES finalState)
+{
+	// buffers start in COMMON and are promoted to COPY_DEST by the copy
+	ComPtr<ID3D12Resource> buffer;
+	ThrowIfFailed(_Heaps.CreateResource(CD3DX12_RESOURCE_DESC::Buffer(byteSize),
+		D3D12_RESOURCE_STATE_COMMON, buffer, placement));
+
+	UploadBuffer(buffer.Get(), 0, data, byteSize, finalState);
+	return buffer;
+}
+
+void UploadManager::UploadBuffer(ID3D12Resource* buffer, UINT64 dstOffset, const void* data, UINT64 byteSize,
+	D3D12_RESOURCE_STATES finalState)
+{
+	ID3D12Resource* staging;
+	UINT64 offset;
+	BYTE* dst = Stage(byteSize, 16, staging, offset);
+	memcpy(dst, data, (size_t)byteSize);
+
+	_CmdList->CopyBufferRegion(buffer, dstOffset, staging, offset, byteSize);
+
+	_Barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(buffer,
+		D3D12_RESOURCE_STATE_COPY_DEST, finalState));
+}
+
+ComPtr<ID3D12Resource> UploadManager::CreateTexture(const D3D12_RESOURCE_DESC& desc,
+	const D3D12_SUBRESOURCE_DATA* subresources, HeapPlacement& placement, D3D12_RESOURCE_STATES finalState)
+{
+	ComPtr<ID3D12Resource> texture;
+	ThrowIfFailed(_Heaps.CreateResource(desc, D3D12_RESOURCE_STATE_COPY_DEST, texture, placement));
+
+	UploadTexture(texture.Get(), subresources, finalState);
+	return texture;
+}
+
+void UploadManager::UploadTexture(ID3D12Resource* texture, const D3D12_SUBRESOURCE_DATA* subresources,
+	D3D12_RESOURCE_STATES finalState)
+{
+	D3D12_RESOURCE_DESC desc = texture->GetDesc();
+	const UINT subresourceCount = desc.DepthOrArraySize * desc.MipLevels;
+
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(subresourceCount);
+	std::vector<UINT> rowCounts(subresourceCount);
+	std::vector<UINT64> rowSizes(subresourceCount);
+	UINT64 totalBytes = 0;
+	_Device->GetCopyableFootprints(&desc, 0, subresourceCount, 0,
+		layouts.data(), rowCounts.data(), rowSizes.data(), &totalBytes);
+
+	ID3D12Resource* staging;
+	UINT64 offset;
+	BYTE* dst = Stage(totalBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, staging, offset);
+
+	for (UINT i = 0; i < subresourceCount; ++i)
+	{
+		// the footprints are padded to the row pitch alignment, the source rows are not
+		const D3D12_SUBRESOURCE_FOOTPRINT& footprint = layouts[i].Footprint;
+		for (UINT z = 0; z < footprint.Depth; ++z)
+		{
+			BYTE* dstSlice = dst + layouts[i].Offset + (UINT64)footprint.RowPitch * rowCounts[i] * z;
+			const BYTE* srcSlice = (const BYTE*)subresources[i].pData + subresources[i].SlicePitch * z;
+
+			for (UINT row = 0; row < rowCounts[i]; ++row)
+				memcpy(dstSlice + (UINT64)footprint.RowPitch * row, srcSlice + subresources[i].RowPitch * row, (size_t)rowSizes[i]);
+		}
+
+		layouts[i].Offset += offset;
+		CD3DX12_TEXTURE_COPY_LOCATION dstLocation(texture, i);
+		CD3DX12_TEXTURE_COPY_LOCATION srcLocation(staging, layouts[i]);
+		_CmdList->CopyTextureRegion(&dstLocation, 0, 0, 0, &srcLocation, nullptr);
+	}
+
+	_Barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(texture,
+		D3D12_RESOURCE_STATE_COPY_DEST, finalState));
+}
+
+void UploadManager::Release(ComPtr<ID3D12Resource> resource, const HeapPlacement& placement)
+{
+	_Retired.push_back({ _FrameFence, std::move(resource), placement });
+}
+
+void UploadManager::Flush()
+{
+	if (_Barriers.empty())
+		return;
+
+	// several uploads into one buffer leave it in COPY_DEST only once
+	std::sort(_Barriers.begin(), _Barriers.end(), [](const D3D12_RESOURCE_BARRIER& a, const D3D12_RESOURCE_BARRIER& b) {
+		return a.Transition.pResource < b.Transition.pResource;
+	});
+	_Barriers.erase(std::unique(_Barriers.begin(), _Barriers.end(), [](const D3D12_RESOURCE_BARRIER& a, const D3D12_RESOURCE_BARRIER& b) {
+		return a.Transition.pResource == b.Transition.pResource;
+	}), _Barriers.end());
+
+	_CmdList->ResourceBarrier((UINT)_Barriers.size(), _Barriers.data());
+	_Barriers.clear();
+}
+
+BYTE* UploadManager::Stage(UINT64 size, UINT64 alignment, ID3D12Resource*& buffer, UINT64& offset)
+{
+	assert(_CmdList);
+
+	if (_Ring.Allocate(size, alignment, _FrameFence, offset))
+	{
+		buffer = _RingBuffer.Get();
+		return _RingData + offset;
+	}
+
+	// larger than the ring, or the ring is still full of frames in flight
+	BYTE* mapped;
+	ComPtr<ID3D12Resource> dedicated = CreateUploadBuffer(size, mapped);
+	_Retired.push_back({ _FrameFence, dedicated, HeapPlacement() });
+
+	buffer = dedicated.Get();
+	offset = 0;
+	return mapped;
+}
+
+ComPtr<ID3D12Resource> UploadManager::CreateUploadBuffer(UINT64 size, BYTE*& mapped)
+{
+	ComPtr<ID3D12Resource> buffer;
+	ThrowIfFailed(_Device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(size),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&buffer)));
+
+	// upload heaps may stay mapped for their whole lifetime
+	ThrowIfFailed(buffer->Map(0, nullptr, reinterpret_cast<void**>(&mapped)));
+	return buffer;
+}
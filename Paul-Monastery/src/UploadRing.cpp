@@ -0,0 +1,47 @@
+#include "pch.h"
+#include "platform.h"
+
+#include <UploadRing.h>
+
+bool UploadRing::Allocate(UINT64 size, UINT64 alignment, UINT64 fence, UINT64& offset)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+	assert(_Spans.empty() || _Spans.back().Fence <= fence);
+
+	if (size == 0 || size > _Capacity)
+		return false;
+
+	// the free space runs from the head around to the oldest allocation
+	UINT64 start = (_Head + alignment - 1) & ~(alignment - 1);
+	if (start + size > _Capacity)
+		start = 0;
+
+	UINT64 end = start + size;
+	UINT64 bytes = start >= _Head ? end - _Head : _Capacity - _Head + end;
+	if (bytes > _Capacity - _UsedBytes)
+		return false;
+
+	_Head = end == _Capacity ? 0 : end;
+	_UsedBytes += bytes;
+
+	if (!_Spans.empty() && _Spans.back().Fence == fence)
+		_Spans.back().Bytes += bytes;
+	else
+		_Spans.push_back({ fence, bytes });
+
+	offset = start;
+	return true;
+}
+
+void UploadRing::Reclaim(UINT64 completedFence)
+{
+	while (!_Spans.empty() && _Spans.front().Fence <= completedFence)
+	{
+		_UsedBytes -= _Spans.front().Bytes;
+		_Spans.pop_front();
+	}
+
+	// an empty ring starts over, so large allocations do not have to wrap
+	if (_UsedBytes == 0)
+		_Head = 0;
+}
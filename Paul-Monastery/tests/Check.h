@@ -0,0 +1,35 @@
+#ifndef _CHECK_H_
+#define _CHECK_H_
+
+// Checks for the standalone tests in this directory. A failed CHECK prints
+// the expression and where it failed and the test goes on; main() returns
+// CheckResult() so a failure is seen by whatever runs the test.
+
+#include <cstdio>
+
+inline int& CheckFailures()
+{
+	static int failures = 0;
+	return failures;
+}
+
+#define CHECK(x)                                                          \
+{                                                                         \
+	if (!(x))                                                             \
+	{                                                                     \
+		std::printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #x);        \
+		CheckFailures()++;                                                \
+	}                                                                     \
+}
+
+inline int CheckResult()
+{
+	if (CheckFailures() == 0)
+		std::printf("all checks passed\n");
+	else
+		std::printf("%d checks failed\n", CheckFailures());
+
+	return CheckFailures() == 0 ? 0 : 1;
+}
+
+#endif /* _CHECK_H_ */
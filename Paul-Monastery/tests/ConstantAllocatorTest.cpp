@@ -0,0 +1,178 @@
+// Tests ConstantAllocator on the recording backend: alignment and view
+// sizes, wrapping around its ring with frames in flight, reuse of memory
+// only after the fence of the frame that read it, and the larger ring that
+// replaces a full one while the old one is still read.
+//
+// Builds on its own with the app's portable sources:
+//   g++ -O2 -std=c++17 -I../include -I../src ConstantAllocatorTest.cpp ../src/ConstantAllocator.cpp ../src/UploadRing.cpp ../src/CommandRecorder.cpp ../src/FrameCapture.cpp -o ConstantAllocatorTest
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src ConstantAllocatorTest.cpp ..\src\ConstantAllocator.cpp ..\src\UploadRing.cpp ..\src\CommandRecorder.cpp ..\src\FrameCapture.cpp
+
+#include "platform.h"
+
+#include <random>
+
+#include <ConstantAllocator.h>
+#include <CommandRecorder.h>
+
+#include "Check.h"
+
+namespace
+{
+	struct Constants
+	{
+		float World[16];
+		float TexTransform[16];
+	};
+
+	// an allocation and the frame byte it was filled with
+	struct Written
+	{
+		UINT64 Fence;
+		BYTE* Data;
+		RenderAddress GpuAddress;
+		UINT64 Size;
+	};
+
+	bool Holds(const Written& written)
+	{
+		for (UINT64 i = 0; i < written.Size; ++i)
+		{
+			if (written.Data[i] != (BYTE)written.Fence)
+				return false;
+		}
+		return true;
+	}
+
+	void TestAlignment()
+	{
+		RecordingDevice device;
+		ConstantAllocator constants(device, 4096);
+		constants.BeginFrame(1, 0);
+
+		CHECK(ConstantAllocator::Stride<Constants>() == 256);
+		CHECK(ConstantAllocator::Stride<float[65]>() == 512);
+
+		// every allocation is a whole number of views at a view's alignment
+		ConstantAllocator::Allocation a = constants.Allocate(1);
+		ConstantAllocator::Allocation b = constants.Allocate(300);
+		ConstantAllocator::Allocation c = constants.Allocate(256);
+		CHECK(a.GpuAddress % ConstantAllocator::Alignment == 0);
+		CHECK(b.GpuAddress == a.GpuAddress + 256);
+		CHECK(c.GpuAddress == b.GpuAddress + 512);
+		CHECK(c.Data - a.Data == 768);
+		CHECK(constants.UsedBytes() == 1024);
+
+		Constants value = {};
+		value.World[0] = 2.0f;
+		RenderAddress pushed = constants.Push(value);
+		CHECK(pushed == c.GpuAddress + 256);
+		CHECK(std::memcmp(c.Data + 256, &value, sizeof(value)) == 0);
+	}
+
+	// Three frames in flight, the fence completing each two frames after it
+	// was submitted. Every allocation must hold what its frame wrote until
+	// that frame's fence has completed.
+	void TestWrapAround()
+	{
+		RecordingDevice device;
+		SimulatedFence fence;
+		const UINT64 capacity = 64 * 1024;
+		ConstantAllocator constants(device, capacity);
+
+		std::mt19937 rng(3);
+		std::deque<Written> inFlight;
+		RenderAddress firstAddress = 0;
+		UINT wraps = 0;
+		UINT reused = 0;
+		UINT overwritten = 0;
+
+		for (UINT64 frame = 1; frame <= 2000; ++frame)
+		{
+			fence.Complete(frame > 2 ? frame - 2 : 0);
+			UINT64 completed = fence.CompletedValue();
+
+			// the GPU read them all as written
+			while (!inFlight.empty() && inFlight.front().Fence <= completed)
+			{
+				overwritten += !Holds(inFlight.front());
+				inFlight.pop_front();
+			}
+
+			constants.BeginFrame(frame, completed);
+
+			RenderAddress previous = 0;
+			UINT count = 1 + rng() % 12;
+			for (UINT i = 0; i < count; ++i)
+			{
+				UINT64 size = 64 + rng() % 1024;
+				ConstantAllocator::Allocation a = constants.Allocate(size);
+				std::memset(a.Data, (BYTE)frame, (size_t)size);
+
+				if (firstAddress == 0)
+					firstAddress = a.GpuAddress;
+
+				CHECK(a.GpuAddress % ConstantAllocator::Alignment == 0);
+				CHECK(a.GpuAddress >= firstAddress && a.GpuAddress + size <= firstAddress + capacity);
+				wraps += a.GpuAddress < previous;
+				reused += a.GpuAddress == firstAddress && frame > 1;
+				previous = a.GpuAddress;
+
+				inFlight.push_back({ frame, a.Data, a.GpuAddress, size });
+			}
+
+			fence.Signal(frame);
+		}
+
+		// never outgrew the ring, wrapped around it, and reused its front
+		CHECK(constants.Capacity() == capacity);
+		CHECK(wraps > 0);
+		CHECK(reused > 0);
+		CHECK(overwritten == 0);
+
+		for (const Written& written : inFlight)
+			CHECK(Holds(written));
+
+		std::printf("wrap-around: %u wraps, front reused %u times in 2000 frames\n", wraps, reused);
+	}
+
+	void TestGrowth()
+	{
+		RecordingDevice device;
+		ConstantAllocator constants(device, 4096);
+
+		// frame 1 fills the ring; frame 2 needs more while frame 1 is read
+		constants.BeginFrame(1, 0);
+		ConstantAllocator::Allocation old = constants.Allocate(4096);
+		std::memset(old.Data, 1, 4096);
+
+		constants.BeginFrame(2, 0);
+		ConstantAllocator::Allocation grown = constants.Allocate(256);
+		CHECK(constants.Capacity() == 8192);
+		CHECK(grown.GpuAddress >= old.GpuAddress + 4096 || grown.GpuAddress + 256 <= old.GpuAddress);
+
+		// the old ring stays mapped until the frames reading it are done
+		Written written = { 1, old.Data, old.GpuAddress, 4096 };
+		CHECK(Holds(written));
+
+		// a single allocation larger than twice the ring grows it to fit
+		constants.BeginFrame(3, 0);
+		constants.Allocate(40000);
+		CHECK(constants.Capacity() == 65536);
+
+		// once everything completed the new ring starts over at its front
+		constants.BeginFrame(4, 3);
+		CHECK(constants.UsedBytes() == 0);
+		ConstantAllocator::Allocation a = constants.Allocate(256);
+		ConstantAllocator::Allocation b = constants.Allocate(256);
+		CHECK(b.GpuAddress == a.GpuAddress + 256);
+	}
+}
+
+int main()
+{
+	TestAlignment();
+	TestWrapAround();
+	TestGrowth();
+
+	return CheckResult();
+}
@@ -0,0 +1,220 @@
+// Times the device-free stage of texture loading, LoadDDSTextureData12:
+// mapping, validating and finding the subresources of 10 to 10,000
+// synthetic DDS files, and the parse alone on files already in memory.
+// The files mix BC1, BC3 and RGBA8 2D textures with full mip chains, cube
+// maps and legacy headers without the DX10 extension. Every file must parse
+// to the expected layout, and truncated or corrupt ones must be rejected.
+//
+//   DDSParseBenchmark [max files]
+//
+// Builds on its own with the app's portable sources:
+//   g++ -O2 -std=c++17 -I../include -I../src DDSParseBenchmark.cpp ../src/DDSParser.cpp ../src/MappedFile.cpp -o DDSParseBenchmark
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src DDSParseBenchmark.cpp ..\src\DDSParser.cpp ..\src\MappedFile.cpp
+
+#include "platform.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+
+#include <DDSParser.h>
+
+#include "Check.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const char* const Directory = "DDSParseBenchmark.tmp";
+
+	struct Template
+	{
+		DXGI_FORMAT Format;
+		UINT Size;
+		bool Cube;
+		bool Legacy;
+	};
+
+	const Template Templates[] =
+	{
+		{ DXGI_FORMAT_BC1_UNORM, 128, false, false },
+		{ DXGI_FORMAT_BC3_UNORM_SRGB, 64, false, false },
+		{ DXGI_FORMAT_R8G8B8A8_UNORM, 32, false, false },
+		{ DXGI_FORMAT_BC1_UNORM, 32, true, false },
+		{ DXGI_FORMAT_BC3_UNORM, 64, false, true },
+	};
+
+	UINT MipCount(UINT size)
+	{
+		UINT count = 1;
+		while (size > 1)
+		{
+			size >>= 1;
+			count++;
+		}
+		return count;
+	}
+
+	// A file as a DDS writer lays it out: faces, each with its mip chain.
+	std::vector<BYTE> MakeDDS(const Template& t)
+	{
+		DDS_HEADER header = {};
+		header.size = sizeof(DDS_HEADER);
+		header.flags = DDS_HEIGHT | DDS_WIDTH | 0x1007;
+		header.width = t.Size;
+		header.height = t.Size;
+		header.mipMapCount = MipCount(t.Size);
+		header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+		header.ddspf.flags = DDS_FOURCC;
+		header.caps2 = t.Cube ? DDS_CUBEMAP | DDS_CUBEMAP_ALLFACES : 0;
+
+		DDS_HEADER_DXT10 dx10 = {};
+		if (t.Legacy)
+		{
+			header.ddspf.fourCC = MAKEFOURCC('D', 'X', 'T', '5');
+		}
+		else
+		{
+			header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+			dx10.dxgiFormat = t.Format;
+			dx10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+			dx10.miscFlag = t.Cube ? DDS_RESOURCE_MISC_TEXTURECUBE : 0;
+			dx10.arraySize = 1;
+		}
+
+		std::vector<BYTE> file(sizeof(DDS_MAGIC) + sizeof(header) + (t.Legacy ? 0 : sizeof(dx10)));
+		std::memcpy(file.data(), &DDS_MAGIC, sizeof(DDS_MAGIC));
+		std::memcpy(file.data() + sizeof(DDS_MAGIC), &header, sizeof(header));
+		if (!t.Legacy)
+			std::memcpy(file.data() + sizeof(DDS_MAGIC) + sizeof(header), &dx10, sizeof(dx10));
+
+		for (UINT face = 0; face < (t.Cube ? 6u : 1u); ++face)
+		{
+			for (UINT size = t.Size; ; size /= 2)
+			{
+				size_t bytes = 0;
+				GetSurfaceInfo(size, size, t.Format, &bytes, nullptr, nullptr);
+				file.resize(file.size() + bytes, (BYTE)(size + face));
+				if (size == 1)
+					break;
+			}
+		}
+		return file;
+	}
+
+	std::string FileName(int index)
+	{
+		return std::string(Directory) + "/" + std::to_string(index) + ".dds";
+	}
+
+	std::wstring Widen(const std::string& s)
+	{
+		return std::wstring(s.begin(), s.end());
+	}
+
+	bool Expected(const DDSTextureData12& data, const Template& t)
+	{
+		return data.Width == t.Size && data.Height == t.Size && data.Depth == 1 &&
+			data.MipCount == MipCount(t.Size) && data.ArraySize == (t.Cube ? 6u : 1u) &&
+			data.IsCubeMap == t.Cube && data.Format == t.Format &&
+			data.ResourceDimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D &&
+			data.Subresources.size() == data.MipCount * data.ArraySize;
+	}
+
+	void TestRejection(const std::vector<BYTE>& file)
+	{
+		DDSTextureData12 data;
+		CHECK(SUCCEEDED(ParseDDSTextureData12(file.data(), file.size(), data)));
+
+		// short by a byte: the last mip does not fit
+		CHECK(ParseDDSTextureData12(file.data(), file.size() - 1, data) == HRESULT_FROM_WIN32(ERROR_HANDLE_EOF));
+
+		// cut inside the headers
+		CHECK(FAILED(ParseDDSTextureData12(file.data(), 100, data)));
+		CHECK(FAILED(ParseDDSTextureData12(file.data(), 130, data)));
+
+		std::vector<BYTE> corrupt = file;
+		corrupt[0] = 'X';
+		CHECK(FAILED(ParseDDSTextureData12(corrupt.data(), corrupt.size(), data)));
+
+		// a format without a size, an empty array
+		corrupt = file;
+		DXGI_FORMAT unknown = DXGI_FORMAT_UNKNOWN;
+		std::memcpy(corrupt.data() + sizeof(DDS_MAGIC) + sizeof(DDS_HEADER), &unknown, sizeof(unknown));
+		CHECK(ParseDDSTextureData12(corrupt.data(), corrupt.size(), data) == HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED));
+
+		corrupt = file;
+		std::memset(corrupt.data() + sizeof(DDS_MAGIC) + sizeof(DDS_HEADER) + offsetof(DDS_HEADER_DXT10, arraySize), 0, sizeof(uint32_t));
+		CHECK(ParseDDSTextureData12(corrupt.data(), corrupt.size(), data) == HRESULT_FROM_WIN32(ERROR_INVALID_DATA));
+
+		// a file that is not there
+		CHECK(FAILED(LoadDDSTextureData12(L"DDSParseBenchmark.missing.dds", data)));
+
+		// maxsize drops the mips above it
+		CHECK(SUCCEEDED(ParseDDSTextureData12(file.data(), file.size(), data, 32)));
+		CHECK(data.Width == 32 && data.MipCount == MipCount(32));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int maxFiles = argc > 1 ? max(10, atoi(argv[1])) : 10000;
+
+	const size_t templateCount = sizeof(Templates) / sizeof(Templates[0]);
+	std::vector<std::vector<BYTE>> files;
+	for (const Template& t : Templates)
+		files.push_back(MakeDDS(t));
+
+	TestRejection(files[0]);
+
+	std::filesystem::remove_all(Directory);
+	std::filesystem::create_directory(Directory);
+
+	int written = 0;
+	for (int count = 10; count <= maxFiles; count *= 10)
+	{
+		for (; written < count; ++written)
+		{
+			const std::vector<BYTE>& file = files[written % templateCount];
+			std::ofstream fout(FileName(written), std::ios::binary);
+			fout.write((const char*)file.data(), (std::streamsize)file.size());
+		}
+
+		std::vector<std::wstring> names;
+		for (int i = 0; i < count; ++i)
+			names.push_back(Widen(FileName(i)));
+
+		// the loader's job: map, parse, release; once to warm the file cache
+		double loadSeconds = 1e30;
+		UINT wrong = 0;
+		for (int run = 0; run < 2; ++run)
+		{
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < count; ++i)
+			{
+				DDSTextureData12 data;
+				HRESULT hr = LoadDDSTextureData12(names[i].c_str(), data);
+				wrong += FAILED(hr) || !Expected(data, Templates[i % templateCount]);
+			}
+			loadSeconds = min(loadSeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+		CHECK(wrong == 0);
+
+		// the parse alone, from memory
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; ++i)
+		{
+			const std::vector<BYTE>& file = files[i % templateCount];
+			DDSTextureData12 data;
+			wrong += FAILED(ParseDDSTextureData12(file.data(), file.size(), data));
+		}
+		double parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		CHECK(wrong == 0);
+
+		std::printf("%6d files: load %8.2f ms (%5.2f us per file), of which parsing %6.2f ms (%5.2f us per file)\n",
+			count, loadSeconds * 1e3, loadSeconds * 1e6 / count, parseSeconds * 1e3, parseSeconds * 1e6 / count);
+	}
+
+	std::filesystem::remove_all(Directory);
+	return CheckResult();
+}
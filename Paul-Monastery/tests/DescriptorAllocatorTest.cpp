@@ -0,0 +1,180 @@
+// Tests DescriptorAllocator: freed slots handed out again, released slots
+// kept from reuse until the fence of the frame that reads them completes,
+// the capacity doubling when the slots run out without renumbering the ones
+// in use, and UsedCount and HighWater against a reference model over
+// 100,000 random allocations, frees and releases.
+//
+// Builds on its own with the app's portable sources:
+//   g++ -O2 -std=c++17 -I../include -I../src DescriptorAllocatorTest.cpp ../src/DescriptorAllocator.cpp -o DescriptorAllocatorTest
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src DescriptorAllocatorTest.cpp ..\src\DescriptorAllocator.cpp
+
+#include "platform.h"
+
+#include <deque>
+#include <random>
+#include <set>
+
+#include <DescriptorAllocator.h>
+
+#include "Check.h"
+
+namespace
+{
+	void TestReuse()
+	{
+		DescriptorAllocator allocator(4);
+		UINT a = allocator.Allocate();
+		UINT b = allocator.Allocate();
+		UINT c = allocator.Allocate();
+		CHECK(a == 0 && b == 1 && c == 2);
+
+		// freed at once, the next allocation takes it
+		allocator.Free(b);
+		CHECK(allocator.UsedCount() == 2);
+		CHECK(allocator.Allocate() == b);
+
+		// released, reused after Reclaim
+		allocator.Release(a, 5);
+		allocator.Reclaim(5);
+		CHECK(allocator.UsedCount() == 2);
+		CHECK(allocator.Allocate() == a);
+		CHECK(allocator.HighWater() == 3);
+	}
+
+	void TestFence()
+	{
+		DescriptorAllocator allocator(8);
+		UINT a = allocator.Allocate();
+		UINT b = allocator.Allocate();
+		allocator.Release(a, 10);
+		allocator.Release(b, 12);
+
+		// in use until the frame's fence has completed
+		allocator.Reclaim(9);
+		CHECK(allocator.UsedCount() == 2);
+		UINT c = allocator.Allocate();
+		CHECK(c != a && c != b);
+
+		allocator.Reclaim(11);
+		CHECK(allocator.UsedCount() == 2);
+		UINT d = allocator.Allocate();
+		CHECK(d == a);
+
+		allocator.Reclaim(12);
+		CHECK(allocator.UsedCount() == 2);
+		CHECK(allocator.Allocate() == b);
+		CHECK(allocator.HighWater() == 3);
+	}
+
+	void TestGrowth()
+	{
+		DescriptorAllocator allocator(3);
+		std::vector<UINT> slots;
+		for (UINT i = 0; i < 3; ++i)
+			slots.push_back(allocator.Allocate());
+		CHECK(allocator.Capacity() == 3);
+
+		// the fourth doubles the capacity and the first three keep their slots
+		slots.push_back(allocator.Allocate());
+		CHECK(allocator.Capacity() == 6);
+		CHECK(slots == std::vector<UINT>({ 0, 1, 2, 3 }));
+
+		for (UINT i = 4; i < 13; ++i)
+			slots.push_back(allocator.Allocate());
+		CHECK(allocator.Capacity() == 24);
+		for (UINT i = 0; i < (UINT)slots.size(); ++i)
+			CHECK(slots[i] == i);
+
+		// a free slot is taken before the capacity grows again
+		for (UINT i = 13; i < 24; ++i)
+			allocator.Allocate();
+		allocator.Free(5);
+		CHECK(allocator.Allocate() == 5);
+		CHECK(allocator.Capacity() == 24);
+		CHECK(allocator.Allocate() == 24);
+		CHECK(allocator.Capacity() == 48);
+		CHECK(allocator.UsedCount() == 25 && allocator.HighWater() == 25);
+
+		// at least one slot
+		CHECK(DescriptorAllocator(0).Capacity() == 1);
+	}
+
+	void TestRandom()
+	{
+		DescriptorAllocator allocator(16);
+		std::mt19937 rng(18);
+
+		// what the allocator must agree with: released slots stay used
+		// until their fence completes
+		std::set<UINT> used;
+		std::deque<std::pair<UINT64, UINT>> released;
+		UINT highWater = 0;
+		UINT64 fence = 1, completed = 0;
+
+		std::vector<UINT> owned;
+		UINT wrong = 0, capacityBelowHighWater = 0;
+		for (UINT step = 0; step < 100000; ++step)
+		{
+			UINT op = rng() % 8;
+			if (op < 4 || owned.empty())
+			{
+				UINT slot = allocator.Allocate();
+				wrong += used.count(slot) != 0;
+				used.insert(slot);
+				owned.push_back(slot);
+				highWater = max(highWater, slot + 1);
+			}
+			else if (op < 7)
+			{
+				size_t k = rng() % owned.size();
+				UINT slot = owned[k];
+				owned[k] = owned.back();
+				owned.pop_back();
+
+				if (op == 4)
+				{
+					allocator.Free(slot);
+					used.erase(slot);
+				}
+				else
+				{
+					// read by the frame being recorded
+					allocator.Release(slot, fence);
+					released.push_back({ fence, slot });
+				}
+			}
+			else
+			{
+				// the next frame, the GPU one or two frames behind
+				fence++;
+				completed = max(completed, fence - 1 - rng() % 2);
+				allocator.Reclaim(completed);
+				while (!released.empty() && released.front().first <= completed)
+				{
+					used.erase(released.front().second);
+					released.pop_front();
+				}
+			}
+
+			wrong += allocator.UsedCount() != (UINT)used.size();
+			wrong += allocator.HighWater() != highWater;
+			capacityBelowHighWater += allocator.Capacity() < allocator.HighWater();
+		}
+
+		CHECK(wrong == 0);
+		CHECK(capacityBelowHighWater == 0);
+		CHECK(allocator.Capacity() >= 16);
+		std::printf("100000 random steps: %u used, high water %u, capacity %u\n",
+			allocator.UsedCount(), allocator.HighWater(), allocator.Capacity());
+	}
+}
+
+int main()
+{
+	TestReuse();
+	TestFence();
+	TestGrowth();
+	TestRandom();
+
+	return CheckResult();
+}
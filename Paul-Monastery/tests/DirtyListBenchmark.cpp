@@ -0,0 +1,211 @@
+// Times the object constant update driven by a DirtyList against the walk
+// over every item it replaced, which tested a NumFramesDirty counter per
+// item. Scenes of 10k, 100k and 1M items, with 0.1%, 1% and 100% of them
+// moved every frame, three frame resources. The first three frames write
+// everything, as after loading, and are not timed. Both versions must
+// write the same items each frame.
+//
+//   DirtyListBenchmark [frames]
+//
+// Builds on its own with the app's portable sources:
+//   g++ -O2 -std=c++17 -I../include -I../src DirtyListBenchmark.cpp ../src/DirtyList.cpp -o DirtyListBenchmark
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src DirtyListBenchmark.cpp ..\src\DirtyList.cpp
+
+#include "platform.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+#include <DirtyList.h>
+
+#include "Check.h"
+
+namespace
+{
+	const int FrameResourceCount = 3;
+
+	// the size of ObjectConstants: world and texture transforms
+	struct Constants
+	{
+		float World[16];
+		float TexTransform[16];
+	};
+
+	struct Scene
+	{
+		explicit Scene(UINT itemCount) : Items(itemCount), NumFramesDirty(itemCount, FrameResourceCount)
+		{
+			for (int f = 0; f < FrameResourceCount; ++f)
+				Mapped[f].resize(itemCount);
+		}
+
+		std::vector<Constants> Items;
+		std::vector<int> NumFramesDirty;
+		std::vector<Constants> Mapped[FrameResourceCount];
+	};
+
+	typedef std::chrono::steady_clock Clock;
+
+	double Microseconds(Clock::duration d)
+	{
+		return std::chrono::duration<double, std::micro>(d).count();
+	}
+
+	// Times of the frames after the first FrameResourceCount, which write
+	// every item once as after loading.
+	struct Result
+	{
+		double MarkUs = 0.0;
+		double UpdateUs = 0.0;
+		UINT64 Written = 0;
+
+		void Add(size_t frame, Clock::duration mark, Clock::duration update, UINT written)
+		{
+			Written += written;
+			if (frame < FrameResourceCount)
+				return;
+
+			MarkUs += Microseconds(mark);
+			UpdateUs += Microseconds(update);
+		}
+	};
+
+	// Every item is visited to find the few that changed. The written items
+	// are kept for the check when written is given, the timed runs skip it.
+	Result RunCounter(Scene& scene, const std::vector<std::vector<UINT>>& moves, std::vector<std::vector<UINT>>* written)
+	{
+		Result result;
+		for (size_t frame = 0; frame < moves.size(); ++frame)
+		{
+			auto start = Clock::now();
+			for (UINT index : moves[frame])
+			{
+				scene.Items[index].World[12] += 1.0f;
+				scene.NumFramesDirty[index] = FrameResourceCount;
+			}
+
+			auto marked = Clock::now();
+			std::vector<Constants>& mapped = scene.Mapped[frame % FrameResourceCount];
+			UINT count = 0;
+			for (UINT i = 0; i < (UINT)scene.Items.size(); ++i)
+			{
+				if (scene.NumFramesDirty[i] > 0)
+				{
+					mapped[i] = scene.Items[i];
+					scene.NumFramesDirty[i]--;
+					count++;
+
+					if (written)
+						(*written)[frame].push_back(i);
+				}
+			}
+
+			auto updated = Clock::now();
+			result.Add(frame, marked - start, updated - marked, count);
+		}
+		return result;
+	}
+
+	// only the queued items are visited
+	Result RunDirtyList(Scene& scene, const std::vector<std::vector<UINT>>& moves, std::vector<std::vector<UINT>>* written)
+	{
+		DirtyList dirty;
+		dirty.Reset(FrameResourceCount, (UINT)scene.Items.size());
+		dirty.MarkAllDirty();
+
+		Result result;
+		for (size_t frame = 0; frame < moves.size(); ++frame)
+		{
+			auto start = Clock::now();
+			for (UINT index : moves[frame])
+			{
+				scene.Items[index].World[12] += 1.0f;
+				dirty.MarkDirty(index);
+			}
+
+			auto marked = Clock::now();
+			int frameResource = (int)(frame % FrameResourceCount);
+			std::vector<Constants>& mapped = scene.Mapped[frameResource];
+			const std::vector<UINT>& items = dirty.DirtyItems(frameResource);
+			for (UINT index : items)
+				mapped[index] = scene.Items[index];
+
+			UINT count = (UINT)items.size();
+			if (written)
+				(*written)[frame] = items;
+
+			dirty.Clear(frameResource);
+
+			auto updated = Clock::now();
+			result.Add(frame, marked - start, updated - marked, count);
+		}
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int frames = argc > 1 ? max(atoi(argv[1]), FrameResourceCount + 1) : 60;
+
+	const UINT itemCounts[] = { 10000, 100000, 1000000 };
+	const double movedShares[] = { 0.001, 0.01, 1.0 };
+
+	std::printf("%d frames, %d frame resources, microseconds per frame\n", frames, FrameResourceCount);
+	std::printf("%9s %7s %12s %12s %12s %12s %9s\n", "items", "moved", "counter", "dirty mark", "dirty update", "dirty total", "speedup");
+
+	std::mt19937 rng(1);
+	for (UINT itemCount : itemCounts)
+	{
+		for (double share : movedShares)
+		{
+			// the same moves for both versions; the first frames also write
+			// everything once, as after loading
+			UINT movedCount = max(1u, (UINT)(itemCount * share));
+			std::vector<std::vector<UINT>> moves(frames);
+			for (auto& frameMoves : moves)
+			{
+				if (movedCount == itemCount)
+				{
+					for (UINT i = 0; i < itemCount; ++i)
+						frameMoves.push_back(i);
+					continue;
+				}
+
+				for (UINT i = 0; i < movedCount; ++i)
+					frameMoves.push_back(rng() % itemCount);
+			}
+
+			Scene counterScene(itemCount);
+			Result counter = RunCounter(counterScene, moves, nullptr);
+
+			Scene dirtyScene(itemCount);
+			Result dirty = RunDirtyList(dirtyScene, moves, nullptr);
+
+			CHECK(counter.Written == dirty.Written);
+
+			// again, keeping what was written
+			std::vector<std::vector<UINT>> counterWritten(frames);
+			std::vector<std::vector<UINT>> dirtyWritten(frames);
+			Scene checkScene(itemCount);
+			RunCounter(checkScene, moves, &counterWritten);
+			RunDirtyList(checkScene, moves, &dirtyWritten);
+
+			for (int frame = 0; frame < frames; ++frame)
+			{
+				std::sort(dirtyWritten[frame].begin(), dirtyWritten[frame].end());
+				CHECK(counterWritten[frame] == dirtyWritten[frame]);
+			}
+
+			const int timedFrames = frames - FrameResourceCount;
+			double counterUs = (counter.MarkUs + counter.UpdateUs) / timedFrames;
+			double markUs = dirty.MarkUs / timedFrames;
+			double updateUs = dirty.UpdateUs / timedFrames;
+
+			std::printf("%9u %6.1f%% %12.1f %12.1f %12.1f %12.1f %8.1fx\n", itemCount, share * 100.0,
+				counterUs, markUs, updateUs, markUs + updateUs, counterUs / (markUs + updateUs));
+		}
+	}
+
+	return CheckResult();
+}
@@ -0,0 +1,360 @@
+// Tests DrawChunks and the parallel recording built on it: LayerRange and
+// Split on edge cases, then 100k opaque draws recorded by a render thread
+// attached to the JobSystem, split into chunks as GraphicsWindow::Draw
+// does, against one list recording every draw. Replayed in submission
+// order, the chunked lists must leave every draw the state the single list
+// gives it, and no two threads may record with the same thread index,
+// which picks the command allocator.
+//
+// Builds on its own with the app's portable sources:
+//   g++ -O2 -std=c++17 -pthread -I../include -I../src DrawChunksTest.cpp ../src/DrawChunks.cpp ../src/DrawKey.cpp ../src/CommandRecorder.cpp ../src/JobSystem.cpp ../src/Profiler.cpp -o DrawChunksTest
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src DrawChunksTest.cpp ..\src\DrawChunks.cpp ..\src\DrawKey.cpp ..\src\CommandRecorder.cpp ..\src\JobSystem.cpp ..\src\Profiler.cpp
+
+#include "platform.h"
+
+#include <chrono>
+#include <map>
+#include <random>
+
+#include <JobSystem.h>
+#include <DrawKey.h>
+#include <DrawChunks.h>
+#include <CommandRecorder.h>
+
+#include "Check.h"
+
+namespace
+{
+	// the layers of RenderLayer
+	const UINT SkyLayer = 0;
+	const UINT OpaqueLayer = 2;
+	const UINT InstancedLayer = 3;
+
+	const UINT MinChunkDraws = 1024;
+
+	// what the store keeps per item for drawing
+	struct DrawArgs
+	{
+		UINT Geometry;
+		UINT Topology;
+		UINT Material;
+		UINT IndexCount;
+		UINT StartIndex;
+		INT BaseVertex;
+	};
+
+	struct Scene
+	{
+		std::vector<DrawArgs> Args;
+		std::vector<UINT64> Keys;
+	};
+
+	// the pass state and change tracking of GraphicsWindow::RecordFrameCommands
+	void Record(const Scene& scene, RenderCommandList& cmdList, UINT begin, UINT end)
+	{
+		cmdList.SetGraphicsRootConstantBufferView(2, 0x9000);
+		cmdList.SetGraphicsRootDescriptorTable(0, 0x100);
+		cmdList.SetGraphicsRootDescriptorTable(4, 0x200);
+
+		UINT currPso = UINT_MAX;
+		UINT currGeo = UINT_MAX;
+		UINT currTopology = UINT_MAX;
+		UINT currMat = UINT_MAX;
+
+		for (UINT k = begin; k < end; ++k)
+		{
+			UINT64 key = scene.Keys[k];
+			const DrawArgs& args = scene.Args[DrawKey::Index(key)];
+
+			if (DrawKey::Pso(key) != currPso)
+			{
+				currPso = DrawKey::Pso(key);
+				cmdList.SetPipelineState(currPso);
+			}
+
+			if (args.Geometry != currGeo)
+			{
+				currGeo = args.Geometry;
+				cmdList.SetVertexBuffer({ 0x10000ull * currGeo, 1000, 32 });
+				cmdList.SetIndexBuffer({ 0x20000ull * currGeo, 500, RenderIndexFormat::Uint16 });
+			}
+
+			if (args.Topology != currTopology)
+			{
+				currTopology = args.Topology;
+				cmdList.SetPrimitiveTopology(currTopology);
+			}
+
+			if (args.Material != currMat)
+			{
+				currMat = args.Material;
+				cmdList.SetGraphicsRootConstantBufferView(3, 0x50000 + 256ull * currMat);
+			}
+
+			cmdList.SetGraphicsRootConstantBufferView(1, 0x1000000 + 256ull * k);
+			cmdList.DrawIndexedInstanced(args.IndexCount, 1, args.StartIndex, args.BaseVertex, 0);
+		}
+	}
+
+	// The state every draw sees. A list begins with none, as a D3D12 list
+	// does, so a chunk that relies on state of the list before it shows.
+	class StateTracker : public RenderCommandList
+	{
+	public:
+		static const UINT StateCount = 10;
+		static const UINT64 Unset = ~0ull;
+
+		struct Draw
+		{
+			UINT64 State[StateCount];
+			UINT IndexCount;
+			UINT StartIndex;
+			INT BaseVertex;
+
+			bool operator==(const Draw& rhs) const
+			{
+				return std::memcmp(State, rhs.State, sizeof(State)) == 0 && IndexCount == rhs.IndexCount &&
+					StartIndex == rhs.StartIndex && BaseVertex == rhs.BaseVertex;
+			}
+		};
+
+		void Replay(const RecordingCommandList& list)
+		{
+			for (UINT64& s : _State)
+				s = Unset;
+			CommandReader(list.Stream()).Replay(*this);
+		}
+
+		void SetPipelineState(UINT pso) override { _State[0] = pso; }
+		void SetPrimitiveTopology(UINT topology) override { _State[1] = topology; }
+		void SetVertexBuffer(const RenderVertexBufferView& view) override { _State[2] = view.Address; }
+		void SetIndexBuffer(const RenderIndexBufferView& view) override { _State[3] = view.Address; }
+		void SetGraphicsRootConstantBufferView(UINT parameter, RenderAddress address) override { _State[4 + parameter] = address; }
+		void SetGraphicsRootShaderResourceView(UINT parameter, RenderAddress address) override { _State[4 + parameter] = address; }
+		void SetGraphicsRootDescriptorTable(UINT parameter, RenderAddress descriptor) override { _State[4 + parameter] = descriptor; }
+
+		void DrawIndexedInstanced(UINT indexCount, UINT, UINT startIndex, INT baseVertex, UINT) override
+		{
+			// everything but the instance buffer, root parameter 5
+			for (UINT s = 0; s < 9; ++s)
+			{
+				if (_State[s] == Unset)
+				{
+					MissingState++;
+					break;
+				}
+			}
+
+			Draw draw;
+			std::memcpy(draw.State, _State, sizeof(_State));
+			draw.IndexCount = indexCount;
+			draw.StartIndex = startIndex;
+			draw.BaseVertex = baseVertex;
+			Draws.push_back(draw);
+		}
+
+		std::vector<Draw> Draws;
+		UINT MissingState = 0;
+
+	protected:
+		UINT64 _State[StateCount];
+	};
+
+	void TestSplit()
+	{
+		std::vector<DrawChunk> chunks;
+		DrawChunks::Split(DrawChunk(), 8, 1, chunks);
+		CHECK(chunks.empty());
+
+		for (UINT size : { 1u, 7u, 1023u, 1024u, 2047u, 2048u, 5000u, 100000u })
+		{
+			for (UINT maxChunks : { 1u, 3u, 4u, 8u, 64u })
+			{
+				DrawChunk range;
+				range.Begin = 17;
+				range.End = 17 + size;
+				DrawChunks::Split(range, maxChunks, MinChunkDraws, chunks);
+
+				// contiguous, in order, sizes within one draw of each other
+				CHECK(chunks.size() == min(maxChunks, max(1u, size / MinChunkDraws)));
+				CHECK(chunks.front().Begin == range.Begin && chunks.back().End == range.End);
+				for (size_t c = 0; c < chunks.size(); ++c)
+				{
+					CHECK(chunks[c].Size() > 0);
+					CHECK(c == 0 || chunks[c].Begin == chunks[c - 1].End);
+					CHECK(chunks[c].Size() <= chunks[0].Size() && chunks[c].Size() + 1 >= chunks[0].Size());
+				}
+			}
+		}
+	}
+
+	void TestLayerRange()
+	{
+		std::vector<UINT64> keys;
+		CHECK(DrawChunks::LayerRange(keys, OpaqueLayer).Size() == 0);
+
+		// a layer without keys is the empty range where it would start
+		keys = { DrawKey::Make(0, 0, 0, 0, 0, 0), DrawKey::Make(2, 0, 0, 0, 0, 1), DrawKey::Make(15, 0, 0, 0, 0, 2) };
+		DrawChunk missing = DrawChunks::LayerRange(keys, 1);
+		CHECK(missing.Size() == 0 && missing.Begin == 1);
+
+		// the last layer the key holds
+		DrawChunk last = DrawChunks::LayerRange(keys, 15);
+		CHECK(last.Begin == 2 && last.End == 3);
+	}
+
+	// the monastery scaled to 100k opaque draws, with sky and instanced draws
+	Scene MakeScene(UINT opaqueCount)
+	{
+		std::mt19937 rng(7);
+
+		Scene scene;
+		for (UINT i = 0; i < opaqueCount + 12; ++i)
+		{
+			DrawArgs args;
+			args.Geometry = rng() % 40;
+			args.Topology = 4;
+			args.Material = rng() % 120;
+			args.IndexCount = 36 + rng() % 900;
+			args.StartIndex = rng() % 50000;
+			args.BaseVertex = (INT)(rng() % 3000) - 1000;
+			scene.Args.push_back(args);
+
+			UINT layer = i < opaqueCount ? OpaqueLayer : (i < opaqueCount + 2 ? SkyLayer : InstancedLayer);
+			scene.Keys.push_back(DrawKey::Make(layer, layer, args.Geometry, args.Material, rng() % 4096, i));
+		}
+
+		std::vector<UINT64> scratch;
+		DrawKey::Sort(scene.Keys, scratch);
+		return scene;
+	}
+
+	void TestMerge()
+	{
+		const UINT opaqueCount = 100000;
+		Scene scene = MakeScene(opaqueCount);
+
+		DrawChunk opaque = DrawChunks::LayerRange(scene.Keys, OpaqueLayer);
+		CHECK(opaque.Begin == 2 && opaque.End == opaqueCount + 2);
+
+		// three workers and the render thread's deque, as the app sets it up
+		JobSystem jobs(3, 1);
+
+		std::vector<DrawChunk> chunks;
+		DrawChunks::Split(opaque, jobs.ThreadCount(), MinChunkDraws, chunks);
+
+		RecordingCommandList serial;
+		RecordingCommandList pre;
+		RecordingCommandList post;
+		std::vector<RecordingCommandList> lists(chunks.size());
+
+		// the thread index of every thread that recorded a chunk
+		std::mutex recordersMutex;
+		std::map<std::thread::id, UINT> recorders;
+
+		const int frames = 60;
+		const int warmupFrames = 10;
+		double serialUs = 0.0;
+		double chunkedUs = 0.0;
+
+		std::atomic<bool> rendering{ true };
+		std::thread render([&]()
+		{
+			jobs.AttachThread(0);
+
+			for (int frame = 0; frame < frames; ++frame)
+			{
+				auto start = std::chrono::steady_clock::now();
+				serial.Reset();
+				Record(scene, serial, 0, (UINT)scene.Keys.size());
+
+				auto serialDone = std::chrono::steady_clock::now();
+				pre.Reset();
+				Record(scene, pre, 0, opaque.Begin);
+
+				jobs.ParallelFor((UINT)chunks.size(), 1, [&](UINT begin, UINT end)
+				{
+					{
+						std::lock_guard<std::mutex> lock(recordersMutex);
+						recorders[std::this_thread::get_id()] = jobs.ThreadIndex();
+					}
+
+					for (UINT c = begin; c < end; ++c)
+					{
+						lists[c].Reset();
+						Record(scene, lists[c], chunks[c].Begin, chunks[c].End);
+					}
+				});
+
+				post.Reset();
+				Record(scene, post, opaque.End, (UINT)scene.Keys.size());
+				auto chunkedDone = std::chrono::steady_clock::now();
+
+				if (frame >= warmupFrames)
+				{
+					serialUs += std::chrono::duration<double, std::micro>(serialDone - start).count();
+					chunkedUs += std::chrono::duration<double, std::micro>(chunkedDone - serialDone).count();
+				}
+			}
+			rendering = false;
+		});
+
+		// the window thread simulates meanwhile and may pick up chunks
+		while (rendering)
+		{
+			std::atomic<UINT> sum{ 0 };
+			jobs.ParallelFor(256, 16, [&sum](UINT begin, UINT end) { sum += end - begin; });
+		}
+		render.join();
+
+		// the lists execute in the order pre, chunks, post
+		StateTracker expected;
+		expected.Replay(serial);
+
+		StateTracker merged;
+		merged.Replay(pre);
+		for (const RecordingCommandList& list : lists)
+			merged.Replay(list);
+		merged.Replay(post);
+
+		CHECK(expected.Draws.size() == scene.Keys.size());
+		CHECK(merged.Draws.size() == expected.Draws.size());
+
+		UINT mismatched = 0;
+		for (size_t d = 0; d < min(expected.Draws.size(), merged.Draws.size()); ++d)
+			mismatched += !(expected.Draws[d] == merged.Draws[d]);
+		CHECK(mismatched == 0);
+		CHECK(expected.MissingState == 0);
+		CHECK(merged.MissingState == 0);
+
+		// one allocator per thread: no index is used by two threads
+		std::vector<UINT> recordersPerIndex(jobs.ThreadCount(), 0);
+		for (const auto& recorder : recorders)
+		{
+			CHECK(recorder.second < jobs.ThreadCount());
+			recordersPerIndex[recorder.second]++;
+		}
+		for (UINT count : recordersPerIndex)
+			CHECK(count <= 1);
+
+		UINT chunkedCommands = pre.CommandCount() + post.CommandCount();
+		for (const RecordingCommandList& list : lists)
+			chunkedCommands += list.CommandCount();
+
+		std::printf("%zu draws, %zu chunks, %zu recording threads, %u hardware threads\n",
+			expected.Draws.size(), chunks.size(), recorders.size(), std::thread::hardware_concurrency());
+		std::printf("commands: %u in one list, %u in the chunks (%u restated)\n",
+			serial.CommandCount(), chunkedCommands, chunkedCommands - serial.CommandCount());
+		std::printf("recording: %.0f us per frame in one list, %.0f us in chunks\n",
+			serialUs / (frames - warmupFrames), chunkedUs / (frames - warmupFrames));
+	}
+}
+
+int main()
+{
+	TestSplit();
+	TestLayerRange();
+	TestMerge();
+
+	return CheckResult();
+}
@@ -0,0 +1,358 @@
+// Records the monastery's draws through RecordingCommandList as the app
+// submits them, DrawSubmission::Record on the sorted draw keys, and as
+// they were submitted without redundant state elimination: every draw
+// setting its pipeline state, buffers, topology and constants. Both
+// streams must draw the same things in the same state, the draw is checked
+// call by call after replaying the state changes; the sorted submission
+// must set each pipeline state once, and a mesh's buffers and a material
+// at most once per layer and mesh. Reports the API calls per frame of
+// both, and of Record on the keys in layer order without sorting, from the
+// app's start view, from one far enough out to see every item, and with
+// the copies F5 (GraphicsWindow::ScaleMonastery) adds up to 100,000 draws.
+//
+// Builds with the app's portable sources; DXMATH is a directory with the
+// DirectXMath headers and the sal.h they need elsewhere than on Windows,
+// e.g. vcpkg's installed/x64-linux/include after installing directxmath:
+//   g++ -O2 -std=c++17 -pthread -I$DXMATH -I../include -I../src DrawSubmissionTest.cpp ../src/DrawSubmission.cpp ../src/CommandRecorder.cpp ../src/GeometryGenerator.cpp ../src/MeshPacker.cpp ../src/Church.cpp ../src/Monastery.cpp ../src/Sky.cpp ../src/Fixed.cpp ../src/SceneMaterials.cpp ../src/RenderItemStore.cpp ../src/InstanceGrouping.cpp ../src/DirtyList.cpp ../src/DrawKey.cpp ../src/FrustumCuller.cpp ../src/JobSystem.cpp ../src/Profiler.cpp -o DrawSubmissionTest
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src DrawSubmissionTest.cpp ..\src\DrawSubmission.cpp ..\src\CommandRecorder.cpp ..\src\GeometryGenerator.cpp ..\src\MeshPacker.cpp ..\src\Church.cpp ..\src\Monastery.cpp ..\src\Sky.cpp ..\src\Fixed.cpp ..\src\SceneMaterials.cpp ..\src\RenderItemStore.cpp ..\src\InstanceGrouping.cpp ..\src\DirtyList.cpp ..\src\DrawKey.cpp ..\src\FrustumCuller.cpp ..\src\JobSystem.cpp ..\src\Profiler.cpp
+
+#include "platform.h"
+
+#include <map>
+#include <set>
+#include <tuple>
+
+#include <d3dUtil.h>
+#include <FrameResource.h>
+#include <RenderItemStore.h>
+#include <InstanceGrouping.h>
+#include <JobSystem.h>
+#include <FrustumCuller.h>
+#include <DrawKey.h>
+#include <DrawSubmission.h>
+#include <CommandRecorder.h>
+#include <SceneMaterials.h>
+#include <Sky.h>
+#include <Fixed.h>
+#include <Monastery.h>
+
+#include "Check.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// as in GraphicsWindow
+	const float LodMaxPixelError = 0.5f;
+	const float InstanceClusterSize = 10.0f;
+	const UINT MinInstances = 2;
+	const float FarZ = 1000.0f;
+	const UINT Width = 800;
+	const UINT Height = 600;
+
+	struct Scene
+	{
+		std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> Geometries;
+		std::unordered_map<std::string, std::unique_ptr<Texture>> Textures;
+		std::unordered_map<std::string, std::unique_ptr<Material>> Materials;
+		std::vector<Material*> MaterialTable;
+		RenderItemStore Ritems;
+		FrustumCuller LayerCullers[(int)RenderLayer::Count];
+
+		// made-up buffer addresses of the meshes
+		std::map<const MeshGeometry*, RenderAddress> GeometryAddress;
+	};
+
+	// GraphicsWindow::InitDirect3D without the device and the texture files
+	void BuildScene(Scene& scene, JobSystem& jobs)
+	{
+		for (const SceneMaterials::TextureFile& file : SceneMaterials::TextureFiles(L""))
+		{
+			auto tex = std::make_unique<Texture>();
+			tex->Name = file.Name;
+			scene.Textures[file.Name] = std::move(tex);
+		}
+
+		Monastery monastery;
+		Sky::BuildGeometry(scene.Geometries);
+		Fixed::BuildGeometry(scene.Geometries);
+		monastery.BuildGeometry(scene.Geometries, jobs);
+
+		SceneMaterials::BuildMaterials(scene.Textures, scene.Materials, scene.MaterialTable);
+
+		Sky::BuildRenderItems(scene.Geometries, scene.Materials, scene.Ritems);
+		Fixed::BuildRenderItems(scene.Geometries, scene.Materials, scene.Ritems);
+		monastery.BuildRenderItems(scene.Geometries, scene.Materials, scene.Ritems);
+		InstanceGrouping::Group(scene.Ritems, RenderLayer::Opaque, scene.MaterialTable, InstanceClusterSize, MinInstances);
+
+		RenderAddress address = 0x100000;
+		for (const auto& e : scene.Geometries)
+		{
+			scene.GeometryAddress[e.second.get()] = address;
+			address += 0x100000;
+		}
+	}
+
+	// GraphicsWindow::ScaleMonastery
+	void ScaleMonastery(Scene& scene, UINT drawCount)
+	{
+		std::vector<UINT> opaque = scene.Ritems.Layer(RenderLayer::Opaque);
+		for (UINT n = (UINT)opaque.size(), i = 0; n < drawCount; ++n, i = (i + 1) % opaque.size())
+		{
+			UINT index = opaque[i];
+			const RenderItemDrawArgs& args = scene.Ritems.DrawArgs()[index];
+
+			RenderItem ritem;
+			ritem.World = scene.Ritems.World()[index];
+			ritem.TexTransform = scene.Ritems.TexTransform()[index];
+			ritem.Geo = args.Geo;
+			ritem.Mat = scene.MaterialTable[scene.Ritems.MaterialIds()[index]];
+			ritem.Bounds = scene.Ritems.Bounds()[index];
+			ritem.PrimitiveType = args.PrimitiveType;
+			ritem.IndexCount = args.IndexCount;
+			ritem.StartIndexLocation = args.StartIndexLocation;
+			ritem.BaseVertexLocation = args.BaseVertexLocation;
+
+			scene.Ritems.Add(RenderLayer::Opaque, ritem);
+		}
+	}
+
+	// GraphicsWindow::UpdateCamera, CullRenderItems and BuildDrawKeys; the
+	// keys in layer order and sorted
+	void BuildDrawKeys(Scene& scene, float radius, std::vector<UINT64>& layerOrder, std::vector<UINT64>& sorted)
+	{
+		const float theta = 1.5f * XM_PI;
+		const float phi = XM_PIDIV2 - 0.5f;
+		XMFLOAT3 eyePos(radius * sinf(phi) * cosf(theta), radius * cosf(phi), radius * sinf(phi) * sinf(theta));
+
+		XMMATRIX view = XMMatrixLookAtLH(XMLoadFloat3(&eyePos), XMVectorSet(0.0f, 5.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * XM_PI, (float)Width / Height, 1.0f, FarZ);
+		XMFLOAT4X4 projF, viewProj;
+		XMStoreFloat4x4(&projF, proj);
+		XMStoreFloat4x4(&viewProj, XMMatrixMultiply(view, proj));
+
+		scene.Ritems.SelectLods(eyePos, 0.5f * Height * projF._22, LodMaxPixelError);
+
+		std::vector<UINT> visible[(int)RenderLayer::Count];
+		visible[(int)RenderLayer::Sky] = scene.Ritems.Layer(RenderLayer::Sky);
+		visible[(int)RenderLayer::Fixed] = scene.Ritems.Layer(RenderLayer::Fixed);
+		for (RenderLayer layer : { RenderLayer::Opaque, RenderLayer::Instanced })
+		{
+			scene.LayerCullers[(int)layer].Update(scene.Ritems, layer);
+			scene.LayerCullers[(int)layer].Cull(viewProj, visible[(int)layer]);
+		}
+
+		const auto& worldBounds = scene.Ritems.WorldBounds();
+		const auto& geometryIds = scene.Ritems.GeometryIds();
+		const auto& materialIds = scene.Ritems.MaterialIds();
+
+		layerOrder.clear();
+		for (int layer = 0; layer < (int)RenderLayer::Count; ++layer)
+		{
+			bool depthSorted = layer == (int)RenderLayer::Opaque || layer == (int)RenderLayer::Instanced;
+			for (UINT index : visible[layer])
+			{
+				UINT depthBucket = 0;
+				if (depthSorted)
+				{
+					XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&worldBounds[index].Center), view);
+					depthBucket = DrawKey::DepthBucket(XMVectorGetZ(center), FarZ);
+				}
+				layerOrder.push_back(DrawKey::Make(layer, layer, geometryIds[index], materialIds[index], depthBucket, index));
+			}
+		}
+
+		sorted = layerOrder;
+		std::vector<UINT64> scratch;
+		DrawKey::Sort(sorted, scratch);
+	}
+
+	DrawBindings MakeBindings(const Scene& scene)
+	{
+		DrawBindings bindings;
+		bindings.ObjectCB = 0x10000000;
+		bindings.ObjectCBStride = 256;
+		bindings.MaterialCB = 0x20000000;
+		bindings.MaterialCBStride = 256;
+		bindings.Instances = 0x30000000;
+		bindings.BufferViews = [&scene](const MeshGeometry& geo, RenderVertexBufferView& vbv, RenderIndexBufferView& ibv) {
+			RenderAddress address = scene.GeometryAddress.at(&geo);
+			vbv = { address, geo.VertexBufferByteSize, geo.VertexByteStride };
+			ibv = { address + 0x80000, geo.IndexBufferByteSize,
+				geo.IndexFormat == DXGI_FORMAT_R16_UINT ? RenderIndexFormat::Uint16 : RenderIndexFormat::Uint32 };
+		};
+		return bindings;
+	}
+
+	// The submission without redundant state elimination: every draw sets
+	// everything it depends on.
+	void RecordEveryState(RenderCommandList& cmdList, const RenderItemStore& ritems, const std::vector<UINT64>& keys,
+		const DrawBindings& bindings)
+	{
+		const auto& drawArgs = ritems.DrawArgs();
+		const auto& materialIds = ritems.MaterialIds();
+
+		for (UINT k = 0; k < (UINT)keys.size(); ++k)
+		{
+			UINT index = DrawKey::Index(keys[k]);
+			const RenderItemDrawArgs& args = drawArgs[index];
+
+			RenderVertexBufferView vbv;
+			RenderIndexBufferView ibv;
+			bindings.BufferViews(*args.Geo, vbv, ibv);
+
+			cmdList.SetPipelineState(DrawKey::Pso(keys[k]));
+			cmdList.SetVertexBuffer(vbv);
+			cmdList.SetIndexBuffer(ibv);
+			cmdList.SetPrimitiveTopology(args.PrimitiveType);
+			cmdList.SetGraphicsRootConstantBufferView(DrawSubmission::MaterialCBParameter,
+				bindings.MaterialCB + (UINT64)materialIds[index] * bindings.MaterialCBStride);
+			cmdList.SetGraphicsRootConstantBufferView(DrawSubmission::ObjectCBParameter,
+				bindings.ObjectCB + (UINT64)k * bindings.ObjectCBStride);
+
+			if (args.InstanceCount > 0)
+			{
+				cmdList.SetGraphicsRootShaderResourceView(DrawSubmission::InstancesParameter,
+					bindings.Instances + (UINT64)args.InstanceOffset * sizeof(InstanceData));
+				cmdList.DrawIndexedInstanced(args.IndexCount, args.InstanceCount, args.StartIndexLocation, args.BaseVertexLocation, 0);
+			}
+			else
+			{
+				cmdList.DrawIndexedInstanced(args.IndexCount, 1, args.StartIndexLocation, args.BaseVertexLocation, 0);
+			}
+		}
+	}
+
+	// A draw with the state in effect when it was issued.
+	struct Draw
+	{
+		std::array<UINT64, 12> State = {};
+		std::array<UINT, 5> Args = {};
+
+		bool operator==(const Draw& rhs) const { return State == rhs.State && Args == rhs.Args; }
+	};
+
+	std::vector<Draw> Replay(const RecordingCommandList& cmdList, bool instanced)
+	{
+		std::vector<Draw> draws;
+		Draw current;
+
+		CommandReader reader(cmdList.Stream());
+		RecordedCommand command;
+		while (reader.Next(command))
+		{
+			switch (command.Op)
+			{
+			case RecordedOp::SetPipelineState: current.State[0] = command.Args[0]; break;
+			case RecordedOp::SetPrimitiveTopology: current.State[1] = command.Args[0]; break;
+			case RecordedOp::SetVertexBuffer: current.State[2] = command.Address; current.State[3] = command.Args[1]; break;
+			case RecordedOp::SetIndexBuffer: current.State[4] = command.Address; current.State[5] = command.Args[1]; break;
+			case RecordedOp::SetGraphicsRootConstantBufferView:
+			case RecordedOp::SetGraphicsRootShaderResourceView:
+			case RecordedOp::SetGraphicsRootDescriptorTable:
+				current.State[6 + command.Args[0]] = command.Address;
+				break;
+			case RecordedOp::DrawIndexedInstanced:
+				std::copy(command.Args, command.Args + 5, current.Args.begin());
+				draws.push_back(current);
+
+				// a draw of one instance does not read the instance buffer
+				if (!instanced && current.Args[1] == 1)
+					draws.back().State[6 + DrawSubmission::InstancesParameter] = 0;
+				break;
+			default:
+				break;
+			}
+		}
+		return draws;
+	}
+
+	UINT StateCalls(const RecordingCommandList& cmdList)
+	{
+		return cmdList.CommandCount() - cmdList.CommandCount(RecordedOp::DrawIndexedInstanced);
+	}
+
+	void Report(const char* name, const RecordingCommandList& cmdList)
+	{
+		std::printf("  %-22s %5u calls: %4u PSO, %4u VB, %4u IB, %4u topology, %4u CBV, %4u SRV, %4u draws, %6zu bytes\n",
+			name, cmdList.CommandCount(),
+			cmdList.CommandCount(RecordedOp::SetPipelineState),
+			cmdList.CommandCount(RecordedOp::SetVertexBuffer),
+			cmdList.CommandCount(RecordedOp::SetIndexBuffer),
+			cmdList.CommandCount(RecordedOp::SetPrimitiveTopology),
+			cmdList.CommandCount(RecordedOp::SetGraphicsRootConstantBufferView),
+			cmdList.CommandCount(RecordedOp::SetGraphicsRootShaderResourceView),
+			cmdList.CommandCount(RecordedOp::DrawIndexedInstanced),
+			cmdList.Stream().size());
+	}
+
+	void TestView(Scene& scene, const char* name, float radius)
+	{
+		std::vector<UINT64> layerOrder, sorted;
+		BuildDrawKeys(scene, radius, layerOrder, sorted);
+		CHECK(!sorted.empty());
+
+		const DrawBindings bindings = MakeBindings(scene);
+
+		RecordingCommandList everyState, unsorted, submitted;
+		RecordEveryState(everyState, scene.Ritems, sorted, bindings);
+		DrawSubmission::Record(unsorted, scene.Ritems, layerOrder, 0, (UINT)layerOrder.size(), bindings);
+		DrawSubmission::Record(submitted, scene.Ritems, sorted, 0, (UINT)sorted.size(), bindings);
+
+		// same draws in the same state; a draw of one instance keeps whatever
+		// instance buffer was bound last, which it does not read
+		std::vector<Draw> expected = Replay(everyState, false);
+		CHECK(expected.size() == sorted.size());
+		CHECK(Replay(submitted, false) == expected);
+
+		// one PSO per layer, the buffers bound at most once per mesh and
+		// layer, a material at most once per mesh and layer
+		std::set<UINT> layers;
+		std::set<const MeshGeometry*> meshes;
+		std::set<std::pair<UINT, const MeshGeometry*>> layerMeshes;
+		std::set<std::tuple<UINT, const MeshGeometry*, UINT>> layerMeshMaterials;
+		for (UINT64 key : sorted)
+		{
+			UINT index = DrawKey::Index(key);
+			const MeshGeometry* geo = scene.Ritems.DrawArgs()[index].Geo;
+			layers.insert(DrawKey::Layer(key));
+			meshes.insert(geo);
+			layerMeshes.insert({ DrawKey::Layer(key), geo });
+			layerMeshMaterials.insert(std::make_tuple(DrawKey::Layer(key), geo, scene.Ritems.MaterialIds()[index]));
+		}
+
+		UINT materialCalls = submitted.CommandCount(RecordedOp::SetGraphicsRootConstantBufferView) - (UINT)sorted.size();
+		CHECK(submitted.CommandCount(RecordedOp::DrawIndexedInstanced) == sorted.size());
+		CHECK(submitted.CommandCount(RecordedOp::SetPipelineState) == layers.size());
+		CHECK(submitted.CommandCount(RecordedOp::SetVertexBuffer) >= meshes.size());
+		CHECK(submitted.CommandCount(RecordedOp::SetVertexBuffer) <= layerMeshes.size());
+		CHECK(submitted.CommandCount(RecordedOp::SetIndexBuffer) == submitted.CommandCount(RecordedOp::SetVertexBuffer));
+		CHECK(submitted.CommandCount(RecordedOp::SetPrimitiveTopology) == 1);
+		CHECK(materialCalls <= layerMeshMaterials.size());
+		CHECK(StateCalls(submitted) < StateCalls(everyState));
+		CHECK(submitted.Stream().size() < everyState.Stream().size());
+
+		std::printf("%s, %zu draws:\n", name, sorted.size());
+		Report("every state per draw", everyState);
+		Report("layer order", unsorted);
+		Report("sorted keys", submitted);
+		std::printf("  state calls %u -> %u, %.1f%% fewer\n", StateCalls(everyState), StateCalls(submitted),
+			100.0 * (1.0 - (double)StateCalls(submitted) / StateCalls(everyState)));
+	}
+}
+
+int main()
+{
+	JobSystem jobs;
+
+	Scene scene;
+	BuildScene(scene, jobs);
+
+	TestView(scene, "start view", 30.0f);
+	TestView(scene, "everything in view", 150.0f);
+
+	ScaleMonastery(scene, 100000);
+	TestView(scene, "scaled to 100,000 opaque items", 30.0f);
+
+	return CheckResult();
+}
@@ -0,0 +1,234 @@
+// Tests FrameCapture, the capture FrameReplay reads: uploads and tracked
+// constants of captured frames, a write and read round trip that gives the
+// same frames back, and files that are truncated at any byte or corrupted,
+// which Read() must reject.
+//
+// Builds on its own with the app's portable sources:
+//   g++ -O2 -std=c++17 -I../include -I../src FrameCaptureTest.cpp ../src/FrameCapture.cpp ../src/ConstantAllocator.cpp ../src/UploadRing.cpp ../src/CommandRecorder.cpp -o FrameCaptureTest
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src FrameCaptureTest.cpp ..\src\FrameCapture.cpp ..\src\ConstantAllocator.cpp ..\src\UploadRing.cpp ..\src\CommandRecorder.cpp
+
+#include "platform.h"
+
+#include <cstdio>
+#include <iterator>
+
+#include <FrameCapture.h>
+#include <ConstantAllocator.h>
+#include <CommandRecorder.h>
+
+#include "Check.h"
+
+namespace
+{
+	const char* const CaptureFile = "FrameCaptureTest.pmcap";
+
+	struct Constants
+	{
+		float Values[32];
+	};
+
+	bool SameFrame(const CapturedFrame& a, const CapturedFrame& b)
+	{
+		if (std::memcmp(&a.Camera, &b.Camera, sizeof(a.Camera)) != 0 || a.Uploads.size() != b.Uploads.size())
+			return false;
+
+		for (size_t i = 0; i < a.Uploads.size(); ++i)
+		{
+			if (std::memcmp(&a.Uploads[i], &b.Uploads[i], sizeof(CapturedUpload)) != 0)
+				return false;
+		}
+
+		return a.UploadData == b.UploadData && a.Commands == b.Commands;
+	}
+
+	std::vector<BYTE> ReadFile(const char* filename)
+	{
+		std::ifstream fin(filename, std::ios::binary);
+		return std::vector<BYTE>(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+	}
+
+	void WriteFile(const char* filename, const std::vector<BYTE>& bytes, size_t size)
+	{
+		std::ofstream fout(filename, std::ios::binary | std::ios::trunc);
+		fout.write(reinterpret_cast<const char*>(bytes.data()), size);
+	}
+
+	// Frames as the app captures them: constants from the allocator, which
+	// are filled after allocation, direct uploads, and the recorded draws.
+	FrameCapture CaptureFrames(UINT frameCount, UINT itemCount)
+	{
+		RecordingDevice device;
+		ConstantAllocator constants(device, 64 * 1024);
+		std::unique_ptr<RenderBuffer> instances = device.CreateUploadBuffer(64 * sizeof(Constants));
+
+		FrameCapture capture;
+		constants.SetCapture(&capture);
+
+		for (UINT frame = 1; frame <= frameCount; ++frame)
+		{
+			capture.BeginFrame({ 1.5f + frame * 0.01f, 1.0f, 30.0f - frame * 0.1f });
+			constants.BeginFrame(frame, frame > 3 ? frame - 3 : 0);
+
+			ConstantAllocator::Allocation objects = constants.Allocate((UINT64)itemCount * ConstantAllocator::Stride<Constants>());
+			for (UINT k = 0; k < itemCount; ++k)
+			{
+				Constants c;
+				for (int i = 0; i < 32; ++i)
+					c.Values[i] = (float)(frame * 1000 + k + i);
+				std::memcpy(objects.Data + (UINT64)k * ConstantAllocator::Stride<Constants>(), &c, sizeof(c));
+			}
+
+			for (UINT i = 0; i < 8; ++i)
+			{
+				Constants c = {};
+				c.Values[0] = (float)(frame + i);
+				std::memcpy(instances->Data() + i * sizeof(c), &c, sizeof(c));
+				capture.Upload(instances->GpuAddress() + i * sizeof(c), &c, sizeof(c));
+			}
+
+			RecordingCommandList commands;
+			commands.SetPipelineState(0);
+			commands.SetGraphicsRootShaderResourceView(5, instances->GpuAddress());
+			for (UINT k = 0; k < itemCount; ++k)
+			{
+				commands.SetGraphicsRootConstantBufferView(1, objects.GpuAddress + (UINT64)k * ConstantAllocator::Stride<Constants>());
+				commands.DrawIndexedInstanced(36, 1, 0, 0, 0);
+			}
+			capture.EndFrame(commands.Stream());
+		}
+
+		constants.SetCapture(nullptr);
+		return capture;
+	}
+
+	void TestCapture()
+	{
+		FrameCapture capture;
+		BYTE bytes[64];
+		for (BYTE i = 0; i < 64; ++i)
+			bytes[i] = i;
+
+		// nothing is kept outside a frame
+		capture.Upload(0x1000, bytes, 16);
+		CHECK(capture.Frames().empty());
+
+		capture.BeginFrame({ 1.0f, 2.0f, 3.0f });
+		CHECK(capture.Capturing());
+
+		// consecutive writes become one upload, a gap starts another
+		capture.Upload(0x1000, bytes, 16);
+		capture.Upload(0x1010, bytes + 16, 16);
+		capture.Upload(0x2000, bytes + 32, 8);
+
+		// tracked memory is read at the end of the frame
+		BYTE tracked[4] = { 0, 0, 0, 0 };
+		capture.Track(0x3000, tracked, 4);
+		tracked[3] = 9;
+
+		std::vector<BYTE> commands = { 1, 2, 3 };
+		capture.EndFrame(commands);
+		CHECK(!capture.Capturing());
+
+		capture.Upload(0x4000, bytes, 4);
+
+		CHECK(capture.Frames().size() == 1);
+		const CapturedFrame& frame = capture.Frames()[0];
+		CHECK(frame.Camera.Phi == 2.0f);
+		CHECK(frame.Uploads.size() == 3);
+		CHECK(frame.Uploads[0].Address == 0x1000 && frame.Uploads[0].Offset == 0 && frame.Uploads[0].Size == 32);
+		CHECK(frame.Uploads[1].Address == 0x2000 && frame.Uploads[1].Offset == 32 && frame.Uploads[1].Size == 8);
+		CHECK(frame.Uploads[2].Address == 0x3000 && frame.Uploads[2].Size == 4);
+		CHECK(frame.UploadData.size() == 44);
+		CHECK(std::memcmp(frame.UploadData.data(), bytes, 40) == 0);
+		CHECK(frame.UploadData[43] == 9);
+		CHECK(frame.Commands == commands);
+
+		capture.Clear();
+		CHECK(capture.Frames().empty());
+	}
+
+	void TestRoundTrip()
+	{
+		FrameCapture capture = CaptureFrames(60, 500);
+		CHECK(capture.Frames().size() == 60);
+		CHECK(capture.Write(CaptureFile));
+
+		FrameCapture loaded;
+		CHECK(loaded.Read(CaptureFile));
+		CHECK(loaded.Frames().size() == capture.Frames().size());
+
+		UINT different = 0;
+		for (size_t f = 0; f < min(loaded.Frames().size(), capture.Frames().size()); ++f)
+			different += !SameFrame(loaded.Frames()[f], capture.Frames()[f]);
+		CHECK(different == 0);
+
+		// the constants were captured as filled, after allocation
+		const CapturedFrame& last = loaded.Frames().back();
+		CHECK(last.Uploads.size() == 2);
+		float first = 0.0f;
+		if (last.UploadData.size() >= 8 * sizeof(Constants) + sizeof(float))
+			std::memcpy(&first, last.UploadData.data() + 8 * sizeof(Constants), sizeof(float));
+		CHECK(first == 60000.0f);
+
+		// and the recorded draws read back
+		UINT draws = 0;
+		CommandReader reader(last.Commands);
+		RecordedCommand c;
+		while (reader.Next(c))
+			draws += c.Op == RecordedOp::DrawIndexedInstanced;
+		CHECK(draws == 500);
+	}
+
+	void TestRejection()
+	{
+		FrameCapture capture = CaptureFrames(3, 20);
+		CHECK(capture.Write(CaptureFile));
+		std::vector<BYTE> file = ReadFile(CaptureFile);
+		CHECK(!file.empty());
+
+		// cut at every byte: the header, a count, a camera, an upload or a payload
+		FrameCapture loaded;
+		UINT accepted = 0;
+		for (size_t size = 0; size < file.size(); ++size)
+		{
+			WriteFile(CaptureFile, file, size);
+			accepted += loaded.Read(CaptureFile);
+		}
+		CHECK(accepted == 0);
+
+		WriteFile(CaptureFile, file, file.size());
+		CHECK(loaded.Read(CaptureFile));
+
+		// another file's magic, a later version
+		for (size_t at : { (size_t)0, (size_t)4 })
+		{
+			std::vector<BYTE> corrupt = file;
+			corrupt[at] ^= 0xff;
+			WriteFile(CaptureFile, corrupt, corrupt.size());
+			CHECK(!loaded.Read(CaptureFile));
+		}
+
+		// an upload range past its frame's payload; the first upload's
+		// offset follows the header (12 bytes), the camera and the count
+		const size_t firstUpload = 12 + sizeof(CapturedCamera) + sizeof(UINT);
+		std::vector<BYTE> corrupt = file;
+		UINT64 offset = 1ull << 40;
+		std::memcpy(corrupt.data() + firstUpload + offsetof(CapturedUpload, Offset), &offset, sizeof(offset));
+		WriteFile(CaptureFile, corrupt, corrupt.size());
+		CHECK(!loaded.Read(CaptureFile));
+
+		// a file that does not exist
+		std::remove(CaptureFile);
+		CHECK(!loaded.Read(CaptureFile));
+	}
+}
+
+int main()
+{
+	TestCapture();
+	TestRoundTrip();
+	TestRejection();
+
+	std::remove(CaptureFile);
+	return CheckResult();
+}
@@ -0,0 +1,167 @@
+// Tests FramePacer at 60, 144 and 240 Hz with a random amount of frame work
+// up to 60% of the frame time. Only what holds on any machine is checked:
+// every Wait() moves the deadline forward and returns no earlier than it,
+// the spin margin stays between zero and half a period, and no frame is
+// shorter than the period less the 50 us a late frame may slip. The frame
+// time jitter (its standard deviation) and mean are printed next to those
+// of a loop that only spins to the same deadlines, the best any pacer can
+// do on the machine; they depend on its load and are not checked.
+// FrameTimeStats is checked first.
+//
+//   FramePacerTest [frames]
+//
+// Builds on its own with the app's portable sources:
+//   g++ -O2 -std=c++17 -I../include -I../src FramePacerTest.cpp ../src/FramePacer.cpp -o FramePacerTest
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src FramePacerTest.cpp ..\src\FramePacer.cpp
+
+#include "platform.h"
+
+#include <cstdlib>
+#include <random>
+
+#include <FramePacer.h>
+
+#include "Check.h"
+
+namespace
+{
+	void TestStats()
+	{
+		FrameTimeStats empty;
+		CHECK(empty.Count() == 0 && empty.Mean() == 0.0 && empty.Jitter() == 0.0 && empty.Percentile(0.5) == 0.0);
+
+		// the window keeps the last 1024 of 2000
+		FrameTimeStats stats;
+		for (int i = 1; i <= 2000; ++i)
+			stats.Add(i * 1e-5);
+
+		CHECK(stats.Count() == FrameTimeStats::Window);
+		CHECK(std::fabs(stats.Min() - 977e-5) < 1e-12);
+		CHECK(std::fabs(stats.Max() - 2000e-5) < 1e-12);
+		CHECK(std::fabs(stats.Mean() - (977 + 2000) / 2.0 * 1e-5) < 1e-9);
+
+		// uniform over 1024 values 10 us apart
+		double expectedJitter = 1e-5 * std::sqrt((1024.0 * 1024.0 - 1.0) / 12.0);
+		CHECK(std::fabs(stats.Jitter() - expectedJitter) < 1e-7);
+
+		// a percentile is the upper edge of its bucket
+		double p50 = stats.Percentile(0.5);
+		CHECK(p50 >= 1488e-5 && p50 <= 1488e-5 + FrameTimeStats::BucketSize);
+		CHECK(stats.Percentile(1.0) == stats.Max());
+
+		// longer than the histogram reaches: the last bucket, reported as the max
+		FrameTimeStats longFrame;
+		longFrame.Add(1.0);
+		CHECK(longFrame.Percentile(0.99) == 1.0);
+
+		stats.Reset();
+		CHECK(stats.Count() == 0);
+	}
+
+	void SpinFor(double seconds)
+	{
+		INT64 end = GameTimer::Ticks() + (INT64)(seconds * GameTimer::TicksPerSecond());
+		while (GameTimer::Ticks() < end)
+		{
+		}
+	}
+
+	// FramePacer with the deadline and spin margin of each Wait() checked
+	class CheckedPacer : public FramePacer
+	{
+	public:
+		void CheckedWait()
+		{
+			INT64 previous = _Deadline;
+			Wait();
+			INT64 now = GameTimer::Ticks();
+
+			Waits++;
+			BackwardDeadlines += _Deadline <= previous;
+			EarlyReturns += now < _Deadline;
+			BadSpinTimes += _SpinTicks < 0 || _SpinTicks > max(_TicksPerSecond / 500, _Period / 2) || _Oversleep < 0;
+		}
+
+		// the first Wait() after a new rate starts the schedule, the frame it ends is not paced
+		void StartSchedule()
+		{
+			CheckedWait();
+			_Stats.Reset();
+		}
+
+		UINT Waits = 0;
+		UINT BackwardDeadlines = 0;
+		UINT EarlyReturns = 0;
+		UINT BadSpinTimes = 0;
+	};
+
+	void TestPacing(double framesPerSecond, int frames)
+	{
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<double> work(0.0, 0.6 / framesPerSecond);
+
+		CheckedPacer pacer;
+		pacer.SetTargetFrameRate(framesPerSecond);
+
+		// the first frames measure the timer before the stats count
+		for (int frame = 0; frame < 30; ++frame)
+		{
+			SpinFor(work(rng));
+			pacer.CheckedWait();
+		}
+		pacer.SetTargetFrameRate(framesPerSecond);
+		pacer.StartSchedule();
+
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			SpinFor(work(rng));
+			pacer.CheckedWait();
+		}
+
+		// the same deadlines, spinning all the way
+		FrameTimeStats reference;
+		INT64 period = (INT64)(GameTimer::TicksPerSecond() / framesPerSecond);
+		INT64 deadline = GameTimer::Ticks();
+		INT64 last = 0;
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			SpinFor(work(rng));
+			deadline += period;
+
+			INT64 now;
+			while ((now = GameTimer::Ticks()) < deadline)
+			{
+			}
+
+			if (last != 0)
+				reference.Add((double)(now - last) / GameTimer::TicksPerSecond());
+			last = now;
+		}
+
+		const FrameTimeStats& stats = pacer.Stats();
+		double target = 1.0 / framesPerSecond;
+
+		CHECK(pacer.Waits == (UINT)frames + 31);
+		CHECK(pacer.BackwardDeadlines == 0);
+		CHECK(pacer.EarlyReturns == 0);
+		CHECK(pacer.BadSpinTimes == 0);
+		CHECK(stats.Count() == min((UINT)frames, FrameTimeStats::Window));
+		CHECK(stats.Min() >= target - 60e-6);
+
+		std::printf("%3.0f Hz: mean %.3f ms, p99 %.3f ms, max %.3f ms, jitter %.3f ms (spin-only %.3f ms), spin margin %.3f ms\n",
+			framesPerSecond, stats.Mean() * 1e3, stats.Percentile(0.99) * 1e3, stats.Max() * 1e3,
+			stats.Jitter() * 1e3, reference.Jitter() * 1e3, pacer.SpinTime() * 1e3);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int frames = argc > 1 ? max(10, atoi(argv[1])) : 600;
+
+	TestStats();
+
+	for (double framesPerSecond : { 60.0, 144.0, 240.0 })
+		TestPacing(framesPerSecond, frames);
+
+	return CheckResult();
+}
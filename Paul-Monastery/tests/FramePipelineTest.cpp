@@ -0,0 +1,300 @@
+// Tests FramePipeline and the TripleBuffer under it without a window or a
+// device:
+//   - 2,000,000 values through a TripleBuffer from a producer that never
+//     waits for the consumer, never torn and never out of order
+//   - every frame rendered once and in order, across switches between the
+//     render thread and the serial loop
+//   - what rendering throws is rethrown by the next BeginFrame()
+//   - the simulation moving render items as GraphicsWindow does: the moves
+//     travel in FrameSnapshot::Transforms and the render side applies them
+//     to a RenderItemStore and culls it with FrustumCuller::Update(); every
+//     frame must see the simulation's positions of that frame, and at the
+//     end the store must hold the simulation's transforms
+// and prints the cost of handing a frame over, serial and threaded.
+//
+// Builds with the app's portable sources; DXMATH is a directory with the
+// DirectXMath headers and the sal.h they need elsewhere than on Windows,
+// e.g. vcpkg's installed/x64-linux/include after installing directxmath:
+//   g++ -O2 -std=c++17 -pthread -I$DXMATH -I../include -I../src FramePipelineTest.cpp ../src/FrustumCuller.cpp ../src/RenderItemStore.cpp ../src/DirtyList.cpp ../src/JobSystem.cpp ../src/Profiler.cpp -o FramePipelineTest
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src FramePipelineTest.cpp ..\src\FrustumCuller.cpp ..\src\RenderItemStore.cpp ..\src\DirtyList.cpp ..\src\JobSystem.cpp ..\src\Profiler.cpp
+
+#include "platform.h"
+
+#include <chrono>
+#include <stdexcept>
+
+#include <d3dUtil.h>
+#include <FrameResource.h>
+#include <RenderItemStore.h>
+#include <JobSystem.h>
+#include <FrustumCuller.h>
+#include <FrameSnapshot.h>
+#include <FramePipeline.h>
+
+#include "Check.h"
+
+using namespace DirectX;
+
+namespace
+{
+	void TestTripleBuffer()
+	{
+		const UINT64 count = 2000000;
+
+		TripleBuffer<std::vector<UINT64>> buffer;
+		std::thread producer([&]() {
+			for (UINT64 value = 1; value <= count; ++value)
+			{
+				buffer.Back().assign(16, value);
+				buffer.Publish();
+
+				// lets the consumer in on a single core
+				if (value % 64 == 0)
+					std::this_thread::yield();
+			}
+		});
+
+		UINT64 last = 0, seen = 0, torn = 0, reordered = 0;
+		while (last < count)
+		{
+			if (!buffer.Acquire())
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			const std::vector<UINT64>& front = buffer.Front();
+			for (UINT64 value : front)
+				torn += value != front[0];
+			reordered += front[0] <= last;
+
+			last = front[0];
+			seen++;
+		}
+		producer.join();
+
+		CHECK(torn == 0);
+		CHECK(reordered == 0);
+		CHECK(!buffer.Acquire());
+		std::printf("triple buffer: %llu of %llu values seen\n", (unsigned long long)seen, (unsigned long long)count);
+	}
+
+	struct Frame
+	{
+		UINT64 Index = 0;
+	};
+
+	void TestOrder()
+	{
+		UINT64 expected = 1, wrong = 0;
+		FramePipeline<Frame> pipeline([&](const Frame& frame) {
+			wrong += frame.Index != expected++;
+		});
+
+		for (UINT64 index = 1; index <= 3000; ++index)
+		{
+			if (index % 500 == 0)
+				pipeline.SetThreaded(!pipeline.Threaded());
+
+			pipeline.BeginFrame().Index = index;
+			pipeline.EndFrame();
+		}
+		pipeline.Flush();
+
+		CHECK(wrong == 0);
+		CHECK(expected == 3001);
+	}
+
+	void TestException()
+	{
+		for (bool threaded : { true, false })
+		{
+			FramePipeline<Frame> pipeline([](const Frame& frame) {
+				if (frame.Index == 3)
+					throw std::runtime_error("device removed");
+			}, threaded);
+
+			bool caught = false;
+			try
+			{
+				for (UINT64 index = 1; index < 10; ++index)
+				{
+					pipeline.BeginFrame().Index = index;
+					pipeline.EndFrame();
+				}
+				pipeline.Flush();
+				pipeline.BeginFrame();
+			}
+			catch (const std::runtime_error&)
+			{
+				caught = true;
+			}
+			CHECK(caught);
+		}
+	}
+
+	// Simulation and render state of the moving items test.
+	struct MovingScene
+	{
+		static const UINT ItemCount = 2000;
+		static const UINT MovesPerFrame = 300;
+
+		Material Mat;
+		MeshGeometry Geo;
+
+		// render thread
+		RenderItemStore Ritems;
+		FrustumCuller Culler;
+		std::vector<UINT> Visible;
+		XMFLOAT4X4 ViewProj;
+		UINT64 ExpectedFrame = 1;
+		UINT64 WrongFrames = 0;
+		UINT64 WrongVisible = 0;
+		UINT64 VisibleTotal = 0;
+
+		// simulation thread
+		std::vector<RenderItemHandle> Handles;
+		std::vector<XMFLOAT4X4> SimWorld;
+	};
+
+	struct MovingFrame
+	{
+		UINT64 Index = 0;
+		std::vector<SnapshotTransform> Transforms;
+	};
+
+	// along z through the frustum, half of the positions behind the camera
+	XMFLOAT4X4 ItemWorld(UINT item, UINT64 frame)
+	{
+		float z = (float)((item * 37 + frame * 11) % 200) - 100.0f;
+		XMFLOAT4X4 world;
+		XMStoreFloat4x4(&world, XMMatrixTranslation((float)(item % 7) - 3.0f, 0.0f, z));
+		return world;
+	}
+
+	void Render(MovingScene& scene, const MovingFrame& frame)
+	{
+		scene.WrongFrames += frame.Index != scene.ExpectedFrame++;
+
+		for (const SnapshotTransform& moved : frame.Transforms)
+		{
+			if (scene.Ritems.IsValid(moved.Item))
+				scene.Ritems.SetWorld(moved.Item, moved.World);
+		}
+
+		scene.Culler.Update(scene.Ritems, RenderLayer::Opaque);
+		scene.Culler.Cull(scene.ViewProj, scene.Visible);
+		scene.VisibleTotal += scene.Visible.size();
+
+		// the culled boxes are where this frame put them
+		std::vector<bool> isVisible(scene.Ritems.Size(), false);
+		for (UINT index : scene.Visible)
+			isVisible[index] = true;
+
+		for (UINT index = 0; index < scene.Ritems.Size(); ++index)
+		{
+			// unit boxes at x in [-3, 3] are inside exactly when in front of the near plane
+			float z = scene.Ritems.World()[index]._43;
+			bool inside = z >= 1.5f && z <= 98.5f;
+			bool outside = z <= 0.0f || z >= 101.5f;
+			if (inside || outside)
+				scene.WrongVisible += isVisible[index] != inside;
+		}
+	}
+
+	void TestMovingItems(bool threaded)
+	{
+		MovingScene scene;
+
+		XMMATRIX view = XMMatrixLookAtLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, 1.0f, 100.0f);
+		XMStoreFloat4x4(&scene.ViewProj, XMMatrixMultiply(view, proj));
+
+		for (UINT item = 0; item < MovingScene::ItemCount; ++item)
+		{
+			RenderItem ritem;
+			ritem.World = ItemWorld(item, 0);
+			ritem.Geo = &scene.Geo;
+			ritem.Mat = &scene.Mat;
+			ritem.Bounds = BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f));
+			scene.Handles.push_back(scene.Ritems.Add(RenderLayer::Opaque, ritem));
+			scene.SimWorld.push_back(ritem.World);
+		}
+		scene.Culler.Build(scene.Ritems, RenderLayer::Opaque);
+
+		const UINT64 frameCount = 400;
+		std::vector<SnapshotTransform> moved;
+		{
+			FramePipeline<MovingFrame> pipeline([&](const MovingFrame& frame) {
+				Render(scene, frame);
+			}, threaded);
+
+			for (UINT64 index = 1; index <= frameCount; ++index)
+			{
+				for (UINT k = 0; k < MovingScene::MovesPerFrame; ++k)
+				{
+					UINT item = (UINT)((index * 7919 + k * 104729) % MovingScene::ItemCount);
+					scene.SimWorld[item] = ItemWorld(item, index);
+					moved.push_back({ scene.Handles[item], scene.SimWorld[item] });
+				}
+
+				// as GraphicsWindow::Update, the slot still holds the moves of an older frame
+				MovingFrame& frame = pipeline.BeginFrame();
+				frame.Index = index;
+				frame.Transforms.swap(moved);
+				moved.clear();
+				pipeline.EndFrame();
+			}
+			pipeline.Flush();
+		}
+
+		CHECK(scene.ExpectedFrame == frameCount + 1);
+		CHECK(scene.WrongFrames == 0);
+		CHECK(scene.WrongVisible == 0);
+		CHECK(scene.VisibleTotal > 0);
+
+		UINT differing = 0;
+		for (UINT item = 0; item < MovingScene::ItemCount; ++item)
+		{
+			const XMFLOAT4X4& world = scene.Ritems.World()[scene.Ritems.IndexOf(scene.Handles[item])];
+			differing += std::memcmp(&world, &scene.SimWorld[item], sizeof(XMFLOAT4X4)) != 0;
+		}
+		CHECK(differing == 0);
+
+		std::printf("%s: %llu frames moving %u of %u items, %.0f visible per frame\n",
+			threaded ? "render thread" : "serial", (unsigned long long)frameCount,
+			MovingScene::MovesPerFrame, MovingScene::ItemCount, (double)scene.VisibleTotal / frameCount);
+	}
+
+	void ReportHandOff()
+	{
+		for (bool threaded : { false, true })
+		{
+			const UINT64 frameCount = 200000;
+			FramePipeline<Frame> pipeline([](const Frame&) {}, threaded);
+
+			auto start = std::chrono::steady_clock::now();
+			for (UINT64 index = 1; index <= frameCount; ++index)
+			{
+				pipeline.BeginFrame().Index = index;
+				pipeline.EndFrame();
+			}
+			pipeline.Flush();
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::printf("%s hand-off: %.2f us per frame\n", threaded ? "threaded" : "serial", seconds * 1e6 / frameCount);
+		}
+	}
+}
+
+int main()
+{
+	TestTripleBuffer();
+	TestOrder();
+	TestException();
+	TestMovingItems(false);
+	TestMovingItems(true);
+	ReportHandOff();
+
+	return CheckResult();
+}
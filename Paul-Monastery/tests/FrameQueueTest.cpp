@@ -0,0 +1,277 @@
+// Tests FrameQueue against a simulated GPU on a virtual clock: a slot is
+// never handed out again before the fence of the frame that last used it
+// has completed, at any depth and across depth changes; a GPU-bound frame
+// loop settles at depth 2, as fast as the fixed depths and with less
+// latency than three frames in flight; and the adaptive queue keeps up
+// with the best fixed depth in CPU-bound and balanced loops.
+//
+// Builds on its own with the app's portable sources:
+//   g++ -O2 -std=c++17 -I../include -I../src FrameQueueTest.cpp ../src/FrameQueue.cpp ../src/CommandRecorder.cpp -o FrameQueueTest
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src FrameQueueTest.cpp ..\src\FrameQueue.cpp ..\src\CommandRecorder.cpp
+
+#include "platform.h"
+
+#include <random>
+
+#include <FrameQueue.h>
+#include <CommandRecorder.h>
+
+#include "Check.h"
+
+namespace
+{
+	// virtual nanoseconds
+	const INT64 TicksPerSecond = 1000000000;
+	INT64 g_Now = 0;
+
+	INT64 Now()
+	{
+		return g_Now;
+	}
+
+	INT64 Ms(double ms)
+	{
+		return (INT64)(ms * 1e6);
+	}
+
+	// Runs submitted frames one after another; a frame completes when the
+	// virtual clock passes its end, and a wait moves the clock there.
+	class SimulatedGpu : public SimulatedFence
+	{
+	public:
+		UINT64 Submit(INT64 cost)
+		{
+			INT64 start = max(g_Now, _Done.back());
+			_Done.push_back(start + cost);
+
+			UINT64 fence = _Done.size() - 1;
+			Signal(fence);
+			return fence;
+		}
+
+		void Advance(INT64 ticks)
+		{
+			g_Now += ticks;
+			Update();
+		}
+
+		void Wait(UINT64 value) override
+		{
+			if (value < _Done.size())
+				g_Now = max(g_Now, _Done[value]);
+			Update();
+			SimulatedFence::Wait(value);
+		}
+
+	protected:
+		void Update()
+		{
+			UINT64 completed = CompletedValue();
+			while (completed + 1 < _Done.size() && _Done[completed + 1] <= g_Now)
+				completed++;
+			Complete(completed);
+		}
+
+		// end time of each fence value
+		std::vector<INT64> _Done = { 0 };
+	};
+
+	struct Frames
+	{
+		double CpuMs;
+		double GpuMs;
+
+		// each frame's costs vary by up to this fraction either way
+		double Variation;
+	};
+
+	struct Result
+	{
+		double FramesPerSecond = 0.0;
+		double Latency = 0.0;
+		double CpuWait = 0.0;
+
+		// frames of the second half at each depth
+		UINT DepthFrames[4] = {};
+		UINT Reused = 0;
+	};
+
+	// The second half is measured, once the adaptive queue had time to settle.
+	Result Run(const Frames& frames, UINT fixedDepth, UINT frameCount)
+	{
+		g_Now = 0;
+		SimulatedGpu gpu;
+		std::mt19937 rng(7);
+		std::uniform_real_distribution<double> variation(-frames.Variation, frames.Variation);
+
+		FrameQueue::Config config;
+		config.SlotCount = 3;
+		FrameQueue queue(gpu, config, Now, TicksPerSecond);
+		if (fixedDepth != 0)
+			queue.SetDepth(fixedDepth, false);
+
+		std::vector<UINT64> slotFences(queue.SlotCount(), 0);
+
+		Result result;
+		INT64 start = 0;
+		UINT windows = 0;
+		for (UINT frame = 0; frame < frameCount; ++frame)
+		{
+			bool measured = frame >= frameCount / 2;
+			if (frame == frameCount / 2)
+				start = g_Now;
+
+			UINT slot = queue.BeginFrame();
+			result.Reused += gpu.CompletedValue() < slotFences[slot];
+
+			gpu.Advance(Ms(frames.CpuMs * (1.0 + variation(rng))));
+			slotFences[slot] = gpu.Submit(Ms(frames.GpuMs * (1.0 + variation(rng))));
+			queue.EndFrame(slotFences[slot]);
+
+			if (measured)
+			{
+				result.DepthFrames[queue.Depth()]++;
+
+				// a window just ended
+				if ((frame + 1) % config.Window == 0)
+				{
+					result.Latency += queue.WindowStats().Latency;
+					result.CpuWait += queue.WindowStats().CpuWait;
+					windows++;
+				}
+			}
+		}
+
+		result.FramesPerSecond = (frameCount - frameCount / 2) * (double)TicksPerSecond / (g_Now - start);
+		result.Latency /= max(1u, windows);
+		result.CpuWait /= max(1u, windows);
+		return result;
+	}
+
+	void Print(const char* name, const Result& r)
+	{
+		std::printf("  %-10s %6.1f fps, latency %6.2f ms, CPU wait %5.2f ms, depth 1/2/3 for %u/%u/%u frames\n",
+			name, r.FramesPerSecond, r.Latency * 1e3, r.CpuWait * 1e3,
+			r.DepthFrames[1], r.DepthFrames[2], r.DepthFrames[3]);
+	}
+
+	// Random frame costs, depths changed on the way: the CPU must never
+	// get a slot whose previous frame the GPU may still read.
+	void TestSlotReuse()
+	{
+		g_Now = 0;
+		SimulatedGpu gpu;
+		std::mt19937 rng(5);
+		std::uniform_real_distribution<double> cpu(0.1, 12.0);
+		std::uniform_real_distribution<double> gpuCost(0.1, 20.0);
+
+		FrameQueue::Config config;
+		config.SlotCount = 3;
+		config.Window = 20;
+		FrameQueue queue(gpu, config, Now, TicksPerSecond);
+
+		std::vector<UINT64> slotFences(queue.SlotCount(), 0);
+		UINT reused = 0;
+		UINT overDepth = 0;
+		for (UINT frame = 0; frame < 20000; ++frame)
+		{
+			if (frame % 1000 == 0)
+				queue.SetDepth(1 + rng() % 3, rng() % 2 == 0);
+
+			UINT slot = queue.BeginFrame();
+			CHECK(slot == frame % queue.SlotCount());
+			reused += gpu.CompletedValue() < slotFences[slot];
+
+			// fewer frames in flight than the depth while this one is recorded
+			UINT64 submitted = frame;
+			overDepth += submitted - gpu.CompletedValue() >= queue.Depth();
+
+			gpu.Advance(Ms(cpu(rng)));
+			slotFences[slot] = gpu.Submit(Ms(gpuCost(rng)));
+			queue.EndFrame(slotFences[slot]);
+		}
+
+		CHECK(reused == 0);
+		CHECK(overDepth == 0);
+		CHECK(gpu.WaitCount() == 20000);
+	}
+
+	// CPU 5 ms, GPU 10 ms: one frame in flight leaves the GPU idle while the
+	// CPU records, two keep it busy, three only add a frame of latency.
+	void TestGpuBound()
+	{
+		const Frames frames = { 5.0, 10.0, 0.1 };
+		const UINT frameCount = 6000;
+
+		std::printf("GPU-bound, CPU 5 ms, GPU 10 ms\n");
+		Result fixed[4];
+		for (UINT depth = 1; depth <= 3; ++depth)
+		{
+			fixed[depth] = Run(frames, depth, frameCount);
+			CHECK(fixed[depth].Reused == 0);
+
+			char name[16];
+			std::snprintf(name, sizeof(name), "depth %u", depth);
+			Print(name, fixed[depth]);
+		}
+
+		Result adaptive = Run(frames, 0, frameCount);
+		Print("adaptive", adaptive);
+
+		// the GPU's pace, a frame of latency less than three in flight
+		CHECK(fixed[1].FramesPerSecond < 0.8 * fixed[2].FramesPerSecond);
+		CHECK(adaptive.FramesPerSecond >= 0.97 * fixed[2].FramesPerSecond);
+		CHECK(adaptive.Latency < fixed[3].Latency - 0.008);
+
+		// at depth 2 apart from the odd probe of depth 1, never back to 3
+		UINT measured = frameCount - frameCount / 2;
+		CHECK(adaptive.DepthFrames[2] >= 0.9 * measured);
+		CHECK(adaptive.DepthFrames[3] == 0);
+		CHECK(adaptive.Reused == 0);
+	}
+
+	// the adaptive queue against the best fixed depth
+	void TestAdaptive()
+	{
+		struct Scenario
+		{
+			const char* Name;
+			Frames Costs;
+		};
+		const Scenario scenarios[] =
+		{
+			{ "CPU-bound, CPU 10 ms, GPU 5 ms", { 10.0, 5.0, 0.1 } },
+			{ "balanced, CPU and GPU 8 ms +-50%", { 8.0, 8.0, 0.5 } },
+		};
+
+		for (const Scenario& scenario : scenarios)
+		{
+			std::printf("%s\n", scenario.Name);
+
+			double best = 0.0;
+			double latency3 = 0.0;
+			for (UINT depth = 1; depth <= 3; ++depth)
+			{
+				Result fixed = Run(scenario.Costs, depth, 6000);
+				best = max(best, fixed.FramesPerSecond);
+				latency3 = fixed.Latency;
+			}
+
+			Result adaptive = Run(scenario.Costs, 0, 6000);
+			Print("adaptive", adaptive);
+
+			CHECK(adaptive.FramesPerSecond >= 0.95 * best);
+			CHECK(adaptive.Latency <= 1.02 * latency3);
+			CHECK(adaptive.Reused == 0);
+		}
+	}
+}
+
+int main()
+{
+	TestSlotReuse();
+	TestGpuBound();
+	TestAdaptive();
+
+	return CheckResult();
+}
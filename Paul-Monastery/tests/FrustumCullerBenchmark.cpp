@@ -0,0 +1,155 @@
+// Times FrustumCuller against the per-item plane test it replaced, for 1k,
+// 10k, 100k and 1M boxes scattered around the app's start camera:
+//   build     copying the layer's bounds into the culler's arrays
+//   scalar    one box at a time against the six planes, over WorldBounds
+//   SIMD      Cull on the calling thread, four boxes per plane test
+//   jobs      Cull with a JobSystem, one chunk of boxes per job
+// All three must find the same boxes. The jobs only help with more than one
+// hardware thread; on a single core they show the cost of the chunking.
+//
+//   FrustumCullerBenchmark [frames]
+//
+// Builds with the app's portable sources; DXMATH is a directory with the
+// DirectXMath headers and the sal.h they need elsewhere than on Windows,
+// e.g. vcpkg's installed/x64-linux/include after installing directxmath:
+//   g++ -O2 -std=c++17 -pthread -I$DXMATH -I../include -I../src FrustumCullerBenchmark.cpp ../src/FrustumCuller.cpp ../src/RenderItemStore.cpp ../src/DirtyList.cpp ../src/JobSystem.cpp ../src/Profiler.cpp -o FrustumCullerBenchmark
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src FrustumCullerBenchmark.cpp ..\src\FrustumCuller.cpp ..\src\RenderItemStore.cpp ..\src\DirtyList.cpp ..\src\JobSystem.cpp ..\src\Profiler.cpp
+
+#include "platform.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+#include <d3dUtil.h>
+#include <FrameResource.h>
+#include <RenderItemStore.h>
+#include <JobSystem.h>
+#include <FrustumCuller.h>
+
+#include "Check.h"
+
+using namespace DirectX;
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double Seconds(Clock::time_point start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	// the app's start camera
+	XMFLOAT4X4 ViewProj()
+	{
+		XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 30.0f, -200.0f, 1.0f), XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * XM_PI, 4.0f / 3.0f, 1.0f, 1000.0f);
+		XMFLOAT4X4 viewProj;
+		XMStoreFloat4x4(&viewProj, XMMatrixMultiply(view, proj));
+		return viewProj;
+	}
+
+	// the test the culler replaced, planes pointing inwards
+	void CullScalar(const XMFLOAT4X4& m, const RenderItemStore& ritems, std::vector<UINT>& visible)
+	{
+		XMFLOAT4 planes[6];
+		XMVECTOR c0 = XMVectorSet(m._11, m._21, m._31, m._41);
+		XMVECTOR c1 = XMVectorSet(m._12, m._22, m._32, m._42);
+		XMVECTOR c2 = XMVectorSet(m._13, m._23, m._33, m._43);
+		XMVECTOR c3 = XMVectorSet(m._14, m._24, m._34, m._44);
+		XMVECTOR vectors[6] = { c3 + c0, c3 - c0, c3 + c1, c3 - c1, c2, c3 - c2 };
+		for (int p = 0; p < 6; ++p)
+			XMStoreFloat4(&planes[p], vectors[p]);
+
+		visible.clear();
+		const auto& bounds = ritems.WorldBounds();
+		for (UINT i : ritems.Layer(RenderLayer::Opaque))
+		{
+			const BoundingBox& b = bounds[i];
+			bool inside = true;
+			for (const XMFLOAT4& p : planes)
+			{
+				float distance = p.x * b.Center.x + p.y * b.Center.y + p.z * b.Center.z + p.w;
+				float radius = fabsf(p.x) * b.Extents.x + fabsf(p.y) * b.Extents.y + fabsf(p.z) * b.Extents.z;
+				if (distance + radius < 0.0f)
+				{
+					inside = false;
+					break;
+				}
+			}
+			if (inside)
+				visible.push_back(i);
+		}
+	}
+
+	struct Times
+	{
+		double Build = 1e30;
+		double Scalar = 1e30;
+		double Simd = 1e30;
+		double Jobs = 1e30;
+	};
+}
+
+int main(int argc, char** argv)
+{
+	const int frames = argc > 1 ? max(1, atoi(argv[1])) : 20;
+	const XMFLOAT4X4 viewProj = ViewProj();
+
+	JobSystem jobs;
+	std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+
+	for (UINT itemCount : { 1000u, 10000u, 100000u, 1000000u })
+	{
+		Material mat;
+		MeshGeometry geo;
+		RenderItemStore ritems;
+
+		std::mt19937 rng(itemCount);
+		std::uniform_real_distribution<float> position(-400.0f, 400.0f);
+		for (UINT i = 0; i < itemCount; ++i)
+		{
+			RenderItem ritem;
+			XMStoreFloat4x4(&ritem.World, XMMatrixTranslation(position(rng), position(rng) * 0.1f, position(rng)));
+			ritem.Geo = &geo;
+			ritem.Mat = &mat;
+			ritem.Bounds = BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 2.0f, 1.0f));
+			ritems.Add(RenderLayer::Opaque, ritem);
+		}
+
+		FrustumCuller culler;
+		std::vector<UINT> scalar, simd, parallel;
+		Times times;
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			auto start = Clock::now();
+			culler.Build(ritems, RenderLayer::Opaque);
+			times.Build = min(times.Build, Seconds(start));
+
+			start = Clock::now();
+			CullScalar(viewProj, ritems, scalar);
+			times.Scalar = min(times.Scalar, Seconds(start));
+
+			start = Clock::now();
+			culler.Cull(viewProj, simd);
+			times.Simd = min(times.Simd, Seconds(start));
+
+			start = Clock::now();
+			culler.Cull(viewProj, parallel, &jobs);
+			times.Jobs = min(times.Jobs, Seconds(start));
+		}
+
+		CHECK(simd == scalar);
+		CHECK(parallel == scalar);
+
+		std::printf("%7u items, %.1f%% visible, best of %d frames, ns per item:\n", itemCount,
+			100.0 * simd.size() / itemCount, frames);
+		std::printf("  build %6.2f  scalar %6.2f  SIMD %6.2f  jobs %6.2f  SIMD speedup %.2fx\n",
+			times.Build * 1e9 / itemCount, times.Scalar * 1e9 / itemCount, times.Simd * 1e9 / itemCount,
+			times.Jobs * 1e9 / itemCount, times.Scalar / times.Simd);
+	}
+
+	return CheckResult();
+}
@@ -0,0 +1,251 @@
+// Tests FrustumCuller: boxes placed inside, beyond each of the six planes
+// and across them, layers whose size is not a multiple of the four boxes a
+// SIMD test takes, and 10,003 random boxes against a scalar double
+// precision plane test. Boxes within rounding distance of a plane are left
+// out of that comparison. Culling in parallel chunks must give the same
+// list in the same order as the serial loop. After items are moved, added
+// or removed, Update() must cull them where they are now.
+//
+// Builds with the app's portable sources; DXMATH is a directory with the
+// DirectXMath headers and the sal.h they need elsewhere than on Windows,
+// e.g. vcpkg's installed/x64-linux/include after installing directxmath:
+//   g++ -O2 -std=c++17 -pthread -I$DXMATH -I../include -I../src FrustumCullerTest.cpp ../src/FrustumCuller.cpp ../src/RenderItemStore.cpp ../src/DirtyList.cpp ../src/JobSystem.cpp ../src/Profiler.cpp -o FrustumCullerTest
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src FrustumCullerTest.cpp ..\src\FrustumCuller.cpp ..\src\RenderItemStore.cpp ..\src\DirtyList.cpp ..\src\JobSystem.cpp ..\src\Profiler.cpp
+
+#include "platform.h"
+
+#include <random>
+
+#include <d3dUtil.h>
+#include <FrameResource.h>
+#include <RenderItemStore.h>
+#include <JobSystem.h>
+#include <FrustumCuller.h>
+
+#include "Check.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// at the origin looking down +z, 90 degrees wide and high, depth 1 to 100
+	XMFLOAT4X4 ViewProj()
+	{
+		XMMATRIX view = XMMatrixLookAtLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, 1.0f, 100.0f);
+		XMFLOAT4X4 viewProj;
+		XMStoreFloat4x4(&viewProj, XMMatrixMultiply(view, proj));
+		return viewProj;
+	}
+
+	struct Scene
+	{
+		Material Mat;
+		MeshGeometry Geo;
+		RenderItemStore Ritems;
+
+		UINT Add(const XMFLOAT3& center, const XMFLOAT3& extents, RenderLayer layer = RenderLayer::Opaque)
+		{
+			RenderItem ritem;
+			ritem.Geo = &Geo;
+			ritem.Mat = &Mat;
+			ritem.Bounds = BoundingBox(center, extents);
+			return Ritems.IndexOf(Ritems.Add(layer, ritem));
+		}
+	};
+
+	// -1 outside, 1 inside, 0 too close to a plane to call
+	int Reference(const XMFLOAT4X4& m, const BoundingBox& b)
+	{
+		double planes[6][4];
+		for (int c = 0; c < 4; ++c)
+		{
+			planes[0][c] = (double)m(c, 3) + m(c, 0);
+			planes[1][c] = (double)m(c, 3) - m(c, 0);
+			planes[2][c] = (double)m(c, 3) + m(c, 1);
+			planes[3][c] = (double)m(c, 3) - m(c, 1);
+			planes[4][c] = (double)m(c, 2);
+			planes[5][c] = (double)m(c, 3) - m(c, 2);
+		}
+
+		int result = 1;
+		for (const auto& p : planes)
+		{
+			double distance = p[0] * b.Center.x + p[1] * b.Center.y + p[2] * b.Center.z + p[3];
+			double radius = fabs(p[0]) * b.Extents.x + fabs(p[1]) * b.Extents.y + fabs(p[2]) * b.Extents.z;
+			double margin = distance + radius;
+			if (margin < -1e-3)
+				return -1;
+			if (margin < 1e-3)
+				result = 0;
+		}
+		return result;
+	}
+
+	void TestPlacedBoxes()
+	{
+		Scene scene;
+		const XMFLOAT3 unit(0.5f, 0.5f, 0.5f);
+
+		UINT inside = scene.Add(XMFLOAT3(0.0f, 0.0f, 10.0f), unit);
+		scene.Add(XMFLOAT3(0.0f, 0.0f, -10.0f), unit);  // behind
+		scene.Add(XMFLOAT3(0.0f, 0.0f, 0.2f), unit);    // before the near plane
+		scene.Add(XMFLOAT3(0.0f, 0.0f, 120.0f), unit);  // beyond the far plane
+		scene.Add(XMFLOAT3(-12.0f, 0.0f, 10.0f), unit); // left
+		scene.Add(XMFLOAT3(12.0f, 0.0f, 10.0f), unit);  // right
+		scene.Add(XMFLOAT3(0.0f, -12.0f, 10.0f), unit); // below
+		scene.Add(XMFLOAT3(0.0f, 12.0f, 10.0f), unit);  // above
+		UINT acrossNear = scene.Add(XMFLOAT3(0.0f, 0.0f, 1.0f), unit);
+		UINT acrossFar = scene.Add(XMFLOAT3(0.0f, 0.0f, 100.0f), unit);
+		UINT acrossLeft = scene.Add(XMFLOAT3(-10.2f, 0.0f, 10.0f), unit);
+		UINT acrossTop = scene.Add(XMFLOAT3(0.0f, 10.2f, 10.0f), unit);
+		UINT aroundEye = scene.Add(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(500.0f, 500.0f, 500.0f));
+
+		// outside the corner, though inside the left and top planes taken one at a time
+		scene.Add(XMFLOAT3(-5.0f, 0.0f, 3.0f), XMFLOAT3(0.5f, 0.5f, 0.5f));
+
+		// other layers are not culled with the opaque items
+		scene.Add(XMFLOAT3(0.0f, 0.0f, 10.0f), unit, RenderLayer::Instanced);
+
+		FrustumCuller culler;
+		culler.Build(scene.Ritems, RenderLayer::Opaque);
+
+		std::vector<UINT> visible;
+		culler.Cull(ViewProj(), visible);
+
+		std::vector<UINT> expected = { inside, acrossNear, acrossFar, acrossLeft, acrossTop, aroundEye };
+		CHECK(visible == expected);
+	}
+
+	void TestLayerSizes()
+	{
+		for (UINT count : { 0u, 1u, 3u, 4u, 5u, 7u, 8u, 9u })
+		{
+			// every other box visible, the last always
+			Scene scene;
+			std::vector<UINT> expected;
+			for (UINT i = 0; i < count; ++i)
+			{
+				bool visible = i % 2 == 0 || i + 1 == count;
+				UINT index = scene.Add(XMFLOAT3(0.0f, 0.0f, visible ? 10.0f : -10.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+				if (visible)
+					expected.push_back(index);
+			}
+
+			FrustumCuller culler;
+			culler.Build(scene.Ritems, RenderLayer::Opaque);
+
+			std::vector<UINT> visible = { 12345 };
+			culler.Cull(ViewProj(), visible);
+			CHECK(visible == expected);
+		}
+	}
+
+	void TestRandomBoxes(JobSystem& jobs)
+	{
+		Scene scene;
+		std::mt19937 rng(7);
+		std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+		std::uniform_real_distribution<float> size(0.1f, 8.0f);
+
+		const UINT count = 10003;
+		for (UINT i = 0; i < count; ++i)
+			scene.Add(XMFLOAT3(position(rng), position(rng), position(rng)), XMFLOAT3(size(rng), size(rng), size(rng)));
+
+		FrustumCuller culler;
+		culler.Build(scene.Ritems, RenderLayer::Opaque);
+
+		XMFLOAT4X4 viewProj = ViewProj();
+		std::vector<UINT> visible;
+		culler.Cull(viewProj, visible);
+
+		std::vector<bool> isVisible(count, false);
+		for (UINT index : visible)
+			isVisible[index] = true;
+
+		UINT compared = 0, wrong = 0, expectedVisible = 0;
+		for (UINT i = 0; i < count; ++i)
+		{
+			int reference = Reference(viewProj, scene.Ritems.WorldBounds()[i]);
+			if (reference == 0)
+				continue;
+
+			compared++;
+			expectedVisible += reference > 0;
+			wrong += (reference > 0) != isVisible[i];
+		}
+		CHECK(wrong == 0);
+		CHECK(compared > count * 99 / 100);
+		CHECK(expectedVisible > 0 && expectedVisible < compared);
+		CHECK(std::is_sorted(visible.begin(), visible.end()));
+
+		// chunks culled by the jobs keep the layer order
+		std::vector<UINT> parallel;
+		culler.Cull(viewProj, parallel, &jobs);
+		CHECK(parallel == visible);
+
+		std::printf("%u random boxes, %zu visible, %u compared with the reference\n", count, visible.size(), compared);
+	}
+
+	void TestStoreChanges()
+	{
+		Scene scene;
+		const XMFLOAT3 unit(0.5f, 0.5f, 0.5f);
+
+		RenderItemHandle a = scene.Ritems.HandleOf(scene.Add(XMFLOAT3(0.0f, 0.0f, 10.0f), unit));
+		RenderItemHandle b = scene.Ritems.HandleOf(scene.Add(XMFLOAT3(0.0f, 0.0f, -10.0f), unit));
+		RenderItemHandle c = scene.Ritems.HandleOf(scene.Add(XMFLOAT3(0.0f, 0.0f, 20.0f), unit));
+
+		FrustumCuller culler;
+		culler.Build(scene.Ritems, RenderLayer::Opaque);
+
+		const XMFLOAT4X4 viewProj = ViewProj();
+		auto visibleHandles = [&]() {
+			culler.Update(scene.Ritems, RenderLayer::Opaque);
+			std::vector<UINT> visible;
+			culler.Cull(viewProj, visible);
+
+			std::vector<RenderItemHandle> handles;
+			for (UINT index : visible)
+				handles.push_back(scene.Ritems.HandleOf(index));
+			return handles;
+		};
+
+		CHECK(visibleHandles() == std::vector<RenderItemHandle>({ a, c }));
+
+		// a behind the camera, b in front of it
+		XMFLOAT4X4 world;
+		XMStoreFloat4x4(&world, XMMatrixTranslation(0.0f, 0.0f, -30.0f));
+		scene.Ritems.SetWorld(a, world);
+		XMStoreFloat4x4(&world, XMMatrixTranslation(0.0f, 0.0f, 25.0f));
+		scene.Ritems.SetWorld(b, world);
+		CHECK(visibleHandles() == std::vector<RenderItemHandle>({ b, c }));
+
+		// the last item moves into the hole, its old index must not be drawn
+		scene.Ritems.Remove(a);
+		CHECK(visibleHandles() == std::vector<RenderItemHandle>({ c, b }));
+		scene.Ritems.Remove(c);
+		CHECK(visibleHandles() == std::vector<RenderItemHandle>({ b }));
+
+		RenderItemHandle d = scene.Ritems.HandleOf(scene.Add(XMFLOAT3(0.0f, 0.0f, 30.0f), unit));
+		CHECK(visibleHandles() == std::vector<RenderItemHandle>({ b, d }));
+
+		// an unchanged store keeps the arrays
+		UINT64 layoutVersion = scene.Ritems.LayoutVersion();
+		UINT64 boundsVersion = scene.Ritems.BoundsVersion();
+		CHECK(visibleHandles() == std::vector<RenderItemHandle>({ b, d }));
+		CHECK(scene.Ritems.LayoutVersion() == layoutVersion && scene.Ritems.BoundsVersion() == boundsVersion);
+	}
+}
+
+int main()
+{
+	JobSystem jobs(3);
+
+	TestPlacedBoxes();
+	TestLayerSizes();
+	TestRandomBoxes(jobs);
+	TestStoreChanges();
+
+	return CheckResult();
+}
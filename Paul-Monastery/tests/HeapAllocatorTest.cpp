@@ -0,0 +1,265 @@
+// Tests HeapAllocator: placement and alignment, random operations checked
+// against a reference model, defragmentation of a fragmented heap, and the
+// cost of a mixed allocate/free operation.
+//
+// Builds on its own with the app's portable sources:
+//   g++ -O2 -std=c++17 -I../include -I../src HeapAllocatorTest.cpp ../src/HeapAllocator.cpp -o HeapAllocatorTest
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src HeapAllocatorTest.cpp ..\src\HeapAllocator.cpp
+
+#include "platform.h"
+
+#include <chrono>
+#include <map>
+#include <random>
+
+#include <HeapAllocator.h>
+
+#include "Check.h"
+
+namespace
+{
+	// handle -> (offset, size) of every live allocation
+	typedef std::map<UINT, std::pair<UINT64, UINT64>> Model;
+
+	// no overlaps, inside the capacity, and the allocator's totals agree
+	void Validate(const HeapAllocator& heap, const Model& model)
+	{
+		std::map<UINT64, UINT64> byOffset;
+		UINT64 used = 0;
+		for (const auto& entry : model)
+		{
+			CHECK(heap.Offset(entry.first) == entry.second.first);
+			CHECK(heap.Size(entry.first) == entry.second.second);
+			byOffset[entry.second.first] = entry.second.second;
+			used += entry.second.second;
+		}
+
+		UINT64 end = 0;
+		for (const auto& range : byOffset)
+		{
+			CHECK(range.first >= end);
+			end = range.first + range.second;
+		}
+
+		CHECK(end <= heap.Capacity());
+		CHECK(used == heap.UsedBytes());
+		CHECK(heap.AllocationCount() == model.size());
+	}
+
+	void TestPlacement()
+	{
+		HeapAllocator heap(1024);
+
+		UINT a = heap.Allocate(100);
+		CHECK(a != HeapAllocator::InvalidHandle && heap.Offset(a) == 0);
+
+		UINT b = heap.Allocate(100, 256);
+		CHECK(b != HeapAllocator::InvalidHandle && heap.Offset(b) == 256);
+
+		CHECK(heap.Allocate(1024) == HeapAllocator::InvalidHandle);
+		CHECK(heap.Allocate(0) == HeapAllocator::InvalidHandle);
+
+		heap.Free(a);
+		heap.Free(b);
+		CHECK(heap.UsedBytes() == 0);
+		CHECK(heap.LargestFreeBlock() == 1024);
+		CHECK(heap.Fragmentation() == 0.0f);
+
+		// the freed blocks merged back into one
+		UINT all = heap.Allocate(1024);
+		CHECK(all != HeapAllocator::InvalidHandle && heap.Offset(all) == 0);
+		heap.Free(all);
+	}
+
+	void TestDefragment()
+	{
+		// 64 KB placements fill the heap exactly, freeing every other one
+		// leaves no room for two
+		const UINT64 K = 65536;
+		HeapAllocator heap(16 * K);
+
+		std::vector<UINT> handles;
+		for (int i = 0; i < 16; ++i)
+		{
+			UINT h = heap.Allocate(K, K);
+			CHECK(h != HeapAllocator::InvalidHandle && heap.Offset(h) % K == 0);
+			handles.push_back(h);
+		}
+		CHECK(heap.Allocate(1) == HeapAllocator::InvalidHandle);
+
+		for (int i = 0; i < 16; i += 2)
+			heap.Free(handles[i]);
+
+		CHECK(heap.LargestFreeBlock() == K);
+		CHECK(heap.Allocate(2 * K, K) == HeapAllocator::InvalidHandle);
+		CHECK(heap.Fragmentation() > 0.8f);
+
+		std::vector<HeapAllocator::Move> moves = heap.Defragment(100);
+		CHECK(!moves.empty());
+		for (const HeapAllocator::Move& move : moves)
+		{
+			CHECK(move.To < move.From);
+			CHECK(heap.Offset(move.Handle) == move.To);
+			CHECK(heap.Offset(move.Retired) == move.From);
+		}
+
+		for (const HeapAllocator::Move& move : moves)
+			heap.Free(move.Retired);
+
+		CHECK(heap.LargestFreeBlock() == 8 * K);
+		CHECK(heap.Fragmentation() == 0.0f);
+	}
+
+	void TestAgainstModel()
+	{
+		std::mt19937_64 rng(1);
+		HeapAllocator heap(64ull << 20);
+		Model model;
+
+		const int operations = 200000;
+		UINT failed = 0;
+		for (int op = 0; op < operations; ++op)
+		{
+			if (model.empty() || rng() % 100 < 55)
+			{
+				UINT64 size = 1 + rng() % (1 << (rng() % 20));
+				UINT64 alignment = 1ull << (rng() % 17);
+
+				UINT h = heap.Allocate(size, alignment);
+				if (h == HeapAllocator::InvalidHandle)
+				{
+					failed++;
+					continue;
+				}
+
+				CHECK(heap.Offset(h) % alignment == 0);
+				CHECK(model.count(h) == 0);
+				model[h] = { heap.Offset(h), size };
+			}
+			else
+			{
+				auto entry = model.begin();
+				std::advance(entry, rng() % model.size());
+				heap.Free(entry->first);
+				model.erase(entry);
+			}
+
+			// defragmenting now and then keeps the model honest about moves too
+			if (op % 5000 == 0)
+			{
+				Validate(heap, model);
+
+				std::vector<HeapAllocator::Move> moves = heap.Defragment(16);
+				for (const HeapAllocator::Move& move : moves)
+				{
+					CHECK(move.To < move.From);
+					model[move.Handle].first = move.To;
+				}
+				for (const HeapAllocator::Move& move : moves)
+					heap.Free(move.Retired);
+
+				Validate(heap, model);
+			}
+		}
+
+		Validate(heap, model);
+		std::printf("model: %d operations, %zu live, %.1f MB used, %u allocations did not fit\n",
+			operations, model.size(), heap.UsedBytes() / 1048576.0, failed);
+
+		for (const auto& entry : model)
+			heap.Free(entry.first);
+
+		CHECK(heap.UsedBytes() == 0);
+		CHECK(heap.LargestFreeBlock() == heap.Capacity());
+	}
+
+	void TestDefragmentStress()
+	{
+		// fill with small textures, free half at random, then defragment
+		// until nothing moves
+		std::mt19937_64 rng(7);
+		HeapAllocator heap(256ull << 20);
+
+		std::vector<UINT> handles;
+		for (;;)
+		{
+			UINT h = heap.Allocate(4096 * (1 + rng() % 64), 4096);
+			if (h == HeapAllocator::InvalidHandle)
+				break;
+			handles.push_back(h);
+		}
+
+		std::shuffle(handles.begin(), handles.end(), rng);
+		for (size_t i = 0; i < handles.size() / 2; ++i)
+			heap.Free(handles[i]);
+
+		float fragmentationBefore = heap.Fragmentation();
+		UINT64 largestBefore = heap.LargestFreeBlock();
+
+		UINT moveCount = 0;
+		for (;;)
+		{
+			std::vector<HeapAllocator::Move> moves = heap.Defragment(64);
+			if (moves.empty())
+				break;
+
+			moveCount += (UINT)moves.size();
+			for (const HeapAllocator::Move& move : moves)
+				heap.Free(move.Retired);
+		}
+
+		CHECK(fragmentationBefore > 0.9f);
+		CHECK(heap.Fragmentation() < 0.1f);
+		CHECK(heap.LargestFreeBlock() > 16 * largestBefore);
+
+		std::printf("defragment: fragmentation %.3f -> %.3f, largest free block %.1f -> %.1f MB, %u moves\n",
+			fragmentationBefore, heap.Fragmentation(), largestBefore / 1048576.0,
+			heap.LargestFreeBlock() / 1048576.0, moveCount);
+	}
+
+	void BenchmarkMixed()
+	{
+		std::mt19937_64 rng(3);
+		HeapAllocator heap(1ull << 30);
+
+		std::vector<UINT64> sizes(1 << 20);
+		for (UINT64& size : sizes)
+			size = 256 * (1 + rng() % 256);
+
+		std::vector<UINT> live;
+		live.reserve(1 << 16);
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (size_t i = 0; i < sizes.size(); ++i)
+		{
+			if (live.size() < 4096 || (rng() & 1))
+			{
+				UINT h = heap.Allocate(sizes[i], 256);
+				if (h != HeapAllocator::InvalidHandle)
+					live.push_back(h);
+			}
+			else
+			{
+				size_t j = rng() % live.size();
+				heap.Free(live[j]);
+				live[j] = live.back();
+				live.pop_back();
+			}
+		}
+
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		std::printf("mixed allocate/free: %.1f ns per operation, %zu live\n", ns / sizes.size(), live.size());
+	}
+}
+
+int main()
+{
+	TestPlacement();
+	TestDefragment();
+	TestAgainstModel();
+	TestDefragmentStress();
+	BenchmarkMixed();
+
+	return CheckResult();
+}
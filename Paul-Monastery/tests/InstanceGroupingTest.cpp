@@ -0,0 +1,400 @@
+// Tests InstanceGrouping::Group:
+//   - copies of a mesh become one instanced item per cluster, with the
+//     copies' transforms as instances and bounds covering all of them
+//   - items differing in material, submesh, texture density or bounds, single
+//     copies and items already instanced are left as they are, and their
+//     handles stay valid
+//   - copies with LODs keep their chain
+//   - the monastery, and the monastery with the copies F5
+//     (GraphicsWindow::ScaleMonastery) adds up to 100,000 items, draw the
+//     same meshes with the same transforms and materials after grouping
+// and reports the draw calls DrawSubmission::Record issues per frame before
+// and after grouping, and the CPU time of the frame up to the recorded
+// commands (LODs, culling, sorted draw keys, recording), best of 20 frames.
+//
+// Builds with the app's portable sources; DXMATH is a directory with the
+// DirectXMath headers and the sal.h they need elsewhere than on Windows,
+// e.g. vcpkg's installed/x64-linux/include after installing directxmath:
+//   g++ -O2 -std=c++17 -pthread -I$DXMATH -I../include -I../src InstanceGroupingTest.cpp ../src/InstanceGrouping.cpp ../src/DrawSubmission.cpp ../src/CommandRecorder.cpp ../src/GeometryGenerator.cpp ../src/MeshPacker.cpp ../src/Church.cpp ../src/Monastery.cpp ../src/Sky.cpp ../src/Fixed.cpp ../src/SceneMaterials.cpp ../src/RenderItemStore.cpp ../src/DirtyList.cpp ../src/DrawKey.cpp ../src/FrustumCuller.cpp ../src/JobSystem.cpp ../src/Profiler.cpp -o InstanceGroupingTest
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src InstanceGroupingTest.cpp ..\src\InstanceGrouping.cpp ..\src\DrawSubmission.cpp ..\src\CommandRecorder.cpp ..\src\GeometryGenerator.cpp ..\src\MeshPacker.cpp ..\src\Church.cpp ..\src\Monastery.cpp ..\src\Sky.cpp ..\src\Fixed.cpp ..\src\SceneMaterials.cpp ..\src\RenderItemStore.cpp ..\src\DirtyList.cpp ..\src\DrawKey.cpp ..\src\FrustumCuller.cpp ..\src\JobSystem.cpp ..\src\Profiler.cpp
+
+#include "platform.h"
+
+#include <chrono>
+#include <tuple>
+
+#include <d3dUtil.h>
+#include <FrameResource.h>
+#include <RenderItemStore.h>
+#include <InstanceGrouping.h>
+#include <JobSystem.h>
+#include <FrustumCuller.h>
+#include <DrawKey.h>
+#include <DrawSubmission.h>
+#include <CommandRecorder.h>
+#include <SceneMaterials.h>
+#include <Sky.h>
+#include <Fixed.h>
+#include <Monastery.h>
+
+#include "Check.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// as in GraphicsWindow
+	const float LodMaxPixelError = 0.5f;
+	const float InstanceClusterSize = 10.0f;
+	const UINT MinInstances = 2;
+	const float FarZ = 1000.0f;
+	const UINT Width = 800;
+	const UINT Height = 600;
+
+	// mesh, submesh, material and transforms of one drawn copy
+	typedef std::tuple<std::string, UINT, UINT, std::vector<float>> DrawnCopy;
+
+	std::vector<float> Floats(const XMFLOAT4X4& world, const XMFLOAT4X4& texTransform)
+	{
+		std::vector<float> floats(&world._11, &world._11 + 16);
+		floats.insert(floats.end(), &texTransform._11, &texTransform._11 + 16);
+		return floats;
+	}
+
+	// every copy the store draws at full detail, instances expanded; meshes by
+	// name, so stores of different scenes compare
+	std::vector<DrawnCopy> DrawnCopies(const RenderItemStore& ritems)
+	{
+		std::vector<DrawnCopy> copies;
+		for (RenderLayer layer : { RenderLayer::Opaque, RenderLayer::Instanced })
+		{
+			for (UINT index : ritems.Layer(layer))
+			{
+				const RenderItemDrawArgs& args = ritems.DrawArgs()[index];
+				const RenderItemLod& lod = ritems.Lods()[index];
+				UINT start = lod.LevelCount > 0 ? ritems.LodLevels()[lod.FirstLevel].StartIndexLocation : args.StartIndexLocation;
+				UINT material = ritems.MaterialIds()[index];
+
+				if (args.InstanceCount == 0)
+				{
+					copies.emplace_back(args.Geo->Name, start, material, Floats(ritems.World()[index], ritems.TexTransform()[index]));
+					continue;
+				}
+
+				// the item's own transforms are identity, the instances carry them
+				for (UINT i = 0; i < args.InstanceCount; ++i)
+				{
+					const InstanceData& instance = ritems.Instances()[args.InstanceOffset + i];
+					copies.emplace_back(args.Geo->Name, start, material, Floats(instance.World, instance.TexTransform));
+				}
+			}
+		}
+		std::sort(copies.begin(), copies.end());
+		return copies;
+	}
+
+	bool Contains(const BoundingBox& outer, const BoundingBox& inner)
+	{
+		const float slack = 1e-4f;
+		return fabsf(inner.Center.x - outer.Center.x) + inner.Extents.x <= outer.Extents.x + slack &&
+			fabsf(inner.Center.y - outer.Center.y) + inner.Extents.y <= outer.Extents.y + slack &&
+			fabsf(inner.Center.z - outer.Center.z) + inner.Extents.z <= outer.Extents.z + slack;
+	}
+
+	void TestGroups()
+	{
+		MeshGeometry geo;
+		SubmeshGeometry lods[2];
+		lods[0].IndexCount = 36;
+		lods[1].IndexCount = 12;
+		lods[1].StartIndexLocation = 36;
+		lods[1].GeometricError = 0.1f;
+
+		std::vector<Material> materials(2);
+		std::vector<Material*> materialTable;
+		for (UINT m = 0; m < (UINT)materials.size(); ++m)
+		{
+			materials[m].MatCBIndex = (int)m;
+			materialTable.push_back(&materials[m]);
+		}
+
+		RenderItemStore ritems;
+		auto add = [&](float x, float z) {
+			RenderItem ritem;
+			XMStoreFloat4x4(&ritem.World, XMMatrixRotationY(x) * XMMatrixTranslation(x, 0.0f, z));
+			ritem.Geo = &geo;
+			ritem.Mat = &materials[0];
+			ritem.Bounds = BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f));
+			ritem.IndexCount = 36;
+			ritem.UvDensity = 1.0f;
+			return ritem;
+		};
+
+		// three copies in one cluster, two in another, one alone in a third
+		for (XMFLOAT2 p : { XMFLOAT2(1.0f, 1.0f), XMFLOAT2(2.0f, 3.0f), XMFLOAT2(4.0f, 1.0f), XMFLOAT2(21.0f, 1.0f),
+			XMFLOAT2(22.0f, 2.0f), XMFLOAT2(41.0f, 1.0f) })
+			ritems.Add(RenderLayer::Opaque, add(p.x, p.y));
+
+		// next to the first cluster but not copies of it
+		std::vector<RenderItemHandle> kept;
+		RenderItem ritem = add(3.0f, 3.0f);
+		ritem.Mat = &materials[1];
+		kept.push_back(ritems.Add(RenderLayer::Opaque, ritem));
+		ritem = add(3.0f, 4.0f);
+		ritem.StartIndexLocation = 36;
+		kept.push_back(ritems.Add(RenderLayer::Opaque, ritem));
+		ritem = add(3.0f, 5.0f);
+		XMStoreFloat4x4(&ritem.TexTransform, XMMatrixScaling(2.0f, 2.0f, 1.0f));
+		kept.push_back(ritems.Add(RenderLayer::Opaque, ritem));
+		ritem = add(3.0f, 6.0f);
+		ritem.Bounds.Extents.y = 1.0f;
+		kept.push_back(ritems.Add(RenderLayer::Opaque, ritem));
+
+		// already instanced
+		ritem = add(1.0f, 2.0f);
+		ritem.Instances.resize(2);
+		kept.push_back(ritems.Add(RenderLayer::Instanced, ritem));
+
+		// two copies with LODs, at their coarser level when grouped
+		ritem = add(6.0f, 2.0f);
+		ritem.Lods.assign(lods, lods + 2);
+		ritems.Add(RenderLayer::Opaque, ritem);
+		ritem = add(7.0f, 2.0f);
+		ritem.Lods.assign(lods, lods + 2);
+		ritems.Add(RenderLayer::Opaque, ritem);
+		ritems.SelectLods(XMFLOAT3(-1000.0f, 0.0f, 2.0f), 100.0f, 1000.0f);
+
+		// in another layer
+		kept.push_back(ritems.Add(RenderLayer::Fixed, add(1.0f, 1.0f)));
+
+		std::vector<DrawnCopy> before = DrawnCopies(ritems);
+		UINT64 layoutVersion = ritems.LayoutVersion();
+
+		UINT groups = InstanceGrouping::Group(ritems, RenderLayer::Opaque, materialTable, 10.0f, 2);
+		CHECK(groups == 3);
+		CHECK(ritems.LayoutVersion() != layoutVersion);
+		CHECK(ritems.Layer(RenderLayer::Opaque).size() == 5);
+		CHECK(ritems.Layer(RenderLayer::Instanced).size() == 4);
+		CHECK(ritems.Layer(RenderLayer::Fixed).size() == 1);
+		CHECK(DrawnCopies(ritems) == before);
+
+		for (RenderItemHandle handle : kept)
+			CHECK(ritems.IsValid(handle));
+
+		// the groups in order of their first item: 3 copies, 2 copies, the LOD pair
+		std::vector<UINT> instanceCounts;
+		UINT lodGroups = 0;
+		for (UINT index : ritems.Layer(RenderLayer::Instanced))
+		{
+			const RenderItemDrawArgs& args = ritems.DrawArgs()[index];
+			const RenderItemLod& lod = ritems.Lods()[index];
+			if (ritems.HandleOf(index) == kept[kept.size() - 2])
+				continue;
+			instanceCounts.push_back(args.InstanceCount);
+
+			for (UINT i = 0; i < args.InstanceCount; ++i)
+			{
+				BoundingBox bounds;
+				ritems.Bounds()[index].Transform(bounds, XMLoadFloat4x4(&ritems.Instances()[args.InstanceOffset + i].World));
+				CHECK(Contains(ritems.WorldBounds()[index], bounds));
+			}
+			CHECK(lod.UvDensity == 1.0f);
+			lodGroups += lod.LevelCount == 2;
+		}
+		CHECK(instanceCounts == std::vector<UINT>({ 3, 2, 2 }));
+		CHECK(lodGroups == 1);
+
+		// nothing left to group
+		CHECK(InstanceGrouping::Group(ritems, RenderLayer::Opaque, materialTable, 10.0f, 2) == 0);
+
+		// a minimum above the largest group keeps everything
+		RenderItemStore single;
+		for (UINT i = 0; i < 3; ++i)
+			single.Add(RenderLayer::Opaque, add(1.0f + i, 1.0f));
+		CHECK(InstanceGrouping::Group(single, RenderLayer::Opaque, materialTable, 10.0f, 4) == 0);
+		CHECK(single.Layer(RenderLayer::Opaque).size() == 3);
+	}
+
+	struct Scene
+	{
+		std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> Geometries;
+		std::unordered_map<std::string, std::unique_ptr<Texture>> Textures;
+		std::unordered_map<std::string, std::unique_ptr<Material>> Materials;
+		std::vector<Material*> MaterialTable;
+		RenderItemStore Ritems;
+		FrustumCuller LayerCullers[(int)RenderLayer::Count];
+	};
+
+	// GraphicsWindow::InitDirect3D without the device, the texture files and the grouping
+	void BuildScene(Scene& scene, JobSystem& jobs)
+	{
+		for (const SceneMaterials::TextureFile& file : SceneMaterials::TextureFiles(L""))
+		{
+			auto tex = std::make_unique<Texture>();
+			tex->Name = file.Name;
+			scene.Textures[file.Name] = std::move(tex);
+		}
+
+		Monastery monastery;
+		Sky::BuildGeometry(scene.Geometries);
+		Fixed::BuildGeometry(scene.Geometries);
+		monastery.BuildGeometry(scene.Geometries, jobs);
+
+		SceneMaterials::BuildMaterials(scene.Textures, scene.Materials, scene.MaterialTable);
+
+		Sky::BuildRenderItems(scene.Geometries, scene.Materials, scene.Ritems);
+		Fixed::BuildRenderItems(scene.Geometries, scene.Materials, scene.Ritems);
+		monastery.BuildRenderItems(scene.Geometries, scene.Materials, scene.Ritems);
+	}
+
+	// GraphicsWindow::ScaleMonastery
+	void ScaleMonastery(Scene& scene, UINT drawCount)
+	{
+		std::vector<UINT> opaque = scene.Ritems.Layer(RenderLayer::Opaque);
+		for (UINT n = (UINT)opaque.size(), i = 0; n < drawCount; ++n, i = (i + 1) % opaque.size())
+		{
+			UINT index = opaque[i];
+			const RenderItemDrawArgs& args = scene.Ritems.DrawArgs()[index];
+
+			RenderItem ritem;
+			ritem.World = scene.Ritems.World()[index];
+			ritem.TexTransform = scene.Ritems.TexTransform()[index];
+			ritem.Geo = args.Geo;
+			ritem.Mat = scene.MaterialTable[scene.Ritems.MaterialIds()[index]];
+			ritem.Bounds = scene.Ritems.Bounds()[index];
+			ritem.PrimitiveType = args.PrimitiveType;
+			ritem.IndexCount = args.IndexCount;
+			ritem.StartIndexLocation = args.StartIndexLocation;
+			ritem.BaseVertexLocation = args.BaseVertexLocation;
+
+			scene.Ritems.Add(RenderLayer::Opaque, ritem);
+		}
+	}
+
+	struct FrameCost
+	{
+		UINT Draws = 0;
+		UINT Instances = 0;
+		double Seconds = 1e30;
+	};
+
+	// GraphicsWindow::Render up to the recorded commands, from the start view
+	FrameCost RecordFrames(Scene& scene, int frames)
+	{
+		const float radius = 30.0f;
+		const float theta = 1.5f * XM_PI;
+		const float phi = XM_PIDIV2 - 0.5f;
+		XMFLOAT3 eyePos(radius * sinf(phi) * cosf(theta), radius * cosf(phi), radius * sinf(phi) * sinf(theta));
+
+		XMMATRIX view = XMMatrixLookAtLH(XMLoadFloat3(&eyePos), XMVectorSet(0.0f, 5.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * XM_PI, (float)Width / Height, 1.0f, FarZ);
+		XMFLOAT4X4 projF, viewProj;
+		XMStoreFloat4x4(&projF, proj);
+		XMStoreFloat4x4(&viewProj, XMMatrixMultiply(view, proj));
+
+		DrawBindings bindings;
+		bindings.ObjectCB = 0x10000000;
+		bindings.ObjectCBStride = 256;
+		bindings.MaterialCB = 0x20000000;
+		bindings.MaterialCBStride = 256;
+		bindings.Instances = 0x30000000;
+		bindings.BufferViews = [](const MeshGeometry& geo, RenderVertexBufferView& vbv, RenderIndexBufferView& ibv) {
+			vbv = { 0x100000, geo.VertexBufferByteSize, geo.VertexByteStride };
+			ibv = { 0x200000, geo.IndexBufferByteSize, RenderIndexFormat::Uint32 };
+		};
+
+		std::vector<UINT> visible[(int)RenderLayer::Count];
+		std::vector<UINT64> keys, scratch;
+		RecordingCommandList cmdList;
+
+		FrameCost cost;
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			auto start = std::chrono::steady_clock::now();
+
+			scene.Ritems.SelectLods(eyePos, 0.5f * Height * projF._22, LodMaxPixelError);
+
+			visible[(int)RenderLayer::Sky] = scene.Ritems.Layer(RenderLayer::Sky);
+			visible[(int)RenderLayer::Fixed] = scene.Ritems.Layer(RenderLayer::Fixed);
+			for (RenderLayer layer : { RenderLayer::Opaque, RenderLayer::Instanced })
+			{
+				scene.LayerCullers[(int)layer].Update(scene.Ritems, layer);
+				scene.LayerCullers[(int)layer].Cull(viewProj, visible[(int)layer]);
+			}
+
+			const auto& worldBounds = scene.Ritems.WorldBounds();
+			keys.clear();
+			for (int layer = 0; layer < (int)RenderLayer::Count; ++layer)
+			{
+				bool depthSorted = layer == (int)RenderLayer::Opaque || layer == (int)RenderLayer::Instanced;
+				for (UINT index : visible[layer])
+				{
+					UINT depthBucket = 0;
+					if (depthSorted)
+					{
+						XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&worldBounds[index].Center), view);
+						depthBucket = DrawKey::DepthBucket(XMVectorGetZ(center), FarZ);
+					}
+					keys.push_back(DrawKey::Make(layer, layer, scene.Ritems.GeometryIds()[index],
+						scene.Ritems.MaterialIds()[index], depthBucket, index));
+				}
+			}
+			DrawKey::Sort(keys, scratch);
+
+			cmdList.Reset();
+			DrawSubmission::Record(cmdList, scene.Ritems, keys, 0, (UINT)keys.size(), bindings);
+
+			cost.Seconds = min(cost.Seconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		cost.Draws = cmdList.CommandCount(RecordedOp::DrawIndexedInstanced);
+		for (UINT64 key : keys)
+			cost.Instances += max(1u, scene.Ritems.DrawArgs()[DrawKey::Index(key)].InstanceCount);
+		return cost;
+	}
+
+	void TestScene(JobSystem& jobs, const char* name, UINT drawCount)
+	{
+		Scene ungrouped, grouped;
+		for (Scene* scene : { &ungrouped, &grouped })
+		{
+			BuildScene(*scene, jobs);
+			ScaleMonastery(*scene, drawCount);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		UINT groups = InstanceGrouping::Group(grouped.Ritems, RenderLayer::Opaque, grouped.MaterialTable, InstanceClusterSize, MinInstances);
+		double groupSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		CHECK(groups > 0);
+		CHECK(DrawnCopies(grouped.Ritems) == DrawnCopies(ungrouped.Ritems));
+		CHECK(grouped.Ritems.InstanceCount() + grouped.Ritems.Layer(RenderLayer::Opaque).size() ==
+			ungrouped.Ritems.InstanceCount() + ungrouped.Ritems.Layer(RenderLayer::Opaque).size());
+
+		const int frames = 20;
+		FrameCost before = RecordFrames(ungrouped, frames);
+		FrameCost after = RecordFrames(grouped, frames);
+		CHECK(after.Draws < before.Draws);
+
+		// whole clusters are drawn, so at least every copy that was visible alone
+		CHECK(after.Instances >= before.Instances);
+
+		std::printf("%s, %u items grouped into %u instanced items in %.2f ms:\n", name,
+			ungrouped.Ritems.Size() - (grouped.Ritems.Size() - groups), groups, groupSeconds * 1e3);
+		std::printf("  ungrouped %6u draws of %6u copies, %8.3f ms per frame\n", before.Draws, before.Instances, before.Seconds * 1e3);
+		std::printf("  grouped   %6u draws of %6u copies, %8.3f ms per frame\n", after.Draws, after.Instances, after.Seconds * 1e3);
+		std::printf("  %.1f%% fewer draws, frame %.1fx faster\n", 100.0 * (1.0 - (double)after.Draws / before.Draws),
+			before.Seconds / after.Seconds);
+	}
+}
+
+int main()
+{
+	JobSystem jobs;
+
+	TestGroups();
+	TestScene(jobs, "monastery", 0);
+	TestScene(jobs, "scaled to 100,000 opaque items", 100000);
+
+	return CheckResult();
+}
@@ -0,0 +1,162 @@
+// Times one frame of per-item work on a 100k-item scene with 1 to N threads
+// in the JobSystem: every item's world matrix is rebuilt from its position
+// and yaw and its local bounds are transformed to world bounds, the work
+// UpdateObjectCBs and the culler's bounds refresh do per item. Chunks of 256
+// items, as UpdateObjectCBs uses. Every thread count must produce the same
+// bounds as the serial loop.
+//
+//   JobSystemBenchmark [max threads] [frames]
+//
+// Builds on its own with the app's portable sources:
+//   g++ -O2 -std=c++17 -pthread -I../include -I../src JobSystemBenchmark.cpp ../src/JobSystem.cpp ../src/Profiler.cpp -o JobSystemBenchmark
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src JobSystemBenchmark.cpp ..\src\JobSystem.cpp ..\src\Profiler.cpp
+
+#include "platform.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+#include <JobSystem.h>
+
+#include "Check.h"
+
+namespace
+{
+	const UINT ItemCount = 100000;
+	const UINT GrainSize = 256;
+
+	struct Bounds
+	{
+		float Center[3];
+		float Extents[3];
+	};
+
+	struct Scene
+	{
+		std::vector<float> Position;
+		std::vector<float> Yaw;
+		std::vector<Bounds> LocalBounds;
+
+		std::vector<float> World;
+		std::vector<Bounds> WorldBounds;
+	};
+
+	Scene MakeScene()
+	{
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		Scene scene;
+		scene.Position.resize(3 * ItemCount);
+		scene.Yaw.resize(ItemCount);
+		scene.LocalBounds.resize(ItemCount);
+		scene.World.resize(16 * ItemCount);
+		scene.WorldBounds.resize(ItemCount);
+
+		for (UINT i = 0; i < ItemCount; ++i)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				scene.Position[3 * i + c] = 1000.0f * unit(rng) - 500.0f;
+				scene.LocalBounds[i].Center[c] = unit(rng) - 0.5f;
+				scene.LocalBounds[i].Extents[c] = 0.1f + 4.0f * unit(rng);
+			}
+			scene.Yaw[i] = 6.2831853f * unit(rng);
+		}
+		return scene;
+	}
+
+	// a rotation about y and a translation, row vectors as in the app
+	void UpdateItems(Scene& scene, UINT begin, UINT end)
+	{
+		for (UINT i = begin; i < end; ++i)
+		{
+			float s = std::sin(scene.Yaw[i]);
+			float c = std::cos(scene.Yaw[i]);
+			const float* p = &scene.Position[3 * i];
+
+			float* m = &scene.World[16 * i];
+			m[0] = c;    m[1] = 0.0f; m[2] = -s;   m[3] = 0.0f;
+			m[4] = 0.0f; m[5] = 1.0f; m[6] = 0.0f; m[7] = 0.0f;
+			m[8] = s;    m[9] = 0.0f; m[10] = c;   m[11] = 0.0f;
+			m[12] = p[0]; m[13] = p[1]; m[14] = p[2]; m[15] = 1.0f;
+
+			// the center moves with the matrix, the extents by its absolute values
+			const Bounds& local = scene.LocalBounds[i];
+			Bounds& world = scene.WorldBounds[i];
+			for (int col = 0; col < 3; ++col)
+			{
+				world.Center[col] = m[12 + col];
+				world.Extents[col] = 0.0f;
+				for (int row = 0; row < 3; ++row)
+				{
+					world.Center[col] += local.Center[row] * m[4 * row + col];
+					world.Extents[col] += local.Extents[row] * std::fabs(m[4 * row + col]);
+				}
+			}
+		}
+	}
+
+	bool SameBounds(const std::vector<Bounds>& a, const std::vector<Bounds>& b)
+	{
+		return std::memcmp(a.data(), b.data(), a.size() * sizeof(Bounds)) == 0;
+	}
+
+	typedef std::chrono::steady_clock Clock;
+}
+
+int main(int argc, char** argv)
+{
+	const UINT hardwareThreads = max(1u, std::thread::hardware_concurrency());
+	const UINT maxThreads = argc > 1 ? max(1, atoi(argv[1])) : max(4u, hardwareThreads);
+	const int frames = argc > 2 ? max(1, atoi(argv[2])) : 50;
+
+	Scene scene = MakeScene();
+
+	std::printf("%u items, %u per chunk, %d frames, %u hardware threads, milliseconds per frame\n",
+		ItemCount, GrainSize, frames, hardwareThreads);
+	std::printf("%8s %10s %10s %10s\n", "threads", "median", "best", "speedup");
+
+	double serialMedian = 0.0;
+	for (UINT threads = 1; threads <= maxThreads; ++threads)
+	{
+		JobSystem jobs(threads - 1);
+
+		std::vector<double> times;
+		for (int frame = 0; frame < frames + 1; ++frame)
+		{
+			// each frame turns every item a little, as a scene that moves
+			for (float& yaw : scene.Yaw)
+				yaw += 0.001f;
+
+			auto start = Clock::now();
+			jobs.ParallelFor(ItemCount, GrainSize, [&scene](UINT begin, UINT end)
+			{
+				UpdateItems(scene, begin, end);
+			});
+			double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+			// the first frame wakes the workers and is not timed
+			if (frame > 0)
+				times.push_back(ms);
+		}
+
+		// the serial loop, as it ran before the job system, must agree
+		std::vector<Bounds> threaded = scene.WorldBounds;
+		UpdateItems(scene, 0, ItemCount);
+		CHECK(SameBounds(threaded, scene.WorldBounds));
+
+		std::sort(times.begin(), times.end());
+		double median = times[times.size() / 2];
+		if (threads == 1)
+			serialMedian = median;
+
+		std::printf("%8u %10.3f %10.3f %9.2fx\n", threads, median, times.front(), serialMedian / median);
+	}
+
+	if (maxThreads > hardwareThreads)
+		std::printf("more threads than the %u hardware threads share them, expect no speedup there\n", hardwareThreads);
+
+	return CheckResult();
+}
@@ -0,0 +1,324 @@
+// Tests JobSystem: counters and continuations, jobs that wait on jobs they
+// spawn, threads attached to the system, exceptions thrown by jobs on workers and by the caller's chunk of a
+// ParallelFor, and a stress run for ThreadSanitizer.
+//
+// Builds on its own with the app's portable sources:
+//   g++ -O2 -std=c++17 -pthread -I../include -I../src JobSystemTest.cpp ../src/JobSystem.cpp ../src/Profiler.cpp -o JobSystemTest
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src JobSystemTest.cpp ..\src\JobSystem.cpp ..\src\Profiler.cpp
+// and under ThreadSanitizer, which must report nothing:
+//   g++ -O1 -g -fsanitize=thread -std=c++17 -pthread -I../include -I../src JobSystemTest.cpp ../src/JobSystem.cpp ../src/Profiler.cpp -o JobSystemTest
+
+#include "platform.h"
+
+#include <chrono>
+#include <stdexcept>
+
+#include <JobSystem.h>
+
+#include "Check.h"
+
+namespace
+{
+	const UINT WorkerCount = 3;
+
+	void TestRunAndWait()
+	{
+		JobSystem jobs(WorkerCount);
+		CHECK(jobs.ThreadCount() == WorkerCount + 1);
+
+		std::atomic<int> sum{ 0 };
+		JobCounter counter;
+		for (int i = 1; i <= 1000; ++i)
+			jobs.Run([&sum, i]() { sum += i; }, &counter);
+
+		jobs.Wait(counter);
+		CHECK(counter.IsDone());
+		CHECK(sum == 500500);
+	}
+
+	void TestContinuations()
+	{
+		JobSystem jobs(WorkerCount);
+
+		// every stage reads what the whole previous stage wrote
+		std::vector<int> values(64, 0);
+		JobCounter first;
+		JobCounter second;
+		JobCounter third;
+
+		for (UINT i = 0; i < values.size(); ++i)
+			jobs.Run([&values, i]() { values[i] = 1; }, &first);
+
+		std::atomic<int> firstSum{ 0 };
+		for (UINT i = 0; i < 8; ++i)
+		{
+			jobs.RunAfter(first, [&values, &firstSum]()
+			{
+				int sum = 0;
+				for (int v : values)
+					sum += v;
+				firstSum += sum;
+			}, &second);
+		}
+
+		int secondSum = 0;
+		jobs.RunAfter(second, [&firstSum, &secondSum]() { secondSum = firstSum; }, &third);
+
+		jobs.Wait(third);
+		CHECK(first.IsDone() && second.IsDone());
+		CHECK(secondSum == 8 * 64);
+
+		// a continuation of a finished counter runs right away
+		int late = 0;
+		JobCounter after;
+		jobs.RunAfter(first, [&late]() { late = 1; }, &after);
+		jobs.Wait(after);
+		CHECK(late == 1);
+	}
+
+	void TestNestedWait()
+	{
+		JobSystem jobs(WorkerCount);
+
+		// more waiting jobs than threads: waiters execute jobs, so nothing stalls
+		std::atomic<int> leaves{ 0 };
+		JobCounter outer;
+		for (int i = 0; i < 16; ++i)
+		{
+			jobs.Run([&jobs, &leaves]()
+			{
+				JobCounter inner;
+				for (int j = 0; j < 16; ++j)
+					jobs.Run([&leaves]() { leaves++; }, &inner);
+				jobs.Wait(inner);
+			}, &outer);
+		}
+
+		jobs.Wait(outer);
+		CHECK(leaves == 256);
+	}
+
+	void TestAttachThread()
+	{
+		JobSystem jobs(WorkerCount, 1);
+		CHECK(jobs.ThreadCount() == WorkerCount + 2);
+		CHECK(jobs.ThreadIndex() == 0);
+
+		// a render thread of its own: no index it could share with the owner
+		UINT attachedIndex = 0;
+		std::vector<UINT> chunkIndices(64, UINT_MAX);
+		std::thread render([&]()
+		{
+			CHECK(jobs.ThreadIndex() == 0);
+			jobs.AttachThread(0);
+			attachedIndex = jobs.ThreadIndex();
+
+			jobs.ParallelFor((UINT)chunkIndices.size(), 1, [&](UINT begin, UINT end)
+			{
+				for (UINT i = begin; i < end; ++i)
+					chunkIndices[i] = jobs.ThreadIndex();
+			});
+		});
+
+		// meanwhile the owner waits on jobs of its own and may run the above
+		std::atomic<int> sum{ 0 };
+		for (int round = 0; round < 100; ++round)
+			jobs.ParallelFor(64, 1, [&sum](UINT begin, UINT end) { sum += end - begin; });
+
+		render.join();
+		CHECK(sum == 6400);
+		CHECK(attachedIndex == WorkerCount + 1);
+		CHECK(chunkIndices[0] == attachedIndex);
+		for (UINT index : chunkIndices)
+			CHECK(index < jobs.ThreadCount());
+	}
+
+	void TestWorkerThrows()
+	{
+		JobSystem jobs(WorkerCount);
+
+		std::atomic<int> finished{ 0 };
+		JobCounter counter;
+		for (int i = 0; i < 100; ++i)
+		{
+			jobs.Run([&finished, i]()
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+				if (i == 10 || i == 60)
+					throw std::runtime_error(i == 10 ? "first" : "second");
+				finished++;
+			}, &counter);
+		}
+
+		// the continuation still runs, a failed group is done all the same
+		bool continued = false;
+		JobCounter after;
+		jobs.RunAfter(counter, [&continued]() { continued = true; }, &after);
+
+		std::string message;
+		try
+		{
+			jobs.Wait(counter);
+		}
+		catch (const std::runtime_error& e)
+		{
+			message = e.what();
+		}
+
+		// one of the two, and only after every other job finished
+		CHECK(message == "first" || message == "second");
+		CHECK(counter.IsDone());
+		CHECK(finished == 98);
+
+		jobs.Wait(after);
+		CHECK(continued);
+
+		// the error was taken, the counter is ready for the next group
+		bool threw = false;
+		try
+		{
+			jobs.Wait(counter);
+			jobs.Run([&finished]() { finished++; }, &counter);
+			jobs.Wait(counter);
+		}
+		catch (...)
+		{
+			threw = true;
+		}
+		CHECK(!threw);
+		CHECK(finished == 99);
+	}
+
+	void TestParallelForThrows()
+	{
+		JobSystem jobs(WorkerCount);
+
+		// the caller's chunk throws at once while the queued chunks still run
+		// with references to func and the counter on the caller's stack
+		const UINT count = 64;
+		std::atomic<UINT> done{ 0 };
+		std::atomic<bool> returned{ false };
+		std::atomic<UINT> lateChunks{ 0 };
+
+		bool threw = false;
+		try
+		{
+			jobs.ParallelFor(count, 1, [&](UINT begin, UINT end)
+			{
+				if (begin == 0)
+					throw std::runtime_error("caller");
+
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+				if (returned)
+					lateChunks++;
+				done += end - begin;
+			});
+		}
+		catch (const std::runtime_error& e)
+		{
+			threw = std::string(e.what()) == "caller";
+		}
+		returned = true;
+
+		CHECK(threw);
+		CHECK(done == count - 1);
+		CHECK(lateChunks == 0);
+
+		// a chunk on a worker throws, the caller's chunk is the one that waits
+		done = 0;
+		threw = false;
+		try
+		{
+			jobs.ParallelFor(count, 4, [&](UINT begin, UINT end)
+			{
+				if (begin == 32)
+					throw std::runtime_error("worker");
+				done += end - begin;
+			});
+		}
+		catch (const std::runtime_error& e)
+		{
+			threw = std::string(e.what()) == "worker";
+		}
+
+		CHECK(threw);
+		CHECK(done == count - 4);
+
+		// nested: the inner error reaches the outer ParallelFor through its job
+		threw = false;
+		try
+		{
+			jobs.ParallelFor(8, 1, [&](UINT begin, UINT)
+			{
+				jobs.ParallelFor(8, 1, [begin](UINT innerBegin, UINT)
+				{
+					if (begin == 5 && innerBegin == 3)
+						throw std::runtime_error("nested");
+				});
+			});
+		}
+		catch (const std::runtime_error& e)
+		{
+			threw = std::string(e.what()) == "nested";
+		}
+		CHECK(threw);
+
+		// and the system goes on as before
+		std::atomic<UINT> sum{ 0 };
+		jobs.ParallelFor(1000, 16, [&sum](UINT begin, UINT end) { sum += end - begin; });
+		CHECK(sum == 1000);
+	}
+
+	// every index written by exactly one chunk, every round reads the last
+	void TestStress()
+	{
+		JobSystem jobs(WorkerCount);
+
+		const UINT count = 10000;
+		std::vector<UINT> values(count, 0);
+		for (UINT round = 1; round <= 200; ++round)
+		{
+			UINT grain = 1 + round % 97;
+			jobs.ParallelFor(count, grain, [&values, round](UINT begin, UINT end)
+			{
+				for (UINT i = begin; i < end; ++i)
+				{
+					CHECK(values[i] == round - 1);
+					values[i] = round;
+				}
+			});
+		}
+
+		UINT wrong = 0;
+		for (UINT v : values)
+			wrong += v != 200;
+		CHECK(wrong == 0);
+
+		// continuations queued while the dependency finishes on other threads
+		std::atomic<int> ran{ 0 };
+		for (int round = 0; round < 200; ++round)
+		{
+			JobCounter first;
+			JobCounter second;
+			for (int i = 0; i < 8; ++i)
+				jobs.Run([]() {}, &first);
+			for (int i = 0; i < 8; ++i)
+				jobs.RunAfter(first, [&ran]() { ran++; }, &second);
+			jobs.Wait(second);
+		}
+		CHECK(ran == 200 * 8);
+	}
+}
+
+int main()
+{
+	TestRunAndWait();
+	TestContinuations();
+	TestNestedWait();
+	TestAttachThread();
+	TestWorkerThrows();
+	TestParallelForThrows();
+	TestStress();
+
+	return CheckResult();
+}
@@ -0,0 +1,285 @@
+// Tests the LOD chains of GeometryGenerator and the level RenderItemStore::
+// SelectLods picks. Every chain is built with the scene's parameters: each
+// level must be the mesh generated at half the segment counts of the one
+// before, clamped at the smallest that still closes the shape, with fewer
+// triangles, and no point of it may stray from the ideal surface by more
+// than its Errors entry, measured on a grid of points on every triangle (on
+// the chords of the outer rim for the flat ring and sector). SelectLods must
+// then pick, for an eye moving away from the dome and for scaled and
+// instanced items, the coarsest level whose error projects to at most the
+// allowed pixels, and set the draw arguments to it.
+//
+// Builds with the app's portable sources; DXMATH is a directory with the
+// DirectXMath headers and the sal.h they need elsewhere than on Windows,
+// e.g. vcpkg's installed/x64-linux/include after installing directxmath:
+//   g++ -O2 -std=c++17 -I$DXMATH -I../include -I../src LodTest.cpp ../src/GeometryGenerator.cpp ../src/MeshPacker.cpp ../src/RenderItemStore.cpp ../src/DirtyList.cpp -o LodTest
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src LodTest.cpp ..\src\GeometryGenerator.cpp ..\src\MeshPacker.cpp ..\src\RenderItemStore.cpp ..\src\DirtyList.cpp
+
+#include "platform.h"
+
+#include <d3dUtil.h>
+#include <GeometryGenerator.h>
+#include <FrameResource.h>
+#include <MeshPacker.h>
+#include <RenderItemStore.h>
+
+#include "Check.h"
+
+using namespace DirectX;
+
+namespace
+{
+	using MeshData = GeometryGenerator::MeshData;
+	using uint32 = GeometryGenerator::uint32;
+
+	// as in GraphicsWindow at 600 pixels high: 0.5 * height * proj(1,1)
+	const float PixelScale = 0.5f * 600.0f / tanf(0.125f * XM_PI);
+	const float MaxPixelError = 0.5f;
+
+	// float rounding of the sampled points
+	const float Tolerance = 1e-5f;
+
+	// Largest distance from the surface over a grid of points on every triangle.
+	float SurfaceError(const MeshData& mesh, const std::function<float(XMVECTOR)>& distance)
+	{
+		const int steps = 8;
+		float worst = 0.0f;
+		for (size_t i = 0; i + 2 < mesh.Indices32.size(); i += 3)
+		{
+			XMVECTOR a = XMLoadFloat3(&mesh.Vertices[mesh.Indices32[i]].Position);
+			XMVECTOR b = XMLoadFloat3(&mesh.Vertices[mesh.Indices32[i + 1]].Position);
+			XMVECTOR c = XMLoadFloat3(&mesh.Vertices[mesh.Indices32[i + 2]].Position);
+
+			for (int u = 0; u <= steps; ++u)
+			{
+				for (int v = 0; u + v <= steps; ++v)
+				{
+					float wb = (float)u / steps;
+					float wc = (float)v / steps;
+					worst = max(worst, distance(a * (1.0f - wb - wc) + b * wb + c * wc));
+				}
+			}
+		}
+		return worst;
+	}
+
+	// Largest gap between the circle of the given radius around y and the
+	// triangle edges whose ends both lie on it.
+	float RimError(const MeshData& mesh, float radius)
+	{
+		auto onRim = [&](const XMFLOAT3& p) { return fabsf(sqrtf(p.x * p.x + p.z * p.z) - radius) < Tolerance; };
+
+		float worst = 0.0f;
+		for (size_t i = 0; i + 2 < mesh.Indices32.size(); i += 3)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				const XMFLOAT3& a = mesh.Vertices[mesh.Indices32[i + k]].Position;
+				const XMFLOAT3& b = mesh.Vertices[mesh.Indices32[i + (k + 1) % 3]].Position;
+				if (onRim(a) && onRim(b))
+				{
+					float x = 0.5f * (a.x + b.x);
+					float z = 0.5f * (a.z + b.z);
+					worst = max(worst, radius - sqrtf(x * x + z * z));
+				}
+			}
+		}
+		return worst;
+	}
+
+	// The chain against the generator called with the halved counts directly.
+	void TestChain(const char* name, const GeometryGenerator::LodChain& chain,
+		const std::function<MeshData(uint32)>& createLevel, const std::function<float(const MeshData&)>& measure)
+	{
+		CHECK(!chain.Levels.empty() && chain.Levels.size() == chain.Errors.size());
+
+		for (size_t level = 0; level < chain.Levels.size(); ++level)
+		{
+			const MeshData& mesh = chain.Levels[level];
+			MeshData expected = createLevel((uint32)level);
+			CHECK(mesh.Indices32.size() == expected.Indices32.size());
+			CHECK(mesh.Vertices.size() == expected.Vertices.size());
+
+			if (level > 0)
+			{
+				CHECK(mesh.Indices32.size() < chain.Levels[level - 1].Indices32.size());
+				CHECK(chain.Errors[level] > chain.Errors[level - 1]);
+			}
+
+			float measured = measure(mesh);
+			CHECK(measured <= chain.Errors[level] * (1.0f + 1e-3f) + Tolerance);
+
+			std::printf("%-12s LOD %zu: %5zu triangles, error bound %.5f, measured %.5f\n",
+				name, level, mesh.Indices32.size() / 3, chain.Errors[level], measured);
+		}
+	}
+
+	void TestChains()
+	{
+		GeometryGenerator geoGen;
+		auto sphere = [](float radius) {
+			return [radius](const MeshData& mesh) {
+				return SurfaceError(mesh, [radius](XMVECTOR p) { return fabsf(radius - XMVectorGetX(XMVector3Length(p))); });
+			};
+		};
+		auto cylinder = [](float radius) {
+			return [radius](const MeshData& mesh) {
+				return SurfaceError(mesh, [radius](XMVECTOR p) {
+					return fabsf(radius - sqrtf(XMVectorGetX(p) * XMVectorGetX(p) + XMVectorGetZ(p) * XMVectorGetZ(p)));
+				});
+			};
+		};
+
+		// the scene's meshes, see Sky.cpp and Church.cpp
+		TestChain("sky sphere", geoGen.CreateSphereLods(0.2f, 50, 50, 4),
+			[&](uint32 l) { return geoGen.CreateSphere(0.2f, 50 >> l, 50 >> l); }, sphere(0.2f));
+		TestChain("dome", geoGen.CreateDomeLods(3.5f, XM_PIDIV2, 50, 50, 4),
+			[&](uint32 l) { return geoGen.CreateDome(3.5f, XM_PIDIV2, 50 >> l, 50 >> l); }, sphere(3.5f));
+		TestChain("block", geoGen.CreateCylinderLods(5.0f, 0.3f, 0.0f, XM_2PI / 40, 4, 4, 4),
+			[&](uint32 l) { return geoGen.CreateCylinder(5.0f, 0.3f, 0.0f, XM_2PI / 40, 4 >> l, 4 >> l); }, cylinder(5.0f));
+		TestChain("roof ring", geoGen.CreateRingLods(5.0f, 1.5f, 0.0f, XM_2PI, 50, 4, 4),
+			[&](uint32 l) { return geoGen.CreateRing(5.0f, 1.5f, 0.0f, XM_2PI, max(3u, 50u >> l), max(1u, 4u >> l)); },
+			[](const MeshData& mesh) { return RimError(mesh, 5.0f); });
+		TestChain("dome sector", geoGen.CreateSectorLods(4.0f, 0.5f, 0.0f, XM_PIDIV2, 0.5f, 50, 2, 2, 4),
+			[&](uint32 l) { return geoGen.CreateSector(4.0f, 0.5f, 0.0f, XM_PIDIV2, 0.5f, 50 >> l, 2, 2); },
+			[](const MeshData& mesh) { return RimError(mesh, 4.0f); });
+
+		// a long chain stops at the coarsest closed sphere: 16, 8, 4, then 3 slices and 2 stacks
+		GeometryGenerator::LodChain coarse = geoGen.CreateSphereLods(1.0f, 16, 16, 10);
+		CHECK(coarse.Levels.size() == 4);
+		CHECK(coarse.Levels.back().Indices32.size() == geoGen.CreateSphere(1.0f, 3, 2).Indices32.size());
+	}
+
+	struct Scene
+	{
+		GeometryGenerator::LodChain Chain;
+		std::unique_ptr<MeshGeometry> Geo;
+		std::vector<SubmeshGeometry> Levels;
+		Material Mat;
+		RenderItemStore Ritems;
+	};
+
+	RenderItem DomeItem(Scene& scene)
+	{
+		RenderItem ritem;
+		ritem.Geo = scene.Geo.get();
+		ritem.Mat = &scene.Mat;
+		ritem.Bounds = scene.Levels[0].Bounds;
+		ritem.Lods = scene.Levels;
+		return ritem;
+	}
+
+	// The coarsest level within MaxPixelError at the item's scale and nearest distance.
+	UINT ExpectedLevel(const Scene& scene, UINT index, const XMFLOAT3& eye)
+	{
+		const BoundingBox& bounds = scene.Ritems.WorldBounds()[index];
+		XMVECTOR e = XMLoadFloat3(&eye);
+		XMVECTOR nearest = XMVectorClamp(e, XMLoadFloat3(&bounds.Center) - XMLoadFloat3(&bounds.Extents),
+			XMLoadFloat3(&bounds.Center) + XMLoadFloat3(&bounds.Extents));
+		float distance = XMVectorGetX(XMVector3Length(e - nearest));
+		if (distance == 0.0f)
+			return 0;
+
+		UINT level = 0;
+		float scale = scene.Ritems.Lods()[index].Scale;
+		while (level + 1 < scene.Levels.size() &&
+			scene.Levels[level + 1].GeometricError * scale * PixelScale / distance <= MaxPixelError)
+			++level;
+		return level;
+	}
+
+	bool DrawsLevel(const Scene& scene, UINT index, UINT level)
+	{
+		const RenderItemDrawArgs& args = scene.Ritems.DrawArgs()[index];
+		const SubmeshGeometry& submesh = scene.Levels[level];
+		return scene.Ritems.Lods()[index].Level == level && args.IndexCount == submesh.IndexCount &&
+			args.StartIndexLocation == submesh.StartIndexLocation && args.BaseVertexLocation == submesh.BaseVertexLocation;
+	}
+
+	void TestSelectLods()
+	{
+		Scene scene;
+		GeometryGenerator geoGen;
+		scene.Chain = geoGen.CreateDomeLods(3.5f, XM_PIDIV2, 50, 50, 4);
+
+		MeshPacker packer;
+		packer.AddLods("dome", scene.Chain);
+		scene.Geo = packer.Pack("domeGeo");
+		scene.Levels = MeshPacker::LodLevels(*scene.Geo, "dome");
+		CHECK(scene.Levels.size() == scene.Chain.Levels.size());
+
+		RenderItemHandle dome = scene.Ritems.Add(RenderLayer::Opaque, DomeItem(scene));
+		UINT index = scene.Ritems.IndexOf(dome);
+
+		// added at the finest level
+		CHECK(DrawsLevel(scene, index, 0));
+
+		// inside the bounds
+		scene.Ritems.SelectLods(XMFLOAT3(0.0f, 1.0f, 0.0f), PixelScale, MaxPixelError);
+		CHECK(DrawsLevel(scene, index, 0));
+
+		// walking away, the level only gets coarser and reaches the last one
+		UINT previous = 0;
+		for (float distance = 1.0f; distance <= 100000.0f; distance *= 1.25f)
+		{
+			XMFLOAT3 eye(3.5f + distance, 1.0f, 0.0f);
+			scene.Ritems.SelectLods(eye, PixelScale, MaxPixelError);
+
+			UINT level = scene.Ritems.Lods()[index].Level;
+			CHECK(level == ExpectedLevel(scene, index, eye));
+			CHECK(DrawsLevel(scene, index, level));
+			CHECK(level >= previous);
+
+			if (level != previous)
+			{
+				std::printf("dome at %8.1f: LOD %u, %4u triangles, error %.3f pixels\n", distance, level,
+					scene.Levels[level].IndexCount / 3, scene.Levels[level].GeometricError * PixelScale / distance);
+			}
+			previous = level;
+		}
+		CHECK(previous == scene.Levels.size() - 1);
+
+		// twice as large, the same eye needs a finer level
+		XMFLOAT3 eye(3.5f + 300.0f, 1.0f, 0.0f);
+		scene.Ritems.SelectLods(eye, PixelScale, MaxPixelError);
+		UINT unscaled = scene.Ritems.Lods()[index].Level;
+
+		XMFLOAT4X4 world;
+		XMStoreFloat4x4(&world, XMMatrixScaling(2.0f, 2.0f, 2.0f));
+		scene.Ritems.SetWorld(dome, world);
+		scene.Ritems.SelectLods(eye, PixelScale, MaxPixelError);
+		CHECK(scene.Ritems.Lods()[index].Scale == 2.0f);
+		CHECK(scene.Ritems.Lods()[index].Level == ExpectedLevel(scene, index, eye));
+		CHECK(scene.Ritems.Lods()[index].Level < unscaled);
+
+		// instanced, the largest instance scale counts and the nearest instance
+		RenderItem instanced = DomeItem(scene);
+		for (int i = 0; i < 4; ++i)
+		{
+			InstanceData instance;
+			XMStoreFloat4x4(&instance.World, XMMatrixScaling(1.0f + i, 1.0f + i, 1.0f + i) * XMMatrixTranslation(0.0f, 0.0f, 20.0f * i));
+			instanced.Instances.push_back(instance);
+		}
+		UINT instancedIndex = scene.Ritems.IndexOf(scene.Ritems.Add(RenderLayer::Instanced, instanced));
+		CHECK(scene.Ritems.Lods()[instancedIndex].Scale == 4.0f);
+
+		for (float distance : { 10.0f, 100.0f, 1000.0f, 10000.0f })
+		{
+			XMFLOAT3 far(0.0f, 1.0f, -distance);
+			scene.Ritems.SelectLods(far, PixelScale, MaxPixelError);
+			CHECK(DrawsLevel(scene, instancedIndex, ExpectedLevel(scene, instancedIndex, far)));
+			CHECK(DrawsLevel(scene, index, ExpectedLevel(scene, index, far)));
+		}
+
+		// both items share one level table
+		CHECK(scene.Ritems.Lods()[index].FirstLevel == scene.Ritems.Lods()[instancedIndex].FirstLevel);
+	}
+}
+
+int main()
+{
+	TestChains();
+	TestSelectLods();
+
+	return CheckResult();
+}
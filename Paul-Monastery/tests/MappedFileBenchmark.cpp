@@ -0,0 +1,237 @@
+// Times loading files through MappedFile against reading them into a heap
+// copy, the way LoadTextureDataFromFile did before, and measures the
+// private memory each needs. Every loaded file is copied once into an
+// upload buffer, as UpdateSubresources does. Files are loaded one after
+// another, each released after its copy, and as a batch held together
+// until all are copied, like a level's textures. The files come from the
+// file cache (they were just written), so this is the copy and mapping
+// cost, not the disk.
+//
+// Private memory is what the process alone holds: heap copies count, the
+// mapped pages are the file cache's and are shared. The resident set is
+// printed too; it includes mapped pages while they are in use. One by one,
+// the heap may keep the last freed copy from the warm-up and reuse it,
+// which then does not show as growth.
+//
+//   MappedFileBenchmark [files] [MB per file]
+//
+// Builds on its own with the app's portable sources:
+//   g++ -O2 -std=c++17 -I../include -I../src MappedFileBenchmark.cpp ../src/MappedFile.cpp -o MappedFileBenchmark
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src MappedFileBenchmark.cpp ..\src\MappedFile.cpp psapi.lib
+
+#include "platform.h"
+
+#include <chrono>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <psapi.h>
+#endif
+
+#include <MappedFile.h>
+
+#include "Check.h"
+
+namespace
+{
+	struct Memory
+	{
+		UINT64 Private = 0;
+		UINT64 Resident = 0;
+	};
+
+	Memory CurrentMemory()
+	{
+		Memory memory;
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS_EX counters = {};
+		if (GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&counters, sizeof(counters)))
+		{
+			memory.Private = counters.PrivateUsage;
+			memory.Resident = counters.WorkingSetSize;
+		}
+#else
+		std::ifstream status("/proc/self/status");
+		std::string line;
+		while (std::getline(status, line))
+		{
+			if (line.compare(0, 8, "RssAnon:") == 0)
+				memory.Private = std::strtoull(line.c_str() + 8, nullptr, 10) * 1024;
+			else if (line.compare(0, 6, "VmRSS:") == 0)
+				memory.Resident = std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+		}
+#endif
+		return memory;
+	}
+
+	// the peaks over the samples taken
+	struct MemoryPeak
+	{
+		Memory Base;
+		Memory Peak;
+
+		MemoryPeak() : Base(CurrentMemory()), Peak(Base) {}
+
+		void Sample()
+		{
+			Memory now = CurrentMemory();
+			Peak.Private = max(Peak.Private, now.Private);
+			Peak.Resident = max(Peak.Resident, now.Resident);
+		}
+
+		double PrivateMB() const { return (double)(Peak.Private - min(Base.Private, Peak.Private)) / (1 << 20); }
+		double ResidentMB() const { return (double)(Peak.Resident - min(Base.Resident, Peak.Resident)) / (1 << 20); }
+	};
+
+	std::wstring Widen(const std::string& s)
+	{
+		return std::wstring(s.begin(), s.end());
+	}
+
+	// a loaded file, either way
+	struct Loaded
+	{
+		MappedFile File;
+		std::unique_ptr<BYTE[]> Copy;
+		UINT64 Size = 0;
+
+		const BYTE* Data() const { return Copy ? Copy.get() : File.Data(); }
+	};
+
+	bool LoadMapped(const std::string& name, Loaded& loaded)
+	{
+		if (!loaded.File.Open(Widen(name).c_str()))
+			return false;
+		loaded.Size = loaded.File.Size();
+		return true;
+	}
+
+	// the old way: a heap buffer as large as the file, read whole
+	bool LoadCopy(const std::string& name, Loaded& loaded)
+	{
+		std::ifstream fin(name, std::ios::binary | std::ios::ate);
+		if (!fin)
+			return false;
+
+		loaded.Size = (UINT64)fin.tellg();
+		loaded.Copy.reset(new BYTE[(size_t)loaded.Size]);
+		fin.seekg(0);
+		return (bool)fin.read((char*)loaded.Copy.get(), (std::streamsize)loaded.Size);
+	}
+
+	typedef bool (*LoadFunc)(const std::string&, Loaded&);
+
+	struct Result
+	{
+		double Seconds = 0.0;
+		double PrivateMB = 0.0;
+		double ResidentMB = 0.0;
+		UINT64 Checksum = 0;
+	};
+
+	// what the copy into the upload heap costs either way; the checksum
+	// makes sure both read the same bytes
+	UINT64 Upload(const Loaded& loaded, std::vector<BYTE>& upload)
+	{
+		std::memcpy(upload.data(), loaded.Data(), (size_t)loaded.Size);
+
+		UINT64 checksum = 0;
+		for (UINT64 i = 0; i < loaded.Size; i += 4096)
+			checksum = checksum * 31 + upload[(size_t)i];
+		return checksum;
+	}
+
+	Result Run(const std::vector<std::string>& files, LoadFunc load, bool batch, std::vector<BYTE>& upload)
+	{
+		Result result;
+		MemoryPeak peak;
+
+		auto start = std::chrono::steady_clock::now();
+		if (batch)
+		{
+			std::vector<Loaded> loaded(files.size());
+			for (size_t i = 0; i < files.size(); ++i)
+			{
+				CHECK(load(files[i], loaded[i]));
+				peak.Sample();
+			}
+			for (const Loaded& l : loaded)
+			{
+				result.Checksum = result.Checksum * 7 + Upload(l, upload);
+				peak.Sample();
+			}
+		}
+		else
+		{
+			for (const std::string& file : files)
+			{
+				Loaded loaded;
+				CHECK(load(file, loaded));
+				result.Checksum = result.Checksum * 7 + Upload(loaded, upload);
+				peak.Sample();
+			}
+		}
+		result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		result.PrivateMB = peak.PrivateMB();
+		result.ResidentMB = peak.ResidentMB();
+		return result;
+	}
+
+	std::vector<std::string> WriteFiles(int count, UINT64 size)
+	{
+		std::vector<std::string> files;
+		std::vector<BYTE> bytes((size_t)size);
+		for (int f = 0; f < count; ++f)
+		{
+			for (size_t i = 0; i < bytes.size(); ++i)
+				bytes[i] = (BYTE)(i * 131 + f * 7 + (i >> 12));
+
+			files.push_back("MappedFileBenchmark" + std::to_string(f) + ".bin");
+			std::ofstream fout(files.back(), std::ios::binary | std::ios::trunc);
+			fout.write((const char*)bytes.data(), (std::streamsize)bytes.size());
+		}
+		return files;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int fileCount = argc > 1 ? max(1, atoi(argv[1])) : 16;
+	const UINT64 size = (argc > 2 ? max(1, atoi(argv[2])) : 4) * (1ull << 20);
+	const double totalMB = fileCount * (double)size / (1 << 20);
+
+	std::vector<std::string> files = WriteFiles(fileCount, size);
+
+	// the upload heap is there before and after either way
+	std::vector<BYTE> upload((size_t)size, 1);
+
+	std::printf("%d files of %.0f MB\n", fileCount, (double)size / (1 << 20));
+	for (bool batch : { false, true })
+	{
+		// once each to warm up, then the measured runs
+		Run(files, LoadCopy, batch, upload);
+		Run(files, LoadMapped, batch, upload);
+
+		Result copied = Run(files, LoadCopy, batch, upload);
+		Result mapped = Run(files, LoadMapped, batch, upload);
+		CHECK(copied.Checksum == mapped.Checksum);
+
+		std::printf("%s:\n", batch ? "as a batch" : "one by one");
+		for (const Result* r : { &copied, &mapped })
+		{
+			std::printf("  %-7s %7.2f ms, %6.0f MB/s, peak private +%6.1f MB, peak resident +%6.1f MB\n",
+				r == &copied ? "read" : "mapped", r->Seconds * 1e3, totalMB / r->Seconds,
+				r->PrivateMB, r->ResidentMB);
+		}
+
+		// the heap copies are private, the mapping is not
+		if (batch)
+			CHECK(mapped.PrivateMB < 0.25 * copied.PrivateMB);
+	}
+
+	for (const std::string& file : files)
+		std::remove(file.c_str());
+
+	return CheckResult();
+}
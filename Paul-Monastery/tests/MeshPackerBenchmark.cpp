@@ -0,0 +1,339 @@
+// Measures what MeshPacker::Pack saves over the way Church, Sky and Fixed
+// built their geometry before it: heap allocations, bytes allocated and time
+// to pack the church's LOD chains and the sky sphere into one vertex and one
+// index buffer. The old path converted the generator vertices into a
+// std::vector<Vertex>, concatenated GetIndices16() copies into a 16-bit index
+// vector, copied both into the CPU blobs and worked out the submesh offsets
+// and bounds by hand. Both must produce the same bytes and submeshes.
+//
+// Pack also works out each submesh's texture coordinate density for texture
+// streaming, which the old build did not; its share is timed on its own.
+//
+// Every run starts from fresh copies of the generated meshes, made outside
+// the measurement, since GetIndices16 caches its copy in the MeshData. The
+// counts come from replacing the global operator new.
+//
+//   MeshPackerBenchmark [runs]
+//
+// Builds with the app's portable sources; DXMATH is a directory with the
+// DirectXMath headers and the sal.h they need elsewhere than on Windows,
+// e.g. vcpkg's installed/x64-linux/include after installing directxmath:
+//   g++ -O2 -std=c++17 -I$DXMATH -I../include -I../src MeshPackerBenchmark.cpp ../src/GeometryGenerator.cpp ../src/MeshPacker.cpp -o MeshPackerBenchmark
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src MeshPackerBenchmark.cpp ..\src\GeometryGenerator.cpp ..\src\MeshPacker.cpp
+
+#include "platform.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+#include <d3dUtil.h>
+#include <GeometryGenerator.h>
+#include <FrameResource.h>
+#include <MeshPacker.h>
+
+#include "Check.h"
+
+using namespace DirectX;
+
+namespace
+{
+	bool Counting = false;
+	UINT64 Allocations = 0;
+	UINT64 AllocatedBytes = 0;
+}
+
+namespace
+{
+	void* CountedAlloc(size_t size) noexcept
+	{
+		if (Counting)
+		{
+			Allocations++;
+			AllocatedBytes += size;
+		}
+		return std::malloc(size ? size : 1);
+	}
+
+	// kept out of line so GCC does not pair the free with the new it inlines
+	// the deletes into and warn about a mismatch
+#if defined(__GNUC__)
+	__attribute__((noinline))
+#endif
+	void CountedFree(void* p) noexcept
+	{
+		std::free(p);
+	}
+}
+
+// every form of new and delete goes through malloc and free
+void* operator new(size_t size)
+{
+	if (void* p = CountedAlloc(size))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+	if (void* p = CountedAlloc(size))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAlloc(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	CountedFree(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	CountedFree(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	CountedFree(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	CountedFree(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+	CountedFree(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+	CountedFree(p);
+}
+
+namespace
+{
+	using MeshData = GeometryGenerator::MeshData;
+
+	struct Named
+	{
+		std::string Name;
+		MeshData Mesh;
+		float GeometricError;
+	};
+
+	// what Church::BuildGeometry and Sky::BuildGeometry generate
+	std::vector<Named> SceneMeshes()
+	{
+		GeometryGenerator geoGen;
+		std::vector<Named> meshes;
+
+		auto addLods = [&](const std::string& name, const GeometryGenerator::LodChain& chain) {
+			for (size_t level = 0; level < chain.Levels.size(); ++level)
+			{
+				std::string levelName = level == 0 ? name : name + "_lod" + std::to_string(level);
+				meshes.push_back({ levelName, chain.Levels[level], chain.Errors[level] });
+			}
+		};
+
+		addLods("block", geoGen.CreateCylinderLods(5.0f, 0.3f, 0.0f, XM_2PI / 40, 4, 4, 4));
+		addLods("dome", geoGen.CreateDomeLods(3.5f, XM_PIDIV2, 50, 50, 4));
+		addLods("roofRing", geoGen.CreateRingLods(5.0f, 1.5f, 0.0f, XM_2PI, 50, 4, 4));
+		addLods("domeSector", geoGen.CreateSectorLods(4.0f, 0.5f, 0.0f, XM_PIDIV2, 0.5f, 50, 2, 2, 4));
+		meshes.push_back({ "sphere", geoGen.CreateSphere(0.2f, 50, 50), 0.0f });
+
+		for (Named& named : meshes)
+			geoGen.Optimize(named.Mesh);
+		return meshes;
+	}
+
+	// The build before MeshPacker, for any number of submeshes.
+	std::unique_ptr<MeshGeometry> PackLegacy(std::vector<Named>& meshes)
+	{
+		size_t totalSize = 0;
+		for (const Named& named : meshes)
+			totalSize += named.Mesh.Vertices.size();
+		std::vector<Vertex> vertices(totalSize);
+
+		UINT k = 0;
+		for (const Named& named : meshes)
+		{
+			for (size_t i = 0; i < named.Mesh.Vertices.size(); ++i, ++k)
+			{
+				vertices[k].Pos = named.Mesh.Vertices[i].Position;
+				vertices[k].Normal = named.Mesh.Vertices[i].Normal;
+				vertices[k].TexC = named.Mesh.Vertices[i].TexC;
+			}
+		}
+		const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
+
+		std::vector<std::uint16_t> indices;
+		for (Named& named : meshes)
+			indices.insert(indices.end(), std::begin(named.Mesh.GetIndices16()), std::end(named.Mesh.GetIndices16()));
+		const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
+
+		auto geo = std::make_unique<MeshGeometry>();
+		geo->Name = "sceneGeo";
+
+		// D3DCreateBlob and CopyMemory
+		geo->VertexBufferCPU.resize(vbByteSize);
+		std::memcpy(geo->VertexBufferCPU.data(), vertices.data(), vbByteSize);
+		geo->IndexBufferCPU.resize(ibByteSize);
+		std::memcpy(geo->IndexBufferCPU.data(), indices.data(), ibByteSize);
+
+		geo->VertexByteStride = sizeof(Vertex);
+		geo->VertexBufferByteSize = vbByteSize;
+		geo->IndexFormat = DXGI_FORMAT_R16_UINT;
+		geo->IndexBufferByteSize = ibByteSize;
+
+		UINT vertexOffset = 0;
+		UINT indexOffset = 0;
+		for (const Named& named : meshes)
+		{
+			SubmeshGeometry submesh;
+			submesh.IndexCount = (UINT)named.Mesh.Indices32.size();
+			submesh.StartIndexLocation = indexOffset;
+			submesh.BaseVertexLocation = (INT)vertexOffset;
+			submesh.GeometricError = named.GeometricError;
+			BoundingBox::CreateFromPoints(submesh.Bounds, named.Mesh.Vertices.size(),
+				&vertices[vertexOffset].Pos, sizeof(Vertex));
+
+			geo->DrawArgs[named.Name] = submesh;
+
+			vertexOffset += (UINT)named.Mesh.Vertices.size();
+			indexOffset += submesh.IndexCount;
+		}
+
+		return geo;
+	}
+
+	std::unique_ptr<MeshGeometry> PackMeshPacker(std::vector<Named>& meshes)
+	{
+		MeshPacker packer;
+		for (const Named& named : meshes)
+			packer.Add(named.Name, named.Mesh, named.GeometricError);
+		return packer.Pack("sceneGeo");
+	}
+
+	// the density pass on its own
+	struct UvDensityPass : MeshPacker
+	{
+		static float Run(const std::vector<Named>& meshes)
+		{
+			float sum = 0.0f;
+			for (const Named& named : meshes)
+				sum += UvDensity(named.Mesh);
+			return sum;
+		}
+	};
+
+	bool Same(const MeshGeometry& a, const MeshGeometry& b)
+	{
+		if (a.VertexBufferCPU != b.VertexBufferCPU || a.IndexBufferCPU != b.IndexBufferCPU ||
+			a.IndexFormat != b.IndexFormat || a.DrawArgs.size() != b.DrawArgs.size())
+			return false;
+
+		for (const auto& e : a.DrawArgs)
+		{
+			auto it = b.DrawArgs.find(e.first);
+			if (it == b.DrawArgs.end())
+				return false;
+
+			const SubmeshGeometry& s = e.second;
+			const SubmeshGeometry& t = it->second;
+			if (s.IndexCount != t.IndexCount || s.StartIndexLocation != t.StartIndexLocation ||
+				s.BaseVertexLocation != t.BaseVertexLocation || s.GeometricError != t.GeometricError ||
+				std::memcmp(&s.Bounds.Center, &t.Bounds.Center, sizeof(XMFLOAT3)) != 0 ||
+				std::memcmp(&s.Bounds.Extents, &t.Bounds.Extents, sizeof(XMFLOAT3)) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	struct Result
+	{
+		double Seconds = 1e30;
+		UINT64 Allocations = 0;
+		UINT64 Bytes = 0;
+		std::unique_ptr<MeshGeometry> Geo;
+	};
+
+	Result Measure(const std::vector<Named>& generated, int runs,
+		std::unique_ptr<MeshGeometry> (*pack)(std::vector<Named>&))
+	{
+		Result result;
+		for (int run = 0; run < runs; ++run)
+		{
+			std::vector<Named> meshes = generated;
+
+			Allocations = 0;
+			AllocatedBytes = 0;
+			Counting = true;
+			auto start = std::chrono::steady_clock::now();
+			std::unique_ptr<MeshGeometry> geo = pack(meshes);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			Counting = false;
+
+			result.Seconds = min(result.Seconds, seconds);
+			result.Allocations = Allocations;
+			result.Bytes = AllocatedBytes;
+			result.Geo = std::move(geo);
+		}
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int runs = argc > 1 ? max(1, atoi(argv[1])) : 200;
+
+	std::vector<Named> meshes = SceneMeshes();
+
+	size_t vertexCount = 0;
+	size_t indexCount = 0;
+	for (const Named& named : meshes)
+	{
+		vertexCount += named.Mesh.Vertices.size();
+		indexCount += named.Mesh.Indices32.size();
+	}
+
+	Result legacy = Measure(meshes, runs, PackLegacy);
+	Result packed = Measure(meshes, runs, PackMeshPacker);
+
+	double densitySeconds = 1e30;
+	float density = 0.0f;
+	for (int run = 0; run < runs; ++run)
+	{
+		auto start = std::chrono::steady_clock::now();
+		density += UvDensityPass::Run(meshes);
+		densitySeconds = min(densitySeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+	CHECK(density > 0.0f);
+
+	CHECK(Same(*legacy.Geo, *packed.Geo));
+	CHECK(packed.Geo->VertexBufferCPU.size() == vertexCount * sizeof(Vertex));
+	CHECK(packed.Geo->IndexBufferCPU.size() == indexCount * sizeof(std::uint16_t));
+	CHECK(packed.Allocations < legacy.Allocations);
+	CHECK(packed.Bytes < legacy.Bytes);
+
+	std::printf("%zu submeshes, %zu vertices, %zu indices, %zu KB packed, best of %d runs\n",
+		meshes.size(), vertexCount, indexCount,
+		(packed.Geo->VertexBufferCPU.size() + packed.Geo->IndexBufferCPU.size()) / 1024, runs);
+	std::printf("before MeshPacker: %8.1f us, %4llu allocations, %7llu KB allocated\n",
+		legacy.Seconds * 1e6, (unsigned long long)legacy.Allocations, (unsigned long long)legacy.Bytes / 1024);
+	std::printf("MeshPacker::Pack:  %8.1f us, %4llu allocations, %7llu KB allocated\n",
+		packed.Seconds * 1e6, (unsigned long long)packed.Allocations, (unsigned long long)packed.Bytes / 1024);
+	std::printf("UV density alone:  %8.1f us\n", densitySeconds * 1e6);
+
+	return CheckResult();
+}
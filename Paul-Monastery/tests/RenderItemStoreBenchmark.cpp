@@ -0,0 +1,289 @@
+// Times the per-frame walks over the render items in RenderItemStore's
+// arrays against the layout it replaced: a std::vector of
+// std::unique_ptr<RenderItem>, each item a heap block with both transforms,
+// the bounds, the mesh and material pointers and the draw arguments. The
+// old items are allocated one by one with other small allocations in
+// between, as the scene build did with the names and meshes it created.
+//
+// The walks are the ones GraphicsWindow does every frame:
+//   cull      bounds against the six frustum planes
+//   constants both transforms transposed into the mapped object constants
+//   keys      material, geometry and depth of the visible items into draw keys
+// For 10k, 100k and 1M items; both layouts must give the same results.
+//
+//   RenderItemStoreBenchmark [frames]
+//
+// Builds with the app's portable sources; DXMATH is a directory with the
+// DirectXMath headers and the sal.h they need elsewhere than on Windows,
+// e.g. vcpkg's installed/x64-linux/include after installing directxmath:
+//   g++ -O2 -std=c++17 -I$DXMATH -I../include -I../src RenderItemStoreBenchmark.cpp ../src/RenderItemStore.cpp ../src/DirtyList.cpp ../src/DrawKey.cpp -o RenderItemStoreBenchmark
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src RenderItemStoreBenchmark.cpp ..\src\RenderItemStore.cpp ..\src\DirtyList.cpp ..\src\DrawKey.cpp
+
+#include "platform.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+#include <d3dUtil.h>
+#include <FrameResource.h>
+#include <RenderItemStore.h>
+#include <DrawKey.h>
+
+#include "Check.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT GeometryCount = 4;
+	const UINT MaterialCount = 8;
+	const float FarZ = 1000.0f;
+
+	// RenderItem before RenderItemStore
+	struct OldRenderItem
+	{
+		XMFLOAT4X4 World = MathHelper::Identity4x4();
+		XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
+
+		int NumFramesDirty = 3;
+		UINT ObjCBIndex = (UINT)-1;
+
+		MeshGeometry* Geo = nullptr;
+		Material* Mat = nullptr;
+
+		BoundingBox Bounds;
+
+		D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+
+		UINT IndexCount = 0;
+		UINT StartIndexLocation = 0;
+		int BaseVertexLocation = 0;
+	};
+
+	struct ObjectConstantsCopy
+	{
+		XMFLOAT4X4 World;
+		XMFLOAT4X4 TexTransform;
+	};
+
+	struct Scene
+	{
+		MeshGeometry Geometries[GeometryCount];
+		Material Materials[MaterialCount];
+
+		RenderItemStore Store;
+
+		std::vector<std::unique_ptr<OldRenderItem>> AllRitems;
+		std::vector<std::unique_ptr<char[]>> Interleaved;
+	};
+
+	void Build(Scene& scene, UINT itemCount)
+	{
+		for (UINT m = 0; m < MaterialCount; ++m)
+			scene.Materials[m].MatCBIndex = (int)m;
+
+		std::mt19937 rng(itemCount);
+		std::uniform_real_distribution<float> position(-400.0f, 400.0f);
+		std::uniform_int_distribution<size_t> interleaved(16, 256);
+
+		for (UINT i = 0; i < itemCount; ++i)
+		{
+			RenderItem ritem;
+			XMStoreFloat4x4(&ritem.World, XMMatrixTranslation(position(rng), position(rng) * 0.1f, position(rng)));
+			XMStoreFloat4x4(&ritem.TexTransform, XMMatrixScaling(2.0f, 2.0f, 1.0f));
+			ritem.Geo = &scene.Geometries[i % GeometryCount];
+			ritem.Mat = &scene.Materials[(i / 3) % MaterialCount];
+			ritem.Bounds = BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 2.0f, 1.0f));
+			ritem.IndexCount = 36;
+			RenderItemHandle handle = scene.Store.Add(RenderLayer::Opaque, ritem);
+
+			// the old items kept their world bounds in Bounds
+			auto old = std::make_unique<OldRenderItem>();
+			old->World = ritem.World;
+			old->TexTransform = ritem.TexTransform;
+			old->ObjCBIndex = i;
+			old->Geo = ritem.Geo;
+			old->Mat = ritem.Mat;
+			old->Bounds = scene.Store.WorldBounds()[scene.Store.IndexOf(handle)];
+			old->IndexCount = ritem.IndexCount;
+			scene.AllRitems.push_back(std::move(old));
+
+			scene.Interleaved.push_back(std::make_unique<char[]>(interleaved(rng)));
+		}
+	}
+
+	struct Frustum
+	{
+		XMFLOAT4 Planes[6];
+		XMFLOAT4X4 View;
+	};
+
+	// the app's start camera, planes pointing inwards
+	Frustum MakeFrustum()
+	{
+		XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 30.0f, -200.0f, 1.0f), XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * XM_PI, 4.0f / 3.0f, 1.0f, FarZ);
+		XMFLOAT4X4 m;
+		XMStoreFloat4x4(&m, XMMatrixMultiply(view, proj));
+
+		Frustum frustum;
+		XMStoreFloat4x4(&frustum.View, view);
+		XMVECTOR c0 = XMVectorSet(m._11, m._21, m._31, m._41);
+		XMVECTOR c1 = XMVectorSet(m._12, m._22, m._32, m._42);
+		XMVECTOR c2 = XMVectorSet(m._13, m._23, m._33, m._43);
+		XMVECTOR c3 = XMVectorSet(m._14, m._24, m._34, m._44);
+		XMVECTOR planes[6] = { c3 + c0, c3 - c0, c3 + c1, c3 - c1, c2, c3 - c2 };
+		for (int p = 0; p < 6; ++p)
+			XMStoreFloat4(&frustum.Planes[p], XMPlaneNormalize(planes[p]));
+		return frustum;
+	}
+
+	bool Visible(const Frustum& frustum, const BoundingBox& b)
+	{
+		for (const XMFLOAT4& p : frustum.Planes)
+		{
+			float distance = p.x * b.Center.x + p.y * b.Center.y + p.z * b.Center.z + p.w;
+			float radius = fabsf(p.x) * b.Extents.x + fabsf(p.y) * b.Extents.y + fabsf(p.z) * b.Extents.z;
+			if (distance + radius < 0.0f)
+				return false;
+		}
+		return true;
+	}
+
+	UINT64 MakeKey(const Frustum& frustum, const BoundingBox& b, UINT geometry, UINT material, UINT index)
+	{
+		const XMFLOAT4X4& v = frustum.View;
+		float viewZ = b.Center.x * v._13 + b.Center.y * v._23 + b.Center.z * v._33 + v._43;
+		return DrawKey::Make((UINT)RenderLayer::Opaque, 0, geometry, material, DrawKey::DepthBucket(viewZ, FarZ), index);
+	}
+
+	void StoreConstants(ObjectConstantsCopy& dst, const XMFLOAT4X4& world, const XMFLOAT4X4& texTransform)
+	{
+		XMStoreFloat4x4(&dst.World, XMMatrixTranspose(XMLoadFloat4x4(&world)));
+		XMStoreFloat4x4(&dst.TexTransform, XMMatrixTranspose(XMLoadFloat4x4(&texTransform)));
+	}
+
+	struct Output
+	{
+		std::vector<UINT> Visible;
+		std::vector<ObjectConstantsCopy> Constants;
+		std::vector<UINT64> Keys;
+	};
+
+	struct Times
+	{
+		double Cull = 1e30;
+		double Constants = 1e30;
+		double Keys = 1e30;
+	};
+
+	typedef std::chrono::steady_clock Clock;
+
+	double Seconds(Clock::time_point start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	void FrameOld(const Scene& scene, const Frustum& frustum, Output& out, Times& times)
+	{
+		auto start = Clock::now();
+		out.Visible.clear();
+		for (UINT i = 0; i < (UINT)scene.AllRitems.size(); ++i)
+		{
+			if (Visible(frustum, scene.AllRitems[i]->Bounds))
+				out.Visible.push_back(i);
+		}
+		times.Cull = min(times.Cull, Seconds(start));
+
+		start = Clock::now();
+		for (const auto& e : scene.AllRitems)
+			StoreConstants(out.Constants[e->ObjCBIndex], e->World, e->TexTransform);
+		times.Constants = min(times.Constants, Seconds(start));
+
+		// the geometry ID is the mesh's place in the scene's table
+		start = Clock::now();
+		out.Keys.clear();
+		for (UINT i : out.Visible)
+		{
+			const OldRenderItem& e = *scene.AllRitems[i];
+			UINT geometry = (UINT)(e.Geo - scene.Geometries);
+			out.Keys.push_back(MakeKey(frustum, e.Bounds, geometry, (UINT)e.Mat->MatCBIndex, i));
+		}
+		times.Keys = min(times.Keys, Seconds(start));
+	}
+
+	void FrameStore(const Scene& scene, const Frustum& frustum, Output& out, Times& times)
+	{
+		const RenderItemStore& store = scene.Store;
+		const auto& worldBounds = store.WorldBounds();
+
+		auto start = Clock::now();
+		out.Visible.clear();
+		for (UINT i = 0; i < store.Size(); ++i)
+		{
+			if (Visible(frustum, worldBounds[i]))
+				out.Visible.push_back(i);
+		}
+		times.Cull = min(times.Cull, Seconds(start));
+
+		start = Clock::now();
+		const auto& world = store.World();
+		const auto& texTransform = store.TexTransform();
+		for (UINT i = 0; i < store.Size(); ++i)
+			StoreConstants(out.Constants[i], world[i], texTransform[i]);
+		times.Constants = min(times.Constants, Seconds(start));
+
+		start = Clock::now();
+		out.Keys.clear();
+		const auto& geometryIds = store.GeometryIds();
+		const auto& materialIds = store.MaterialIds();
+		for (UINT i : out.Visible)
+			out.Keys.push_back(MakeKey(frustum, worldBounds[i], geometryIds[i], materialIds[i], i));
+		times.Keys = min(times.Keys, Seconds(start));
+	}
+
+	void Report(const char* name, const Times& times, UINT itemCount, size_t visibleCount)
+	{
+		std::printf("  %-16s cull %7.2f ns, constants %7.2f ns, keys %7.2f ns per item\n", name,
+			times.Cull * 1e9 / itemCount, times.Constants * 1e9 / itemCount, times.Keys * 1e9 / max<size_t>(1, visibleCount));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int frames = argc > 1 ? max(1, atoi(argv[1])) : 20;
+	const Frustum frustum = MakeFrustum();
+
+	for (UINT itemCount : { 10000u, 100000u, 1000000u })
+	{
+		Scene scene;
+		Build(scene, itemCount);
+
+		// geometries get their IDs in order of first use, which is their order here
+		CHECK(scene.Store.GeometryIds()[1] == 1);
+
+		Output oldOut, storeOut;
+		oldOut.Constants.resize(itemCount);
+		storeOut.Constants.resize(itemCount);
+
+		Times oldTimes, storeTimes;
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			FrameOld(scene, frustum, oldOut, oldTimes);
+			FrameStore(scene, frustum, storeOut, storeTimes);
+		}
+
+		CHECK(oldOut.Visible == storeOut.Visible);
+		CHECK(oldOut.Keys == storeOut.Keys);
+		CHECK(std::memcmp(oldOut.Constants.data(), storeOut.Constants.data(), itemCount * sizeof(ObjectConstantsCopy)) == 0);
+
+		std::printf("%7u items, %zu visible, best of %d frames:\n", itemCount, storeOut.Visible.size(), frames);
+		Report("unique_ptr items", oldTimes, itemCount, oldOut.Visible.size());
+		Report("RenderItemStore", storeTimes, itemCount, storeOut.Visible.size());
+		std::printf("  store speedup    cull %.2fx, constants %.2fx, keys %.2fx\n",
+			oldTimes.Cull / storeTimes.Cull, oldTimes.Constants / storeTimes.Constants, oldTimes.Keys / storeTimes.Keys);
+	}
+
+	return CheckResult();
+}
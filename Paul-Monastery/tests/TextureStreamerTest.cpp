@@ -0,0 +1,269 @@
+// Tests the TextureStreamer policy against a fake TextureStreamingDevice:
+// the budget cap, least recently used eviction, MipForDensity, and the
+// rollback after the device fails to change a texture's residency.
+//
+// Builds on its own with the app's portable sources:
+//   g++ -O2 -std=c++17 -I../include -I../src TextureStreamerTest.cpp ../src/TextureStreamer.cpp -o TextureStreamerTest
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src TextureStreamerTest.cpp ..\src\TextureStreamer.cpp
+
+#include "platform.h"
+
+#include <limits>
+
+#include <TextureStreamer.h>
+
+#include "Check.h"
+
+namespace
+{
+	// Keeps the first resident mip of every texture as the renderer would,
+	// and can be told to refuse changes.
+	class FakeDevice : public TextureStreamingDevice
+	{
+	public:
+		bool SetFirstResidentMip(UINT texture, UINT firstMip) override
+		{
+			if (Fail)
+				return false;
+
+			if (texture >= FirstMips.size())
+				FirstMips.resize(texture + 1, UINT_MAX);
+
+			FirstMips[texture] = firstMip;
+			return true;
+		}
+
+		std::vector<UINT> FirstMips;
+		bool Fail = false;
+	};
+
+	// 4 bytes per texel, every mip down to 1x1
+	TextureStreamingDesc MakeDesc(UINT width, UINT height)
+	{
+		TextureStreamingDesc desc;
+		desc.Width = width;
+		desc.Height = height;
+
+		for (;;)
+		{
+			desc.MipBytes.push_back((UINT64)width * height * 4);
+			if (width == 1 && height == 1)
+				break;
+
+			width = max(1u, width / 2);
+			height = max(1u, height / 2);
+		}
+		return desc;
+	}
+
+	// what the device holds, to compare with the streamer's bookkeeping
+	UINT64 DeviceBytes(const FakeDevice& device, const std::vector<TextureStreamingDesc>& descs)
+	{
+		UINT64 bytes = 0;
+		for (size_t t = 0; t < descs.size(); ++t)
+		{
+			for (size_t mip = device.FirstMips[t]; mip < descs[t].MipBytes.size(); ++mip)
+				bytes += descs[t].MipBytes[mip];
+		}
+		return bytes;
+	}
+
+	// uv units per pixel that make a size x size texture want the mip
+	float UvPerPixelForMip(UINT size, UINT mip)
+	{
+		return (float)(1u << mip) / (float)size;
+	}
+
+	void TestMipForDensity()
+	{
+		CHECK(TextureStreamer::MipForDensity(0.25f, 10) == 0);
+		CHECK(TextureStreamer::MipForDensity(1.0f, 10) == 0);
+		CHECK(TextureStreamer::MipForDensity(1.99f, 10) == 0);
+		CHECK(TextureStreamer::MipForDensity(2.0f, 10) == 1);
+		CHECK(TextureStreamer::MipForDensity(3.9f, 10) == 1);
+		CHECK(TextureStreamer::MipForDensity(4.0f, 10) == 2);
+		CHECK(TextureStreamer::MipForDensity(1e9f, 10) == 9);
+		CHECK(TextureStreamer::MipForDensity(std::numeric_limits<float>::quiet_NaN(), 10) == 0);
+	}
+
+	void TestTail()
+	{
+		TextureStreamer::Config config;
+		config.TailSize = 32;
+
+		TextureStreamer streamer(config);
+		FakeDevice device;
+
+		TextureStreamingDesc desc = MakeDesc(512, 256);
+		UINT id = streamer.Add(desc, device);
+
+		// 32x16 is the first mip within the tail size
+		CHECK(streamer.FirstResidentMip(id) == 4);
+		CHECK(device.FirstMips[id] == 4);
+		CHECK(streamer.ResidentBytes() == DeviceBytes(device, { desc }));
+
+		// a block-compressed texture cannot start below its last mip of 4x4 texels
+		TextureStreamingDesc capped = MakeDesc(512, 512);
+		capped.MaxFirstMip = 2;
+		UINT cappedId = streamer.Add(capped, device);
+		CHECK(streamer.FirstResidentMip(cappedId) == 2);
+	}
+
+	void TestBudgetCap()
+	{
+		TextureStreamer::Config config;
+		config.BudgetBytes = 1 << 20;
+		config.MaxLoadsPerUpdate = 4;
+
+		TextureStreamer streamer(config);
+		FakeDevice device;
+
+		std::vector<TextureStreamingDesc> descs = { MakeDesc(512, 512), MakeDesc(512, 512) };
+		UINT a = streamer.Add(descs[0], device);
+		UINT b = streamer.Add(descs[1], device);
+		UINT64 tailBytes = streamer.ResidentBytes();
+
+		UINT previous = streamer.FirstResidentMip(a);
+		for (int frame = 0; frame < 8; ++frame)
+		{
+			streamer.Request(a, UvPerPixelForMip(512, 0));
+			streamer.Update(device);
+
+			CHECK(streamer.ResidentBytes() <= streamer.Budget());
+			CHECK(streamer.ResidentBytes() == DeviceBytes(device, descs));
+			CHECK(device.FirstMips[a] == streamer.FirstResidentMip(a));
+
+			// no more than MaxLoadsPerUpdate levels per frame
+			CHECK(previous - streamer.FirstResidentMip(a) <= config.MaxLoadsPerUpdate);
+			previous = streamer.FirstResidentMip(a);
+		}
+
+		// mip 0 alone is the whole budget, so mip 1 is as far as it gets
+		CHECK(streamer.FirstResidentMip(a) == 1);
+		CHECK(streamer.WantedMip(a) == 0);
+		CHECK(streamer.FirstResidentMip(b) == 4);
+
+		// a lowered budget takes back what was streamed in, never the tails
+		streamer.SetBudget(tailBytes);
+		streamer.Request(a, UvPerPixelForMip(512, 0));
+		streamer.Update(device);
+		CHECK(streamer.FirstResidentMip(a) == 4);
+		CHECK(streamer.FirstResidentMip(b) == 4);
+		CHECK(streamer.ResidentBytes() == tailBytes);
+		CHECK(streamer.ResidentBytes() == DeviceBytes(device, descs));
+	}
+
+	void TestLruEviction()
+	{
+		// room for the tails and two textures at mip 1, not three
+		std::vector<TextureStreamingDesc> descs = { MakeDesc(256, 256), MakeDesc(256, 256), MakeDesc(256, 256) };
+
+		UINT64 tails = 0;
+		UINT64 toMip1 = 0;
+		for (UINT mip = 1; mip < 3; ++mip)
+			toMip1 += descs[0].MipBytes[mip];
+		for (UINT mip = 3; mip < descs[0].MipBytes.size(); ++mip)
+			tails += 3 * descs[0].MipBytes[mip];
+
+		TextureStreamer::Config config;
+		config.BudgetBytes = tails + 2 * toMip1 + 1000;
+		config.MaxLoadsPerUpdate = 16;
+
+		TextureStreamer streamer(config);
+		FakeDevice device;
+
+		UINT a = streamer.Add(descs[0], device);
+		UINT b = streamer.Add(descs[1], device);
+		UINT c = streamer.Add(descs[2], device);
+		CHECK(streamer.FirstResidentMip(a) == 3);
+
+		// a is used first, then b
+		for (int frame = 0; frame < 3; ++frame)
+		{
+			streamer.Request(a, UvPerPixelForMip(256, 1));
+			streamer.Update(device);
+		}
+		for (int frame = 0; frame < 3; ++frame)
+		{
+			streamer.Request(b, UvPerPixelForMip(256, 1));
+			streamer.Update(device);
+		}
+		CHECK(streamer.FirstResidentMip(a) == 1);
+		CHECK(streamer.FirstResidentMip(b) == 1);
+
+		// c needs the room of one of them: a, used longest ago, gives it up
+		for (int frame = 0; frame < 3; ++frame)
+		{
+			streamer.Request(c, UvPerPixelForMip(256, 1));
+			streamer.Update(device);
+		}
+		CHECK(streamer.FirstResidentMip(c) == 1);
+		CHECK(streamer.FirstResidentMip(b) == 1);
+		CHECK(streamer.FirstResidentMip(a) == 3);
+		CHECK(streamer.ResidentBytes() <= streamer.Budget());
+		CHECK(streamer.ResidentBytes() == DeviceBytes(device, descs));
+
+		// requested mips are never evicted for another texture
+		for (int frame = 0; frame < 3; ++frame)
+		{
+			streamer.Request(b, UvPerPixelForMip(256, 1));
+			streamer.Request(c, UvPerPixelForMip(256, 1));
+			streamer.Request(a, UvPerPixelForMip(256, 1));
+			streamer.Update(device);
+		}
+		CHECK(streamer.FirstResidentMip(b) == 1);
+		CHECK(streamer.FirstResidentMip(c) == 1);
+		CHECK(streamer.FirstResidentMip(a) == 3);
+	}
+
+	void TestRollback()
+	{
+		TextureStreamer::Config config;
+		config.BudgetBytes = 4 << 20;
+		config.MaxLoadsPerUpdate = 2;
+
+		TextureStreamer streamer(config);
+		FakeDevice device;
+
+		std::vector<TextureStreamingDesc> descs = { MakeDesc(512, 512) };
+		UINT a = streamer.Add(descs[0], device);
+
+		streamer.Request(a, UvPerPixelForMip(512, 0));
+		streamer.Update(device);
+		CHECK(streamer.FirstResidentMip(a) == 2);
+
+		// a load the device refuses leaves the residency it still has
+		device.Fail = true;
+		UINT64 bytes = streamer.ResidentBytes();
+		streamer.Request(a, UvPerPixelForMip(512, 0));
+		streamer.Update(device);
+		CHECK(streamer.FirstResidentMip(a) == 2);
+		CHECK(streamer.ResidentBytes() == bytes);
+
+		// so does a refused eviction
+		streamer.SetBudget(1000);
+		streamer.Update(device);
+		CHECK(streamer.FirstResidentMip(a) == 2);
+		CHECK(streamer.ResidentBytes() == bytes);
+		CHECK(streamer.ResidentBytes() == DeviceBytes(device, descs));
+
+		// and the next accepted change starts from there
+		device.Fail = false;
+		streamer.SetBudget(4 << 20);
+		streamer.Request(a, UvPerPixelForMip(512, 0));
+		streamer.Update(device);
+		CHECK(streamer.FirstResidentMip(a) == 0);
+		CHECK(streamer.ResidentBytes() == DeviceBytes(device, descs));
+	}
+}
+
+int main()
+{
+	TestMipForDensity();
+	TestTail();
+	TestBudgetCap();
+	TestLruEviction();
+	TestRollback();
+
+	return CheckResult();
+}
@@ -0,0 +1,177 @@
+// Tests UploadRing: placement and alignment, allocations that do not fit,
+// wrapping at the end of the ring, and frames in flight against a
+// SimulatedFence, where no allocation may overlap memory of a frame the
+// fence has not completed.
+//
+// Builds on its own with the app's portable sources:
+//   g++ -O2 -std=c++17 -I../include -I../src UploadRingTest.cpp ../src/UploadRing.cpp ../src/CommandRecorder.cpp -o UploadRingTest
+//   cl /O2 /EHsc /std:c++17 /I..\include /I..\src UploadRingTest.cpp ..\src\UploadRing.cpp ..\src\CommandRecorder.cpp
+
+#include "platform.h"
+
+#include <random>
+
+#include <UploadRing.h>
+#include <CommandRecorder.h>
+
+#include "Check.h"
+
+namespace
+{
+	void TestPlacement()
+	{
+		UploadRing ring(1024);
+		UINT64 offset = UINT64_MAX;
+
+		CHECK(ring.Allocate(100, 16, 1, offset) && offset == 0);
+		CHECK(ring.Allocate(100, 256, 1, offset) && offset == 256);
+		CHECK(ring.UsedBytes() == 356);
+
+		// the padding in front of an aligned allocation counts as used
+		CHECK(ring.Allocate(600, 4, 2, offset) && offset == 356);
+		CHECK(ring.UsedBytes() == 956);
+	}
+
+	void TestCapacity()
+	{
+		UploadRing ring(1024);
+		UINT64 offset = UINT64_MAX;
+
+		CHECK(!ring.Allocate(0, 16, 1, offset));
+		CHECK(!ring.Allocate(1025, 1, 1, offset));
+
+		// a failed allocation changes nothing
+		CHECK(ring.Allocate(1024, 512, 1, offset) && offset == 0);
+		CHECK(!ring.Allocate(1, 1, 1, offset));
+		CHECK(ring.UsedBytes() == ring.Capacity());
+
+		ring.Reclaim(1);
+		CHECK(ring.UsedBytes() == 0);
+		CHECK(ring.Allocate(512, 512, 2, offset) && offset == 0);
+		CHECK(ring.Allocate(512, 512, 2, offset) && offset == 512);
+		CHECK(ring.UsedBytes() == 1024);
+	}
+
+	void TestWrap()
+	{
+		UploadRing ring(1024);
+		UINT64 offset = UINT64_MAX;
+
+		CHECK(ring.Allocate(100, 16, 1, offset));
+		CHECK(ring.Allocate(100, 256, 1, offset));
+		CHECK(ring.Allocate(600, 4, 2, offset));
+		CHECK(!ring.Allocate(100, 16, 3, offset));
+
+		ring.Reclaim(0);
+		CHECK(ring.UsedBytes() == 956);
+		ring.Reclaim(1);
+		CHECK(ring.UsedBytes() == 600);
+
+		// 68 bytes are left at the end: 200 wrap to the front, and the end
+		// counts as used until the wrapped allocation is reclaimed
+		CHECK(ring.Allocate(200, 16, 3, offset) && offset == 0);
+		CHECK(ring.UsedBytes() == 600 + 68 + 200);
+
+		// 156 bytes up to fence 2's allocation at 356
+		CHECK(!ring.Allocate(200, 16, 3, offset));
+		CHECK(ring.Allocate(140, 16, 3, offset) && offset == 208);
+
+		ring.Reclaim(2);
+		CHECK(ring.UsedBytes() == 68 + 200 + 8 + 140);
+		ring.Reclaim(3);
+		CHECK(ring.UsedBytes() == 0);
+
+		// an empty ring starts over at the front instead of wrapping
+		CHECK(ring.Allocate(1000, 8, 4, offset) && offset == 0);
+		ring.Reclaim(4);
+		CHECK(ring.Allocate(1000, 8, 5, offset) && offset == 0);
+
+		// filling up to the end exactly leaves the head at the front
+		ring.Reclaim(5);
+		CHECK(ring.Allocate(24, 8, 6, offset) && offset == 0);
+		CHECK(ring.Allocate(1000, 8, 6, offset) && offset == 24);
+		CHECK(ring.UsedBytes() == 1024);
+		ring.Reclaim(6);
+		CHECK(ring.Allocate(8, 8, 7, offset) && offset == 0);
+	}
+
+	// Frames signal the fence when they are submitted; the GPU completes
+	// them up to three frames later. Every allocation is checked against
+	// the ones not yet completed.
+	void TestFramesInFlight()
+	{
+		struct Live
+		{
+			UINT64 Fence;
+			UINT64 Begin;
+			UINT64 End;
+		};
+
+		const UINT64 capacity = 128 * 1024;
+		UploadRing ring(capacity);
+		SimulatedFence fence;
+		std::deque<Live> live;
+		std::mt19937 rng(5);
+
+		UINT failed = 0;
+		UINT overlaps = 0;
+		UINT64 maxUsed = 0;
+		for (UINT64 frame = 1; frame <= 20000; ++frame)
+		{
+			// the GPU is one to three frames behind
+			UINT latency = 1 + rng() % 3;
+			fence.Complete(frame > latency ? frame - latency : 0);
+
+			ring.Reclaim(fence.CompletedValue());
+			while (!live.empty() && live.front().Fence <= fence.CompletedValue())
+				live.pop_front();
+
+			UINT count = 1 + rng() % 24;
+			for (UINT i = 0; i < count; ++i)
+			{
+				UINT64 size = 1 + rng() % 4096;
+				UINT64 alignment = 1ull << (rng() % 9);
+
+				UINT64 offset = 0;
+				if (!ring.Allocate(size, alignment, frame, offset))
+				{
+					// only a ring with frames in flight may refuse, the GPU frees it
+					failed++;
+					CHECK(!live.empty());
+					continue;
+				}
+
+				CHECK(offset % alignment == 0);
+				CHECK(offset + size <= capacity);
+				for (const Live& other : live)
+					overlaps += offset < other.End && other.Begin < offset + size;
+
+				live.push_back({ frame, offset, offset + size });
+			}
+
+			maxUsed = max(maxUsed, ring.UsedBytes());
+			CHECK(ring.UsedBytes() <= capacity);
+			fence.Signal(frame);
+		}
+
+		CHECK(overlaps == 0);
+
+		// all frames done, all memory back
+		fence.Wait(20000);
+		ring.Reclaim(fence.CompletedValue());
+		CHECK(ring.UsedBytes() == 0);
+
+		std::printf("frames in flight: peak %.1f KB of %.0f KB used, %u allocations refused\n",
+			maxUsed / 1024.0, capacity / 1024.0, failed);
+	}
+}
+
+int main()
+{
+	TestPlacement();
+	TestCapacity();
+	TestWrap();
+	TestFramesInFlight();
+
+	return CheckResult();
+}
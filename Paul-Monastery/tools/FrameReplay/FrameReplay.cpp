@@ -0,0 +1,236 @@
+// Replays frames captured with F10 (FrameCapture.pmcap) on the recording
+// backend and reports CPU timings per phase:
+//   upload   the captured payloads are copied to their GPU addresses
+//   record   the draw sequence is re-issued to a RecordingCommandList
+//   resolve  every root CBV/SRV binding is looked up in the uploaded memory
+//            and its contents hashed, as the GPU would read them
+// The hash depends only on the capture, so runs can be compared.
+//
+//   FrameReplay [-n <iterations>] capture.pmcap
+//
+// Builds on its own with the app's portable sources:
+//   g++ -O2 -std=c++17 -I../../include -I../../src FrameReplay.cpp ../../src/FrameCapture.cpp ../../src/CommandRecorder.cpp -o FrameReplay
+//   cl /O2 /EHsc /std:c++17 /I..\..\include /I..\..\src FrameReplay.cpp ..\..\src\FrameCapture.cpp ..\..\src\CommandRecorder.cpp
+
+#include "platform.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include <FrameCapture.h>
+#include <CommandRecorder.h>
+
+namespace
+{
+	enum Phase { Upload, Record, Resolve, PhaseCount };
+	const char* const PhaseNames[PhaseCount] = { "upload", "record", "resolve" };
+
+	struct PhaseStats
+	{
+		double Total = 0.0;
+		double Min = 1e30;
+		double Max = 0.0;
+
+		void Add(double us)
+		{
+			Total += us;
+			Min = min(Min, us);
+			Max = max(Max, us);
+		}
+	};
+
+	// Upload memory of one frame: the captured ranges, sorted by address.
+	class ReplayMemory
+	{
+	public:
+		void Load(const CapturedFrame& frame)
+		{
+			_Ranges.clear();
+			_Memory.resize(frame.UploadData.size());
+
+			UINT64 offset = 0;
+			for (const CapturedUpload& upload : frame.Uploads)
+			{
+				memcpy(_Memory.data() + offset, frame.UploadData.data() + upload.Offset, (size_t)upload.Size);
+				_Ranges.push_back({ upload.Address, offset, upload.Size });
+				offset += upload.Size;
+			}
+
+			std::sort(_Ranges.begin(), _Ranges.end(), [](const CapturedUpload& a, const CapturedUpload& b) {
+				return a.Address < b.Address;
+			});
+		}
+
+		// Bytes from address to the end of the range holding it, nullptr if none does.
+		const BYTE* Find(RenderAddress address, UINT64& size) const
+		{
+			auto it = std::upper_bound(_Ranges.begin(), _Ranges.end(), address, [](RenderAddress a, const CapturedUpload& r) {
+				return a < r.Address;
+			});
+			if (it == _Ranges.begin())
+				return nullptr;
+
+			--it;
+			if (address >= it->Address + it->Size)
+				return nullptr;
+
+			size = it->Address + it->Size - address;
+			return _Memory.data() + it->Offset + (address - it->Address);
+		}
+
+	protected:
+		std::vector<BYTE> _Memory;
+		std::vector<CapturedUpload> _Ranges;
+	};
+
+	struct ResolveResult
+	{
+		UINT64 Hash = 1469598103934665603ull;
+		UINT Bindings = 0;
+		UINT Unresolved = 0;
+		UINT Draws = 0;
+		UINT64 Indices = 0;
+	};
+
+	void HashBytes(UINT64& hash, const BYTE* data, UINT64 size)
+	{
+		for (UINT64 i = 0; i < size; ++i)
+			hash = (hash ^ data[i]) * 1099511628211ull;
+	}
+
+	void ResolveFrame(const RecordingCommandList& cmdList, const ReplayMemory& memory, ResolveResult& result)
+	{
+		// a constant buffer view spans 256 bytes at most here
+		const UINT64 viewSize = 256;
+
+		CommandReader reader(cmdList.Stream());
+		RecordedCommand c;
+		while (reader.Next(c))
+		{
+			switch (c.Op)
+			{
+			case RecordedOp::SetGraphicsRootConstantBufferView:
+			case RecordedOp::SetGraphicsRootShaderResourceView:
+			{
+				result.Bindings++;
+
+				UINT64 size;
+				const BYTE* data = memory.Find(c.Address, size);
+				if (data == nullptr)
+					result.Unresolved++;
+				else
+					HashBytes(result.Hash, data, min(size, viewSize));
+				break;
+			}
+			case RecordedOp::DrawIndexedInstanced:
+				result.Draws++;
+				result.Indices += (UINT64)c.Args[0] * c.Args[1];
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	double Microseconds(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+	{
+		return std::chrono::duration<double, std::micro>(end - start).count();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	UINT iterations = 10;
+	const char* filename = nullptr;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			iterations = max(1, atoi(argv[++i]));
+		else
+			filename = argv[i];
+	}
+
+	if (filename == nullptr)
+	{
+		printf("usage: FrameReplay [-n iterations] capture.pmcap\n");
+		return 1;
+	}
+
+	FrameCapture capture;
+	if (!capture.Read(filename))
+	{
+		printf("%s: not a frame capture\n", filename);
+		return 1;
+	}
+
+	const std::vector<CapturedFrame>& frames = capture.Frames();
+	if (frames.empty())
+	{
+		printf("%s: no frames\n", filename);
+		return 1;
+	}
+
+	ReplayMemory memory;
+	RecordingCommandList cmdList;
+	PhaseStats stats[PhaseCount];
+	ResolveResult result;
+
+	for (UINT it = 0; it < iterations; ++it)
+	{
+		for (const CapturedFrame& frame : frames)
+		{
+			auto t0 = std::chrono::steady_clock::now();
+			memory.Load(frame);
+
+			auto t1 = std::chrono::steady_clock::now();
+			cmdList.Reset();
+			CommandReader(frame.Commands).Replay(cmdList);
+
+			auto t2 = std::chrono::steady_clock::now();
+			ResolveResult frameResult;
+			ResolveFrame(cmdList, memory, frameResult);
+
+			auto t3 = std::chrono::steady_clock::now();
+			stats[Upload].Add(Microseconds(t0, t1));
+			stats[Record].Add(Microseconds(t1, t2));
+			stats[Resolve].Add(Microseconds(t2, t3));
+
+			// the first pass over the frames stands for all of them
+			if (it == 0)
+			{
+				HashBytes(result.Hash, reinterpret_cast<const BYTE*>(&frameResult.Hash), sizeof(UINT64));
+				result.Bindings += frameResult.Bindings;
+				result.Unresolved += frameResult.Unresolved;
+				result.Draws += frameResult.Draws;
+				result.Indices += frameResult.Indices;
+			}
+		}
+	}
+
+	UINT64 uploadBytes = 0, commandBytes = 0;
+	for (const CapturedFrame& frame : frames)
+	{
+		uploadBytes += frame.UploadData.size();
+		commandBytes += frame.Commands.size();
+	}
+
+	const CapturedCamera& first = frames.front().Camera;
+	const CapturedCamera& last = frames.back().Camera;
+
+	printf("%s: %zu frames, %u iterations\n", filename, frames.size(), iterations);
+	printf("camera  theta %.3f -> %.3f, phi %.3f -> %.3f, radius %.2f -> %.2f\n",
+		first.Theta, last.Theta, first.Phi, last.Phi, first.Radius, last.Radius);
+	printf("per frame  %.1f draws, %.0f indices, %.1f KB uploaded, %.1f KB of commands\n",
+		(double)result.Draws / frames.size(), (double)result.Indices / frames.size(),
+		uploadBytes / 1024.0 / frames.size(), commandBytes / 1024.0 / frames.size());
+	printf("bindings %u, unresolved %u, hash %016llx\n", result.Bindings, result.Unresolved, (unsigned long long)result.Hash);
+
+	double samples = (double)iterations * frames.size();
+	printf("phase      mean us    min us    max us\n");
+	for (UINT p = 0; p < PhaseCount; ++p)
+		printf("%-8s %9.2f %9.2f %9.2f\n", PhaseNames[p], stats[p].Total / samples, stats[p].Min, stats[p].Max);
+
+	return result.Unresolved == 0 ? 0 : 2;
+}
@@ -0,0 +1,334 @@
+// Renders the monastery without a GPU: builds the scene as GraphicsWindow
+// does (geometry, materials, render items, level of detail, frustum culling,
+// sorted draw keys), draws it with the SoftwareRasterizer from the app's
+// start camera and writes the frame as a PPM. With -r the frame is compared
+// against a reference and the run fails if more than 1% of the pixels differ
+// by more than 8 in a channel, which leaves room for the odd edge pixel that
+// another compiler or math library rounds the other way. reference.ppm next
+// to this file is the default 320x240 view.
+//
+//   SceneRender [-s <width>x<height>] [-t <texture dir>] [-n <frames>] [-o out.ppm] [-r reference.ppm]
+//
+// -n renders the frame that many times and reports the time per frame.
+// Run from Paul-Monastery/, where Textures/ is, or pass -t.
+//
+// Builds with the app's portable sources; DXMATH is a directory with the
+// DirectXMath headers and the sal.h they need elsewhere than on Windows,
+// e.g. vcpkg's installed/x64-linux/include after installing directxmath:
+//   g++ -O2 -std=c++17 -pthread -I$DXMATH -I../../include -I../../src SceneRender.cpp ../../src/GeometryGenerator.cpp ../../src/MeshPacker.cpp ../../src/Church.cpp ../../src/Monastery.cpp ../../src/Sky.cpp ../../src/Fixed.cpp ../../src/SceneMaterials.cpp ../../src/RenderItemStore.cpp ../../src/InstanceGrouping.cpp ../../src/DirtyList.cpp ../../src/DrawKey.cpp ../../src/FrustumCuller.cpp ../../src/SoftwareRasterizer.cpp ../../src/LightingUtil.cpp ../../src/JobSystem.cpp ../../src/Profiler.cpp ../../src/MappedFile.cpp -o SceneRender
+//   cl /O2 /EHsc /std:c++17 /I..\..\include /I..\..\src SceneRender.cpp ..\..\src\GeometryGenerator.cpp ..\..\src\MeshPacker.cpp ..\..\src\Church.cpp ..\..\src\Monastery.cpp ..\..\src\Sky.cpp ..\..\src\Fixed.cpp ..\..\src\SceneMaterials.cpp ..\..\src\RenderItemStore.cpp ..\..\src\InstanceGrouping.cpp ..\..\src\DirtyList.cpp ..\..\src\DrawKey.cpp ..\..\src\FrustumCuller.cpp ..\..\src\SoftwareRasterizer.cpp ..\..\src\LightingUtil.cpp ..\..\src\JobSystem.cpp ..\..\src\Profiler.cpp ..\..\src\MappedFile.cpp
+
+#include "platform.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include <d3dUtil.h>
+#include <FrameResource.h>
+#include <GeometryGenerator.h>
+#include <RenderItemStore.h>
+#include <InstanceGrouping.h>
+#include <JobSystem.h>
+#include <FrustumCuller.h>
+#include <DrawKey.h>
+#include <SceneMaterials.h>
+#include <Sky.h>
+#include <Fixed.h>
+#include <Monastery.h>
+#include <SoftwareRasterizer.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// as in GraphicsWindow
+	const float LodMaxPixelError = 0.5f;
+	const float InstanceClusterSize = 10.0f;
+	const UINT MinInstances = 2;
+	const float StartTheta = 1.5f * XM_PI;
+	const float StartPhi = XM_PIDIV2 - 0.5f;
+	const float StartRadius = 30.0f;
+
+	// a channel may differ by this much
+	const int PixelTolerance = 8;
+
+	// and this fraction of the pixels by more
+	const double MaxDifferentPixels = 0.01;
+
+	struct Camera
+	{
+		XMFLOAT3 EyePos;
+		XMFLOAT4X4 View;
+		XMFLOAT4X4 Proj;
+		float PixelScale;
+		PassConstants Pass;
+	};
+
+	// GraphicsWindow::UpdateCamera, UpdateFixedCamera, OnResize and UpdateMainPassCB
+	Camera MakeCamera(float theta, float phi, float radius, UINT width, UINT height)
+	{
+		Camera camera;
+		camera.EyePos.x = radius * sinf(phi) * cosf(theta);
+		camera.EyePos.z = radius * sinf(phi) * sinf(theta);
+		camera.EyePos.y = radius * cosf(phi);
+
+		XMVECTOR pos = XMVectorSet(camera.EyePos.x, camera.EyePos.y, camera.EyePos.z, 1.0f);
+		XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+		XMMATRIX view = XMMatrixLookAtLH(pos, XMVectorSet(0.0f, 5.0f, 0.0f, 0.0f), up);
+		XMMATRIX fixedView = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, -1.0f, 1.0f), XMVectorZero(), up);
+		XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * XM_PI, (float)width / height, 1.0f, 1000.0f);
+
+		XMStoreFloat4x4(&camera.View, view);
+		XMStoreFloat4x4(&camera.Proj, proj);
+		camera.PixelScale = 0.5f * height * camera.Proj._22;
+
+		PassConstants& pass = camera.Pass;
+		XMStoreFloat4x4(&pass.View, XMMatrixTranspose(view));
+		XMStoreFloat4x4(&pass.Proj, XMMatrixTranspose(proj));
+		XMStoreFloat4x4(&pass.ViewProj, XMMatrixTranspose(XMMatrixMultiply(view, proj)));
+		XMStoreFloat4x4(&pass.FixedView, XMMatrixTranspose(fixedView));
+		pass.EyePosW = camera.EyePos;
+		pass.RenderTargetSize = XMFLOAT2((float)width, (float)height);
+		pass.InvRenderTargetSize = XMFLOAT2(1.0f / width, 1.0f / height);
+		pass.NearZ = 1.0f;
+		pass.FarZ = 1000.0f;
+		pass.AmbientLight = { 0.25f, 0.25f, 0.35f, 1.0f };
+		pass.Lights[0].Direction = { 0.57735f, -0.57735f, 0.57735f };
+		pass.Lights[0].Strength = { 0.8f, 0.8f, 0.8f };
+		pass.Lights[1].Direction = { -0.57735f, -0.57735f, 0.57735f };
+		pass.Lights[1].Strength = { 0.4f, 0.4f, 0.4f };
+		pass.Lights[2].Direction = { 0.0f, -0.707f, -0.707f };
+		pass.Lights[2].Strength = { 0.2f, 0.2f, 0.2f };
+		return camera;
+	}
+
+	struct Scene
+	{
+		std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> Geometries;
+		std::unordered_map<std::string, std::unique_ptr<Texture>> Textures;
+		std::unordered_map<std::string, std::unique_ptr<Material>> Materials;
+		std::vector<Material*> MaterialTable;
+		std::unordered_map<const Texture*, SoftwareTexture> SoftwareTextures;
+		RenderItemStore Ritems;
+		FrustumCuller LayerCullers[(int)RenderLayer::Count];
+	};
+
+	// GraphicsWindow::InitDirect3D without the device
+	bool BuildScene(Scene& scene, const std::wstring& textureDir, JobSystem& jobs)
+	{
+		for (const SceneMaterials::TextureFile& file : SceneMaterials::TextureFiles(textureDir))
+		{
+			auto tex = std::make_unique<Texture>();
+			tex->Name = file.Name;
+			tex->Filename = file.Filename;
+			if (!scene.SoftwareTextures[tex.get()].LoadDDS(tex->Filename))
+			{
+				std::fprintf(stderr, "cannot load texture %s\n", std::string(file.Filename.begin(), file.Filename.end()).c_str());
+				return false;
+			}
+			scene.Textures[file.Name] = std::move(tex);
+		}
+
+		Monastery monastery;
+		Sky::BuildGeometry(scene.Geometries);
+		Fixed::BuildGeometry(scene.Geometries);
+		monastery.BuildGeometry(scene.Geometries, jobs);
+
+		SceneMaterials::BuildMaterials(scene.Textures, scene.Materials, scene.MaterialTable);
+
+		Sky::BuildRenderItems(scene.Geometries, scene.Materials, scene.Ritems);
+		Fixed::BuildRenderItems(scene.Geometries, scene.Materials, scene.Ritems);
+		monastery.BuildRenderItems(scene.Geometries, scene.Materials, scene.Ritems);
+		InstanceGrouping::Group(scene.Ritems, RenderLayer::Opaque, scene.MaterialTable, InstanceClusterSize, MinInstances);
+
+		scene.LayerCullers[(int)RenderLayer::Opaque].Build(scene.Ritems, RenderLayer::Opaque);
+		scene.LayerCullers[(int)RenderLayer::Instanced].Build(scene.Ritems, RenderLayer::Instanced);
+		return true;
+	}
+
+	// GraphicsWindow::Render up to the draw keys: LODs, culling, sorting
+	void BuildDrawKeys(Scene& scene, const Camera& camera, JobSystem& jobs, std::vector<UINT64>& drawKeys)
+	{
+		scene.Ritems.SelectLods(camera.EyePos, camera.PixelScale, LodMaxPixelError);
+
+		XMMATRIX view = XMLoadFloat4x4(&camera.View);
+		XMFLOAT4X4 viewProj;
+		XMStoreFloat4x4(&viewProj, XMMatrixMultiply(view, XMLoadFloat4x4(&camera.Proj)));
+
+		std::vector<UINT> visible[(int)RenderLayer::Count];
+		visible[(int)RenderLayer::Sky] = scene.Ritems.Layer(RenderLayer::Sky);
+		visible[(int)RenderLayer::Fixed] = scene.Ritems.Layer(RenderLayer::Fixed);
+		scene.LayerCullers[(int)RenderLayer::Opaque].Cull(viewProj, visible[(int)RenderLayer::Opaque], &jobs);
+		scene.LayerCullers[(int)RenderLayer::Instanced].Cull(viewProj, visible[(int)RenderLayer::Instanced], &jobs);
+
+		const auto& worldBounds = scene.Ritems.WorldBounds();
+		const auto& geometryIds = scene.Ritems.GeometryIds();
+		const auto& materialIds = scene.Ritems.MaterialIds();
+
+		drawKeys.clear();
+		for (int layer = 0; layer < (int)RenderLayer::Count; ++layer)
+		{
+			bool depthSorted = layer == (int)RenderLayer::Opaque || layer == (int)RenderLayer::Instanced;
+			for (UINT index : visible[layer])
+			{
+				UINT depthBucket = 0;
+				if (depthSorted)
+				{
+					XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&worldBounds[index].Center), view);
+					depthBucket = DrawKey::DepthBucket(XMVectorGetZ(center), camera.Pass.FarZ);
+				}
+				drawKeys.push_back(DrawKey::Make(layer, layer, geometryIds[index], materialIds[index], depthBucket, index));
+			}
+		}
+
+		std::vector<UINT64> scratch;
+		DrawKey::Sort(drawKeys, scratch);
+	}
+
+	bool ReadPPM(const std::string& filename, UINT& width, UINT& height, std::vector<BYTE>& rgb)
+	{
+		std::ifstream fin(filename, std::ios::binary);
+		std::string magic;
+		int maxValue = 0;
+		if (!(fin >> magic >> width >> height >> maxValue) || magic != "P6" || maxValue != 255)
+			return false;
+		fin.get();
+
+		rgb.resize((size_t)width * height * 3);
+		return (bool)fin.read((char*)rgb.data(), (std::streamsize)rgb.size());
+	}
+
+	// Fraction of the pixels with a channel off by more than PixelTolerance.
+	bool Compare(const SoftwareRasterizer& rasterizer, const std::string& reference, double& different, double& meanError)
+	{
+		UINT width = 0, height = 0;
+		std::vector<BYTE> rgb;
+		if (!ReadPPM(reference, width, height, rgb))
+		{
+			std::fprintf(stderr, "cannot read reference %s\n", reference.c_str());
+			return false;
+		}
+		if (width != rasterizer.Width() || height != rasterizer.Height())
+		{
+			std::fprintf(stderr, "reference is %ux%u, the frame %ux%u\n", width, height, rasterizer.Width(), rasterizer.Height());
+			return false;
+		}
+
+		UINT64 differentCount = 0;
+		UINT64 errorSum = 0;
+		for (size_t i = 0; i < rasterizer.ColorBuffer().size(); ++i)
+		{
+			std::uint32_t c = rasterizer.ColorBuffer()[i];
+			int worst = 0;
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				int error = abs((int)((c >> (8 * channel)) & 0xFF) - (int)rgb[i * 3 + channel]);
+				worst = max(worst, error);
+				errorSum += error;
+			}
+			differentCount += worst > PixelTolerance;
+		}
+
+		different = (double)differentCount / rasterizer.ColorBuffer().size();
+		meanError = (double)errorSum / rgb.size();
+		return true;
+	}
+
+	void Usage()
+	{
+		std::fprintf(stderr, "usage: SceneRender [-s <width>x<height>] [-t <texture dir>] [-n <frames>] [-o out.ppm] [-r reference.ppm]\n");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	UINT width = 320;
+	UINT height = 240;
+	std::string textureDir = "Textures/";
+	std::string output = "SceneRender.ppm";
+	std::string reference;
+	int frames = 1;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (i + 1 >= argc)
+		{
+			Usage();
+			return 1;
+		}
+
+		if (arg == "-s" && std::sscanf(argv[i + 1], "%ux%u", &width, &height) == 2 && width > 0 && height > 0)
+			++i;
+		else if (arg == "-t")
+			textureDir = argv[++i];
+		else if (arg == "-n" && (frames = atoi(argv[i + 1])) > 0)
+			++i;
+		else if (arg == "-o")
+			output = argv[++i];
+		else if (arg == "-r")
+			reference = argv[++i];
+		else
+		{
+			Usage();
+			return 1;
+		}
+	}
+
+	if (textureDir.back() != '/' && textureDir.back() != '\\')
+		textureDir += '/';
+
+	JobSystem jobs;
+	Scene scene;
+
+	auto start = std::chrono::steady_clock::now();
+	if (!BuildScene(scene, std::wstring(textureDir.begin(), textureDir.end()), jobs))
+		return 1;
+	double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	Camera camera = MakeCamera(StartTheta, StartPhi, StartRadius, width, height);
+
+	SoftwareRasterizer rasterizer(jobs);
+	rasterizer.Resize(width, height);
+
+	std::vector<UINT64> drawKeys;
+	double best = 1e30;
+	double total = 0.0;
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		start = std::chrono::steady_clock::now();
+		BuildDrawKeys(scene, camera, jobs, drawKeys);
+		rasterizer.Render(scene.Ritems, drawKeys, scene.MaterialTable, scene.SoftwareTextures, camera.Pass);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		best = min(best, seconds);
+		total += seconds;
+	}
+
+	std::printf("scene built in %.1f ms, %u items, %u instances, %zu draws\n",
+		buildSeconds * 1e3, scene.Ritems.Size(), scene.Ritems.InstanceCount(), drawKeys.size());
+	std::printf("%ux%u frame in %.2f ms (best of %d, mean %.2f ms)\n", width, height, best * 1e3, frames, total * 1e3 / frames);
+
+	if (!rasterizer.WritePPM(output))
+	{
+		std::fprintf(stderr, "cannot write %s\n", output.c_str());
+		return 1;
+	}
+
+	if (!reference.empty())
+	{
+		double different = 0.0;
+		double meanError = 0.0;
+		if (!Compare(rasterizer, reference, different, meanError))
+			return 1;
+
+		bool match = different <= MaxDifferentPixels;
+		std::printf("%s reference: %.3f%% of the pixels differ by more than %d, mean channel error %.3f\n",
+			match ? "matches" : "DIFFERS FROM", different * 100.0, PixelTolerance, meanError);
+		if (!match)
+			return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,729 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BC_USE_SSE 1
+#endif
+
+#include "Image.h"
+#include "BlockCompressor.h"
+
+namespace
+{
+	// Principal axis of the block by power iteration on the covariance matrix.
+	// Returns the mean in mean and the axis in axis, both with n channels.
+	template <int N>
+	void PrincipalAxis(const float (*texels)[4], float* mean, float* axis)
+	{
+		for (int c = 0; c < N; ++c)
+		{
+			mean[c] = 0.0f;
+			for (int i = 0; i < 16; ++i)
+				mean[c] += texels[i][c];
+			mean[c] /= 16.0f;
+		}
+
+		float cov[N][N] = {};
+		for (int i = 0; i < 16; ++i)
+		{
+			float d[N];
+			for (int c = 0; c < N; ++c)
+				d[c] = texels[i][c] - mean[c];
+			for (int r = 0; r < N; ++r)
+			{
+				for (int c = 0; c < N; ++c)
+					cov[r][c] += d[r] * d[c];
+			}
+		}
+
+		for (int c = 0; c < N; ++c)
+			axis[c] = 1.0f;
+
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			float next[N] = {};
+			float length = 0.0f;
+			for (int r = 0; r < N; ++r)
+			{
+				for (int c = 0; c < N; ++c)
+					next[r] += cov[r][c] * axis[c];
+				length = std::max(length, std::fabs(next[r]));
+			}
+
+			// flat block, any axis will do
+			if (length < 1e-6f)
+				break;
+
+			for (int c = 0; c < N; ++c)
+				axis[c] = next[c] / length;
+		}
+	}
+
+	// Endpoints at the extreme projections of the texels onto the principal axis.
+	template <int N>
+	void AxisEndpoints(const float (*texels)[4], float* e0, float* e1)
+	{
+		float mean[N], axis[N];
+		PrincipalAxis<N>(texels, mean, axis);
+
+		float tmin = 0.0f, tmax = 0.0f;
+		float axisLength2 = 0.0f;
+		for (int c = 0; c < N; ++c)
+			axisLength2 += axis[c] * axis[c];
+
+		for (int i = 0; i < 16; ++i)
+		{
+			float t = 0.0f;
+			for (int c = 0; c < N; ++c)
+				t += (texels[i][c] - mean[c]) * axis[c];
+			t /= axisLength2;
+			tmin = std::min(tmin, t);
+			tmax = std::max(tmax, t);
+		}
+
+		for (int c = 0; c < N; ++c)
+		{
+			e0[c] = std::min(std::max(mean[c] + axis[c] * tmax, 0.0f), 255.0f);
+			e1[c] = std::min(std::max(mean[c] + axis[c] * tmin, 0.0f), 255.0f);
+		}
+	}
+
+	// Least squares endpoints for fixed interpolation weights: each texel is
+	// modelled as (1 - w) * e0 + w * e1.
+	template <int N>
+	bool FitEndpoints(const float (*texels)[4], const float* weights, float* e0, float* e1)
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[N] = {}, bx[N] = {};
+		for (int i = 0; i < 16; ++i)
+		{
+			float b = weights[i];
+			float a = 1.0f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (int c = 0; c < N; ++c)
+			{
+				ax[c] += a * texels[i][c];
+				bx[c] += b * texels[i][c];
+			}
+		}
+
+		float det = aa * bb - ab * ab;
+		if (std::fabs(det) < 1e-6f)
+			return false;
+
+		float inv = 1.0f / det;
+		for (int c = 0; c < N; ++c)
+		{
+			e0[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) * inv, 0.0f), 255.0f);
+			e1[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) * inv, 0.0f), 255.0f);
+		}
+		return true;
+	}
+
+	// Picks the nearest palette entry per texel, returns the squared error.
+	// Ties go to the lower index.
+	template <int N>
+	float SelectIndices(const float (*texels)[4], const float (*palette)[4], int paletteSize, std::uint8_t* indices)
+	{
+#ifdef BC_USE_SSE
+		// four texels per register, one register per channel
+		__m128 total = _mm_setzero_ps();
+		for (int i = 0; i < 16; i += 4)
+		{
+			__m128 t[N];
+			for (int c = 0; c < N; ++c)
+				t[c] = _mm_set_ps(texels[i + 3][c], texels[i + 2][c], texels[i + 1][c], texels[i][c]);
+
+			__m128 best = _mm_set1_ps(1e30f);
+			__m128i bestIndex = _mm_setzero_si128();
+			for (int p = 0; p < paletteSize; ++p)
+			{
+				__m128 error = _mm_setzero_ps();
+				for (int c = 0; c < N; ++c)
+				{
+					__m128 d = _mm_sub_ps(t[c], _mm_set1_ps(palette[p][c]));
+					error = _mm_add_ps(error, _mm_mul_ps(d, d));
+				}
+
+				__m128i less = _mm_castps_si128(_mm_cmplt_ps(error, best));
+				best = _mm_min_ps(error, best);
+				bestIndex = _mm_or_si128(_mm_andnot_si128(less, bestIndex), _mm_and_si128(less, _mm_set1_epi32(p)));
+			}
+
+			alignas(16) std::int32_t lanes[4];
+			_mm_store_si128((__m128i*)lanes, bestIndex);
+			for (int k = 0; k < 4; ++k)
+				indices[i + k] = (std::uint8_t)lanes[k];
+
+			total = _mm_add_ps(total, best);
+		}
+
+		alignas(16) float sums[4];
+		_mm_store_ps(sums, total);
+		return sums[0] + sums[1] + sums[2] + sums[3];
+#else
+		float total = 0.0f;
+		for (int i = 0; i < 16; ++i)
+		{
+			float best = 1e30f;
+			for (int p = 0; p < paletteSize; ++p)
+			{
+				float error = 0.0f;
+				for (int c = 0; c < N; ++c)
+				{
+					float d = texels[i][c] - palette[p][c];
+					error += d * d;
+				}
+				if (error < best)
+				{
+					best = error;
+					indices[i] = (std::uint8_t)p;
+				}
+			}
+			total += best;
+		}
+		return total;
+#endif
+	}
+
+	void LoadTexels(const std::uint8_t* rgba, float (*texels)[4])
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			for (int c = 0; c < 4; ++c)
+				texels[i][c] = rgba[i * 4 + c];
+		}
+	}
+
+	// --- BC1 color block, also the color half of BC3 ---
+
+	std::uint16_t Pack565(const float* c)
+	{
+		int r = (int)(c[0] * 31.0f / 255.0f + 0.5f);
+		int g = (int)(c[1] * 63.0f / 255.0f + 0.5f);
+		int b = (int)(c[2] * 31.0f / 255.0f + 0.5f);
+		return (std::uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	void Unpack565(std::uint16_t v, float* c)
+	{
+		int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+		c[0] = (float)((r << 3) | (r >> 2));
+		c[1] = (float)((g << 2) | (g >> 4));
+		c[2] = (float)((b << 3) | (b >> 2));
+		c[3] = 255.0f;
+	}
+
+	void ColorPalette(std::uint16_t c0, std::uint16_t c1, bool fourColor, float (*palette)[4])
+	{
+		Unpack565(c0, palette[0]);
+		Unpack565(c1, palette[1]);
+		for (int c = 0; c < 3; ++c)
+		{
+			if (fourColor)
+			{
+				palette[2][c] = std::floor((2.0f * palette[0][c] + palette[1][c]) / 3.0f + 0.5f);
+				palette[3][c] = std::floor((palette[0][c] + 2.0f * palette[1][c]) / 3.0f + 0.5f);
+			}
+			else
+			{
+				palette[2][c] = std::floor((palette[0][c] + palette[1][c]) / 2.0f + 0.5f);
+				palette[3][c] = 0.0f;
+			}
+		}
+		palette[2][3] = 255.0f;
+		palette[3][3] = fourColor ? 255.0f : 0.0f;
+	}
+
+	// Always four-color mode; BC3 ignores the endpoint order anyway.
+	void EncodeColor(const float (*texels)[4], std::uint8_t* block)
+	{
+		static const float weightOf[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+		float e0[3], e1[3];
+		AxisEndpoints<3>(texels, e0, e1);
+
+		std::uint16_t best0 = 0, best1 = 0;
+		std::uint8_t bestIndices[16] = {};
+		float bestError = 1e30f;
+
+		for (int iteration = 0; iteration < 3; ++iteration)
+		{
+			std::uint16_t c0 = Pack565(e0);
+			std::uint16_t c1 = Pack565(e1);
+			if (c0 < c1)
+				std::swap(c0, c1);
+
+			std::uint8_t indices[16];
+			float error;
+			if (c0 == c1)
+			{
+				float palette[4][4];
+				ColorPalette(c0, c1, true, palette);
+				memset(indices, 0, sizeof(indices));
+				error = 0.0f;
+				for (int i = 0; i < 16; ++i)
+				{
+					for (int c = 0; c < 3; ++c)
+						error += (texels[i][c] - palette[0][c]) * (texels[i][c] - palette[0][c]);
+				}
+			}
+			else
+			{
+				float palette[4][4];
+				ColorPalette(c0, c1, true, palette);
+				error = SelectIndices<3>(texels, palette, 4, indices);
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				best0 = c0;
+				best1 = c1;
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+
+			if (bestError == 0.0f)
+				break;
+
+			float weights[16];
+			for (int i = 0; i < 16; ++i)
+				weights[i] = weightOf[indices[i]];
+			if (!FitEndpoints<3>(texels, weights, e0, e1))
+				break;
+		}
+
+		std::uint32_t bits = 0;
+		for (int i = 0; i < 16; ++i)
+			bits |= (std::uint32_t)(best0 == best1 ? 0 : bestIndices[i]) << (i * 2);
+
+		block[0] = (std::uint8_t)best0;
+		block[1] = (std::uint8_t)(best0 >> 8);
+		block[2] = (std::uint8_t)best1;
+		block[3] = (std::uint8_t)(best1 >> 8);
+		memcpy(block + 4, &bits, 4);
+	}
+
+	void DecodeColor(const std::uint8_t* block, bool forceFourColor, std::uint8_t* rgba)
+	{
+		std::uint16_t c0 = (std::uint16_t)(block[0] | (block[1] << 8));
+		std::uint16_t c1 = (std::uint16_t)(block[2] | (block[3] << 8));
+		std::uint32_t bits;
+		memcpy(&bits, block + 4, 4);
+
+		float palette[4][4];
+		ColorPalette(c0, c1, forceFourColor || c0 > c1, palette);
+
+		for (int i = 0; i < 16; ++i)
+		{
+			const float* p = palette[(bits >> (i * 2)) & 3];
+			for (int c = 0; c < 4; ++c)
+				rgba[i * 4 + c] = (std::uint8_t)p[c];
+		}
+	}
+
+	// --- BC3 alpha block ---
+
+	void AlphaPalette(int a0, int a1, int* palette)
+	{
+		palette[0] = a0;
+		palette[1] = a1;
+		if (a0 > a1)
+		{
+			for (int i = 1; i < 7; ++i)
+				palette[i + 1] = ((7 - i) * a0 + i * a1 + 3) / 7;
+		}
+		else
+		{
+			for (int i = 1; i < 5; ++i)
+				palette[i + 1] = ((5 - i) * a0 + i * a1 + 2) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	int AlphaIndices(const std::uint8_t* rgba, int a0, int a1, std::uint8_t* indices)
+	{
+		int palette[8];
+		AlphaPalette(a0, a1, palette);
+
+		int total = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			int a = rgba[i * 4 + 3];
+			int best = 1 << 30;
+			for (int p = 0; p < 8; ++p)
+			{
+				int d = (a - palette[p]) * (a - palette[p]);
+				if (d < best)
+				{
+					best = d;
+					indices[i] = (std::uint8_t)p;
+				}
+			}
+			total += best;
+		}
+		return total;
+	}
+
+	void EncodeAlpha(const std::uint8_t* rgba, std::uint8_t* block)
+	{
+		// eight interpolated values between the extremes, or six between the
+		// inner extremes plus exact 0 and 255 for cut-out edges
+		int lo = 255, hi = 0, innerLo = 255, innerHi = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			int a = rgba[i * 4 + 3];
+			lo = std::min(lo, a);
+			hi = std::max(hi, a);
+			if (a != 0 && a != 255)
+			{
+				innerLo = std::min(innerLo, a);
+				innerHi = std::max(innerHi, a);
+			}
+		}
+		if (innerLo > innerHi)
+			innerLo = innerHi = lo;
+
+		std::uint8_t indices[16], indices6[16];
+		int a0 = hi, a1 = lo;
+		int error = AlphaIndices(rgba, a0, a1, indices);
+		int error6 = AlphaIndices(rgba, innerLo, innerHi, indices6);
+		if (error6 < error)
+		{
+			a0 = innerLo;
+			a1 = innerHi;
+			memcpy(indices, indices6, sizeof(indices));
+		}
+
+		std::uint64_t bits = 0;
+		for (int i = 0; i < 16; ++i)
+			bits |= (std::uint64_t)indices[i] << (i * 3);
+
+		block[0] = (std::uint8_t)a0;
+		block[1] = (std::uint8_t)a1;
+		for (int i = 0; i < 6; ++i)
+			block[2 + i] = (std::uint8_t)(bits >> (i * 8));
+	}
+
+	void DecodeAlpha(const std::uint8_t* block, std::uint8_t* rgba)
+	{
+		int palette[8];
+		AlphaPalette(block[0], block[1], palette);
+
+		std::uint64_t bits = 0;
+		for (int i = 0; i < 6; ++i)
+			bits |= (std::uint64_t)block[2 + i] << (i * 8);
+
+		for (int i = 0; i < 16; ++i)
+			rgba[i * 4 + 3] = (std::uint8_t)palette[(bits >> (i * 3)) & 7];
+	}
+
+	// --- BC7 mode 6: one subset, RGBA endpoints of 7 bits plus a p-bit, 4-bit indices ---
+
+	const int g_Bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(std::uint8_t* data) : _Data(data) { memset(data, 0, 16); }
+
+		void Write(std::uint32_t value, int count)
+		{
+			for (int i = 0; i < count; ++i, ++_Pos)
+				_Data[_Pos >> 3] |= (std::uint8_t)(((value >> i) & 1) << (_Pos & 7));
+		}
+
+	private:
+		std::uint8_t* _Data;
+		int _Pos = 0;
+	};
+
+	class BitReader
+	{
+	public:
+		explicit BitReader(const std::uint8_t* data) : _Data(data) {}
+
+		std::uint32_t Read(int count)
+		{
+			std::uint32_t value = 0;
+			for (int i = 0; i < count; ++i, ++_Pos)
+				value |= (std::uint32_t)((_Data[_Pos >> 3] >> (_Pos & 7)) & 1) << i;
+			return value;
+		}
+
+	private:
+		const std::uint8_t* _Data;
+		int _Pos = 0;
+	};
+
+	// 7-bit endpoint and the p-bit shared by its four channels.
+	void QuantizeMode6(const float* e, std::uint8_t* q, std::uint8_t& pbit)
+	{
+		float bestError = 1e30f;
+		for (int p = 0; p < 2; ++p)
+		{
+			std::uint8_t candidate[4];
+			float error = 0.0f;
+			for (int c = 0; c < 4; ++c)
+			{
+				int v = (int)std::floor((e[c] - p) / 2.0f + 0.5f);
+				candidate[c] = (std::uint8_t)std::min(std::max(v, 0), 127);
+				float d = e[c] - (candidate[c] * 2 + p);
+				error += d * d;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				memcpy(q, candidate, 4);
+				pbit = (std::uint8_t)p;
+			}
+		}
+	}
+
+	void Mode6Palette(const std::uint8_t* q0, int p0, const std::uint8_t* q1, int p1, float (*palette)[4])
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			int a = q0[c] * 2 + p0;
+			int b = q1[c] * 2 + p1;
+			for (int i = 0; i < 16; ++i)
+				palette[i][c] = (float)((a * (64 - g_Bc7Weights4[i]) + b * g_Bc7Weights4[i] + 32) >> 6);
+		}
+	}
+
+	void EncodeBc7(const float (*source)[4], std::uint8_t* block)
+	{
+		// the color of fully transparent texels is never seen, moving it to
+		// the mean of the others keeps them off the single endpoint line
+		float texels[16][4];
+		float visible[3] = {};
+		int visibleCount = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			if (source[i][3] == 0.0f)
+				continue;
+			for (int c = 0; c < 3; ++c)
+				visible[c] += source[i][c];
+			++visibleCount;
+		}
+		for (int i = 0; i < 16; ++i)
+		{
+			for (int c = 0; c < 4; ++c)
+				texels[i][c] = source[i][3] == 0.0f && visibleCount > 0 && c < 3 ? visible[c] / visibleCount : source[i][c];
+		}
+
+		float e0[4], e1[4];
+		AxisEndpoints<4>(texels, e1, e0);
+
+		std::uint8_t bestQ0[4] = {}, bestQ1[4] = {}, bestP0 = 0, bestP1 = 0;
+		std::uint8_t bestIndices[16] = {};
+		float bestError = 1e30f;
+
+		for (int iteration = 0; iteration < 3; ++iteration)
+		{
+			std::uint8_t q0[4], q1[4], p0, p1;
+			QuantizeMode6(e0, q0, p0);
+			QuantizeMode6(e1, q1, p1);
+
+			float palette[16][4];
+			Mode6Palette(q0, p0, q1, p1, palette);
+
+			std::uint8_t indices[16];
+			float error = SelectIndices<4>(texels, palette, 16, indices);
+			if (error < bestError)
+			{
+				bestError = error;
+				memcpy(bestQ0, q0, 4);
+				memcpy(bestQ1, q1, 4);
+				bestP0 = p0;
+				bestP1 = p1;
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+
+			if (bestError == 0.0f)
+				break;
+
+			float weights[16];
+			for (int i = 0; i < 16; ++i)
+				weights[i] = g_Bc7Weights4[indices[i]] / 64.0f;
+			if (!FitEndpoints<4>(texels, weights, e0, e1))
+				break;
+		}
+
+		// the MSB of the first index is implicit zero
+		if (bestIndices[0] & 8)
+		{
+			std::uint8_t tmp[4];
+			memcpy(tmp, bestQ0, 4);
+			memcpy(bestQ0, bestQ1, 4);
+			memcpy(bestQ1, tmp, 4);
+			std::swap(bestP0, bestP1);
+			for (int i = 0; i < 16; ++i)
+				bestIndices[i] = (std::uint8_t)(15 - bestIndices[i]);
+		}
+
+		BitWriter writer(block);
+		writer.Write(1 << 6, 7);
+		for (int c = 0; c < 4; ++c)
+		{
+			writer.Write(bestQ0[c], 7);
+			writer.Write(bestQ1[c], 7);
+		}
+		writer.Write(bestP0, 1);
+		writer.Write(bestP1, 1);
+		for (int i = 0; i < 16; ++i)
+			writer.Write(bestIndices[i], i == 0 ? 3 : 4);
+	}
+
+	// Mode 6 only; blocks in other modes decode to black.
+	void DecodeBc7(const std::uint8_t* block, std::uint8_t* rgba)
+	{
+		BitReader reader(block);
+		if (reader.Read(7) != (1 << 6))
+		{
+			memset(rgba, 0, 64);
+			return;
+		}
+
+		std::uint8_t q0[4], q1[4];
+		for (int c = 0; c < 4; ++c)
+		{
+			q0[c] = (std::uint8_t)reader.Read(7);
+			q1[c] = (std::uint8_t)reader.Read(7);
+		}
+		int p0 = (int)reader.Read(1);
+		int p1 = (int)reader.Read(1);
+
+		float palette[16][4];
+		Mode6Palette(q0, p0, q1, p1, palette);
+
+		for (int i = 0; i < 16; ++i)
+		{
+			const float* p = palette[reader.Read(i == 0 ? 3 : 4)];
+			for (int c = 0; c < 4; ++c)
+				rgba[i * 4 + c] = (std::uint8_t)p[c];
+		}
+	}
+}
+
+size_t BlockBytes(BlockFormat format)
+{
+	return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+void EncodeBlock(BlockFormat format, const std::uint8_t* rgba, std::uint8_t* block)
+{
+	float texels[16][4];
+	LoadTexels(rgba, texels);
+
+	switch (format)
+	{
+	case BlockFormat::BC1:
+		EncodeColor(texels, block);
+		break;
+	case BlockFormat::BC3:
+		EncodeAlpha(rgba, block);
+		EncodeColor(texels, block + 8);
+		break;
+	case BlockFormat::BC7:
+		EncodeBc7(texels, block);
+		break;
+	}
+}
+
+void DecodeBlock(BlockFormat format, const std::uint8_t* block, std::uint8_t* rgba)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1:
+		DecodeColor(block, false, rgba);
+		break;
+	case BlockFormat::BC3:
+		DecodeColor(block + 8, true, rgba);
+		DecodeAlpha(block, rgba);
+		break;
+	case BlockFormat::BC7:
+		DecodeBc7(block, rgba);
+		break;
+	}
+}
+
+std::vector<std::uint8_t> CompressImage(const Image& image, BlockFormat format, unsigned threadCount)
+{
+	const std::uint32_t blocksX = (image.Width + 3) / 4;
+	const std::uint32_t blocksY = (image.Height + 3) / 4;
+	const size_t blockBytes = BlockBytes(format);
+
+	std::vector<std::uint8_t> result((size_t)blocksX * blocksY * blockBytes);
+
+	// block rows are handed out one at a time, they take about the same time
+	std::atomic<std::uint32_t> nextRow{ 0 };
+	auto worker = [&]()
+	{
+		std::uint8_t rgba[64];
+		for (std::uint32_t by = nextRow++; by < blocksY; by = nextRow++)
+		{
+			for (std::uint32_t bx = 0; bx < blocksX; ++bx)
+			{
+				for (std::uint32_t i = 0; i < 16; ++i)
+				{
+					std::uint32_t x = std::min(bx * 4 + (i & 3), image.Width - 1);
+					std::uint32_t y = std::min(by * 4 + (i >> 2), image.Height - 1);
+					memcpy(rgba + i * 4, &image.Pixels[((size_t)y * image.Width + x) * 4], 4);
+				}
+				EncodeBlock(format, rgba, &result[((size_t)by * blocksX + bx) * blockBytes]);
+			}
+		}
+	};
+
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	threadCount = std::min(threadCount, blocksY);
+
+	std::vector<std::thread> threads;
+	for (unsigned i = 1; i < threadCount; ++i)
+		threads.emplace_back(worker);
+	worker();
+	for (auto& thread : threads)
+		thread.join();
+
+	return result;
+}
+
+Image DecompressImage(const std::uint8_t* data, std::uint32_t width, std::uint32_t height, BlockFormat format)
+{
+	const std::uint32_t blocksX = (width + 3) / 4;
+	const std::uint32_t blocksY = (height + 3) / 4;
+	const size_t blockBytes = BlockBytes(format);
+
+	Image image;
+	image.Width = width;
+	image.Height = height;
+	image.Pixels.resize((size_t)width * height * 4);
+
+	std::uint8_t rgba[64];
+	for (std::uint32_t by = 0; by < blocksY; ++by)
+	{
+		for (std::uint32_t bx = 0; bx < blocksX; ++bx)
+		{
+			DecodeBlock(format, data + ((size_t)by * blocksX + bx) * blockBytes, rgba);
+			for (std::uint32_t i = 0; i < 16; ++i)
+			{
+				std::uint32_t x = bx * 4 + (i & 3);
+				std::uint32_t y = by * 4 + (i >> 2);
+				if (x < width && y < height)
+					memcpy(&image.Pixels[((size_t)y * width + x) * 4], rgba + i * 4, 4);
+			}
+		}
+	}
+	return image;
+}
@@ -0,0 +1,23 @@
+#ifndef _BLOCK_COMPRESSOR_H_
+#define _BLOCK_COMPRESSOR_H_
+
+enum class BlockFormat
+{
+	BC1,	// RGB, 4 bpp
+	BC3,	// RGB + interpolated alpha, 8 bpp
+	BC7		// RGBA, mode 6 only, 8 bpp
+};
+
+size_t BlockBytes(BlockFormat format);
+
+// One 4x4 block, 16 RGBA texels in row order.
+void EncodeBlock(BlockFormat format, const std::uint8_t* rgba, std::uint8_t* block);
+void DecodeBlock(BlockFormat format, const std::uint8_t* block, std::uint8_t* rgba);
+
+// Compresses the image in block rows spread over threadCount threads (0 uses
+// every hardware thread). Partial blocks at the right and bottom edges repeat
+// the last row and column.
+std::vector<std::uint8_t> CompressImage(const Image& image, BlockFormat format, unsigned threadCount = 0);
+Image DecompressImage(const std::uint8_t* data, std::uint32_t width, std::uint32_t height, BlockFormat format);
+
+#endif /* _BLOCK_COMPRESSOR_H_ */
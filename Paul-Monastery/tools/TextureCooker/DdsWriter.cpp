@@ -0,0 +1,140 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "DdsWriter.h"
+
+namespace
+{
+	// layout as in DDSTextureLoader.cpp
+	struct DdsPixelFormat
+	{
+		std::uint32_t Size;
+		std::uint32_t Flags;
+		std::uint32_t FourCC;
+		std::uint32_t RGBBitCount;
+		std::uint32_t RBitMask;
+		std::uint32_t GBitMask;
+		std::uint32_t BBitMask;
+		std::uint32_t ABitMask;
+	};
+
+	struct DdsHeader
+	{
+		std::uint32_t Size;
+		std::uint32_t Flags;
+		std::uint32_t Height;
+		std::uint32_t Width;
+		std::uint32_t PitchOrLinearSize;
+		std::uint32_t Depth;
+		std::uint32_t MipMapCount;
+		std::uint32_t Reserved1[11];
+		DdsPixelFormat PixelFormat;
+		std::uint32_t Caps;
+		std::uint32_t Caps2;
+		std::uint32_t Caps3;
+		std::uint32_t Caps4;
+		std::uint32_t Reserved2;
+	};
+
+	struct DdsHeaderDxt10
+	{
+		std::uint32_t DxgiFormat;
+		std::uint32_t ResourceDimension;
+		std::uint32_t MiscFlag;
+		std::uint32_t ArraySize;
+		std::uint32_t MiscFlags2;
+	};
+
+	static_assert(sizeof(DdsHeader) == 124, "DDS header size");
+	static_assert(sizeof(DdsHeaderDxt10) == 20, "DX10 header size");
+
+	const std::uint32_t DDS_MAGIC = 0x20534444;
+	const std::uint32_t DDS_FOURCC = 0x4;
+	const std::uint32_t DDS_DX10 = 0x30315844;
+
+	const std::uint32_t DDSD_CAPS = 0x1;
+	const std::uint32_t DDSD_HEIGHT = 0x2;
+	const std::uint32_t DDSD_WIDTH = 0x4;
+	const std::uint32_t DDSD_PITCH = 0x8;
+	const std::uint32_t DDSD_PIXELFORMAT = 0x1000;
+	const std::uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+	const std::uint32_t DDSD_LINEARSIZE = 0x80000;
+
+	const std::uint32_t DDSCAPS_COMPLEX = 0x8;
+	const std::uint32_t DDSCAPS_TEXTURE = 0x1000;
+	const std::uint32_t DDSCAPS_MIPMAP = 0x400000;
+	const std::uint32_t DDSCAPS2_CUBEMAP_ALLFACES = 0xfe00;
+
+	const std::uint32_t RESOURCE_DIMENSION_TEXTURE2D = 3;
+	const std::uint32_t RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+	const std::uint32_t ALPHA_MODE_STRAIGHT = 1;
+	const std::uint32_t ALPHA_MODE_OPAQUE = 3;
+
+	bool IsCompressed(DdsFormat format)
+	{
+		return format != DdsFormat_R8G8B8A8_UNORM && format != DdsFormat_R8G8B8A8_UNORM_SRGB;
+	}
+
+	std::uint32_t BlockBytes(DdsFormat format)
+	{
+		return format == DdsFormat_BC1_UNORM || format == DdsFormat_BC1_UNORM_SRGB ? 8 : 16;
+	}
+}
+
+bool WriteDds(const std::string& filename, const DdsDesc& desc, const std::vector<std::vector<std::uint8_t>>& surfaces)
+{
+	DdsHeader header = {};
+	header.Size = sizeof(DdsHeader);
+	header.Flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT;
+	header.Height = desc.Height;
+	header.Width = desc.Width;
+	header.MipMapCount = desc.MipCount;
+
+	if (IsCompressed(desc.Format))
+	{
+		header.Flags |= DDSD_LINEARSIZE;
+		header.PitchOrLinearSize = ((desc.Width + 3) / 4) * ((desc.Height + 3) / 4) * BlockBytes(desc.Format);
+	}
+	else
+	{
+		header.Flags |= DDSD_PITCH;
+		header.PitchOrLinearSize = desc.Width * 4;
+	}
+
+	header.PixelFormat.Size = sizeof(DdsPixelFormat);
+	header.PixelFormat.Flags = DDS_FOURCC;
+	header.PixelFormat.FourCC = DDS_DX10;
+
+	header.Caps = DDSCAPS_TEXTURE;
+	if (desc.MipCount > 1)
+		header.Caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+	if (desc.IsCubeMap)
+	{
+		header.Caps |= DDSCAPS_COMPLEX;
+		header.Caps2 = DDSCAPS2_CUBEMAP_ALLFACES;
+	}
+
+	DdsHeaderDxt10 dx10 = {};
+	dx10.DxgiFormat = desc.Format;
+	dx10.ResourceDimension = RESOURCE_DIMENSION_TEXTURE2D;
+	dx10.MiscFlag = desc.IsCubeMap ? RESOURCE_MISC_TEXTURECUBE : 0;
+	dx10.ArraySize = 1;
+	dx10.MiscFlags2 = desc.HasAlpha ? ALPHA_MODE_STRAIGHT : ALPHA_MODE_OPAQUE;
+
+	FILE* file = fopen(filename.c_str(), "wb");
+	if (!file)
+		return false;
+
+	bool ok = fwrite(&DDS_MAGIC, sizeof(DDS_MAGIC), 1, file) == 1 &&
+		fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(&dx10, sizeof(dx10), 1, file) == 1;
+
+	for (const auto& surface : surfaces)
+		ok = ok && fwrite(surface.data(), 1, surface.size(), file) == surface.size();
+
+	return fclose(file) == 0 && ok;
+}
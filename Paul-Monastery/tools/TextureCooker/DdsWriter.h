@@ -0,0 +1,31 @@
+#ifndef _DDS_WRITER_H_
+#define _DDS_WRITER_H_
+
+// DXGI_FORMAT values the cooker writes.
+enum DdsFormat : std::uint32_t
+{
+	DdsFormat_R8G8B8A8_UNORM = 28,
+	DdsFormat_R8G8B8A8_UNORM_SRGB = 29,
+	DdsFormat_BC1_UNORM = 71,
+	DdsFormat_BC1_UNORM_SRGB = 72,
+	DdsFormat_BC3_UNORM = 77,
+	DdsFormat_BC3_UNORM_SRGB = 78,
+	DdsFormat_BC7_UNORM = 98,
+	DdsFormat_BC7_UNORM_SRGB = 99,
+};
+
+struct DdsDesc
+{
+	std::uint32_t Width = 0;
+	std::uint32_t Height = 0;
+	std::uint32_t MipCount = 1;
+	DdsFormat Format = DdsFormat_R8G8B8A8_UNORM;
+	bool IsCubeMap = false;
+	bool HasAlpha = false;
+};
+
+// Writes a DX10-header DDS file. surfaces holds every subresource in file
+// order: for each cube face (or the single image) its mips, largest first.
+bool WriteDds(const std::string& filename, const DdsDesc& desc, const std::vector<std::vector<std::uint8_t>>& surfaces);
+
+#endif /* _DDS_WRITER_H_ */
@@ -0,0 +1,22 @@
+#ifndef _IMAGE_H_
+#define _IMAGE_H_
+
+// 8-bit RGBA image, rows top to bottom.
+struct Image
+{
+	std::uint32_t Width = 0;
+	std::uint32_t Height = 0;
+	std::vector<std::uint8_t> Pixels;
+
+	bool HasAlpha() const
+	{
+		for (size_t i = 3; i < Pixels.size(); i += 4)
+		{
+			if (Pixels[i] != 255)
+				return true;
+		}
+		return false;
+	}
+};
+
+#endif /* _IMAGE_H_ */
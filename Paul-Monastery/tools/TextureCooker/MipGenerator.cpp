@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MIP_USE_SSE 1
+#endif
+
+#include "Image.h"
+#include "MipGenerator.h"
+
+namespace
+{
+	struct SrgbTable
+	{
+		float ToLinear[256];
+
+		SrgbTable()
+		{
+			for (int i = 0; i < 256; ++i)
+			{
+				float c = i / 255.0f;
+				ToLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+		}
+	};
+
+	const SrgbTable g_Srgb;
+
+	std::uint8_t LinearToSrgb(float c)
+	{
+		c = std::min(std::max(c, 0.0f), 1.0f);
+		c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+		return (std::uint8_t)(c * 255.0f + 0.5f);
+	}
+
+	// Source texels and weights of one destination texel along one axis.
+	struct Footprint
+	{
+		std::uint32_t First;
+		std::vector<float> Weights;
+	};
+
+	std::vector<Footprint> Footprints(std::uint32_t srcSize, std::uint32_t dstSize)
+	{
+		std::vector<Footprint> result(dstSize);
+		double scale = (double)srcSize / dstSize;
+
+		for (std::uint32_t i = 0; i < dstSize; ++i)
+		{
+			double begin = i * scale;
+			double end = (i + 1) * scale;
+			std::uint32_t first = (std::uint32_t)begin;
+			std::uint32_t last = std::min(srcSize - 1, (std::uint32_t)std::ceil(end) - 1);
+
+			Footprint& f = result[i];
+			f.First = first;
+			for (std::uint32_t s = first; s <= last; ++s)
+			{
+				double coverage = std::min(end, s + 1.0) - std::max(begin, (double)s);
+				f.Weights.push_back((float)(coverage / scale));
+			}
+		}
+		return result;
+	}
+
+	// dst = sum of w[i] * src[i * step], four channels at a time.
+	void Accumulate(float* dst, const float* src, size_t step, const std::vector<float>& weights)
+	{
+#ifdef MIP_USE_SSE
+		__m128 sum = _mm_setzero_ps();
+		for (size_t i = 0; i < weights.size(); ++i)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + i * step), _mm_set1_ps(weights[i])));
+		_mm_storeu_ps(dst, sum);
+#else
+		float sum[4] = {};
+		for (size_t i = 0; i < weights.size(); ++i)
+		{
+			for (int c = 0; c < 4; ++c)
+				sum[c] += src[i * step + c] * weights[i];
+		}
+		for (int c = 0; c < 4; ++c)
+			dst[c] = sum[c];
+#endif
+	}
+}
+
+LinearImage ToLinear(const Image& image)
+{
+	LinearImage result;
+	result.Width = image.Width;
+	result.Height = image.Height;
+	result.Pixels.resize(image.Pixels.size());
+
+	for (size_t i = 0; i < image.Pixels.size(); i += 4)
+	{
+		// premultiplied while filtering, see Resample()
+		float a = image.Pixels[i + 3] / 255.0f;
+		result.Pixels[i + 0] = g_Srgb.ToLinear[image.Pixels[i + 0]] * a;
+		result.Pixels[i + 1] = g_Srgb.ToLinear[image.Pixels[i + 1]] * a;
+		result.Pixels[i + 2] = g_Srgb.ToLinear[image.Pixels[i + 2]] * a;
+		result.Pixels[i + 3] = a;
+	}
+	return result;
+}
+
+Image ToSrgb(const LinearImage& image)
+{
+	Image result;
+	result.Width = image.Width;
+	result.Height = image.Height;
+	result.Pixels.resize(image.Pixels.size());
+
+	for (size_t i = 0; i < image.Pixels.size(); i += 4)
+	{
+		float a = std::min(std::max(image.Pixels[i + 3], 0.0f), 1.0f);
+		float inv = a > 0.0f ? 1.0f / a : 0.0f;
+		result.Pixels[i + 0] = LinearToSrgb(image.Pixels[i + 0] * inv);
+		result.Pixels[i + 1] = LinearToSrgb(image.Pixels[i + 1] * inv);
+		result.Pixels[i + 2] = LinearToSrgb(image.Pixels[i + 2] * inv);
+		result.Pixels[i + 3] = (std::uint8_t)(a * 255.0f + 0.5f);
+	}
+	return result;
+}
+
+LinearImage Resample(const LinearImage& src, std::uint32_t width, std::uint32_t height)
+{
+	std::vector<Footprint> fx = Footprints(src.Width, width);
+	std::vector<Footprint> fy = Footprints(src.Height, height);
+
+	// horizontal pass, then vertical
+	LinearImage tmp;
+	tmp.Width = width;
+	tmp.Height = src.Height;
+	tmp.Pixels.resize((size_t)width * src.Height * 4);
+
+	for (std::uint32_t y = 0; y < src.Height; ++y)
+	{
+		const float* row = &src.Pixels[(size_t)y * src.Width * 4];
+		float* out = &tmp.Pixels[(size_t)y * width * 4];
+		for (std::uint32_t x = 0; x < width; ++x)
+			Accumulate(out + x * 4, row + fx[x].First * 4, 4, fx[x].Weights);
+	}
+
+	LinearImage result;
+	result.Width = width;
+	result.Height = height;
+	result.Pixels.resize((size_t)width * height * 4);
+
+	for (std::uint32_t y = 0; y < height; ++y)
+	{
+		const float* column = &tmp.Pixels[(size_t)fy[y].First * width * 4];
+		float* out = &result.Pixels[(size_t)y * width * 4];
+		for (std::uint32_t x = 0; x < width; ++x)
+			Accumulate(out + x * 4, column + x * 4, (size_t)width * 4, fy[y].Weights);
+	}
+
+	return result;
+}
+
+std::vector<Image> GenerateMips(const Image& top)
+{
+	std::vector<Image> mips;
+	mips.push_back(top);
+
+	// each level is filtered from the one above, never from requantized 8-bit data
+	LinearImage level = ToLinear(top);
+	while (level.Width > 1 || level.Height > 1)
+	{
+		level = Resample(level, std::max(1u, level.Width / 2), std::max(1u, level.Height / 2));
+		mips.push_back(ToSrgb(level));
+	}
+	return mips;
+}
@@ -0,0 +1,24 @@
+#ifndef _MIP_GENERATOR_H_
+#define _MIP_GENERATOR_H_
+
+// Linear-light RGBA float image.
+struct LinearImage
+{
+	std::uint32_t Width = 0;
+	std::uint32_t Height = 0;
+	std::vector<float> Pixels;
+};
+
+// sRGB-encoded 8-bit color to linear light; alpha stays linear.
+LinearImage ToLinear(const Image& image);
+Image ToSrgb(const LinearImage& image);
+
+// Box-filters src down (or up, for the multiple-of-4 fixup) to width x
+// height. Each destination texel averages the exact source area it covers;
+// color is weighted by alpha so transparent texels do not darken the edges.
+LinearImage Resample(const LinearImage& src, std::uint32_t width, std::uint32_t height);
+
+// Full chain down to 1x1, filtered in linear light and stored as sRGB.
+std::vector<Image> GenerateMips(const Image& top);
+
+#endif /* _MIP_GENERATOR_H_ */
@@ -0,0 +1,548 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Image.h"
+#include "PngDecoder.h"
+
+namespace
+{
+	// raw DEFLATE (RFC 1951)
+	class Inflater
+	{
+	public:
+		Inflater(const std::uint8_t* data, size_t size) : _Data(data), _Size(size) {}
+
+		bool Run(std::vector<std::uint8_t>& out)
+		{
+			int last;
+			do
+			{
+				last = Bits(1);
+				int type = Bits(2);
+
+				bool ok;
+				if (type == 0)
+					ok = Stored(out);
+				else if (type == 1)
+					ok = Fixed(out);
+				else if (type == 2)
+					ok = Dynamic(out);
+				else
+					ok = false;
+
+				if (!ok || _Overrun)
+					return false;
+			} while (!last);
+
+			return true;
+		}
+
+	private:
+		struct Huffman
+		{
+			std::uint16_t Counts[16];
+			std::uint16_t Symbols[288];
+		};
+
+		int Bits(int count)
+		{
+			std::uint32_t value = _BitBuffer;
+			while (_BitCount < count)
+			{
+				if (_Pos >= _Size)
+				{
+					_Overrun = true;
+					return 0;
+				}
+				value |= (std::uint32_t)_Data[_Pos++] << _BitCount;
+				_BitCount += 8;
+			}
+
+			_BitBuffer = value >> count;
+			_BitCount -= count;
+			return (int)(value & ((1u << count) - 1));
+		}
+
+		// canonical codes from code lengths, false for over-subscribed sets
+		static bool Build(Huffman& h, const std::uint8_t* lengths, int count)
+		{
+			memset(h.Counts, 0, sizeof(h.Counts));
+			for (int i = 0; i < count; ++i)
+				h.Counts[lengths[i]]++;
+
+			int left = 1;
+			for (int len = 1; len < 16; ++len)
+			{
+				left <<= 1;
+				left -= h.Counts[len];
+				if (left < 0)
+					return false;
+			}
+
+			std::uint16_t offsets[16];
+			offsets[1] = 0;
+			for (int len = 1; len < 15; ++len)
+				offsets[len + 1] = offsets[len] + h.Counts[len];
+
+			for (int i = 0; i < count; ++i)
+			{
+				if (lengths[i] != 0)
+					h.Symbols[offsets[lengths[i]]++] = (std::uint16_t)i;
+			}
+			return true;
+		}
+
+		int Decode(const Huffman& h)
+		{
+			int code = 0;
+			int first = 0;
+			int index = 0;
+			for (int len = 1; len < 16; ++len)
+			{
+				code |= Bits(1);
+				int count = h.Counts[len];
+				if (code - count < first)
+					return h.Symbols[index + (code - first)];
+
+				index += count;
+				first += count;
+				first <<= 1;
+				code <<= 1;
+			}
+			return -1;
+		}
+
+		bool Stored(std::vector<std::uint8_t>& out)
+		{
+			_BitBuffer = 0;
+			_BitCount = 0;
+
+			if (_Pos + 4 > _Size)
+				return false;
+
+			unsigned len = _Data[_Pos] | (_Data[_Pos + 1] << 8);
+			unsigned nlen = _Data[_Pos + 2] | (_Data[_Pos + 3] << 8);
+			_Pos += 4;
+
+			if (len != (~nlen & 0xffff) || _Pos + len > _Size)
+				return false;
+
+			out.insert(out.end(), _Data + _Pos, _Data + _Pos + len);
+			_Pos += len;
+			return true;
+		}
+
+		bool Codes(std::vector<std::uint8_t>& out, const Huffman& lencode, const Huffman& distcode)
+		{
+			static const std::uint16_t lengthBase[29] = {
+				3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+				35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+			static const std::uint8_t lengthExtra[29] = {
+				0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+				3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+			static const std::uint16_t distBase[30] = {
+				1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+				257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+			static const std::uint8_t distExtra[30] = {
+				0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+				7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+			while (true)
+			{
+				int symbol = Decode(lencode);
+				if (symbol < 0 || _Overrun)
+					return false;
+
+				if (symbol < 256)
+				{
+					out.push_back((std::uint8_t)symbol);
+					continue;
+				}
+
+				if (symbol == 256)
+					return true;
+
+				symbol -= 257;
+				if (symbol >= 29)
+					return false;
+				size_t length = lengthBase[symbol] + Bits(lengthExtra[symbol]);
+
+				symbol = Decode(distcode);
+				if (symbol < 0 || symbol >= 30)
+					return false;
+				size_t dist = distBase[symbol] + Bits(distExtra[symbol]);
+				if (dist > out.size())
+					return false;
+
+				// byte by byte, the source may overlap the bytes being written
+				size_t from = out.size() - dist;
+				for (size_t i = 0; i < length; ++i)
+					out.push_back(out[from + i]);
+			}
+		}
+
+		bool Fixed(std::vector<std::uint8_t>& out)
+		{
+			std::uint8_t lengths[288];
+			int i = 0;
+			for (; i < 144; ++i) lengths[i] = 8;
+			for (; i < 256; ++i) lengths[i] = 9;
+			for (; i < 280; ++i) lengths[i] = 7;
+			for (; i < 288; ++i) lengths[i] = 8;
+
+			Huffman lencode, distcode;
+			Build(lencode, lengths, 288);
+
+			for (i = 0; i < 30; ++i) lengths[i] = 5;
+			Build(distcode, lengths, 30);
+
+			return Codes(out, lencode, distcode);
+		}
+
+		bool Dynamic(std::vector<std::uint8_t>& out)
+		{
+			static const std::uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+			int nlen = Bits(5) + 257;
+			int ndist = Bits(5) + 1;
+			int ncode = Bits(4) + 4;
+			if (nlen > 286 || ndist > 30)
+				return false;
+
+			std::uint8_t lengths[320] = {};
+			for (int i = 0; i < ncode; ++i)
+				lengths[order[i]] = (std::uint8_t)Bits(3);
+
+			Huffman lencode, distcode;
+			if (!Build(lencode, lengths, 19))
+				return false;
+
+			int index = 0;
+			while (index < nlen + ndist)
+			{
+				int symbol = Decode(lencode);
+				if (symbol < 0 || _Overrun)
+					return false;
+
+				if (symbol < 16)
+				{
+					lengths[index++] = (std::uint8_t)symbol;
+					continue;
+				}
+
+				std::uint8_t len = 0;
+				int repeat;
+				if (symbol == 16)
+				{
+					if (index == 0)
+						return false;
+					len = lengths[index - 1];
+					repeat = 3 + Bits(2);
+				}
+				else if (symbol == 17)
+					repeat = 3 + Bits(3);
+				else
+					repeat = 11 + Bits(7);
+
+				if (index + repeat > nlen + ndist)
+					return false;
+				while (repeat--)
+					lengths[index++] = len;
+			}
+
+			if (lengths[256] == 0)
+				return false;
+
+			// incomplete codes are allowed, over-subscribed ones are not
+			if (!Build(lencode, lengths, nlen) || !Build(distcode, lengths + nlen, ndist))
+				return false;
+
+			return Codes(out, lencode, distcode);
+		}
+
+		const std::uint8_t* _Data;
+		size_t _Size;
+		size_t _Pos = 0;
+		std::uint32_t _BitBuffer = 0;
+		int _BitCount = 0;
+		bool _Overrun = false;
+	};
+
+	std::uint32_t ReadBE32(const std::uint8_t* p)
+	{
+		return ((std::uint32_t)p[0] << 24) | ((std::uint32_t)p[1] << 16) | ((std::uint32_t)p[2] << 8) | p[3];
+	}
+
+	int Paeth(int a, int b, int c)
+	{
+		int p = a + b - c;
+		int pa = abs(p - a);
+		int pb = abs(p - b);
+		int pc = abs(p - c);
+		if (pa <= pb && pa <= pc)
+			return a;
+		return pb <= pc ? b : c;
+	}
+
+	// Reverses the per-row filters in place; rows are 1 + stride bytes.
+	bool Unfilter(std::uint8_t* data, std::uint32_t rows, size_t stride, size_t bpp)
+	{
+		std::vector<std::uint8_t> zero(stride, 0);
+		const std::uint8_t* prev = zero.data();
+
+		for (std::uint32_t y = 0; y < rows; ++y)
+		{
+			std::uint8_t filter = data[0];
+			std::uint8_t* row = data + 1;
+
+			for (size_t x = 0; x < stride; ++x)
+			{
+				int a = x >= bpp ? row[x - bpp] : 0;
+				int b = prev[x];
+				int c = x >= bpp ? prev[x - bpp] : 0;
+
+				switch (filter)
+				{
+				case 0: break;
+				case 1: row[x] = (std::uint8_t)(row[x] + a); break;
+				case 2: row[x] = (std::uint8_t)(row[x] + b); break;
+				case 3: row[x] = (std::uint8_t)(row[x] + ((a + b) >> 1)); break;
+				case 4: row[x] = (std::uint8_t)(row[x] + Paeth(a, b, c)); break;
+				default: return false;
+				}
+			}
+
+			prev = row;
+			data += stride + 1;
+		}
+		return true;
+	}
+
+	struct Header
+	{
+		std::uint32_t Width;
+		std::uint32_t Height;
+		int BitDepth;
+		int ColorType;
+		int Channels;
+	};
+
+	// Sample c of pixel x in an unfiltered row, scaled to 8 bits.
+	std::uint8_t Sample(const Header& h, const std::uint8_t* row, std::uint32_t x, int c)
+	{
+		if (h.BitDepth == 8)
+			return row[x * h.Channels + c];
+		if (h.BitDepth == 16)
+			return row[(x * h.Channels + c) * 2];
+
+		// 1, 2 and 4 bit gray or palette, one channel, MSB first
+		std::uint32_t bit = x * h.BitDepth;
+		int value = (row[bit >> 3] >> (8 - h.BitDepth - (bit & 7))) & ((1 << h.BitDepth) - 1);
+		if (h.ColorType == 3)
+			return (std::uint8_t)value;
+		return (std::uint8_t)(value * 255 / ((1 << h.BitDepth) - 1));
+	}
+}
+
+bool DecodePng(const std::vector<std::uint8_t>& file, Image& image, std::string& error)
+{
+	static const std::uint8_t signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+	if (file.size() < 8 || memcmp(file.data(), signature, 8) != 0)
+	{
+		error = "not a PNG file";
+		return false;
+	}
+
+	Header h = {};
+	bool interlaced = false;
+	std::vector<std::uint8_t> palette;
+	std::vector<std::uint8_t> paletteAlpha;
+	int transparentGray = -1;
+	int transparentRgb[3] = { -1, -1, -1 };
+	std::vector<std::uint8_t> compressed;
+
+	size_t pos = 8;
+	while (pos + 12 <= file.size())
+	{
+		std::uint32_t length = ReadBE32(&file[pos]);
+		const std::uint8_t* type = &file[pos + 4];
+		const std::uint8_t* data = &file[pos + 8];
+		if (length > file.size() - pos - 12)
+		{
+			error = "truncated chunk";
+			return false;
+		}
+
+		if (memcmp(type, "IHDR", 4) == 0 && length >= 13)
+		{
+			h.Width = ReadBE32(data);
+			h.Height = ReadBE32(data + 4);
+			h.BitDepth = data[8];
+			h.ColorType = data[9];
+			interlaced = data[12] == 1;
+		}
+		else if (memcmp(type, "PLTE", 4) == 0)
+			palette.assign(data, data + length);
+		else if (memcmp(type, "tRNS", 4) == 0)
+		{
+			if (h.ColorType == 3)
+				paletteAlpha.assign(data, data + length);
+			else if (h.ColorType == 0 && length >= 2)
+				transparentGray = (data[0] << 8) | data[1];
+			else if (h.ColorType == 2 && length >= 6)
+			{
+				for (int c = 0; c < 3; ++c)
+					transparentRgb[c] = (data[c * 2] << 8) | data[c * 2 + 1];
+			}
+		}
+		else if (memcmp(type, "IDAT", 4) == 0)
+			compressed.insert(compressed.end(), data, data + length);
+		else if (memcmp(type, "IEND", 4) == 0)
+			break;
+
+		pos += 12 + (size_t)length;
+	}
+
+	switch (h.ColorType)
+	{
+	case 0: h.Channels = 1; break;
+	case 2: h.Channels = 3; break;
+	case 3: h.Channels = 1; break;
+	case 4: h.Channels = 2; break;
+	case 6: h.Channels = 4; break;
+	default:
+		error = "unsupported color type";
+		return false;
+	}
+
+	bool validDepth = h.BitDepth == 8 || h.BitDepth == 16 ||
+		((h.ColorType == 0 || h.ColorType == 3) && (h.BitDepth == 1 || h.BitDepth == 2 || h.BitDepth == 4));
+	if (!validDepth || h.Width == 0 || h.Height == 0 || (h.ColorType == 3 && palette.empty()))
+	{
+		error = "invalid header";
+		return false;
+	}
+
+	// zlib wrapper: 2 byte header, DEFLATE stream, adler32
+	if (compressed.size() < 2 || (compressed[0] & 0x0f) != 8)
+	{
+		error = "invalid zlib stream";
+		return false;
+	}
+
+	std::vector<std::uint8_t> raw;
+	Inflater inflater(compressed.data() + 2, compressed.size() - 2);
+	if (!inflater.Run(raw))
+	{
+		error = "corrupt image data";
+		return false;
+	}
+
+	image.Width = h.Width;
+	image.Height = h.Height;
+	image.Pixels.assign((size_t)h.Width * h.Height * 4, 0);
+
+	const size_t bitsPerPixel = (size_t)h.Channels * h.BitDepth;
+	const size_t bpp = (bitsPerPixel + 7) / 8;
+
+	static const std::uint32_t adam7[7][4] = {
+		{ 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 },
+		{ 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 } };
+	static const std::uint32_t progressive[1][4] = { { 0, 0, 1, 1 } };
+
+	const std::uint32_t (*passes)[4] = interlaced ? adam7 : progressive;
+	int passCount = interlaced ? 7 : 1;
+
+	size_t offset = 0;
+	for (int p = 0; p < passCount; ++p)
+	{
+		std::uint32_t x0 = passes[p][0], y0 = passes[p][1];
+		std::uint32_t dx = passes[p][2], dy = passes[p][3];
+		std::uint32_t w = h.Width > x0 ? (h.Width - x0 + dx - 1) / dx : 0;
+		std::uint32_t rows = h.Height > y0 ? (h.Height - y0 + dy - 1) / dy : 0;
+		if (w == 0 || rows == 0)
+			continue;
+
+		size_t stride = (w * bitsPerPixel + 7) / 8;
+		if (offset + (stride + 1) * rows > raw.size())
+		{
+			error = "truncated image data";
+			return false;
+		}
+
+		std::uint8_t* passData = raw.data() + offset;
+		if (!Unfilter(passData, rows, stride, bpp))
+		{
+			error = "invalid row filter";
+			return false;
+		}
+
+		for (std::uint32_t y = 0; y < rows; ++y)
+		{
+			const std::uint8_t* row = passData + y * (stride + 1) + 1;
+			for (std::uint32_t x = 0; x < w; ++x)
+			{
+				std::uint8_t* dst = &image.Pixels[(((size_t)(y0 + y * dy)) * h.Width + x0 + x * dx) * 4];
+
+				switch (h.ColorType)
+				{
+				case 0:
+				{
+					std::uint8_t g = Sample(h, row, x, 0);
+					dst[0] = dst[1] = dst[2] = g;
+					dst[3] = 255;
+					if (transparentGray >= 0)
+					{
+						int value = h.BitDepth == 16 ? (g << 8) | row[x * 2 + 1] :
+							h.BitDepth == 8 ? g : (row[(x * h.BitDepth) >> 3] >> (8 - h.BitDepth - ((x * h.BitDepth) & 7))) & ((1 << h.BitDepth) - 1);
+						if (value == transparentGray)
+							dst[3] = 0;
+					}
+					break;
+				}
+				case 2:
+				{
+					bool transparent = transparentRgb[0] >= 0;
+					for (int c = 0; c < 3; ++c)
+					{
+						dst[c] = Sample(h, row, x, c);
+						int value = h.BitDepth == 16 ? (row[(x * 3 + c) * 2] << 8) | row[(x * 3 + c) * 2 + 1] : dst[c];
+						transparent = transparent && value == transparentRgb[c];
+					}
+					dst[3] = transparent ? 0 : 255;
+					break;
+				}
+				case 3:
+				{
+					size_t index = Sample(h, row, x, 0);
+					if (index * 3 + 2 >= palette.size())
+					{
+						error = "palette index out of range";
+						return false;
+					}
+					dst[0] = palette[index * 3];
+					dst[1] = palette[index * 3 + 1];
+					dst[2] = palette[index * 3 + 2];
+					dst[3] = index < paletteAlpha.size() ? paletteAlpha[index] : 255;
+					break;
+				}
+				case 4:
+					dst[0] = dst[1] = dst[2] = Sample(h, row, x, 0);
+					dst[3] = Sample(h, row, x, 1);
+					break;
+				case 6:
+					for (int c = 0; c < 4; ++c)
+						dst[c] = Sample(h, row, x, c);
+					break;
+				}
+			}
+		}
+
+		offset += (stride + 1) * rows;
+	}
+
+	return true;
+}
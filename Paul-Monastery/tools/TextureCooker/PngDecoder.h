@@ -0,0 +1,9 @@
+#ifndef _PNG_DECODER_H_
+#define _PNG_DECODER_H_
+
+// Decodes every standard PNG variant (all color types and bit depths,
+// palette transparency, Adam7 interlacing) to 8-bit RGBA. 16-bit channels
+// keep their high byte; gamma and color chunks are ignored.
+bool DecodePng(const std::vector<std::uint8_t>& file, Image& image, std::string& error);
+
+#endif /* _PNG_DECODER_H_ */
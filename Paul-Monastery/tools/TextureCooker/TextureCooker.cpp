@@ -0,0 +1,335 @@
+// Offline texture cooker: PNG in, block-compressed and mipmapped DDS out, in
+// the layout CreateDDSTextureFromFile12 loads.
+//
+//   TextureCooker [options] input.png...
+//     -o <dir>         output directory, created if missing; default next
+//                      to each input
+//     -f <format>      auto | bc1 | bc3 | bc7 | rgba, default auto
+//                      (bc1 for opaque images, bc3 when alpha is used)
+//     --srgb           write the _SRGB variant of the format
+//     --cube <out.dds> assemble six inputs (+X -X +Y -Y +Z -Z) into a cube map
+//     -j <threads>     encoder threads, default every hardware thread
+//
+// Block-compressed images whose size is not a multiple of 4 are stretched
+// to the next multiple (159x120 becomes 160x120), not padded: padding would
+// move the image away from the texture coordinates that address it.
+//
+// Builds standalone with any C++17 compiler:
+//   g++ -O2 -std=c++17 -pthread *.cpp -o TextureCooker
+//   cl /O2 /EHsc /std:c++17 *.cpp
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Image.h"
+#include "PngDecoder.h"
+#include "MipGenerator.h"
+#include "BlockCompressor.h"
+#include "DdsWriter.h"
+
+namespace
+{
+	enum class OutputFormat { Auto, BC1, BC3, BC7, Rgba };
+
+	struct Options
+	{
+		std::string OutDir;
+		OutputFormat Format = OutputFormat::Auto;
+		bool Srgb = false;
+		std::string CubeOutput;
+		unsigned Threads = 0;
+		std::vector<std::string> Inputs;
+	};
+
+	struct Stats
+	{
+		double Pixels = 0.0;
+		double Seconds = 0.0;
+	};
+
+	void PrintUsage()
+	{
+		printf("usage: TextureCooker [-o dir] [-f auto|bc1|bc3|bc7|rgba] [--srgb] [--cube out.dds] [-j threads] input.png...\n");
+	}
+
+	bool ParseArgs(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			if (arg == "-o" && hasValue)
+				options.OutDir = argv[++i];
+			else if (arg == "-f" && hasValue)
+			{
+				std::string f = argv[++i];
+				if (f == "auto") options.Format = OutputFormat::Auto;
+				else if (f == "bc1") options.Format = OutputFormat::BC1;
+				else if (f == "bc3") options.Format = OutputFormat::BC3;
+				else if (f == "bc7") options.Format = OutputFormat::BC7;
+				else if (f == "rgba") options.Format = OutputFormat::Rgba;
+				else
+					return false;
+			}
+			else if (arg == "--srgb")
+				options.Srgb = true;
+			else if (arg == "--cube" && hasValue)
+				options.CubeOutput = argv[++i];
+			else if (arg == "-j" && hasValue)
+				options.Threads = (unsigned)atoi(argv[++i]);
+			else if (!arg.empty() && arg[0] == '-')
+				return false;
+			else
+				options.Inputs.push_back(arg);
+		}
+
+		if (options.Inputs.empty())
+			return false;
+		if (!options.CubeOutput.empty() && options.Inputs.size() != 6)
+			return false;
+		return true;
+	}
+
+	bool ReadFile(const std::string& filename, std::vector<std::uint8_t>& data)
+	{
+		std::ifstream file(filename, std::ios::binary);
+		if (!file)
+			return false;
+
+		data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return true;
+	}
+
+	std::string OutputName(const Options& options, const std::string& input)
+	{
+		size_t slash = input.find_last_of("/\\");
+		size_t dot = input.find_last_of('.');
+		if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+			dot = input.size();
+
+		std::string stem = input.substr(0, dot);
+		if (options.OutDir.empty())
+			return stem + ".dds";
+
+		std::string name = slash == std::string::npos ? stem : stem.substr(slash + 1);
+		char last = options.OutDir.back();
+		return options.OutDir + (last == '/' || last == '\\' ? "" : "/") + name + ".dds";
+	}
+
+	DdsFormat ToDdsFormat(OutputFormat format, bool srgb)
+	{
+		switch (format)
+		{
+		case OutputFormat::BC1: return srgb ? DdsFormat_BC1_UNORM_SRGB : DdsFormat_BC1_UNORM;
+		case OutputFormat::BC3: return srgb ? DdsFormat_BC3_UNORM_SRGB : DdsFormat_BC3_UNORM;
+		case OutputFormat::BC7: return srgb ? DdsFormat_BC7_UNORM_SRGB : DdsFormat_BC7_UNORM;
+		default: return srgb ? DdsFormat_R8G8B8A8_UNORM_SRGB : DdsFormat_R8G8B8A8_UNORM;
+		}
+	}
+
+	const char* FormatName(OutputFormat format)
+	{
+		switch (format)
+		{
+		case OutputFormat::BC1: return "BC1";
+		case OutputFormat::BC3: return "BC3";
+		case OutputFormat::BC7: return "BC7";
+		default: return "RGBA8";
+		}
+	}
+
+	// Peak signal to noise ratio over the given channels, 99 dB for an exact
+	// match. The color of fully transparent source texels is not counted.
+	double Psnr(const Image& a, const Image& b, int firstChannel, int channelCount)
+	{
+		double error = 0.0;
+		size_t count = 0;
+		for (size_t i = 0; i < a.Pixels.size(); i += 4)
+		{
+			if (firstChannel < 3 && a.Pixels[i + 3] == 0)
+				continue;
+
+			for (int c = firstChannel; c < firstChannel + channelCount; ++c)
+			{
+				double d = (double)a.Pixels[i + c] - b.Pixels[i + c];
+				error += d * d;
+				++count;
+			}
+		}
+
+		if (error == 0.0 || count == 0)
+			return 99.0;
+		return 10.0 * std::log10(255.0 * 255.0 / (error / count));
+	}
+
+	// One face (or the whole 2D texture): mips appended to surfaces.
+	// Block-compressed textures need a top level in multiples of 4 texels;
+	// other sizes are resampled to the next one, so the UVs still span it.
+	bool CookSurface(const Options& options, const std::string& input, OutputFormat format,
+		std::vector<std::vector<std::uint8_t>>& surfaces, DdsDesc& desc, Stats& stats, double& psnrColor, double& psnrAlpha)
+	{
+		std::vector<std::uint8_t> file;
+		Image image;
+		std::string error;
+		if (!ReadFile(input, file))
+		{
+			fprintf(stderr, "%s: cannot read file\n", input.c_str());
+			return false;
+		}
+		if (!DecodePng(file, image, error))
+		{
+			fprintf(stderr, "%s: %s\n", input.c_str(), error.c_str());
+			return false;
+		}
+
+		if (format != OutputFormat::Rgba && (image.Width % 4 != 0 || image.Height % 4 != 0))
+		{
+			std::uint32_t width = (image.Width + 3) & ~3u;
+			std::uint32_t height = (image.Height + 3) & ~3u;
+			printf("%s: stretched %ux%u to %ux%u for block compression\n", input.c_str(), image.Width, image.Height, width, height);
+			image = ToSrgb(Resample(ToLinear(image), width, height));
+		}
+
+		if (desc.Width != 0 && (desc.Width != image.Width || desc.Height != image.Height))
+		{
+			fprintf(stderr, "%s: cube faces differ in size\n", input.c_str());
+			return false;
+		}
+
+		std::vector<Image> mips = GenerateMips(image);
+		desc.Width = image.Width;
+		desc.Height = image.Height;
+		desc.MipCount = (std::uint32_t)mips.size();
+		desc.HasAlpha = desc.HasAlpha || image.HasAlpha();
+
+		for (size_t level = 0; level < mips.size(); ++level)
+		{
+			const Image& mip = mips[level];
+			if (format == OutputFormat::Rgba)
+			{
+				surfaces.push_back(mip.Pixels);
+				continue;
+			}
+
+			BlockFormat blockFormat = format == OutputFormat::BC1 ? BlockFormat::BC1 :
+				format == OutputFormat::BC3 ? BlockFormat::BC3 : BlockFormat::BC7;
+
+			auto start = std::chrono::steady_clock::now();
+			surfaces.push_back(CompressImage(mip, blockFormat, options.Threads));
+			stats.Seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			stats.Pixels += (double)mip.Width * mip.Height;
+
+			if (level == 0)
+			{
+				Image decoded = DecompressImage(surfaces.back().data(), mip.Width, mip.Height, blockFormat);
+				psnrColor = std::min(psnrColor, Psnr(mip, decoded, 0, 3));
+				psnrAlpha = std::min(psnrAlpha, Psnr(mip, decoded, 3, 1));
+			}
+		}
+
+		return true;
+	}
+
+	OutputFormat ResolveFormat(OutputFormat format, const std::vector<std::string>& inputs)
+	{
+		if (format != OutputFormat::Auto)
+			return format;
+
+		for (const auto& input : inputs)
+		{
+			std::vector<std::uint8_t> file;
+			Image image;
+			std::string error;
+			if (ReadFile(input, file) && DecodePng(file, image, error) && image.HasAlpha())
+				return OutputFormat::BC3;
+		}
+		return OutputFormat::BC1;
+	}
+
+	bool Cook(const Options& options, const std::vector<std::string>& inputs, const std::string& output, Stats& total)
+	{
+		OutputFormat format = ResolveFormat(options.Format, inputs);
+
+		DdsDesc desc;
+		desc.IsCubeMap = inputs.size() == 6;
+		desc.Format = ToDdsFormat(format, options.Srgb);
+
+		std::vector<std::vector<std::uint8_t>> surfaces;
+		Stats stats;
+		double psnrColor = 99.0, psnrAlpha = 99.0;
+		for (const auto& input : inputs)
+		{
+			if (!CookSurface(options, input, format, surfaces, desc, stats, psnrColor, psnrAlpha))
+				return false;
+		}
+
+		errno = 0;
+		if (!WriteDds(output, desc, surfaces))
+		{
+			int error = errno;
+			fprintf(stderr, "%s: cannot write file: %s\n", output.c_str(), error != 0 ? strerror(error) : "write failed");
+			return false;
+		}
+
+		printf("%s: %ux%u%s %s, %u mips", output.c_str(), desc.Width, desc.Height,
+			desc.IsCubeMap ? " cube" : "", FormatName(format), desc.MipCount);
+		if (format != OutputFormat::Rgba)
+		{
+			printf(", %.1f MPix/s, PSNR %.2f dB", stats.Pixels / stats.Seconds / 1e6, psnrColor);
+			if (desc.HasAlpha)
+				printf(" (alpha %.2f dB)", psnrAlpha);
+		}
+		printf("\n");
+
+		total.Pixels += stats.Pixels;
+		total.Seconds += stats.Seconds;
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseArgs(argc, argv, options))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (!options.OutDir.empty())
+	{
+		std::error_code error;
+		std::filesystem::create_directories(options.OutDir, error);
+		if (error)
+		{
+			fprintf(stderr, "%s: cannot create directory: %s\n", options.OutDir.c_str(), error.message().c_str());
+			return 1;
+		}
+	}
+
+	Stats total;
+	bool ok = true;
+	if (!options.CubeOutput.empty())
+		ok = Cook(options, options.Inputs, options.CubeOutput, total);
+	else
+	{
+		for (const auto& input : options.Inputs)
+			ok = Cook(options, { input }, OutputName(options, input), total) && ok;
+	}
+
+	if (total.Seconds > 0.0)
+		printf("total: %.2f MPix in %.3f s, %.1f MPix/s\n", total.Pixels / 1e6, total.Seconds, total.Pixels / total.Seconds / 1e6);
+
+	return ok ? 0 : 1;
+}